@@ -40,6 +40,12 @@ void app_console_start()
     register_ir_send_step_commands();
     register_ir_reset_nvs_commands();
     register_ir_print_delay_commands();
+    register_ir_tx_stats_commands();
+    register_ir_mem_stats_commands();
+    register_ir_match_stats_commands();
+    register_ir_rx_stats_commands();
+    register_ir_db_stats_commands();
+    register_ir_cache_stats_commands();
     ESP_LOGI(TAG, "Registering IR commands");
 
 
@@ -17,7 +17,6 @@
 
 static const char *TAG = "Device";
 extern QueueHandle_t ir_trans_queue; // Queue to handle IR transmit events
-extern QueueHandle_t ir_learn_queue; // Queue to handle IR learn events
 
 extern ir_learn_common_param_t *learn_param;
 bool light_flag = false; // Flag to control light state
@@ -35,7 +34,7 @@ static void button_event_cb(void *arg, void *data)
             .event = IR_EVENT_LEARN_NORMAL,
             .key = "unknow" // Key for the button event
         };
-        xQueueSend(ir_learn_queue, &ir_event, portMAX_DELAY);
+        ir_learn_post_event(&ir_event, portMAX_DELAY);
     }
 }
 static void config_btn_gpio()
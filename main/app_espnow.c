@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #include "freertos/FreeRTOS.h"
@@ -200,6 +202,11 @@ static void handle_received_data(espnow_event_recv_cb_t *recv_cb)
         ESP_LOGI(TAG, "Reset screen command received, sending IR command.");
         ir_reset_screen();
     }
+    else if (strcmp(espnow_data.cmd, LEARN_CANCEL_CMD) == 0)
+    {
+        ESP_LOGI(TAG, "Learn cancel command received.");
+        ir_learn_cancel();
+    }
     else
     {
         ESP_LOGW(TAG, "Unknown command received: %s", espnow_data.cmd);
@@ -261,9 +268,18 @@ static esp_err_t espnow_init(void)
 
     return ESP_OK;
 }
+static void espnow_learn_progress_cb(const ir_learn_progress_t *progress)
+{
+    char model[BUTTON_CMD_MAX_LENGTH];
+    snprintf(model, sizeof(model), "%s %s %d/%d %" PRIu32, ir_learn_progress_name(progress->state), progress->key,
+             progress->sample, progress->samples, progress->remaining_ms);
+    send_data_to_screen(LEARN_PROGRESS_CMD, model);
+}
+
 void app_espnow_start(void)
 {
     ESP_ERROR_CHECK(espnow_init());
+    ir_learn_register_progress_cb(espnow_learn_progress_cb);
 }
 static void espnow_deinit()
 {
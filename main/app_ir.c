@@ -1,5 +1,6 @@
 /* C includes */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
 #include <unistd.h>
@@ -25,6 +26,8 @@
 #include "ir_config.h"
 #include "driver_config.h"
 #include "ir_storage.h"
+#include "ir_sequence.h"
+#include "ir_cache.h"
 #include "espnow_config.h"
 
 static const char *TAG = "App_IR_learn";
@@ -82,60 +85,67 @@ static void ir_send_cb(ir_learn_state_t state, uint8_t sub_step, struct ir_learn
     return;
 }
 
-static void ir_learn_tx_task(void *arg)
+static esp_err_t ir_transmit_key(const char *key)
 {
+    ir_tx_key_t tx_key;
+    esp_err_t ret = ir_tx_load_key(key, &tx_key);
+    if (ret == ESP_OK)
+    {
+        ir_tx_queue_key(&tx_key);
+        ir_tx_wait_done();
+    }
+    ir_tx_release_key(&tx_key);
+    return ret;
+}
 
-    ir_trans_queue = xQueueCreate(5, sizeof(ir_event_cmd_t));
-    ir_learn_queue = xQueueCreate(5, sizeof(ir_event_cmd_t));
-
+static void ir_learn_tx_task(void *arg)
+{
     ir_event_cmd_t ir_event;
+    bool tx_active = false;
+    esp_err_t ret;
 
     while (1)
     {
-        if (xQueueReceive(ir_trans_queue, &ir_event, portMAX_DELAY) == pdPASS)
+        TickType_t wait = (tx_active && IR_TX_IDLE_TIMEOUT_MS > 0) ? pdMS_TO_TICKS(IR_TX_IDLE_TIMEOUT_MS) : portMAX_DELAY;
+        if (xQueueReceive(ir_trans_queue, &ir_event, wait) == pdPASS)
         {
             switch (ir_event.event)
             {
             case IR_EVENT_TRANSMIT:
+                ir_tx_mark_request(ir_event.request_time);
                 rmt_tx_start();
+                tx_active = true;
                 ESP_LOGI(TAG, "IR transmit command for key: %s", ir_event.key);
-                ir_learn_load(&ir_data, ir_event.key);
-                ir_send_raw(&ir_data);
-                ir_learn_clean_sub_data(&ir_data);
-                rmt_tx_stop();
+                if (ir_transmit_key(ir_event.key) == ESP_OK)
+                {
+                    // Counted once sent, the bookkeeping doesn't delay the press
+                    ir_cache_note_use(ir_event.key, IR_CACHE_KIND_KEY);
+                }
                 break;
             case IR_EVENT_SEND_STEP:
+                ir_tx_mark_request(ir_event.request_time);
                 rmt_tx_start();
+                tx_active = true;
                 ESP_LOGI(TAG, "IR send step command for key: %s", ir_event.key_name_step);
-                int loaded_list[IR_STEP_COUNT_MAX] = {0};
-                char key_name_load[IR_KEY_MAX_LEN] = {0};
-                size_t count = 0;
-                load_step_timediff_from_file(ir_event.key_name_step, loaded_list, &count);
-
-                for (size_t i = 0; i <= count; i++)
+                ret = ir_send_step(ir_event.key_name_step);
+                if (ret == ESP_ERR_INVALID_STATE)
                 {
-                    if (remote_state == STOP_SENDING)
-                    {
-                        ESP_LOGI(TAG, "IR send step command stopped for key: %s", ir_event.key_name_step);
-                        response_to_button(ir_event.key_name_step, "unknow", NOT_SENDING);
-                        break;
-                    }
-                    snprintf(key_name_load, IR_KEY_MAX_LEN, "%s_step%d", ir_event.key_name_step, i + 1);
-                    ESP_LOGI(TAG, "Loading step: %s", key_name_load);
-                    ir_learn_load(&ir_data, key_name_load);
-                    ir_send_raw(&ir_data);
-                    ir_learn_clean_sub_data(&ir_data);
-                    vTaskDelay(pdMS_TO_TICKS(loaded_list[i]));
+                    response_to_button(ir_event.key_name_step, "unknow", NOT_SENDING);
+                }
+                else if (ret == ESP_OK)
+                {
+                    ir_cache_note_use(ir_event.key_name_step, IR_CACHE_KIND_SEQ);
                 }
                 ESP_LOGI(TAG, "IR send step command completed for key: %s", ir_event.key_name_step);
 
                 response_to_button(ir_event.key_name_step, "unknow", SEND_DONE);
-
-                rmt_tx_stop();
                 break;
             case IR_EVENT_LEARN_DONE:
-                ir_learn_save(&ir_data, ir_event.data, ir_event.key);
+                ir_learn_save(&ir_data, ir_event.data, ir_event.key, &ir_event.carrier);
                 ir_learn_clean_sub_data(&ir_data);
+                // The learn task handed the command over with the event
+                ir_learn_clean_sub_data(ir_event.data);
+                free(ir_event.data);
                 if (strcmp(ir_event.key, "unknow") != 0)
                 {
                     ESP_LOGI(TAG, "IR learn done for key: %s", ir_event.key);
@@ -145,6 +155,20 @@ static void ir_learn_tx_task(void *arg)
                     ESP_LOGI(TAG, "Key IR is unknow, set name for IR learn command:");
                 }
                 break;
+            case IR_EVENT_HELD:
+                // Auto-repeat of the alias of a held key, e.g. volume ramping
+                ir_tx_mark_request(ir_event.request_time);
+                rmt_tx_start();
+                tx_active = true;
+                ESP_LOGD(TAG, "IR held key: %s, repeat %u", ir_event.key, ir_event.repeats);
+                ir_transmit_key(ir_event.key);
+                break;
+            case IR_EVENT_PACK_STEP:
+                if (ir_seq_pack(ir_event.key_name_step) != ESP_OK)
+                {
+                    ESP_LOGE(TAG, "Failed to pack step sequence: %s", ir_event.key_name_step);
+                }
+                break;
             case IR_EVENT_SET_NAME:
                 rename_ir_key_in_spiffs("unknow", ir_event.key);
                 break;
@@ -155,6 +179,12 @@ static void ir_learn_tx_task(void *arg)
                 break;
             }
         }
+        else
+        {
+            // No transmission for IR_TX_IDLE_TIMEOUT_MS, power the TX channel down
+            rmt_tx_stop();
+            tx_active = false;
+        }
     }
     vTaskDelete(NULL);
 }
@@ -162,6 +192,10 @@ static esp_err_t ir_learn_init_task(ir_learn_result_cb cb)
 {
     esp_err_t ret = ESP_OK;
 
+    // Both tasks use both queues, they exist before either task starts
+    ir_trans_queue = xQueueCreate(5, sizeof(ir_event_cmd_t));
+    ir_learn_queue = xQueueCreate(5, sizeof(ir_event_cmd_t));
+
     xTaskCreate(ir_learn_tx_task, "Tx task", 1024 * 6, NULL, 10, NULL);
 
     const ir_learn_cfg_t config = {
@@ -187,6 +221,14 @@ esp_err_t ir_task_start(void)
     }
     ESP_LOGI(TAG, "SPIFFS initialized successfully");
 
+    // Initialize the TX engine, kept for the lifetime of the application
+    ret = ir_tx_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "IR TX initialization failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     // Initialize IR learn task
     ret = ir_learn_init_task(ir_send_cb);
     if (ret != ESP_OK)
@@ -197,5 +239,13 @@ esp_err_t ir_task_start(void)
 
     ESP_LOGI(TAG, "IR learn task started successfully");
 
+    // Warm up the storage: alias table and most used keys in RAM before the first press
+    ret = ir_cache_warm_up();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Storage warm-up failed: %s", esp_err_to_name(ret));
+        ret = ESP_OK;
+    }
+
     return ret;
 }
@@ -11,6 +11,9 @@
 #include "web_server.h"
 #include "ir_config.h"
 #include "ir_storage.h"
+#include "ir_alias.h"
+#include "ir_sequence.h"
+#include "ir_db.h"
 
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
@@ -182,17 +185,23 @@ esp_err_t ir_send_handler(httpd_req_t *req)
 }
 esp_err_t ir_learn_handler(httpd_req_t *req)
 {
-    char query[64];
+    char query[96];
     if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK)
     {
-        char mode[16], name[32];
+        char mode[16], name[32], timeout[12];
         if (httpd_query_key_value(query, "mode", mode, sizeof(mode)) == ESP_OK &&
             httpd_query_key_value(query, "name", name, sizeof(name)) == ESP_OK)
         {
+            // Optional deadline in ms, CONFIG_IR_LEARN_TIMEOUT_MS without it
+            uint32_t timeout_ms = 0;
+            if (httpd_query_key_value(query, "timeout", timeout, sizeof(timeout)) == ESP_OK)
+            {
+                timeout_ms = strtoul(timeout, NULL, 10);
+            }
 
             ESP_LOGI("LEARN", "Học lệnh chế độ: %s, tên: %s", mode, name);
 
-            bool success = ir_learn_command(mode, name); // 🧠 Giả định Bro có hàm học lệnh
+            bool success = ir_learn_command(mode, name, timeout_ms); // 🧠 Giả định Bro có hàm học lệnh
             if (success)
             {
                 httpd_resp_set_type(req, "application/json");
@@ -209,6 +218,115 @@ esp_err_t ir_learn_handler(httpd_req_t *req)
     return ESP_FAIL;
 }
 
+esp_err_t ir_learn_cancel_handler(httpd_req_t *req)
+{
+    if (ir_learn_cancel() != ESP_OK)
+    {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Cancel failed");
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, "{\"status\":\"ok\"}");
+}
+
+#if CONFIG_HTTPD_WS_SUPPORT
+/* A learn progress event, sent to every WebSocket client by the server task */
+typedef struct
+{
+    httpd_handle_t hd;
+    char *json;
+} ir_learn_ws_msg_t;
+
+static void ir_learn_ws_broadcast(void *arg)
+{
+    ir_learn_ws_msg_t *msg = (ir_learn_ws_msg_t *)arg;
+    int fds[CONFIG_LWIP_MAX_SOCKETS];
+    size_t fd_count = sizeof(fds) / sizeof(fds[0]);
+
+    if (httpd_get_client_list(msg->hd, &fd_count, fds) == ESP_OK)
+    {
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)msg->json,
+            .len = strlen(msg->json),
+        };
+        for (size_t i = 0; i < fd_count; i++)
+        {
+            if (httpd_ws_get_fd_info(msg->hd, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET)
+            {
+                httpd_ws_send_frame_async(msg->hd, fds[i], &frame);
+            }
+        }
+    }
+    free(msg->json);
+    free(msg);
+}
+
+/* Runs in the learn task: the event is handed to the server task, nothing is sent from here */
+static void ir_learn_ws_progress_cb(const ir_learn_progress_t *progress)
+{
+    httpd_handle_t hd = s_server;
+    if (!hd)
+    {
+        return;
+    }
+
+    // The key name is user input, cJSON escapes it
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "state", ir_learn_progress_name(progress->state));
+    cJSON_AddStringToObject(json, "key", progress->key);
+    cJSON_AddNumberToObject(json, "sample", progress->sample);
+    cJSON_AddNumberToObject(json, "samples", progress->samples);
+    cJSON_AddNumberToObject(json, "sub", progress->sub);
+    cJSON_AddNumberToObject(json, "symbols", progress->symbols);
+    cJSON_AddNumberToObject(json, "variance", progress->max_variance);
+    cJSON_AddNumberToObject(json, "remaining_ms", progress->remaining_ms);
+    char *json_str = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+
+    ir_learn_ws_msg_t *msg = malloc(sizeof(ir_learn_ws_msg_t));
+    if (!json_str || !msg)
+    {
+        free(json_str);
+        free(msg);
+        return;
+    }
+    msg->hd = hd;
+    msg->json = json_str;
+    if (httpd_queue_work(hd, ir_learn_ws_broadcast, msg) != ESP_OK)
+    {
+        free(msg->json);
+        free(msg);
+    }
+}
+
+esp_err_t ir_learn_ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET)
+    {
+        ESP_LOGI(TAG, "Learn progress client connected, fd %d", httpd_req_to_sockfd(req));
+        return ESP_OK;
+    }
+
+    // The only message of a client is "cancel"
+    uint8_t buf[16] = {0};
+    httpd_ws_frame_t frame = {
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = buf,
+    };
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, sizeof(buf) - 1);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (frame.type == HTTPD_WS_TYPE_TEXT && strcmp((const char *)buf, "cancel") == 0)
+    {
+        ir_learn_cancel();
+    }
+    return ESP_OK;
+}
+#endif
+
 esp_err_t ir_save_handler(httpd_req_t *req)
 {
     char query[64];
@@ -257,6 +375,47 @@ esp_err_t ir_update_handler(httpd_req_t *req)
     esp_restart();
     return ESP_OK;
 }
+typedef struct
+{
+    char name[32];
+    bool step_exist[64];
+} key_info_t;
+
+typedef struct
+{
+    key_info_t keys[32];
+    int key_count;
+} key_list_t;
+
+static bool ir_list_add_step_key(const char *db_key, const ir_db_entry_t *db_entry, void *arg)
+{
+    key_list_t *list = arg;
+    char key[32];
+    int step;
+    int len;
+
+    // Chuỗi step chưa đóng gói: các key "<key>_stepN" trong cơ sở dữ liệu key
+    if (sscanf(db_key, "%31[^_]_step%d%n", key, &step, &len) != 2 || db_key[len] != '\0' || step <= 0 || step >= 64)
+    {
+        return true;
+    }
+    for (int i = 0; i < list->key_count; i++)
+    {
+        if (strcmp(list->keys[i].name, key) == 0)
+        {
+            list->keys[i].step_exist[step] = true;
+            return true;
+        }
+    }
+    if (list->key_count < 32)
+    {
+        strcpy(list->keys[list->key_count].name, key);
+        list->keys[list->key_count].step_exist[step] = true;
+        list->key_count++;
+    }
+    return true;
+}
+
 esp_err_t ir_list_handler(httpd_req_t *req)
 {
     const char *dir_path = "/spiffs";
@@ -268,13 +427,14 @@ esp_err_t ir_list_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    typedef struct
+    key_list_t *list = calloc(1, sizeof(key_list_t));
+    if (!list)
     {
-        char name[32];
-        bool step_exist[64];
-    } key_info_t;
-
-    key_info_t keys[32] = {0};
+        closedir(dir);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    key_info_t *keys = list->keys;
     int key_count = 0;
 
     struct dirent *entry;
@@ -284,29 +444,29 @@ esp_err_t ir_list_handler(httpd_req_t *req)
             continue;
 
         char key[32];
-        int step;
+        const char *ext = strrchr(entry->d_name, '.');
 
-        if (sscanf(entry->d_name, "%[^_]_step%d.ir", key, &step) == 2)
+        if (ext && strcmp(ext, ".seq") == 0 && ext - entry->d_name < sizeof(key) && key_count < 32)
         {
-            bool found = false;
-            for (int i = 0; i < key_count; i++)
+            // Chuỗi step đã đóng gói: các step 1..N đều tồn tại
+            int delays[IR_STEP_COUNT_MAX];
+            size_t delay_count = 0;
+            snprintf(key, sizeof(key), "%.*s", (int)(ext - entry->d_name), entry->d_name);
+            if (ir_seq_get_delays(key, delays, &delay_count) == ESP_OK)
             {
-                if (strcmp(keys[i].name, key) == 0)
+                strcpy(keys[key_count].name, key);
+                for (int j = 1; j <= delay_count + 1; j++)
                 {
-                    keys[i].step_exist[step] = true;
-                    found = true;
-                    break;
+                    keys[key_count].step_exist[j] = true;
                 }
-            }
-            if (!found && key_count < 32)
-            {
-                strcpy(keys[key_count].name, key);
-                keys[key_count].step_exist[step] = true;
                 key_count++;
             }
         }
     }
     closedir(dir);
+    list->key_count = key_count;
+    ir_db_foreach(ir_list_add_step_key, list);
+    key_count = list->key_count;
 
     // Tạo JSON
     char json[2048];
@@ -320,19 +480,12 @@ esp_err_t ir_list_handler(httpd_req_t *req)
 
         offset += snprintf(json + offset, sizeof(json) - offset, "{\"name\":\"%s\",\"delays\":[", keys[i].name);
 
-        // Đọc delay file
-        char delay_path[64];
-        snprintf(delay_path, sizeof(delay_path), "/spiffs/%s.delay", keys[i].name);
+        // Đọc delay từ file .seq, hoặc file .delay
         int delays[64] = {0};
-        FILE *f = fopen(delay_path, "r");
-        int delay_count = 0;
-        if (f)
+        size_t delay_count = 0;
+        if (ir_seq_get_delays(keys[i].name, delays, &delay_count) != ESP_OK)
         {
-            while (fscanf(f, "%d", &delays[delay_count]) == 1 && delay_count < 64)
-            {
-                delay_count++;
-            }
-            fclose(f);
+            read_step_timediff_file(keys[i].name, delays, &delay_count);
         }
 
         // Mảng lưu các step tồn tại
@@ -362,6 +515,7 @@ esp_err_t ir_list_handler(httpd_req_t *req)
     }
 
     offset += snprintf(json + offset, sizeof(json) - offset, "]");
+    free(list);
 
     httpd_resp_set_type(req, "application/json");
     return httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
@@ -523,8 +677,12 @@ esp_err_t ir_assign_handler(httpd_req_t *req)
         return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Load failed");
 
     cJSON_ReplaceItemInObject(aliases, source, cJSON_CreateString(target));
-    ir_save_aliases(aliases);
+    esp_err_t save_res = ir_save_aliases(aliases);
     cJSON_Delete(aliases);
+    ir_alias_invalidate();
+
+    if (save_res != ESP_OK)
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Save failed");
 
     return httpd_resp_sendstr(req, "Alias updated");
 }
@@ -558,8 +716,12 @@ esp_err_t ir_alias_delete_handler(httpd_req_t *req)
         return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Load failed");
 
     cJSON_DeleteItemFromObject(aliases, source);
-    ir_save_aliases(aliases);
+    esp_err_t save_res = ir_save_aliases(aliases);
     cJSON_Delete(aliases);
+    ir_alias_invalidate();
+
+    if (save_res != ESP_OK)
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Save failed");
 
     return httpd_resp_sendstr(req, "Alias deleted");
 }
@@ -609,6 +771,7 @@ esp_err_t ir_assign_bulk_handler(httpd_req_t *req)
     esp_err_t save_res = ir_save_aliases(aliases);
     cJSON_Delete(aliases);
     cJSON_Delete(arr);
+    ir_alias_invalidate();
 
     if (save_res != ESP_OK)
         return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save alias file");
@@ -616,23 +779,20 @@ esp_err_t ir_assign_bulk_handler(httpd_req_t *req)
     return httpd_resp_sendstr(req, "✅ Bulk IR assignments saved!");
 }
 
+static bool ir_simple_list_add_key(const char *key, const ir_db_entry_t *entry, void *arg)
+{
+    // Alias vẫn dùng tên file "<key>.ir"
+    char name[64];
+    snprintf(name, sizeof(name), "%s.ir", key);
+    cJSON_AddItemToArray((cJSON *)arg, cJSON_CreateString(name));
+    return true;
+}
+
 esp_err_t ir_simple_list_handler(httpd_req_t *req)
 {
     cJSON *arr = cJSON_CreateArray();
 
-    DIR *dir = opendir("/spiffs");
-    if (!dir)
-        return httpd_resp_send_err(req, 500, "Cannot open SPIFFS");
-
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
-    {
-        if (entry->d_type != DT_REG)
-            continue;
-        if (strstr(entry->d_name, ".ir"))
-            cJSON_AddItemToArray(arr, cJSON_CreateString(entry->d_name));
-    }
-    closedir(dir);
+    ir_db_foreach(ir_simple_list_add_key, arr);
 
     char *json = cJSON_PrintUnformatted(arr);
     httpd_resp_set_type(req, "application/json");
@@ -682,6 +842,21 @@ httpd_uri_t learn_uri = {
     .handler = ir_learn_handler,
     .user_ctx = NULL};
 
+httpd_uri_t learn_cancel_uri = {
+    .uri = "/ir/learn/cancel",
+    .method = HTTP_GET,
+    .handler = ir_learn_cancel_handler,
+    .user_ctx = NULL};
+
+#if CONFIG_HTTPD_WS_SUPPORT
+httpd_uri_t learn_ws_uri = {
+    .uri = "/ir/learn/ws",
+    .method = HTTP_GET,
+    .handler = ir_learn_ws_handler,
+    .user_ctx = NULL,
+    .is_websocket = true};
+#endif
+
 httpd_uri_t save_uri = {
     .uri = "/ir/save",
     .method = HTTP_GET,
@@ -776,6 +951,17 @@ void app_web_server_start(void)
     httpd_register_uri_handler(server, &reset_uri);
 
     httpd_register_uri_handler(server, &learn_uri);
+    httpd_register_uri_handler(server, &learn_cancel_uri);
+#if CONFIG_HTTPD_WS_SUPPORT
+    httpd_register_uri_handler(server, &learn_ws_uri);
+
+    // Learn progress is pushed to the page as it happens
+    static bool progress_registered = false;
+    if (!progress_registered)
+    {
+        progress_registered = ir_learn_register_progress_cb(ir_learn_ws_progress_cb) == ESP_OK;
+    }
+#endif
     httpd_register_uri_handler(server, &save_uri);
     httpd_register_uri_handler(server, &update_uri);
     httpd_register_uri_handler(server, &uri_list);
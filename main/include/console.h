@@ -71,6 +71,36 @@ void register_ir_reset_nvs_commands(void);
  */
 void register_ir_print_delay_commands(void);
 
+/**
+ * @brief Register command to print IR TX engine statistics.
+ */
+void register_ir_tx_stats_commands(void);
+
+/**
+ * @brief Register command to print heap and IR list allocation statistics.
+ */
+void register_ir_mem_stats_commands(void);
+
+/**
+ * @brief Register command to print IR matcher statistics.
+ */
+void register_ir_match_stats_commands(void);
+
+/**
+ * @brief Register command to print IR RX engine statistics.
+ */
+void register_ir_rx_stats_commands(void);
+
+/**
+ * @brief Register command to print key database statistics.
+ */
+void register_ir_db_stats_commands(void);
+
+/**
+ * @brief Register command to print the boot warm-up and key cache statistics.
+ */
+void register_ir_cache_stats_commands(void);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -86,6 +86,8 @@ typedef enum
 
 #define WHITE_SCREEN_CMD "white_screen"
 #define RESET_SCREEN_CMD "reset_screen"
+#define LEARN_CANCEL_CMD "learn_cancel"     // Ends the learn session in progress
+#define LEARN_PROGRESS_CMD "learn_progress" // Sent to the screen, model is "<stage> <key> <k>/<K> <ms left>"
 #define BUTTON_CMD_MAX_LENGTH 100
 
 typedef struct __attribute__((packed))
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_alias.h
+ * @brief Resident alias table used to dispatch received IR frames.
+ *
+ * The mappings of ir_alias.json ("source" key sent when the "target" key is
+ * received) are loaded once into a flat array, sized to the file and hashed
+ * by the index signature of the target key. A received frame is only compared
+ * with the aliases whose target has the same signature.
+ */
+
+/**
+ * @brief Number of hash buckets of the alias table.
+ */
+#define IR_ALIAS_BUCKETS 16
+
+/**
+ * @brief Load the alias table from SPIFFS.
+ *
+ * @note Called lazily by ir_alias_resolve() if not done before.
+ * @return ESP_OK on success, or appropriate error code
+ */
+esp_err_t ir_alias_init(void);
+
+/**
+ * @brief Mark the alias table stale, it is reloaded on the next lookup.
+ *
+ * @note Call after every change of ir_alias.json.
+ */
+void ir_alias_invalidate(void);
+
+/**
+ * @brief Find the source key mapped to the received IR data.
+ *
+ * @param result Received IR data
+ * @param out_original_key Output buffer for the source key, IR_KEY_MAX_LEN bytes
+ * @return true if an alias matches, false otherwise
+ */
+bool find_original_key_from_match(const struct ir_learn_sub_list_head *result, char *out_original_key);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_cache.h
+ * @brief Boot warm-up and RAM cache of the most used keys.
+ *
+ * Every completed send counts one use of its key (or step sequence) in a
+ * usage table, kept in NVS and written back every IR_CACHE_USAGE_FLUSH_MS by
+ * a low priority task if it changed. At boot, ir_cache_warm_up() loads the
+ * alias table and copies the IR_CACHE_KEYS most used keys into RAM, up to
+ * IR_CACHE_BUDGET bytes, so their first press doesn't wait for the flash.
+ *
+ * A cached key is the data of its database record, checked against the index
+ * on every lookup: a key saved again, renamed or deleted is read again from
+ * the database. A cached sequence is the whole .seq file, dropped by
+ * ir_cache_invalidate() when the file changes and read again if the file is
+ * gone or its size changed. ir_cache_clear() drops everything after a format.
+ * Entries are pinned while in use, a stale pinned entry is freed on its last
+ * release.
+ */
+
+/**
+ * @brief Number of cache entries.
+ */
+#define IR_CACHE_KEYS CONFIG_IR_CACHE_KEYS
+
+/**
+ * @brief RAM held by the cached data, in bytes.
+ */
+#define IR_CACHE_BUDGET (CONFIG_IR_CACHE_BUDGET_KB * 1024)
+
+/**
+ * @brief Keys counted by the usage table, the least used one makes room for a new key.
+ */
+#define IR_CACHE_USAGE_MAX 64
+
+/**
+ * @brief Period of the NVS writes of the usage table.
+ */
+#define IR_CACHE_USAGE_FLUSH_MS (60 * 1000)
+
+#define IR_CACHE_USAGE_NVS_KEY "ir_usage"
+
+#define IR_CACHE_KIND_KEY 0 /*!< A key of the database */
+#define IR_CACHE_KIND_SEQ 1 /*!< A packed step sequence, "<key>.seq" */
+
+/**
+ * @brief Entry of the usage table, 8 bytes.
+ */
+typedef struct
+{
+    uint32_t key_hash; /*!< ir_db_hash() of the key or sequence name */
+    uint16_t count;    /*!< Completed sends, all counts are halved when one saturates */
+    uint8_t kind;      /*!< IR_CACHE_KIND_* */
+    uint8_t reserved;
+} ir_cache_usage_t;
+
+/**
+ * @brief Statistics of the cache and of the warm-up.
+ */
+typedef struct
+{
+    uint16_t entries;    /*!< Keys and sequences in RAM */
+    uint32_t bytes;      /*!< RAM held by their data */
+    uint32_t budget;     /*!< IR_CACHE_BUDGET */
+    uint32_t hits;       /*!< Lookups served from RAM */
+    uint32_t misses;     /*!< Lookups left to the flash */
+    uint32_t refills;    /*!< Stale entries read again */
+    uint16_t prefetched; /*!< Entries filled by the warm-up */
+    uint16_t tracked;    /*!< Keys in the usage table */
+    uint32_t warm_us;    /*!< Duration of ir_cache_warm_up(), in us */
+    uint32_t ready_us;   /*!< esp_timer time at the end of ir_cache_warm_up(), in us: the end of ir_task_start(),
+                              not when the storage was mounted */
+} ir_cache_stats_t;
+
+/**
+ * @brief Warm up the storage: load the alias table and the usage table, prefetch the most used keys.
+ *
+ * @note Call once the key database and SPIFFS are mounted.
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the cache lock can't be created
+ */
+esp_err_t ir_cache_warm_up(void);
+
+/**
+ * @brief Count one use of a key, after it has been sent.
+ *
+ * Only updates the table in RAM, the NVS write is left to the usage task.
+ *
+ * @param key Key or sequence name
+ * @param kind IR_CACHE_KIND_*
+ */
+void ir_cache_note_use(const char *key, uint8_t kind);
+
+/**
+ * @brief Get the data of a cached key and pin it.
+ *
+ * @param key Key or sequence name
+ * @param kind IR_CACHE_KIND_*
+ * @param data_out Output, data of the key record or of the .seq file, 4-byte aligned
+ * @param size_out Output, size of the data
+ * @return ESP_OK on success, to be released with ir_cache_release(),
+ *         ESP_ERR_NOT_FOUND if the key isn't cached (read it from flash)
+ */
+esp_err_t ir_cache_get(const char *key, uint8_t kind, const uint8_t **data_out, size_t *size_out);
+
+/**
+ * @brief Unpin data from ir_cache_get().
+ */
+void ir_cache_release(const uint8_t *data);
+
+/**
+ * @brief Drop the cached data of a key, if any, it is read again on its next lookup.
+ */
+void ir_cache_invalidate(const char *key, uint8_t kind);
+
+/**
+ * @brief Drop every cached key and sequence, e.g. after the storage was erased.
+ */
+void ir_cache_clear(void);
+
+/**
+ * @brief Write the usage table to NVS now if it changed.
+ */
+void ir_cache_flush_usage(void);
+
+/**
+ * @brief Get the statistics of the cache.
+ */
+void ir_cache_get_stats(ir_cache_stats_t *stats_out);
+
+/**
+ * @brief Get the usage table, most used first.
+ *
+ * @param usage Output entries
+ * @param max Size of usage, in entries
+ * @return Number of entries written
+ */
+size_t ir_cache_get_usage(ir_cache_usage_t *usage, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
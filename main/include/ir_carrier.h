@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_carrier.h
+ * @brief Carrier frequency and duty measurement of the learned keys.
+ *
+ * The demodulating receiver strips the carrier, so it is measured on a second,
+ * unfiltered photodiode input (CONFIG_IR_CARRIER_GPIO) by an RMT RX channel at
+ * IR_CARRIER_RESOLUTION_HZ. Each capture is a burst of carrier pulses, ended by
+ * the first space; while a learn session runs the done callback folds the pulses
+ * into running totals and re-arms. Pulses cut by the capture or outside
+ * IR_CARRIER_MIN_HZ..IR_CARRIER_MAX_HZ are left out.
+ */
+
+/**
+ * @brief GPIO of the raw photodiode input, -1 if there's none.
+ */
+#define IR_CARRIER_GPIO_NUM CONFIG_IR_CARRIER_GPIO
+
+/**
+ * @brief Resolution of the carrier capture, 0.1 us.
+ */
+#define IR_CARRIER_RESOLUTION_HZ 10000000
+
+/**
+ * @brief Lowest and highest carrier accepted, in Hz.
+ */
+#define IR_CARRIER_MIN_HZ 15000
+#define IR_CARRIER_MAX_HZ 100000
+
+/**
+ * @brief Pulses needed for an estimate.
+ */
+#define IR_CARRIER_MIN_PERIODS 16
+
+/**
+ * @brief Pulses after which a session stops capturing, the estimate doesn't improve.
+ */
+#define IR_CARRIER_MAX_PERIODS 4096
+
+/**
+ * @brief Carrier of a key.
+ */
+typedef struct
+{
+    uint32_t frequency_hz;  /*!< Carrier frequency, 0 if unknown */
+    uint16_t duty_permille; /*!< Share of the period the carrier pulse is on, 0 if unknown */
+    uint16_t periods;       /*!< Pulses the estimate is made of, 0 if not measured */
+} ir_carrier_t;
+
+/**
+ * @brief Running totals of the carrier pulses of a session.
+ */
+typedef struct
+{
+    uint32_t periods;      /*!< Pulses accepted */
+    uint32_t period_ticks; /*!< Sum of their periods */
+    uint32_t on_ticks;     /*!< Sum of their on times */
+    uint32_t rejected;     /*!< Pulses out of range */
+} ir_carrier_acc_t;
+
+/**
+ * @brief Create the capture channel of the raw input.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if CONFIG_IR_CARRIER_GPIO is -1,
+ *         or the error of the RMT driver, e.g. when no RMT memory block is left
+ */
+esp_err_t ir_carrier_init(void);
+
+/**
+ * @brief Start measuring, the totals of the previous session are dropped.
+ */
+void ir_carrier_start(void);
+
+/**
+ * @brief Stop measuring and estimate the carrier of the session.
+ *
+ * @param carrier_out Estimate, zeroed if there's none
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if too few pulses were captured,
+ *         ESP_ERR_NOT_SUPPORTED if there's no raw input
+ */
+esp_err_t ir_carrier_stop(ir_carrier_t *carrier_out);
+
+/**
+ * @brief Fold a capture of the raw input into the totals.
+ *
+ * The first and last symbols are left out, the capture may have cut them.
+ *
+ * @param acc Totals
+ * @param symbols Captured symbols, the carrier pulse on level 1
+ * @param num_symbols Number of symbols
+ * @param resolution_hz Resolution of the capture
+ */
+void ir_carrier_accumulate(ir_carrier_acc_t *acc, const rmt_symbol_word_t *symbols, size_t num_symbols, uint32_t resolution_hz);
+
+/**
+ * @brief Estimate the carrier from the totals.
+ *
+ * Frequencies within 3% of a common carrier (30, 33, 36, 38, 40, 56 kHz) are
+ * snapped to it, others are rounded to 100 Hz.
+ *
+ * @param acc Totals
+ * @param resolution_hz Resolution of the captures
+ * @param carrier_out Estimate, zeroed if there's none
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there are fewer than IR_CARRIER_MIN_PERIODS pulses
+ */
+esp_err_t ir_carrier_estimate(const ir_carrier_acc_t *acc, uint32_t resolution_hz, ir_carrier_t *carrier_out);
+
+#ifdef __cplusplus
+}
+#endif
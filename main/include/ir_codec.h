@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_codec.h
+ * @brief Compact encoding of the raw sub-frames of a key.
+ *
+ * Each half of a symbol (level and duration) is the 16-bit value
+ * level << 15 | duration. A key is encoded as:
+ *
+ *   ir_codec_header_t | dictionary | sub-frame | sub-frame | ...
+ *
+ * and each sub-frame as a varint timediff, a varint symbol count and its
+ * halves, in one of two modes:
+ *
+ * - IR_CODEC_MODE_DICT: the distinct halves of the key are listed once in the
+ *   dictionary (uint16_t each), the halves are bit-packed indices into it. A
+ *   normalized NEC frame has 4 to 6 distinct halves: 3 bits per half instead of 16.
+ * - IR_CODEC_MODE_DELTA: no dictionary, each half is a varint of the zigzag
+ *   difference with the previous duration of the same level, then the level in
+ *   bit 0. For signals with too many distinct durations.
+ *
+ * The encoder picks the smaller mode. The encoding is lossless.
+ */
+
+#define IR_CODEC_MAGIC 0x43505249 /*!< "IRPC" */
+
+#define IR_CODEC_MODE_DICT 1  /*!< Dictionary and bit-packed indices */
+#define IR_CODEC_MODE_DELTA 2 /*!< Zigzag delta varints */
+
+/**
+ * @brief Largest dictionary, indices are up to 8 bits.
+ */
+#define IR_CODEC_DICT_MAX 256
+
+/**
+ * @brief Header of an encoded key, 12 bytes.
+ */
+typedef struct
+{
+    uint32_t magic;     /*!< IR_CODEC_MAGIC */
+    uint16_t frames;    /*!< Number of sub-frames */
+    uint16_t symbols;   /*!< Total number of symbols */
+    uint8_t mode;       /*!< IR_CODEC_MODE_* */
+    uint8_t bits;       /*!< Bits per index, IR_CODEC_MODE_DICT only */
+    uint16_t dict_size; /*!< Entries of the dictionary, IR_CODEC_MODE_DICT only */
+} ir_codec_header_t;
+
+/**
+ * @brief Encode the sub-frames of a list.
+ *
+ * @param list Sub-frames
+ * @param out Output buffer, NULL to get the size only
+ * @param out_size Size of the output buffer
+ * @param mode_out Optional output, IR_CODEC_MODE_* picked
+ * @return Size of the encoding, 0 if the list is too long to be encoded
+ *         (more than 65535 sub-frames or symbols) or if the output buffer is too small
+ */
+size_t ir_codec_encode(const struct ir_learn_sub_list_head *list, uint8_t *out, size_t out_size, uint8_t *mode_out);
+
+/**
+ * @brief Check whether the data of a key (after its header) is encoded.
+ */
+bool ir_codec_is_encoded(const uint8_t *data, size_t size);
+
+/**
+ * @brief Decode an encoded key into a list, the symbols are written straight into the list arena.
+ *
+ * @param data Encoded data
+ * @param size Size of the encoded data
+ * @param out_list Output list of sub-frames
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the data is truncated or corrupted,
+ *         ESP_ERR_NO_MEM if the list can't be allocated
+ */
+esp_err_t ir_codec_decode(const uint8_t *data, size_t size, struct ir_learn_sub_list_head *out_list);
+
+#ifdef __cplusplus
+}
+#endif
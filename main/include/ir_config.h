@@ -7,6 +7,7 @@
 #include "esp_err.h"
 #include "driver/gpio.h"
 #include "ir_learn.h"
+#include "ir_protocol.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,10 +46,55 @@ extern "C" {
 /**
  * @brief Number of times to learn the IR signal before saving.
  */
-#define IR_LEARN_COUNT 1
+#define IR_LEARN_COUNT CONFIG_IR_LEARN_SAMPLES
+
+/**
+ * @brief Default deadline of a learn session, in ms, 0 for none.
+ */
+#define IR_LEARN_TIMEOUT_MS CONFIG_IR_LEARN_TIMEOUT_MS
 
 #define IR_STEP_COUNT_MAX 30
 
+/**
+ * @brief Default IR carrier, for raw keys whose carrier wasn't measured.
+ */
+#define IR_CARRIER_FREQ_HZ 38000
+#define IR_CARRIER_DUTY_PERMILLE 330
+
+/**
+ * @brief Time without transmission before the TX channel is disabled, 0 to keep it enabled.
+ */
+#define IR_TX_IDLE_TIMEOUT_MS CONFIG_IR_TX_IDLE_TIMEOUT_MS
+
+/**
+ * @brief Number of frames queued to the RMT TX channel at once.
+ */
+#define IR_TX_QUEUE_DEPTH 4
+
+/**
+ * @brief Statistics of the TX engine.
+ *
+ * Latency is measured from the send request to the first rmt_transmit().
+ * Cold sends had to power up the TX channel first.
+ */
+typedef struct
+{
+    uint32_t sends;                 /*!< Measured send requests */
+    uint32_t frames;                /*!< Frames queued to the TX channel */
+    uint32_t cold_sends;            /*!< Send requests that found the channel powered down */
+    uint32_t power_ups;             /*!< Number of times the TX channel was enabled */
+    uint32_t carrier_changes;       /*!< Number of carrier reconfigurations */
+    uint32_t first_latency_us;      /*!< Request-to-first-edge latency of the first send since boot, in us */
+    uint32_t last_latency_us;       /*!< Latency of the last send */
+    uint32_t warm_max_latency_us;   /*!< Max latency with the channel already enabled */
+    uint32_t cold_max_latency_us;   /*!< Max latency including the power-up */
+    uint64_t warm_total_latency_us; /*!< Sum of the warm latencies */
+    uint32_t step_sequences;        /*!< Step sequences sent */
+    uint32_t step_last_max_jitter_us; /*!< Max lateness of a step in the last sequence */
+    uint32_t step_max_jitter_us;    /*!< Max lateness of a step since boot */
+} ir_tx_stats_t;
+
+
 /**
  * @brief Starts the IR learning task and initializes NVS and RMT peripherals.
  * 
@@ -61,22 +107,38 @@ struct ir_learn_sub_list_head;
 /**
  * @brief Sends the learned IR command.
  * 
- * This function transmits the IR command using the RMT peripheral.
- * It retrieves the IR data from storage and sends it through the configured GPIO.
+ * All sub-frames are queued to the RMT TX channel back to back, the time
+ * differences between them are sent as idle symbols. Returns once the
+ * hardware has sent the last one.
  * 
  * @param rmt_out Pointer to the list of IR symbols to be transmitted.
  */
 void ir_send_raw(struct ir_learn_sub_list_head *rmt_out);
 
 /**
- * @brief Sends a step of the IR command.
+ * @brief Sends a key stored as a protocol record.
  * 
- * This function sends a single step of an IR command based on the key name.
- * It loads the timing data from storage and transmits the corresponding IR signal.
+ * The symbols are synthesized by the protocol encoder while transmitting,
+ * nothing is loaded or allocated per frame.
  * 
- * @param key_name The name of the IR command to send.
+ * @param record Protocol record of the key, see ir_learn_load_record().
  */
-void ir_send_step(const char *key_name);
+void ir_send_protocol(const ir_protocol_record_t *record);
+
+/**
+ * @brief Sends a step sequence.
+ * 
+ * Step N + 1 is sent at an absolute deadline from the start of the sequence,
+ * given by the .delay file of the key, with an esp_timer one-shot. Step N + 1
+ * is loaded from flash while step N is transmitting, so neither the load nor
+ * the transmission shifts the following steps. The lateness of every step is
+ * logged and kept in ir_tx_stats_t.
+ * 
+ * @param key_name The name of the step sequence.
+ * @return ESP_OK once every step is sent, ESP_ERR_INVALID_STATE if stopped by the remote.
+ */
+esp_err_t ir_send_step(const char *key_name);
+
 
 /**
  * @brief Matches an IR command from the SPIFFS storage.
@@ -97,21 +159,60 @@ void ir_white_screen(void);
  */
 void ir_reset_screen(void);
 
+/**
+ * @brief Creates the TX channel and encoders, once at startup.
+ * 
+ * The channel and encoders stay allocated for the lifetime of the application,
+ * rmt_tx_start() and rmt_tx_stop() only power the channel up and down.
+ * 
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t ir_tx_init(void);
+
+/**
+ * @brief Applies a carrier to the TX channel, only if it differs from the current one.
+ * 
+ * @param frequency_hz Carrier frequency in Hz.
+ * @param duty_permille Carrier duty, in 1/1000 of the period.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t ir_tx_set_carrier(uint32_t frequency_hz, uint16_t duty_permille);
+
 /**
  * @brief Starts the RMT transmission.
  * 
- * This function initializes and starts the RMT peripheral for IR transmission.
- * It prepares the RMT channel and sets the GPIO for output.
+ * Enables the TX channel if it was powered down, does nothing otherwise.
  */
 void rmt_tx_start(void);
 
 /**
  * @brief Stops the RMT transmission.
  * 
- * This function stops the RMT peripheral and releases the resources used for IR transmission.
+ * Disables the TX channel after the idle timeout. The channel and encoders are kept.
  */
 void rmt_tx_stop(void);
 
+/**
+ * @brief Waits until every queued frame has been sent.
+ * 
+ * Completion is reported by the on_trans_done callback of the TX channel.
+ */
+void ir_tx_wait_done(void);
+
+/**
+ * @brief Arms the latency measurement of the next transmission.
+ * 
+ * @param request_time esp_timer time of the send request, 0 for now.
+ */
+void ir_tx_mark_request(int64_t request_time);
+
+/**
+ * @brief Gets the statistics of the TX engine.
+ * 
+ * @param stats_out Output statistics.
+ */
+void ir_tx_get_stats(ir_tx_stats_t *stats_out);
+
  /**
   * @brief Sends an IR command based on the provided command string.
   * This function is a wrapper for sending IR commands using the RMT peripheral.
@@ -126,10 +227,11 @@ void ir_send_command(const char *command);
  * 
  * @param mode The mode of the IR command (e.g., "normal", "step").
  * @param name The name of the IR command to be learned.
+ * @param timeout_ms Deadline of the session (of each step), 0 for IR_LEARN_TIMEOUT_MS.
  * @return true if learning was successful, false otherwise.
  */
 
-bool ir_learn_command(const char *mode, const char* name);
+bool ir_learn_command(const char *mode, const char* name, uint32_t timeout_ms);
 
 /**
  * @brief Saves the learned IR command to storage.
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_db.h
+ * @brief Log-structured database of the learned IR keys.
+ *
+ * All keys are kept in one raw data partition (IR_DB_PARTITION_LABEL), as a
+ * ring of append-only records:
+ *
+ *   ir_db_record_t | key name | data
+ *
+ * The key name and the data start on a 4-byte boundary. The data is the content
+ * of a key as ir_storage.c lays it out: an optional ir_key_header_t, then a
+ * protocol record or raw sub-frames.
+ *
+ * A record is programmed with its state word erased, then committed by
+ * programming IR_DB_STATE_VALID. Saving, renaming or deleting a key appends the
+ * new record first and then clears the state word of the old one, so a reset at
+ * any point leaves the old or the new version of the key.
+ *
+ * The partition is scanned once at boot: the data of each committed record is
+ * checked against its CRC, a corrupted record is ended and the previous version
+ * of its key, if still committed, is kept. The newest committed record of each
+ * key goes into a RAM index sorted by key hash (ir_db_entry_t, 12 bytes per
+ * key). Lookup, listing and match candidate enumeration use this index only.
+ *
+ * Dead records are reclaimed from the oldest end of the ring by a background
+ * task: the live records found there are appended again and the sectors left
+ * behind are erased. A save that doesn't fit runs the same compaction first.
+ *
+ * The partition is also mapped in the data cache once, at init. Reads are then
+ * copies from the cache, and ir_db_view() hands out the data of a key in place:
+ * no heap, no copy, the RMT encoder reads the symbols straight from flash. No
+ * sector is erased while a view is held, the compaction waits for the release.
+ */
+
+#define IR_DB_PARTITION_LABEL "irdb"
+
+#define IR_DB_MAGIC 0x42445249 /*!< "IRDB" */
+
+/**
+ * @brief Record states, bits are only ever cleared.
+ */
+#define IR_DB_STATE_ERASED 0xFFFFFFFF /*!< Written, not committed */
+#define IR_DB_STATE_VALID 0x5A5A5A5A  /*!< Committed */
+#define IR_DB_STATE_DEAD 0x00000000   /*!< Replaced or deleted */
+
+#define IR_DB_KIND_KEY 1 /*!< A key */
+#define IR_DB_KIND_PAD 2 /*!< Filler up to the end of the partition, the ring goes on at offset 0 */
+
+/**
+ * @brief Flags of a key.
+ */
+#define IR_DB_FLAG_CARRIER (1 << 0)  /*!< The data starts with an ir_key_header_t */
+#define IR_DB_FLAG_DATA_CRC (1 << 1) /*!< data_crc holds the CRC32 of the data, set by ir_db_write() */
+
+/**
+ * @brief Maximum number of keys in the RAM index.
+ */
+#define IR_DB_KEYS_MAX 256
+
+/**
+ * @brief Largest data of a key, in bytes.
+ */
+#define IR_DB_DATA_MAX (8 * 1024)
+
+/**
+ * @brief Longest wait of a compaction for the views to be released, in ms.
+ */
+#define IR_DB_VIEW_WAIT_MS 5000
+
+/**
+ * @brief Record header, 32 bytes, followed by the key name and the data.
+ */
+typedef struct
+{
+    uint32_t magic;      /*!< IR_DB_MAGIC */
+    uint32_t seq;        /*!< Write sequence number, the newest record of a key wins */
+    uint32_t key_hash;   /*!< ir_db_hash() of the key name */
+    uint32_t data_len;   /*!< Size of the data, in bytes */
+    uint8_t kind;        /*!< IR_DB_KIND_* */
+    uint8_t key_len;     /*!< Length of the key name, without terminator */
+    uint8_t protocol;    /*!< ir_protocol_t of a protocol record, IR_PROTOCOL_UNKNOWN for raw symbols */
+    uint8_t flags;       /*!< IR_DB_FLAG_* */
+    uint32_t data_crc;   /*!< CRC32 of the data if IR_DB_FLAG_DATA_CRC is set, 0 in records of older firmware */
+    uint32_t header_crc; /*!< CRC32 of the fields above and of the key name */
+    uint32_t state;      /*!< IR_DB_STATE_*, not covered by the CRC */
+} ir_db_record_t;
+
+/**
+ * @brief Entry of the RAM index, 12 bytes.
+ */
+typedef struct
+{
+    uint32_t key_hash; /*!< ir_db_hash() of the key name */
+    uint32_t offset;   /*!< Offset of the record in the partition */
+    uint16_t length;   /*!< Size of the data, in bytes */
+    uint8_t protocol;  /*!< ir_protocol_t of a protocol record, IR_PROTOCOL_UNKNOWN for raw symbols */
+    uint8_t flags;     /*!< IR_DB_FLAG_* */
+} ir_db_entry_t;
+
+/**
+ * @brief Usage of the partition and counters.
+ */
+typedef struct
+{
+    uint32_t size;       /*!< Size of the partition */
+    uint32_t used;       /*!< Bytes from the oldest record to the newest one */
+    uint32_t live;       /*!< Bytes of the live records */
+    uint32_t free;       /*!< Erased bytes ready for appends */
+    uint16_t keys;       /*!< Keys in the index */
+    uint32_t appends;    /*!< Records written by saves and renames */
+    uint32_t relocated;  /*!< Live records appended again by the compaction */
+    uint32_t erases;     /*!< Sectors erased by the compaction */
+    uint32_t gc_runs;    /*!< Compaction runs, background and foreground */
+    uint32_t scan_us;    /*!< Time of the boot scan */
+    uint16_t corrupt;    /*!< Records dropped by the boot scan for a bad data CRC */
+    uint16_t views;      /*!< Views held, see ir_db_view() */
+    bool mapped;         /*!< The partition is mapped, views are available */
+} ir_db_stats_t;
+
+/**
+ * @brief Data of a key, read in place from the mapped partition.
+ */
+typedef struct
+{
+    const uint8_t *data; /*!< Data of the key, 4-byte aligned, in the flash cache */
+    size_t size;         /*!< Size of the data, in bytes */
+    uint8_t protocol;    /*!< ir_protocol_t of a protocol record, IR_PROTOCOL_UNKNOWN for raw symbols */
+    uint8_t flags;       /*!< IR_DB_FLAG_* */
+} ir_db_view_t;
+
+/**
+ * @brief Called for each key by ir_db_foreach().
+ *
+ * @return false to stop
+ */
+typedef bool (*ir_db_foreach_cb_t)(const char *key, const ir_db_entry_t *entry, void *arg);
+
+/**
+ * @brief Mount the database: scan the partition, build the RAM index and start the compaction task.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no IR_DB_PARTITION_LABEL partition
+ */
+esp_err_t ir_db_init(void);
+
+/**
+ * @brief Save a key, replacing the previous version if there's one.
+ *
+ * @param key Key name, shorter than IR_KEY_MAX_LEN
+ * @param data Data of the key
+ * @param size Size of the data, up to IR_DB_DATA_MAX
+ * @param protocol ir_protocol_t of a protocol record, IR_PROTOCOL_UNKNOWN for raw symbols
+ * @param flags IR_DB_FLAG_*
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the partition or the index is full
+ */
+esp_err_t ir_db_write(const char *key, const void *data, size_t size, uint8_t protocol, uint8_t flags);
+
+/**
+ * @brief Look up a key in the RAM index.
+ *
+ * @param key Key name
+ * @param entry_out Optional output, index entry of the key
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no such key
+ */
+esp_err_t ir_db_find(const char *key, ir_db_entry_t *entry_out);
+
+/**
+ * @brief Check whether a key exists.
+ */
+bool ir_db_exists(const char *key);
+
+/**
+ * @brief Read the data of a key.
+ *
+ * @param key Key name
+ * @param offset Offset in the data
+ * @param buf Output buffer
+ * @param size Size of the buffer
+ * @param read_out Optional output, bytes read, less than size at the end of the data
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no such key
+ */
+esp_err_t ir_db_read(const char *key, size_t offset, void *buf, size_t size, size_t *read_out);
+
+/**
+ * @brief Get the data of a key in place, without a copy.
+ *
+ * The data stays readable until ir_db_view_release(), even if the key is saved
+ * again or deleted meanwhile. Saves that have to compact wait for the release,
+ * up to IR_DB_VIEW_WAIT_MS, so release views soon and don't save while holding one.
+ *
+ * @param key Key name
+ * @param view_out Output, to be released with ir_db_view_release()
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no such key,
+ *         ESP_ERR_NOT_SUPPORTED if the partition isn't mapped (read the key with ir_db_read())
+ */
+esp_err_t ir_db_view(const char *key, ir_db_view_t *view_out);
+
+/**
+ * @brief Release a view from ir_db_view(), does nothing if view->data is NULL.
+ */
+void ir_db_view_release(ir_db_view_t *view);
+
+/**
+ * @brief Delete a key.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no such key
+ */
+esp_err_t ir_db_delete(const char *key);
+
+/**
+ * @brief Rename a key.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if old_key doesn't exist,
+ *         ESP_ERR_INVALID_STATE if new_key already exists
+ */
+esp_err_t ir_db_rename(const char *old_key, const char *new_key);
+
+/**
+ * @brief Call cb for each key, by key hash then by name.
+ *
+ * The database isn't locked while cb runs, cb may read and write keys: each step
+ * looks up the key after the last one, so keys added, deleted or moved meanwhile
+ * don't make the walk skip or repeat the others.
+ *
+ * @return Number of keys visited
+ */
+size_t ir_db_foreach(ir_db_foreach_cb_t cb, void *arg);
+
+/**
+ * @brief Number of keys.
+ */
+size_t ir_db_count(void);
+
+/**
+ * @brief Erase the whole partition.
+ */
+esp_err_t ir_db_format(void);
+
+/**
+ * @brief Compact the whole ring now, instead of waiting for the background task.
+ */
+esp_err_t ir_db_compact(void);
+
+/**
+ * @brief Usage of the partition and counters.
+ */
+void ir_db_get_stats(ir_db_stats_t *stats_out);
+
+/**
+ * @brief Hash of a key name, FNV-1a.
+ */
+uint32_t ir_db_hash(const char *key);
+
+#ifdef __cplusplus
+}
+#endif
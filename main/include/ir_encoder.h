@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 #include "driver/rmt_encoder.h"
+#include "ir_protocol.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,9 +21,25 @@ typedef struct {
     uint32_t resolution; /*!< Encoder resolution, in Hz */
 } ir_encoder_config_t;
 
+/**
+ * @brief Primary data of the IR encoders, one transmission.
+ *
+ * The gap is sent as idle (level 0) symbols before the frame, so back to back
+ * transmissions keep the inter-frame timing of the hardware, to the microsecond.
+ * The descriptor must stay valid until the transmission is done.
+ */
+typedef struct {
+    uint32_t gap_us;                  /*!< Idle time before the frame, in us */
+    const rmt_symbol_word_t *symbols; /*!< Raw symbols, used by the raw encoder */
+    size_t num_symbols;               /*!< Number of raw symbols */
+    ir_protocol_frame_t frame;        /*!< Decoded frame, used by the protocol encoder */
+} ir_encoder_frame_t;
+
 /**
  * @brief Create RMT encoder for encoding raw symbols into RMT symbols.
  *
+ * The primary data passed to rmt_transmit() is one ir_encoder_frame_t, data_size is sizeof(ir_encoder_frame_t).
+ *
  * @param[in] config Encoder configuration
  * @param[out] ret_encoder Returned encoder handle
  * @return
@@ -33,6 +50,22 @@ typedef struct {
  */
 esp_err_t ir_encoder_new(const ir_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
 
+/**
+ * @brief Create RMT encoder that synthesizes the symbols of a decoded frame.
+ *
+ * The primary data passed to rmt_transmit() is one ir_encoder_frame_t, data_size is sizeof(ir_encoder_frame_t).
+ * The symbols are generated in the encode callback, nothing is allocated per transmission.
+ *
+ * @param[in] config Encoder configuration, the resolution must be 1 MHz
+ * @param[out] ret_encoder Returned encoder handle
+ * @return
+ *      - ESP_OK                    Create protocol encoder successfully
+ *      - ESP_ERR_INVALID_ARG       Create protocol encoder failed because of invalid argument
+ *      - ESP_ERR_NO_MEM            Create protocol encoder failed because out of memory
+ *      - ESP_FAIL                  Create protocol encoder failed because of other error
+ */
+esp_err_t ir_protocol_encoder_new(const ir_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
+
 #ifdef __cplusplus
 }
 #endif
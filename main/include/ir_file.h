@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_file.h
+ * @brief Crash-safe SPIFFS files with a checksummed header.
+ *
+ * A file is written as:
+ *
+ *   ir_file_header_t | payload
+ *
+ * into a temporary file next to it (same name, ".tmp" extension), which is
+ * flushed and synced, then renamed over the target. SPIFFS rename doesn't
+ * replace, so the target is removed first: a reset in between leaves only the
+ * temporary file, which the next read checks and renames back. A reset at any
+ * other point leaves the old file in place.
+ *
+ * Reads check the header against the size of the file before allocating
+ * anything, then the CRC32 of the payload. Files written before the header
+ * existed are reported as ESP_ERR_INVALID_VERSION for the caller to read the
+ * old way.
+ */
+
+#define IR_FILE_MAGIC 0x46465249 /*!< "IRFF" */
+#define IR_FILE_VERSION 1
+
+#define IR_FILE_TYPE_DELAY 1 /*!< "<key>.delay", int32_t delays in ms */
+#define IR_FILE_TYPE_ALIAS 2 /*!< ir_alias.json, JSON text */
+
+/**
+ * @brief Largest payload, in bytes.
+ */
+#define IR_FILE_PAYLOAD_MAX (16 * 1024)
+
+/**
+ * @brief Longest path of a file, terminator included, ".tmp" path included.
+ */
+#define IR_FILE_PATH_MAX 96
+
+/**
+ * @brief File header, 16 bytes.
+ */
+typedef struct
+{
+    uint32_t magic;   /*!< IR_FILE_MAGIC */
+    uint16_t version; /*!< IR_FILE_VERSION */
+    uint16_t type;    /*!< IR_FILE_TYPE_* */
+    uint32_t length;  /*!< Size of the payload, the file is exactly header + payload */
+    uint32_t crc;     /*!< CRC32 of the payload */
+} ir_file_header_t;
+
+/**
+ * @brief Write a file atomically.
+ *
+ * @param path Target path, with an extension, shorter than IR_FILE_PATH_MAX
+ * @param type IR_FILE_TYPE_*
+ * @param data Payload
+ * @param size Size of the payload, up to IR_FILE_PAYLOAD_MAX
+ * @return ESP_OK once the new file is in place, ESP_FAIL if a write failed (the old file is kept)
+ */
+esp_err_t ir_file_write(const char *path, uint16_t type, const void *data, size_t size);
+
+/**
+ * @brief Read and check a file.
+ *
+ * @param path Path of the file
+ * @param type Expected IR_FILE_TYPE_*
+ * @param data_out Output, payload allocated with malloc() plus a terminating '\0', to be freed by the caller
+ * @param size_out Output, size of the payload
+ * @return
+ *          - ESP_OK                  Success
+ *          - ESP_ERR_NOT_FOUND       No such file
+ *          - ESP_ERR_INVALID_VERSION No header, the file predates it
+ *          - ESP_ERR_INVALID_SIZE    Truncated file or wrong type
+ *          - ESP_ERR_INVALID_CRC     Corrupted payload
+ *          - ESP_ERR_NO_MEM          Out of memory
+ */
+esp_err_t ir_file_read(const char *path, uint16_t type, uint8_t **data_out, size_t *size_out);
+
+/**
+ * @brief Check a whole file image in RAM, as ir_file_read() does.
+ *
+ * @param payload_out Optional output, start of the payload in buf
+ * @return Same as ir_file_read(), without ESP_ERR_NOT_FOUND and ESP_ERR_NO_MEM
+ */
+esp_err_t ir_file_check(const uint8_t *buf, size_t size, uint16_t type, const uint8_t **payload_out);
+
+/**
+ * @brief Temporary path of a file: its extension replaced by ".tmp".
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_SIZE if it doesn't fit in size bytes
+ */
+esp_err_t ir_file_tmp_path(const char *path, char *tmp_path, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ir_learn.h"
+#include "ir_rx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_hold.h
+ * @brief Repeat and hold detection of the received frames.
+ *
+ * A held button sends either repeat codes (NEC: 9 ms + 2.25 ms) or copies of
+ * its frame. The first frame of a press is matched against the stored keys;
+ * the frames that follow it within IR_HOLD_TIMEOUT_MS and repeat it resolve to
+ * the key of the press without another lookup. Past IR_HOLD_DELAY_MS they are
+ * reported as held, at most every IR_HOLD_INTERVAL_MS, for auto-repeat.
+ */
+
+/**
+ * @brief Largest gap between two frames of a held button, in ms.
+ */
+#define IR_HOLD_TIMEOUT_MS CONFIG_IR_HOLD_TIMEOUT_MS
+
+/**
+ * @brief Time a button is held before its first held event, in ms.
+ */
+#define IR_HOLD_DELAY_MS CONFIG_IR_HOLD_DELAY_MS
+
+/**
+ * @brief Shortest time between two held events, in ms.
+ */
+#define IR_HOLD_INTERVAL_MS CONFIG_IR_HOLD_INTERVAL_MS
+
+/**
+ * @brief Longest frame kept to recognize raw full-frame repeats, in symbols.
+ */
+#define IR_HOLD_MAX_SYMBOLS 128
+
+/**
+ * @brief What a received frame is to the current press.
+ */
+typedef enum
+{
+    IR_HOLD_NONE,   /*!< Too short to be a key and not a repeat, ignore it */
+    IR_HOLD_PRESS,  /*!< First frame of a new press, match it */
+    IR_HOLD_REPEAT, /*!< Repeat of the current press, nothing to do */
+    IR_HOLD_HELD,   /*!< Repeat of the current press to dispatch as a held event */
+} ir_hold_kind_t;
+
+/**
+ * @brief Counters of the hold detection.
+ */
+typedef struct
+{
+    uint32_t presses;        /*!< Frames that started a press */
+    uint32_t repeats;        /*!< Frames resolved as repeats of the current press */
+    uint32_t held_events;    /*!< Repeats reported as held */
+    uint32_t orphan_repeats; /*!< Repeat codes received with no press to repeat */
+    uint16_t longest_hold;   /*!< Most repeats of one press */
+} ir_hold_stats_t;
+
+/**
+ * @brief Classify a received frame and update the current press.
+ *
+ * @param frame Received frame, in the receiver polarity
+ * @return What the frame is to the current press
+ */
+ir_hold_kind_t ir_hold_feed(const ir_rx_frame_t *frame);
+
+/**
+ * @brief Set the key the current press resolved to.
+ *
+ * @param key Key to auto-repeat, NULL if the press matched none
+ */
+void ir_hold_set_key(const char *key);
+
+/**
+ * @brief Get the key of the current press.
+ *
+ * @param key_out Output buffer, IR_KEY_MAX_LEN bytes
+ * @param repeats_out Optional output, repeats of the press so far
+ * @return true if the press resolved to a key
+ */
+bool ir_hold_get_key(char *key_out, uint16_t *repeats_out);
+
+/**
+ * @brief End the current press, the next frame starts a new one.
+ */
+void ir_hold_reset(void);
+
+/**
+ * @brief Get the counters of the hold detection.
+ */
+void ir_hold_get_stats(ir_hold_stats_t *stats_out);
+
+#ifdef __cplusplus
+}
+#endif
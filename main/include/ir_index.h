@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_index.h
+ * @brief In-RAM signature index of the learned IR keys.
+ *
+ * Every key of the key database (see ir_db.h) gets a compact fingerprint. Keys of a known
+ * protocol (see ir_protocol.h) are reduced to their 8-byte decoded frame and
+ * matched with an integer compare. Other keys keep their sub-frame count,
+ * symbol count, a hash of the frame layout and their durations (two bytes per
+ * level), compared within IR_TOLERANCE_US. Incoming frames are matched
+ * against the fingerprints only, so matching never touches flash.
+ *
+ * Raw keys on a grid are also hashed by their canonical form (see ir_normalize.h);
+ * a lookup tries the key of the same canonical hash before the keys of the same layout.
+ */
+
+/**
+ * @brief Quantization step of the preamble prefilter, in microseconds.
+ *
+ * 80 us * 255 covers the whole RMT_MAX_RANGE_TIME window in one byte.
+ */
+#define IR_INDEX_QUANTUM_US 80
+
+/**
+ * @brief Number of hash buckets used to group keys with the same frame layout.
+ */
+#define IR_INDEX_BUCKETS 32
+
+/**
+ * @brief Number of leading symbols compared before the full compare of a raw key.
+ */
+#define IR_INDEX_PREAMBLE_SYMBOLS 4
+
+/**
+ * @brief Counters of the matcher stages.
+ */
+typedef struct
+{
+    uint32_t lookups;          /*!< Calls to ir_index_match() */
+    uint32_t candidates;       /*!< Entries compared */
+    uint32_t header_rejects;   /*!< Rejected on signature, decoded frame or sub-frame and symbol counts */
+    uint32_t preamble_rejects; /*!< Rejected on the first IR_INDEX_PREAMBLE_SYMBOLS symbols */
+    uint32_t full_compares;    /*!< Entries compared symbol by symbol */
+    uint32_t matches;          /*!< Entries matched */
+    uint32_t canon_hits;       /*!< Lookups matched by the canonical hash, without the layout scan */
+    uint64_t total_us;         /*!< Time spent in ir_index_match() */
+    uint32_t max_us;           /*!< Longest ir_index_match() */
+} ir_index_match_stats_t;
+
+/**
+ * @brief Build the index from every key of the key database.
+ *
+ * @note Must be called once after the key database is mounted.
+ * @return ESP_OK on success, or appropriate error code
+ */
+esp_err_t ir_index_init(void);
+
+/**
+ * @brief Drop every entry and load every key again.
+ *
+ * @return ESP_OK on success, or appropriate error code
+ */
+esp_err_t ir_index_rebuild(void);
+
+/**
+ * @brief Insert or replace the fingerprint of a key.
+ *
+ * @param key Key name (without ".ir" extension)
+ * @param list IR data saved under this key
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the entry can't be allocated
+ */
+esp_err_t ir_index_update(const char *key, const struct ir_learn_sub_list_head *list);
+
+/**
+ * @brief Remove a key from the index.
+ *
+ * @param key Key name (without ".ir" extension)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the key isn't indexed
+ */
+esp_err_t ir_index_remove(const char *key);
+
+/**
+ * @brief Rename an indexed key.
+ *
+ * @param old_key Existing key name
+ * @param new_key New key name
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the old key isn't indexed
+ */
+esp_err_t ir_index_rename(const char *old_key, const char *new_key);
+
+/**
+ * @brief Remove all entries, e.g. after the partition has been formatted.
+ */
+void ir_index_clear(void);
+
+/**
+ * @brief Find the first key matching the received IR data.
+ *
+ * Only keys with the same frame layout are compared.
+ *
+ * @param data Received IR data
+ * @param matched_key_out Output buffer for the matched key (can be NULL)
+ * @param out_len Size of matched_key_out
+ * @return true if a match is found, false otherwise
+ */
+bool ir_index_match(const struct ir_learn_sub_list_head *data, char *matched_key_out, size_t out_len);
+
+/**
+ * @brief Check the received IR data against one key.
+ *
+ * @param data Received IR data
+ * @param key Key name to compare with
+ * @return true if the key exists and matches, false otherwise
+ */
+bool ir_index_match_key(const struct ir_learn_sub_list_head *data, const char *key);
+
+/**
+ * @brief Number of indexed keys.
+ */
+size_t ir_index_count(void);
+
+/**
+ * @brief Signature of IR data (decoded frame or layout), as used to bucket the index.
+ *
+ * Two frames can only match if their signatures are equal.
+ *
+ * @param data IR data
+ * @return Signature hash
+ */
+uint32_t ir_index_signature(const struct ir_learn_sub_list_head *data);
+
+/**
+ * @brief Layout signature of an indexed key.
+ *
+ * @param key Key name
+ * @param signature_out Signature of the key
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the key isn't indexed
+ */
+esp_err_t ir_index_get_signature(const char *key, uint32_t *signature_out);
+
+/**
+ * @brief Get the counters of the matcher stages.
+ *
+ * @param stats_out Output counters
+ */
+void ir_index_get_match_stats(ir_index_match_stats_t *stats_out);
+
+/**
+ * @brief Counter bumped on every change of the index.
+ *
+ * Lets caches built on top of the index detect stale signatures.
+ */
+uint32_t ir_index_generation(void);
+
+#ifdef __cplusplus
+}
+#endif
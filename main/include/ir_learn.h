@@ -15,6 +15,8 @@
 #include "freertos/event_groups.h"
 #include "freertos/semphr.h"
 #include "ir_config.h"
+#include "ir_learn_acc.h"
+#include "ir_carrier.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -59,7 +61,9 @@ extern "C"
         IR_EVENT_SEND_STEP,
         IR_EVENT_SET_NAME,
         IR_EVENT_RESET,
-        IR_EVENT_EXIT
+        IR_EVENT_EXIT,
+        IR_EVENT_PACK_STEP, /*!< Pack the learned steps of key_name_step into a .seq file */
+        IR_EVENT_HELD       /*!< The received key is held, key is the alias to auto-repeat */
     } ir_event_t;
 
     // Maximum length of the IR key used for identifying learned signals.
@@ -71,8 +75,51 @@ extern "C"
         char key[IR_KEY_MAX_LEN]; /*!< Key name for IR command */
         char key_name_step[IR_KEY_MAX_LEN]; /*!< Key name for IR learn step */
         struct ir_learn_sub_list_head *data;
+        int64_t request_time; /*!< esp_timer time of the send request, 0 if unknown */
+        uint8_t learn_count; /*!< Presses to learn for IR_EVENT_LEARN_NORMAL, 0 for IR_LEARN_COUNT */
+        uint16_t repeats;    /*!< Repeat frames received so far for IR_EVENT_HELD */
+        ir_carrier_t carrier; /*!< Measured carrier for IR_EVENT_LEARN_DONE, zeroed if unknown */
+        uint32_t timeout_ms;  /*!< Deadline of a learn session, 0 for IR_LEARN_TIMEOUT_MS */
     } ir_event_cmd_t;
 
+    /**
+     * @brief Stage of a learn session, as reported to the progress callbacks.
+     */
+    typedef enum
+    {
+        IR_LEARN_PROGRESS_START,   /*!< Waiting for the first press */
+        IR_LEARN_PROGRESS_SAMPLE,  /*!< A sub-frame of a press was received */
+        IR_LEARN_PROGRESS_DONE,    /*!< The key was learned */
+        IR_LEARN_PROGRESS_FAIL,    /*!< The presses couldn't be learned */
+        IR_LEARN_PROGRESS_TIMEOUT, /*!< The deadline passed without a press */
+        IR_LEARN_PROGRESS_CANCEL,  /*!< Ended by ir_learn_cancel(), a stop signal or a new request */
+    } ir_learn_progress_state_t;
+
+    /**
+     * @brief Progress of a learn session.
+     */
+    typedef struct
+    {
+        ir_learn_progress_state_t state;
+        char key[IR_KEY_MAX_LEN]; /*!< Key learned, <name>_step<N> for a step */
+        uint8_t sample;           /*!< Presses received */
+        uint8_t samples;          /*!< Presses the session waits for */
+        uint8_t sub;              /*!< Sub-frames received of the current press */
+        uint16_t symbols;         /*!< Symbols of the last sub-frame */
+        uint32_t max_variance;    /*!< Largest variance of a duration over the presses so far, in us^2 */
+        uint32_t remaining_ms;    /*!< Time left before the deadline, 0 if the session has none */
+    } ir_learn_progress_t;
+
+    /**
+     * @brief Learn progress callback, run by the learn task: it must not block.
+     */
+    typedef void (*ir_learn_progress_cb_t)(const ir_learn_progress_t *progress);
+
+    /**
+     * @brief Most progress callbacks registered at once.
+     */
+#define IR_LEARN_PROGRESS_CB_MAX 4
+
     /**
      * @brief An element in the list of infrared (IR) learn data packets.
      *
@@ -86,15 +133,49 @@ extern "C"
     };
 
     /**
-     * @cond Doxy command to hide preprocessor definitions from docs
-     *
+     * @brief Default size of an arena chunk of a sub-frame list, in bytes.
+     */
+#define IR_LEARN_ARENA_CHUNK_SIZE 1024
+
+    struct ir_learn_arena_t;
+
+    /**
      * @brief The head of a singly-linked list for IR learn cmd packets.
      *
+     * Nodes and symbols are carved from arena chunks owned by the list, so
+     * ir_learn_clean_sub_data() frees a whole command with one free per chunk.
+     * The SLIST_* read macros work on it; initialize it with ir_learn_init_sub_list()
+     * and add nodes with ir_learn_add_sub_list_node() only.
+     */
+    struct ir_learn_sub_list_head
+    {
+        struct ir_learn_sub_list_t *slh_first; /*!< First sub-frame */
+        struct ir_learn_sub_list_t *tail;      /*!< Last sub-frame, for O(1) append */
+        struct ir_learn_arena_t *arena;        /*!< Chunks holding the nodes and symbols, newest first */
+    };
+
+    /**
+     * @brief Initialize an empty sub-frame list.
      */
-    SLIST_HEAD(ir_learn_sub_list_head, ir_learn_sub_list_t);
+    static inline void ir_learn_init_sub_list(struct ir_learn_sub_list_head *sub_head)
+    {
+        sub_head->slh_first = NULL;
+        sub_head->tail = NULL;
+        sub_head->arena = NULL;
+    }
+
     /**
-     * @endcond
+     * @brief Memory statistics of the sub-frame lists.
      */
+    typedef struct
+    {
+        uint32_t nodes;         /*!< Sub-frames appended */
+        uint32_t chunk_allocs;  /*!< Arena chunks allocated */
+        uint32_t chunk_frees;   /*!< Arena chunks freed */
+        uint32_t live_bytes;    /*!< Bytes held by live chunks */
+        uint32_t peak_bytes;    /*!< Highest value of live_bytes */
+        uint32_t failed_allocs; /*!< Chunk allocations that failed */
+    } ir_learn_mem_stats_t;
 
     /**
      * @brief The head of a list of infrared (IR) learn data packets.
@@ -147,20 +228,20 @@ extern "C"
 
     typedef struct
     {
-        rmt_channel_handle_t channel_rx; /*!< rmt rx channel handler */
-        rmt_rx_done_event_data_t rmt_rx; /*!< received RMT symbols */
-
         struct ir_learn_list_head learn_list;
         struct ir_learn_sub_list_head learn_result;
+        ir_learn_acc_t learn_acc; /*!< Running totals of the captures, averaged into learn_result */
+        ir_learn_acc_stats_t learn_stats; /*!< Summary of the last learn session */
+        ir_carrier_t learn_carrier; /*!< Carrier measured during the last learn session */
 
         EventGroupHandle_t learn_event;
         SemaphoreHandle_t rmt_mux;
-        QueueHandle_t receive_queue; /*!< A queue used to send the raw data to the task from the ISR */
         bool running;
-        uint32_t pre_time;
+        int64_t pre_time; /*!< Capture time of the previous frame, in us */
         uint8_t learn_count;
         uint8_t learned_count;
         uint8_t learned_sub;
+        bool cancelled; /*!< The last session was ended by a stop signal or a new command */
 
     } ir_learn_t;
 
@@ -231,6 +312,21 @@ extern "C"
     esp_err_t ir_learn_add_sub_list_node(struct ir_learn_sub_list_head *sub_head,
                                          uint32_t timediff, const rmt_rx_done_event_data_t *symbol);
 
+    /**
+     * @brief Add a sub step list node whose symbols are written by the caller.
+     *
+     * @param[in] sub_head IR learn sub step list head
+     * @param[in] timediff Time diff between each sub step
+     * @param[in] num_symbols Number of symbols of the sub step
+     * @param[out] symbols_out Symbols of the node, in the list arena, to be filled in
+     * @return
+     *          - ESP_OK                  Create learn list success.
+     *          - ESP_ERR_NO_MEM          Memory allocation failed.
+     *
+     */
+    esp_err_t ir_learn_alloc_sub_list_node(struct ir_learn_sub_list_head *sub_head, uint32_t timediff,
+                                           size_t num_symbols, rmt_symbol_word_t **symbols_out);
+
     /**
      * @brief Delete IR learn list node, will recursively delete sub steps.
      *
@@ -252,7 +348,29 @@ extern "C"
     esp_err_t ir_learn_clean_sub_data(struct ir_learn_sub_list_head *sub_head);
 
     /**
-     * @brief Add IR learn list node, every new learn list will create it.
+     * @brief Reserve arena space for sub-frames that are about to be added.
+     *
+     * Lets a loader whose total size is known use a single chunk.
+     *
+     * @param[in] sub_head IR learn sub list head
+     * @param[in] frames Number of sub-frames
+     * @param[in] symbols Total number of symbols
+     * @return
+     *          - ESP_OK                  Success.
+     *          - ESP_ERR_NO_MEM          Memory allocation failed.
+     *
+     */
+    esp_err_t ir_learn_reserve_sub_list(struct ir_learn_sub_list_head *sub_head, size_t frames, size_t symbols);
+
+    /**
+     * @brief Get the memory statistics of the sub-frame lists.
+     *
+     * @param[out] stats_out Statistics
+     */
+    void ir_learn_get_mem_stats(ir_learn_mem_stats_t *stats_out);
+
+    /**
+     * @brief Average the captures of a learn list, see ir_learn_acc.h for the tolerances.
      *
      * @param[in] learn_head IR learn list head
      * @param[out] result_out IR learn result
@@ -291,13 +409,56 @@ extern "C"
     void ir_rx_restart(ir_learn_common_param_t *learn_param);
     /**
      * @brief Pause IR RX.
-     * @note This function is used to pause IR RX when transmitting IR signals.
-     * @param
-     *          - ESP_OK                  Pause process success.
-     *          - ESP_ERR_INVALID_ARG     Invalid device handle or argument.
+     * @note Ends the learn session in progress, the learn task goes back to matching.
      */
     void ir_rx_pause();
 
+    /**
+     * @brief Post an event to the learn task and wake it up.
+     *
+     * A learn request posted during a learn session ends the session and runs next,
+     * IR_EVENT_EXIT only ends it.
+     *
+     * @param[in] ir_event Event to post
+     * @param[in] timeout Ticks to wait for room in ir_learn_queue
+     * @return
+     *          - ESP_OK                  Event posted.
+     *          - ESP_ERR_INVALID_STATE   The learn queue isn't created.
+     *          - ESP_ERR_TIMEOUT         The learn queue is full.
+     */
+    esp_err_t ir_learn_post_event(const ir_event_cmd_t *ir_event, TickType_t timeout);
+
+    /**
+     * @brief End the learn session in progress, if any.
+     *
+     * Posts IR_EVENT_EXIT: the session reports IR_LEARN_PROGRESS_CANCEL and the
+     * learn task goes back to matching.
+     *
+     * @return
+     *          - ESP_OK                  Cancel posted.
+     *          - ESP_ERR_INVALID_STATE   The learn queue isn't created.
+     *          - ESP_ERR_TIMEOUT         The learn queue is full.
+     */
+    esp_err_t ir_learn_cancel(void);
+
+    /**
+     * @brief Register a callback for the progress of the learn sessions.
+     *
+     * Called once at start-up, callbacks can't be removed.
+     *
+     * @param[in] cb Callback
+     * @return
+     *          - ESP_OK                  Callback registered.
+     *          - ESP_ERR_INVALID_ARG     cb is NULL.
+     *          - ESP_ERR_NO_MEM          IR_LEARN_PROGRESS_CB_MAX callbacks are registered.
+     */
+    esp_err_t ir_learn_register_progress_cb(ir_learn_progress_cb_t cb);
+
+    /**
+     * @brief Name of a progress stage, e.g. "sample".
+     */
+    const char *ir_learn_progress_name(ir_learn_progress_state_t state);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_learn_acc.h
+ * @brief Streaming accumulator of the captures of a learn session.
+ *
+ * Every capture is folded into per-symbol sums, sums of squares, minimum and
+ * maximum as it arrives, so the learned command and its per-symbol variance are
+ * produced in one pass over the symbols, whatever the number of samples.
+ *
+ * A symbol is accepted if:
+ * - fewer than 3 samples: all samples are within RMT_DECODE_MARGIN of each other,
+ *   the learned duration is their mean;
+ * - 3 samples or more: the standard deviation of the samples, without the one
+ *   farthest from the mean, is within RMT_DECODE_MARGIN / 2. The learned duration
+ *   is the mean without the lowest and the highest sample, so a single bad capture
+ *   neither fails the session nor moves the result.
+ *
+ * ir_learn_acc_median() is the robust learner for K presses: the samples are
+ * clustered by layout, samples off the per-symbol median are dropped and the
+ * median is snapped to the base unit of the protocol it decodes as.
+ */
+
+/**
+ * @brief Most samples ir_learn_acc_median() looks at.
+ */
+#define IR_LEARN_ACC_SAMPLES_MAX 9
+
+/**
+ * @brief Share of symbols, in percent, off the median by more than RMT_DECODE_MARGIN
+ *        that makes ir_learn_acc_median() drop a sample.
+ */
+#define IR_LEARN_ACC_OUTLIER_PCT 10
+
+struct ir_learn_sub_list_head;
+struct ir_learn_list_head;
+
+/**
+ * @brief Running totals of one symbol.
+ */
+typedef struct
+{
+    uint32_t sum0;  /*!< Sum of duration0 */
+    uint32_t sum1;  /*!< Sum of duration1 */
+    uint64_t sq0;   /*!< Sum of duration0 squared */
+    uint64_t sq1;   /*!< Sum of duration1 squared */
+    uint16_t min0;
+    uint16_t max0;
+    uint16_t min1;
+    uint16_t max1;
+} ir_learn_acc_symbol_t;
+
+/**
+ * @brief Running totals of one sub-frame.
+ */
+typedef struct
+{
+    uint32_t timediff_sum;          /*!< Sum of the gaps before the sub-frame, in us */
+    uint16_t num_symbols;           /*!< Symbols of the sub-frame, the same in every sample */
+    uint8_t level0;                 /*!< Level of the first half of the symbols, of the first sample */
+    uint8_t level1;                 /*!< Level of the second half of the symbols, of the first sample */
+    ir_learn_acc_symbol_t *symbols; /*!< Running totals of each symbol */
+} ir_learn_acc_sub_t;
+
+/**
+ * @brief Accumulator of a learn session.
+ */
+typedef struct
+{
+    ir_learn_acc_sub_t *subs; /*!< Sub-frames, their layout is set by the first sample */
+    uint8_t sub_count;        /*!< Sub-frames of the first sample */
+    uint8_t sub_capacity;     /*!< Allocated entries of subs */
+    uint8_t samples;          /*!< Samples started */
+    uint8_t cur_sub;          /*!< Sub-frames received of the current sample */
+    esp_err_t error;          /*!< First layout mismatch, the session can't be averaged */
+} ir_learn_acc_t;
+
+/**
+ * @brief Summary of a finished learn session.
+ */
+typedef struct
+{
+    uint8_t samples;          /*!< Samples averaged */
+    uint8_t sub_count;        /*!< Sub-frames per sample */
+    uint32_t symbols;         /*!< Symbols of the learned command */
+    uint32_t max_variance;    /*!< Largest variance of a duration, in us^2 */
+    uint32_t mean_variance;   /*!< Average variance of the durations, in us^2 */
+    uint8_t worst_sub;        /*!< Sub-frame of the symbol with the largest variance */
+    uint16_t worst_symbol;    /*!< Index of the symbol with the largest variance */
+    uint32_t rejected;        /*!< Symbols outside the tolerance */
+    uint8_t clustered;        /*!< Samples with the layout of the majority, ir_learn_acc_median() only */
+    uint8_t dropped;          /*!< Samples of the majority dropped as outliers, ir_learn_acc_median() only */
+    uint8_t protocol;         /*!< Protocol whose base unit the durations were snapped to, IR_PROTOCOL_UNKNOWN if none */
+} ir_learn_acc_stats_t;
+
+/**
+ * @brief Initialize an empty accumulator.
+ */
+void ir_learn_acc_init(ir_learn_acc_t *acc);
+
+/**
+ * @brief Free the totals and start over.
+ */
+void ir_learn_acc_reset(ir_learn_acc_t *acc);
+
+/**
+ * @brief Fold a captured sub-frame into the totals.
+ *
+ * @param acc Accumulator
+ * @param new_sample The sub-frame is the first of a new sample
+ * @param timediff Gap before the sub-frame, in us
+ * @param symbols Captured symbols
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the sample doesn't have the layout
+ *         of the first one, ESP_ERR_NO_MEM
+ */
+esp_err_t ir_learn_acc_add(ir_learn_acc_t *acc, bool new_sample, uint32_t timediff, const rmt_rx_done_event_data_t *symbols);
+
+/**
+ * @brief Variance of a symbol, the larger of its two durations, in us^2.
+ */
+uint32_t ir_learn_acc_variance(const ir_learn_acc_t *acc, uint8_t sub, uint16_t index);
+
+/**
+ * @brief Largest variance of a duration over the samples so far, in us^2.
+ *
+ * @return Variance, 0 with fewer than two samples or on a layout mismatch
+ */
+uint32_t ir_learn_acc_max_variance(const ir_learn_acc_t *acc);
+
+/**
+ * @brief Emit the learned command.
+ *
+ * @param acc Accumulator, left untouched
+ * @param result_out List the learned sub-frames are appended to
+ * @param stats_out Optional summary, filled even if a symbol is rejected
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE on a layout mismatch,
+ *         ESP_ERR_INVALID_STATE if a symbol is outside the tolerance or nothing was learned
+ */
+esp_err_t ir_learn_acc_finish(const ir_learn_acc_t *acc, struct ir_learn_sub_list_head *result_out, ir_learn_acc_stats_t *stats_out);
+
+/**
+ * @brief Learn a command from the stored samples of a session, by median.
+ *
+ * The samples are clustered by sub-frame and symbol counts and the majority layout
+ * is kept. The per-symbol median of its samples is taken, samples with more than
+ * IR_LEARN_ACC_OUTLIER_PCT of their symbols off the median are dropped and the
+ * median is taken again. Sub-frames that decode as a known protocol have their
+ * durations snapped to its base unit.
+ *
+ * @param samples One list of sub-frames per sample, as captured
+ * @param result_out List the learned sub-frames are appended to
+ * @param stats_out Optional summary, the variances are those of the samples kept
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if no layout has a majority,
+ *         ESP_ERR_INVALID_STATE if no sample is left, ESP_ERR_NO_MEM
+ */
+esp_err_t ir_learn_acc_median(const struct ir_learn_list_head *samples, struct ir_learn_sub_list_head *result_out, ir_learn_acc_stats_t *stats_out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_normalize.h
+ * @brief Normalization of captured frames, between capture and storage or matching.
+ *
+ * A frame is read as a stream of levels and rewritten in place:
+ * 1. Levels shorter than IR_NORMALIZE_GLITCH_US are merged with their neighbours,
+ *    so are consecutive levels of the same value. A leading glitch is dropped.
+ * 2. The trailing idle is trimmed: the last level is a space of 0, as the RMT
+ *    channel ends a frame.
+ * 3. Durations are snapped to a multiple of the base period of the frame: the
+ *    unit of its protocol if it decodes, otherwise the period detected from its
+ *    shortest levels, if at least IR_NORMALIZE_GRID_MIN_PCT of the levels are
+ *    within IR_NORMALIZE_GRID_PCT of a multiple of it.
+ *
+ * The canonical form of a frame is its levels counted in base periods. Presses
+ * of the same key give the same canonical form, so it is hashed for an exact
+ * lookup before the tolerance compare.
+ */
+
+/**
+ * @brief Levels shorter than this are glitches, in us.
+ *
+ * The RMT filter (signal_range_min_ns) only removes pulses of a few clock cycles.
+ */
+#define IR_NORMALIZE_GLITCH_US CONFIG_IR_GLITCH_US
+
+/**
+ * @brief Longest level counted in base periods, longer ones are all the same in the canonical form.
+ */
+#define IR_NORMALIZE_UNITS_MAX 64
+
+/**
+ * @brief Distance to a multiple of the base period, in percent of it, within which a level is on the grid.
+ */
+#define IR_NORMALIZE_GRID_PCT 25
+
+/**
+ * @brief Share of the levels on the grid, in percent, for a detected base period to be used.
+ */
+#define IR_NORMALIZE_GRID_MIN_PCT 90
+
+/**
+ * @brief Summary of a normalization.
+ */
+typedef struct
+{
+    uint16_t glitches; /*!< Glitches merged or dropped */
+    uint16_t trimmed;  /*!< Trailing idle levels trimmed */
+    uint16_t snapped;  /*!< Levels moved to a multiple of the base period */
+    uint16_t levels;   /*!< Levels left */
+    uint32_t base_ns;  /*!< Base period of the last frame, 0 if it has none */
+} ir_normalize_stats_t;
+
+struct ir_learn_sub_list_head;
+
+/**
+ * @brief Normalize a frame in place.
+ *
+ * @param symbols Frame, rewritten in place
+ * @param num_symbols Symbols of the frame
+ * @param stats Optional summary, added to
+ * @return Symbols left
+ */
+size_t ir_normalize_symbols(rmt_symbol_word_t *symbols, size_t num_symbols, ir_normalize_stats_t *stats);
+
+/**
+ * @brief Normalize every sub-frame of a list in place.
+ *
+ * @param list Sub-frames
+ * @param stats_out Optional summary of all the sub-frames
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if a sub-frame is left empty
+ */
+esp_err_t ir_normalize_list(struct ir_learn_sub_list_head *list, ir_normalize_stats_t *stats_out);
+
+/**
+ * @brief Base period of a frame.
+ *
+ * @return Unit of its protocol if it decodes, the detected period otherwise, in ns;
+ *         0 if the levels are not on a grid
+ */
+uint32_t ir_normalize_base_ns(const rmt_symbol_word_t *symbols, size_t num_symbols);
+
+/**
+ * @brief Hash of the canonical form of a list of sub-frames.
+ *
+ * The polarity, the gaps between sub-frames and the trailing idle are not part of it.
+ *
+ * @return Hash, 0 if a sub-frame has no base period
+ */
+uint32_t ir_normalize_hash(const struct ir_learn_sub_list_head *list);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_protocol.h
+ * @brief Decoders for the common consumer IR protocols.
+ *
+ * Received RMT symbols are turned into a (protocol, address, command) tuple
+ * in a single pass. Frames of unknown protocols are left to the raw matcher.
+ * The same tuple is turned back into symbols when sending, so keys of a known
+ * protocol are stored as a short ir_protocol_record_t instead of raw symbols.
+ * Mark/space durations are read from duration0/duration1, so the decoders
+ * don't depend on the polarity of the receiver.
+ */
+
+/**
+ * @brief Supported IR protocols
+ */
+typedef enum
+{
+    IR_PROTOCOL_UNKNOWN = 0, /**< Not decoded, raw symbols only */
+    IR_PROTOCOL_NEC,         /**< NEC, 8-bit address and inverted address */
+    IR_PROTOCOL_NEC_EXT,     /**< NEC extended, 16-bit address */
+    IR_PROTOCOL_SAMSUNG,     /**< Samsung32, 4.5 ms leader */
+    IR_PROTOCOL_SONY,        /**< Sony SIRC 12/15/20 bits */
+    IR_PROTOCOL_RC5,         /**< Philips RC5 */
+    IR_PROTOCOL_RC6,         /**< Philips RC6 mode 0 */
+    IR_PROTOCOL_MAX,
+} ir_protocol_t;
+
+/**
+ * @brief Decoded IR frame, 8 bytes
+ */
+typedef struct
+{
+    uint8_t protocol; /*!< One of ir_protocol_t */
+    uint8_t bits;     /*!< Number of payload bits (Sony: 12, 15 or 20) */
+    uint8_t repeat;   /*!< Frame is a repeat code without payload (NEC) */
+    uint8_t toggle;   /*!< Toggle bit (RC5/RC6) */
+    uint16_t address; /*!< Device address */
+    uint16_t command; /*!< Command code */
+} ir_protocol_frame_t;
+
+/**
+ * @brief Maximum number of symbols of one synthesized frame (NEC: leader, 32 bits, stop bit)
+ */
+#define IR_PROTOCOL_FRAME_MAX_SYMBOLS 34
+
+/**
+ * @brief Magic number at the start of a protocol record file, "IRPR"
+ *
+ * @note Raw .ir files start with the time difference of the first frame, which never gets this large.
+ */
+#define IR_PROTOCOL_RECORD_MAGIC 0x52505249
+
+/**
+ * @brief Compact representation of a learned key of a known protocol, 24 bytes
+ */
+typedef struct
+{
+    uint32_t magic;            /*!< IR_PROTOCOL_RECORD_MAGIC */
+    ir_protocol_frame_t frame; /*!< Decoded frame, sent first */
+    uint16_t frames;           /*!< Total number of frames sent */
+    uint8_t repeat_code;       /*!< Frames after the first are NEC repeat codes instead of copies */
+    uint8_t reserved;
+    uint32_t first_delay_us;   /*!< Delay before the first frame */
+    uint32_t gap_us;           /*!< Delay before each following frame */
+} ir_protocol_record_t;
+
+/**
+ * @brief Try every known protocol on the received symbols.
+ *
+ * @param[in] symbols Received RMT symbols
+ * @param[in] num_symbols Number of symbols
+ * @param[out] frame_out Decoded frame
+ * @return
+ *          - ESP_OK                  Frame decoded.
+ *          - ESP_ERR_INVALID_ARG     Invalid argument.
+ *          - ESP_ERR_NOT_FOUND       No protocol matched.
+ */
+esp_err_t ir_protocol_decode(const rmt_symbol_word_t *symbols, size_t num_symbols, ir_protocol_frame_t *frame_out);
+
+/**
+ * @brief Synthesize the RMT symbols of a decoded frame.
+ *
+ * Marks are on level 1 (carrier on), spaces on level 0.
+ *
+ * @param[in] frame Frame to send, a NEC repeat code if frame->repeat is set
+ * @param[out] symbols Output buffer
+ * @param[in] max_symbols Size of the output buffer, at least IR_PROTOCOL_FRAME_MAX_SYMBOLS
+ * @return Number of symbols written, 0 if the frame can't be synthesized
+ */
+size_t ir_protocol_build(const ir_protocol_frame_t *frame, rmt_symbol_word_t *symbols, size_t max_symbols);
+
+/**
+ * @brief Compare the payload of two decoded frames.
+ *
+ * Repeat and toggle flags are ignored.
+ *
+ * @return true if both frames carry the same protocol, address and command
+ */
+static inline bool ir_protocol_frame_equal(const ir_protocol_frame_t *a, const ir_protocol_frame_t *b)
+{
+    return a->protocol == b->protocol && a->bits == b->bits &&
+           a->address == b->address && a->command == b->command;
+}
+
+/**
+ * @brief Printable name of a protocol.
+ */
+const char *ir_protocol_name(ir_protocol_t protocol);
+
+/**
+ * @brief Base time unit of a protocol, every level of its frames is a multiple of it.
+ *
+ * @return Unit in nanoseconds, 0 for IR_PROTOCOL_UNKNOWN
+ */
+uint32_t ir_protocol_unit_ns(ir_protocol_t protocol);
+
+/**
+ * @brief Nominal carrier of a protocol, used when the carrier of a key wasn't measured.
+ *
+ * @return Carrier in Hz, 0 for IR_PROTOCOL_UNKNOWN
+ */
+uint32_t ir_protocol_carrier_hz(ir_protocol_t protocol);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/rmt_types.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_rx.h
+ * @brief Always-on IR receive engine.
+ *
+ * The RX channel is created once at boot and never deleted. The done callback
+ * re-arms the channel into the next free capture buffer of a ring before handing
+ * the frame over, so the receiver keeps listening while frames are processed.
+ * A frame owns its buffer until ir_rx_release().
+ * Learning, step learning and passive matching are modes of this engine.
+ *
+ * How a frame gets into its buffer depends on the target:
+ * - DMA (CONFIG_IR_RX_DMA): the RMT writes the whole frame into the buffer.
+ * - Ping-pong (SOC_RMT_SUPPORT_RX_PINGPONG): the driver copies each half of the RMT
+ *   memory block to the buffer as it fills, the frame is handed over at its end.
+ * - Otherwise (ESP32): the frame is copied at its end and is limited to
+ *   RMT_RX_MEM_BLOCK_SIZE symbols.
+ */
+
+/**
+ * @brief Number of symbols of a capture buffer.
+ */
+#define IR_RX_BUFFER_SYMBOLS CONFIG_IR_RX_BUFFER_SYMBOLS
+
+/**
+ * @brief Number of capture buffers of the ring.
+ */
+#define IR_RX_BUFFER_COUNT CONFIG_IR_RX_BUFFER_COUNT
+
+/**
+ * @brief What the received frames are used for.
+ */
+typedef enum
+{
+    IR_RX_MODE_MATCH,   /*!< Frames are matched against the stored keys */
+    IR_RX_MODE_LEARN,   /*!< Frames are learned, frames captured before the mode was entered are dropped */
+    IR_RX_MODE_MONITOR, /*!< Frames are only counted, e.g. while replaying a trace */
+} ir_rx_mode_t;
+
+/**
+ * @brief A received frame.
+ *
+ * The symbols stay in the capture buffer, which the channel doesn't reuse before
+ * the frame is released: release it as soon as the symbols are copied.
+ */
+typedef struct
+{
+    rmt_rx_done_event_data_t data; /*!< Received symbols */
+    int64_t time_us;               /*!< esp_timer time of the end of the frame */
+    uint8_t buffer;                /*!< Capture buffer holding the symbols */
+} ir_rx_frame_t;
+
+/**
+ * @brief Counters of the RX engine.
+ */
+typedef struct
+{
+    uint32_t frames;         /*!< Frames captured */
+    uint32_t monitored;      /*!< Frames counted in IR_RX_MODE_MONITOR */
+    uint32_t queue_drops;    /*!< Frames dropped because the receive queue was full */
+    uint32_t overruns;       /*!< Frames dropped because no buffer was free, the channel captured over them */
+    uint32_t rearm_failures; /*!< Re-arms that failed in the done callback, frames were missed until the next one */
+    uint32_t flushed;        /*!< Frames dropped when entering IR_RX_MODE_LEARN */
+    uint32_t truncated;      /*!< Frames that filled the whole capture buffer or RMT memory, their end is missing */
+    uint16_t max_symbols;    /*!< Longest frame captured */
+    uint8_t buffers_in_use;  /*!< Buffers capturing or held by frames */
+    uint8_t high_water;      /*!< Most buffers ever in use at once */
+} ir_rx_stats_t;
+
+/**
+ * @brief Create, enable and arm the RX channel.
+ *
+ * @return ESP_OK on success, or appropriate error code
+ */
+esp_err_t ir_rx_init(void);
+
+/**
+ * @brief Switch the mode of the engine, the channel keeps running.
+ *
+ * @param mode New mode
+ */
+void ir_rx_set_mode(ir_rx_mode_t mode);
+
+/**
+ * @brief Current mode of the engine.
+ */
+ir_rx_mode_t ir_rx_get_mode(void);
+
+/**
+ * @brief Wait for the next received frame.
+ *
+ * @param frame Output frame, to be released with ir_rx_release()
+ * @param timeout Ticks to wait
+ * @return true if a frame was received
+ */
+bool ir_rx_receive(ir_rx_frame_t *frame, TickType_t timeout);
+
+/**
+ * @brief Notify a task of every frame put in the receive queue.
+ *
+ * Lets a task wait for frames and other events at once, with xTaskNotifyWait().
+ *
+ * @param task Task to notify, NULL for none
+ * @param bits Bits set in its notification value
+ */
+void ir_rx_set_notify(TaskHandle_t task, uint32_t bits);
+
+/**
+ * @brief Re-arm the channel if the done callback failed to, call before waiting for a frame.
+ */
+void ir_rx_check_armed(void);
+
+/**
+ * @brief Give the capture buffer of a received frame back to the channel.
+ *
+ * @param frame Frame returned by ir_rx_receive()
+ */
+void ir_rx_release(const ir_rx_frame_t *frame);
+
+/**
+ * @brief Stop receiving, the channel is disabled but kept.
+ */
+esp_err_t ir_rx_suspend(void);
+
+/**
+ * @brief Enable and re-arm the channel after ir_rx_suspend().
+ */
+esp_err_t ir_rx_resume(void);
+
+/**
+ * @brief Get the counters of the RX engine.
+ *
+ * @param stats_out Output counters
+ */
+void ir_rx_get_stats(ir_rx_stats_t *stats_out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ir_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ir_sequence.h
+ * @brief Packed step-sequence container.
+ *
+ * A step sequence is stored in a single "/spiffs/<key>.seq" file:
+ *
+ *   ir_seq_header_t | ir_seq_step_t[step_count] | step blocks
+ *
+ * Each step block has the data of a key (raw sub-frames or a protocol
+ * record) and starts on a 4-byte boundary, so its symbols can be used in place.
+ * All fields are little-endian. tools/ir_seq.py packs and unpacks these files
+ * on the host.
+ *
+ * Sequences are learned as "<key>_stepN" keys of the key database plus a text
+ * "<key>.delay", and packed by ir_seq_pack() once learned; ir_seq_migrate()
+ * packs those left over at boot.
+ */
+
+#define IR_SEQ_MAGIC 0x51535249 /*!< "IRSQ" */
+#define IR_SEQ_VERSION 1
+
+/**
+ * @brief Maximum number of steps, one more than the number of delays.
+ */
+#define IR_SEQ_STEPS_MAX (IR_STEP_COUNT_MAX + 1)
+
+/**
+ * @brief Sequences up to this size are loaded with a single read, larger ones are streamed step by step.
+ */
+#define IR_SEQ_LOAD_MAX (16 * 1024)
+
+/**
+ * @brief File header, 16 bytes
+ */
+typedef struct
+{
+    uint32_t magic;      /*!< IR_SEQ_MAGIC */
+    uint16_t version;    /*!< IR_SEQ_VERSION */
+    uint16_t step_count; /*!< Number of entries of the step table */
+    uint32_t file_size;  /*!< Size of the whole file, in bytes */
+    uint32_t reserved;
+} ir_seq_header_t;
+
+/**
+ * @brief Step table entry, 12 bytes
+ */
+typedef struct
+{
+    uint32_t offset;   /*!< Offset of the step block from the start of the file */
+    uint32_t size;     /*!< Size of the step block, in bytes */
+    uint32_t delay_ms; /*!< Time from the start of this step to the start of the next one, 0 for the last step */
+} ir_seq_step_t;
+
+/**
+ * @brief An opened sequence.
+ */
+typedef struct
+{
+    ir_seq_header_t header;
+    ir_seq_step_t steps[IR_SEQ_STEPS_MAX];
+    const uint8_t *data; /*!< Whole file if it was loaded with one read or is cached, NULL when streaming */
+    bool cached;         /*!< data is pinned in the RAM cache, see ir_cache_get() */
+    FILE *f;             /*!< Open file when streaming */
+    uint8_t *step_buf;   /*!< Buffer of the largest step when streaming */
+} ir_seq_t;
+
+/**
+ * @brief Check whether a packed sequence exists.
+ *
+ * @param key Sequence name (without extension)
+ * @return true if "<key>.seq" exists
+ */
+bool ir_seq_exists(const char *key);
+
+/**
+ * @brief Open a sequence and read its step table.
+ *
+ * @param key Sequence name (without extension)
+ * @param seq Output, to be closed with ir_seq_close()
+ * @return
+ *          - ESP_OK                  Success
+ *          - ESP_ERR_NOT_FOUND       No such sequence
+ *          - ESP_ERR_INVALID_VERSION Unknown magic or version
+ *          - ESP_ERR_INVALID_SIZE    Corrupted step table
+ *          - ESP_ERR_NO_MEM          Out of memory
+ */
+esp_err_t ir_seq_open(const char *key, ir_seq_t *seq);
+
+/**
+ * @brief Get the block of one step.
+ *
+ * @note When streaming, the block is read into a buffer owned by the sequence
+ *       and is only valid until the next call.
+ *
+ * @param seq Opened sequence
+ * @param index Step index, from 0
+ * @param data_out Output, step block (content of a .ir file)
+ * @param size_out Output, size of the step block
+ * @return ESP_OK on success, or appropriate error code
+ */
+esp_err_t ir_seq_get_step(ir_seq_t *seq, uint16_t index, const uint8_t **data_out, size_t *size_out);
+
+/**
+ * @brief Release an opened sequence.
+ */
+void ir_seq_close(ir_seq_t *seq);
+
+/**
+ * @brief Read the delays of a sequence.
+ *
+ * @param key Sequence name (without extension)
+ * @param delays Output, delay from each step to the next one, in ms
+ * @param count_out Output, number of delays (step count - 1)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no such sequence
+ */
+esp_err_t ir_seq_get_delays(const char *key, int *delays, size_t *count_out);
+
+/**
+ * @brief Rewrite the delays of a sequence in place.
+ *
+ * Missing delays are set to 0, extra ones are ignored.
+ *
+ * @param key Sequence name (without extension)
+ * @param delays Delay from each step to the next one, in ms
+ * @param count Number of delays
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no such sequence
+ */
+esp_err_t ir_seq_set_delays(const char *key, const int *delays, size_t count);
+
+/**
+ * @brief Pack the "<key>_stepN" keys and the "<key>.delay" file into "<key>.seq".
+ *
+ * The step keys and the delay file are removed once the sequence is written.
+ *
+ * @param key Sequence name
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no "<key>_step1" key
+ */
+esp_err_t ir_seq_pack(const char *key);
+
+/**
+ * @brief Pack every step sequence left as step keys in the key database.
+ *
+ * @return ESP_OK on success, or appropriate error code
+ */
+esp_err_t ir_seq_migrate(void);
+
+/**
+ * @brief Delete a sequence.
+ */
+esp_err_t ir_seq_delete(const char *key);
+
+/**
+ * @brief Rename a sequence.
+ */
+esp_err_t ir_seq_rename(const char *old_key, const char *new_key);
+
+#ifdef __cplusplus
+}
+#endif
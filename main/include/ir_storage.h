@@ -2,6 +2,9 @@
 
 #include "esp_err.h"
 #include "ir_learn.h"  // Make sure this contains the definition of struct ir_learn_sub_list_head
+#include "ir_protocol.h"
+#include "ir_carrier.h"
+#include "ir_db.h"
 #include "cJSON.h"
 
 #ifdef __cplusplus
@@ -9,59 +12,172 @@ extern "C" {
 #endif
 
 #define NVS_IR_NAMESPACE "ir-nvs-storage"
+
+#define IR_ALIAS_FILE "/spiffs/ir_alias.json"
+
+#define IR_KEY_HEADER_MAGIC 0x484b5249
+
+/**
+ * @brief Optional header of the data of a key, 12 bytes, written when the carrier of the key was measured.
+ *
+ * Keys without it are read as before and sent on the nominal carrier of their protocol.
+ */
+typedef struct
+{
+    uint32_t magic;         /*!< IR_KEY_HEADER_MAGIC */
+    uint32_t carrier_hz;    /*!< Measured carrier frequency */
+    uint16_t duty_permille; /*!< Measured carrier duty */
+    uint16_t reserved;
+} ir_key_header_t;
+
 /**
- * @brief Save IR learning data to SPIFFS storage.
+ * @brief Save IR learning data to the key database (see ir_db.h).
  * 
  * @param data_save Pointer to the destination list to store processed data
  * @param data_src Pointer to the source list that contains learned IR data
- * @param key File name to save (without ".ir" extension; it will be added automatically)
+ * @param key Key name
+ * @param carrier Measured carrier of the key, NULL or zeroed if it wasn't measured
  */
-void ir_learn_save(struct ir_learn_sub_list_head *data_save, struct ir_learn_sub_list_head *data_src, const char *key);
+void ir_learn_save(struct ir_learn_sub_list_head *data_save, struct ir_learn_sub_list_head *data_src, const char *key,
+                   const ir_carrier_t *carrier);
 
 /**
- * @brief Load IR data from SPIFFS storage.
+ * @brief Load IR data from the key database.
  * 
  * @param data_load Pointer to the list to load data into
- * @param key File name to load (without ".ir" extension)
+ * @param key Key name
  */
 esp_err_t ir_learn_load(struct ir_learn_sub_list_head *data_load, const char *key);
 
 /**
- * @brief List all IR keys stored in SPIFFS.
+ * @brief Load the protocol record of a key, without expanding it into symbols.
+ * 
+ * Keys whose frames decode as a known protocol are saved as an ir_protocol_record_t,
+ * other keys keep their raw symbols.
+ * 
+ * @param key Key name
+ * @param record Output record
+ * @param carrier_out Optional output, carrier of the key from its header, zeroed if it has none
+ * @return ESP_OK if the key is a protocol record, ESP_ERR_NOT_SUPPORTED for a raw key,
+ *         ESP_ERR_NOT_FOUND if the key doesn't exist
+ */
+esp_err_t ir_learn_load_record(const char *key, ir_protocol_record_t *record, ir_carrier_t *carrier_out);
+
+/**
+ * @brief Read the optional header at the start of the data of a key.
+ *
+ * @param data Data of the key
+ * @param size Size of the content, in bytes
+ * @param carrier_out Optional output, carrier of the key, zeroed if there's no header
+ * @return Size of the header, 0 if there's none
+ */
+size_t ir_key_read_header(const uint8_t *data, size_t size, ir_carrier_t *carrier_out);
+
+/**
+ * @brief Walk the raw sub-frames of the data of a key, in place.
+ *
+ * Each sub-frame is its timediff, its symbol count and its symbols, 4-byte aligned.
+ *
+ * @param data Data of the key
+ * @param size Size of the content, in bytes
+ * @param pos In/out, offset of the next sub-frame, starts after the header (see ir_key_read_header())
+ * @param timediff_out Output, time since the previous sub-frame, in us
+ * @param symbols_out Output, symbols of the sub-frame, pointing into data
+ * @param num_symbols_out Output, number of symbols
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND after the last sub-frame,
+ *         ESP_ERR_INVALID_SIZE if the sub-frame is truncated
+ */
+esp_err_t ir_key_next_frame(const uint8_t *data, size_t size, size_t *pos, uint32_t *timediff_out,
+                            const rmt_symbol_word_t **symbols_out, size_t *num_symbols_out);
+
+/**
+ * @brief Parse the data of a key held in memory, e.g. a step block of a packed sequence.
+ *
+ * @param data Data of the key (raw sub-frames or a protocol record, after an optional header)
+ * @param size Size of the content, in bytes
+ * @param out_list Output list of sub-frames
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the content is truncated
+ */
+esp_err_t ir_learn_load_from_buffer(const uint8_t *data, size_t size, struct ir_learn_sub_list_head *out_list);
+
+/**
+ * @brief A key loaded for transmission, either a protocol record or raw symbols.
+ *
+ * Raw symbols of a stored key are sent in place from the RAM cache or the
+ * mapped key database, the list is only used when the database isn't mapped
+ * and for packed sequences.
+ */
+typedef struct
+{
+    bool is_record;                            /*!< The key is a protocol record */
+    ir_protocol_record_t record;               /*!< Protocol record, if is_record */
+    bool is_mapped;                            /*!< Raw symbols in view, otherwise in symbols */
+    bool is_cached;                            /*!< view is pinned in the RAM cache rather than in flash */
+    ir_db_view_t view;                         /*!< Data of the key in flash or in the cache, if is_mapped */
+    struct ir_learn_sub_list_head symbols;     /*!< Raw symbols, if neither */
+    ir_carrier_t carrier;                      /*!< Measured carrier, zeroed if the key has none */
+} ir_tx_key_t;
+
+/**
+ * @brief Loads a key for transmission.
+ * 
+ * @param key Key name.
+ * @param tx_key Output, to be released with ir_tx_release_key().
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t ir_tx_load_key(const char *key, ir_tx_key_t *tx_key);
+
+/**
+ * @brief Queues a loaded key to the TX channel, returns before the frames are sent.
+ * 
+ * @note Call ir_tx_wait_done() before ir_tx_release_key().
+ */
+void ir_tx_queue_key(ir_tx_key_t *tx_key);
+
+/**
+ * @brief Frees the data of a loaded key.
+ */
+void ir_tx_release_key(ir_tx_key_t *tx_key);
+
+/**
+ * @brief List all IR keys of the key database.
  */
 void list_ir_keys_from_spiffs(void);
 
 /**
- * @brief Format the entire SPIFFS partition (delete all stored files).
+ * @brief Format the entire SPIFFS partition and erase the key database.
  */
 void format_spiffs(void);
 
 /**
- * @brief Delete a specific IR key (file) from SPIFFS.
+ * @brief Delete a specific IR key, or the packed sequence of that name.
  * 
- * @param key File name to delete (without ".ir" extension)
+ * @param key Key name
  * @return ESP_OK on success, or appropriate error code
  */
 esp_err_t delete_ir_key_from_spiffs(const char *key);
 
 /**
- * @brief Rename an IR key (file) in SPIFFS.
+ * @brief Rename an IR key, or the packed sequence of that name.
  * 
- * @param old_key Existing file name (without ".ir")
- * @param new_key New file name (without ".ir")
- * @return ESP_OK on success
+ * @param old_key Existing key name
+ * @param new_key New key name
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if old_key doesn't exist, ESP_ERR_INVALID_STATE if new_key does
  */
 esp_err_t rename_ir_key_in_spiffs(const char *old_key, const char *new_key);
 
 /**
- * @brief Initialize SPIFFS file system. Must be called before using SPIFFS.
+ * @brief Initialize SPIFFS and the key database, import the key files of older firmware.
+ *
+ * Must be called before using SPIFFS or the keys.
  * 
- * @return ESP_OK on success
+ * @return ESP_OK on success, also without a key database partition: the error is
+ *         logged, and key operations fail until the partition table is reflashed
  */
 esp_err_t spiffs_init(void);
 
 /**
- * @brief Match IR data from SPIFFS with received IR data.
+ * @brief Match received IR data with the stored keys.
  * 
  * @param data_learn Pointer to the list of learned IR data
  * @param matched_key_out Output buffer for the matched key (if found)
@@ -89,6 +205,19 @@ esp_err_t save_step_timediff_to_file(const char *key_name, const int *timediff_l
  */
 esp_err_t load_step_timediff_from_file(const char *key_name, int *timediff_list, size_t *count_out);
 
+/**
+ * @brief Read the "<key>.delay" file only, not the delays of a packed sequence.
+ *
+ * The file is checked (see ir_file.h); text files of older firmware are read as well,
+ * a file that is neither is rejected.
+ *
+ * @param key_name Key name, without extension
+ * @param timediff_list Output, up to IR_STEP_COUNT_MAX delays in ms
+ * @param count_out Output, number of delays
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there's no file, or the error of ir_file_read()
+ */
+esp_err_t read_step_timediff_file(const char *key_name, int *timediff_list, size_t *count_out);
+
 /**
  * @brief List all IR step delay files in SPIFFS.
  * 
@@ -102,7 +231,6 @@ void write_nvs(bool ota_enabled);
 esp_err_t ir_load_aliases(cJSON **out_aliases);
 esp_err_t ir_save_aliases(cJSON *aliases);
 esp_err_t ir_get_mapped_key(const char *src_key, char *out_key, size_t max_len);
-bool find_original_key_from_match(const struct ir_learn_sub_list_head *result, char *out_original_key);
 
 #ifdef __cplusplus
 }
@@ -781,33 +781,118 @@ unsigned char script_js[] = {
   0x47, 0xe1, 0xbb, 0xad, 0x69, 0x20, 0x74, 0x68, 0xe1, 0xba, 0xa5, 0x74,
   0x20, 0x62, 0xe1, 0xba, 0xa1, 0x69, 0x3a, 0x20, 0x22, 0x20, 0x2b, 0x20,
   0x65, 0x72, 0x72, 0x29, 0x29, 0x3b, 0x0a, 0x7d, 0x0a, 0x0a, 0x2f, 0x2f,
-  0x20, 0x4b, 0x68, 0x69, 0x20, 0x74, 0x72, 0x61, 0x6e, 0x67, 0x20, 0x6c,
-  0x6f, 0x61, 0x64, 0x0a, 0x77, 0x69, 0x6e, 0x64, 0x6f, 0x77, 0x2e, 0x61,
-  0x64, 0x64, 0x45, 0x76, 0x65, 0x6e, 0x74, 0x4c, 0x69, 0x73, 0x74, 0x65,
-  0x6e, 0x65, 0x72, 0x28, 0x22, 0x44, 0x4f, 0x4d, 0x43, 0x6f, 0x6e, 0x74,
-  0x65, 0x6e, 0x74, 0x4c, 0x6f, 0x61, 0x64, 0x65, 0x64, 0x22, 0x2c, 0x20,
-  0x61, 0x73, 0x79, 0x6e, 0x63, 0x20, 0x28, 0x29, 0x20, 0x3d, 0x3e, 0x20,
-  0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x61, 0x77, 0x61, 0x69, 0x74, 0x20,
-  0x66, 0x65, 0x74, 0x63, 0x68, 0x41, 0x76, 0x61, 0x69, 0x6c, 0x61, 0x62,
-  0x6c, 0x65, 0x43, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x73, 0x28, 0x29,
-  0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x61, 0x77, 0x61, 0x69, 0x74, 0x20,
-  0x66, 0x65, 0x74, 0x63, 0x68, 0x45, 0x78, 0x69, 0x73, 0x74, 0x69, 0x6e,
-  0x67, 0x41, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x6d, 0x65, 0x6e, 0x74, 0x73,
-  0x28, 0x29, 0x3b, 0x0a, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x69, 0x66, 0x20,
-  0x28, 0x64, 0x6f, 0x63, 0x75, 0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x71, 0x75,
-  0x65, 0x72, 0x79, 0x53, 0x65, 0x6c, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x41,
-  0x6c, 0x6c, 0x28, 0x22, 0x2e, 0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d,
-  0x70, 0x61, 0x69, 0x72, 0x22, 0x29, 0x2e, 0x6c, 0x65, 0x6e, 0x67, 0x74,
-  0x68, 0x20, 0x3d, 0x3d, 0x3d, 0x20, 0x30, 0x29, 0x20, 0x7b, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x61, 0x64, 0x64, 0x41, 0x73,
-  0x73, 0x69, 0x67, 0x6e, 0x50, 0x61, 0x69, 0x72, 0x28, 0x29, 0x3b, 0x20,
-  0x2f, 0x2f, 0x20, 0x4e, 0xe1, 0xba, 0xbf, 0x75, 0x20, 0x63, 0x68, 0xc6,
-  0xb0, 0x61, 0x20, 0x63, 0xc3, 0xb3, 0x20, 0x63, 0xe1, 0xba, 0xb7, 0x70,
-  0x20, 0x6e, 0xc3, 0xa0, 0x6f, 0x2c, 0x20, 0x74, 0x68, 0xc3, 0xaa, 0x6d,
-  0x20, 0x73, 0xe1, 0xba, 0xb5, 0x6e, 0x20, 0x31, 0x20, 0x64, 0xc3, 0xb2,
-  0x6e, 0x67, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x7d, 0x0a, 0x7d, 0x29, 0x3b,
-  0x0a, 0x0a, 0x2f, 0x2f, 0x20, 0x4b, 0x68, 0xe1, 0xbb, 0x9f, 0x69, 0x20,
-  0xc4, 0x91, 0xe1, 0xbb, 0x99, 0x6e, 0x67, 0x0a, 0x6c, 0x6f, 0x61, 0x64,
-  0x49, 0x52, 0x4c, 0x69, 0x73, 0x74, 0x28, 0x29, 0x3b
+  0x20, 0x54, 0x69, 0xe1, 0xba, 0xbf, 0x6e, 0x20, 0x74, 0x72, 0xc3, 0xac,
+  0x6e, 0x68, 0x20, 0x68, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb,
+  0x87, 0x6e, 0x68, 0x2c, 0x20, 0x45, 0x53, 0x50, 0x33, 0x32, 0x20, 0xc4,
+  0x91, 0xe1, 0xba, 0xa9, 0x79, 0x20, 0x74, 0xe1, 0xbb, 0xab, 0x6e, 0x67,
+  0x20, 0x73, 0xe1, 0xbb, 0xb1, 0x20, 0x6b, 0x69, 0xe1, 0xbb, 0x87, 0x6e,
+  0x20, 0x71, 0x75, 0x61, 0x20, 0x57, 0x65, 0x62, 0x53, 0x6f, 0x63, 0x6b,
+  0x65, 0x74, 0x0a, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x4c, 0x45, 0x41,
+  0x52, 0x4e, 0x5f, 0x53, 0x54, 0x41, 0x54, 0x45, 0x5f, 0x54, 0x45, 0x58,
+  0x54, 0x20, 0x3d, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x73, 0x74,
+  0x61, 0x72, 0x74, 0x3a, 0x20, 0x22, 0x43, 0x68, 0xe1, 0xbb, 0x9d, 0x20,
+  0x6e, 0x68, 0xe1, 0xba, 0xa5, 0x6e, 0x20, 0x6e, 0xc3, 0xba, 0x74, 0x22,
+  0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65,
+  0x3a, 0x20, 0x22, 0xc4, 0x90, 0xc3, 0xa3, 0x20, 0x6e, 0x68, 0xe1, 0xba,
+  0xad, 0x6e, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x64, 0x6f, 0x6e,
+  0x65, 0x3a, 0x20, 0x22, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x78, 0x6f,
+  0x6e, 0x67, 0x22, 0x2c, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x66, 0x61, 0x69,
+  0x6c, 0x3a, 0x20, 0x22, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x74, 0x68,
+  0xe1, 0xba, 0xa5, 0x74, 0x20, 0x62, 0xe1, 0xba, 0xa1, 0x69, 0x22, 0x2c,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x74, 0x69, 0x6d, 0x65, 0x6f, 0x75, 0x74,
+  0x3a, 0x20, 0x22, 0x48, 0xe1, 0xba, 0xbf, 0x74, 0x20, 0x74, 0x68, 0xe1,
+  0xbb, 0x9d, 0x69, 0x20, 0x67, 0x69, 0x61, 0x6e, 0x22, 0x2c, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x63, 0x61, 0x6e, 0x63, 0x65, 0x6c, 0x3a, 0x20, 0x22,
+  0xc4, 0x90, 0xc3, 0xa3, 0x20, 0x68, 0x75, 0xe1, 0xbb, 0xb7, 0x22, 0x2c,
+  0x0a, 0x7d, 0x3b, 0x0a, 0x0a, 0x66, 0x75, 0x6e, 0x63, 0x74, 0x69, 0x6f,
+  0x6e, 0x20, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x4c, 0x65, 0x61,
+  0x72, 0x6e, 0x50, 0x72, 0x6f, 0x67, 0x72, 0x65, 0x73, 0x73, 0x28, 0x29,
+  0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x63, 0x6f, 0x6e, 0x73, 0x74,
+  0x20, 0x77, 0x73, 0x20, 0x3d, 0x20, 0x6e, 0x65, 0x77, 0x20, 0x57, 0x65,
+  0x62, 0x53, 0x6f, 0x63, 0x6b, 0x65, 0x74, 0x28, 0x60, 0x77, 0x73, 0x3a,
+  0x2f, 0x2f, 0x24, 0x7b, 0x6c, 0x6f, 0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e,
+  0x2e, 0x68, 0x6f, 0x73, 0x74, 0x7d, 0x2f, 0x69, 0x72, 0x2f, 0x6c, 0x65,
+  0x61, 0x72, 0x6e, 0x2f, 0x77, 0x73, 0x60, 0x29, 0x3b, 0x0a, 0x20, 0x20,
+  0x20, 0x20, 0x77, 0x73, 0x2e, 0x6f, 0x6e, 0x6d, 0x65, 0x73, 0x73, 0x61,
+  0x67, 0x65, 0x20, 0x3d, 0x20, 0x65, 0x76, 0x65, 0x6e, 0x74, 0x20, 0x3d,
+  0x3e, 0x20, 0x73, 0x68, 0x6f, 0x77, 0x4c, 0x65, 0x61, 0x72, 0x6e, 0x50,
+  0x72, 0x6f, 0x67, 0x72, 0x65, 0x73, 0x73, 0x28, 0x4a, 0x53, 0x4f, 0x4e,
+  0x2e, 0x70, 0x61, 0x72, 0x73, 0x65, 0x28, 0x65, 0x76, 0x65, 0x6e, 0x74,
+  0x2e, 0x64, 0x61, 0x74, 0x61, 0x29, 0x29, 0x3b, 0x0a, 0x20, 0x20, 0x20,
+  0x20, 0x77, 0x73, 0x2e, 0x6f, 0x6e, 0x63, 0x6c, 0x6f, 0x73, 0x65, 0x20,
+  0x3d, 0x20, 0x28, 0x29, 0x20, 0x3d, 0x3e, 0x20, 0x73, 0x65, 0x74, 0x54,
+  0x69, 0x6d, 0x65, 0x6f, 0x75, 0x74, 0x28, 0x63, 0x6f, 0x6e, 0x6e, 0x65,
+  0x63, 0x74, 0x4c, 0x65, 0x61, 0x72, 0x6e, 0x50, 0x72, 0x6f, 0x67, 0x72,
+  0x65, 0x73, 0x73, 0x2c, 0x20, 0x33, 0x30, 0x30, 0x30, 0x29, 0x3b, 0x0a,
+  0x7d, 0x0a, 0x0a, 0x66, 0x75, 0x6e, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x20,
+  0x73, 0x68, 0x6f, 0x77, 0x4c, 0x65, 0x61, 0x72, 0x6e, 0x50, 0x72, 0x6f,
+  0x67, 0x72, 0x65, 0x73, 0x73, 0x28, 0x70, 0x29, 0x20, 0x7b, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x20, 0x65, 0x6c, 0x20,
+  0x3d, 0x20, 0x64, 0x6f, 0x63, 0x75, 0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x67,
+  0x65, 0x74, 0x45, 0x6c, 0x65, 0x6d, 0x65, 0x6e, 0x74, 0x42, 0x79, 0x49,
+  0x64, 0x28, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x50, 0x72, 0x6f, 0x67,
+  0x72, 0x65, 0x73, 0x73, 0x22, 0x29, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20,
+  0x69, 0x66, 0x20, 0x28, 0x21, 0x65, 0x6c, 0x29, 0x20, 0x72, 0x65, 0x74,
+  0x75, 0x72, 0x6e, 0x3b, 0x0a, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x6c, 0x65,
+  0x74, 0x20, 0x74, 0x65, 0x78, 0x74, 0x20, 0x3d, 0x20, 0x60, 0x24, 0x7b,
+  0x70, 0x2e, 0x6b, 0x65, 0x79, 0x7d, 0x3a, 0x20, 0x24, 0x7b, 0x4c, 0x45,
+  0x41, 0x52, 0x4e, 0x5f, 0x53, 0x54, 0x41, 0x54, 0x45, 0x5f, 0x54, 0x45,
+  0x58, 0x54, 0x5b, 0x70, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x65, 0x5d, 0x20,
+  0x7c, 0x7c, 0x20, 0x70, 0x2e, 0x73, 0x74, 0x61, 0x74, 0x65, 0x7d, 0x20,
+  0x24, 0x7b, 0x70, 0x2e, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x7d, 0x2f,
+  0x24, 0x7b, 0x70, 0x2e, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x73, 0x7d,
+  0x60, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x69, 0x66, 0x20, 0x28, 0x70,
+  0x2e, 0x73, 0x74, 0x61, 0x74, 0x65, 0x20, 0x3d, 0x3d, 0x3d, 0x20, 0x22,
+  0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x22, 0x29, 0x20, 0x74, 0x65, 0x78,
+  0x74, 0x20, 0x2b, 0x3d, 0x20, 0x60, 0x2c, 0x20, 0x24, 0x7b, 0x70, 0x2e,
+  0x73, 0x79, 0x6d, 0x62, 0x6f, 0x6c, 0x73, 0x7d, 0x20, 0x73, 0x79, 0x6d,
+  0x62, 0x6f, 0x6c, 0x2c, 0x20, 0x70, 0x68, 0xc6, 0xb0, 0xc6, 0xa1, 0x6e,
+  0x67, 0x20, 0x73, 0x61, 0x69, 0x20, 0x24, 0x7b, 0x70, 0x2e, 0x76, 0x61,
+  0x72, 0x69, 0x61, 0x6e, 0x63, 0x65, 0x7d, 0x20, 0xc2, 0xb5, 0x73, 0xc2,
+  0xb2, 0x60, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x69, 0x66, 0x20, 0x28,
+  0x70, 0x2e, 0x72, 0x65, 0x6d, 0x61, 0x69, 0x6e, 0x69, 0x6e, 0x67, 0x5f,
+  0x6d, 0x73, 0x29, 0x20, 0x74, 0x65, 0x78, 0x74, 0x20, 0x2b, 0x3d, 0x20,
+  0x60, 0x2c, 0x20, 0x63, 0xc3, 0xb2, 0x6e, 0x20, 0x24, 0x7b, 0x4d, 0x61,
+  0x74, 0x68, 0x2e, 0x63, 0x65, 0x69, 0x6c, 0x28, 0x70, 0x2e, 0x72, 0x65,
+  0x6d, 0x61, 0x69, 0x6e, 0x69, 0x6e, 0x67, 0x5f, 0x6d, 0x73, 0x20, 0x2f,
+  0x20, 0x31, 0x30, 0x30, 0x30, 0x29, 0x7d, 0x20, 0x73, 0x60, 0x3b, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x65, 0x6c, 0x2e, 0x74, 0x65, 0x78, 0x74, 0x43,
+  0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x20, 0x3d, 0x20, 0x74, 0x65, 0x78,
+  0x74, 0x3b, 0x0a, 0x7d, 0x0a, 0x0a, 0x66, 0x75, 0x6e, 0x63, 0x74, 0x69,
+  0x6f, 0x6e, 0x20, 0x63, 0x61, 0x6e, 0x63, 0x65, 0x6c, 0x4c, 0x65, 0x61,
+  0x72, 0x6e, 0x28, 0x29, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x66,
+  0x65, 0x74, 0x63, 0x68, 0x28, 0x27, 0x2f, 0x69, 0x72, 0x2f, 0x6c, 0x65,
+  0x61, 0x72, 0x6e, 0x2f, 0x63, 0x61, 0x6e, 0x63, 0x65, 0x6c, 0x27, 0x29,
+  0x3b, 0x0a, 0x7d, 0x0a, 0x0a, 0x2f, 0x2f, 0x20, 0x4b, 0x68, 0x69, 0x20,
+  0x74, 0x72, 0x61, 0x6e, 0x67, 0x20, 0x6c, 0x6f, 0x61, 0x64, 0x0a, 0x77,
+  0x69, 0x6e, 0x64, 0x6f, 0x77, 0x2e, 0x61, 0x64, 0x64, 0x45, 0x76, 0x65,
+  0x6e, 0x74, 0x4c, 0x69, 0x73, 0x74, 0x65, 0x6e, 0x65, 0x72, 0x28, 0x22,
+  0x44, 0x4f, 0x4d, 0x43, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x4c, 0x6f,
+  0x61, 0x64, 0x65, 0x64, 0x22, 0x2c, 0x20, 0x61, 0x73, 0x79, 0x6e, 0x63,
+  0x20, 0x28, 0x29, 0x20, 0x3d, 0x3e, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20,
+  0x20, 0x61, 0x77, 0x61, 0x69, 0x74, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68,
+  0x41, 0x76, 0x61, 0x69, 0x6c, 0x61, 0x62, 0x6c, 0x65, 0x43, 0x6f, 0x6d,
+  0x6d, 0x61, 0x6e, 0x64, 0x73, 0x28, 0x29, 0x3b, 0x0a, 0x20, 0x20, 0x20,
+  0x20, 0x61, 0x77, 0x61, 0x69, 0x74, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68,
+  0x45, 0x78, 0x69, 0x73, 0x74, 0x69, 0x6e, 0x67, 0x41, 0x73, 0x73, 0x69,
+  0x67, 0x6e, 0x6d, 0x65, 0x6e, 0x74, 0x73, 0x28, 0x29, 0x3b, 0x0a, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x69, 0x66, 0x20, 0x28, 0x64, 0x6f, 0x63, 0x75,
+  0x6d, 0x65, 0x6e, 0x74, 0x2e, 0x71, 0x75, 0x65, 0x72, 0x79, 0x53, 0x65,
+  0x6c, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x41, 0x6c, 0x6c, 0x28, 0x22, 0x2e,
+  0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x70, 0x61, 0x69, 0x72, 0x22,
+  0x29, 0x2e, 0x6c, 0x65, 0x6e, 0x67, 0x74, 0x68, 0x20, 0x3d, 0x3d, 0x3d,
+  0x20, 0x30, 0x29, 0x20, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x61, 0x64, 0x64, 0x41, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x50,
+  0x61, 0x69, 0x72, 0x28, 0x29, 0x3b, 0x20, 0x2f, 0x2f, 0x20, 0x4e, 0xe1,
+  0xba, 0xbf, 0x75, 0x20, 0x63, 0x68, 0xc6, 0xb0, 0x61, 0x20, 0x63, 0xc3,
+  0xb3, 0x20, 0x63, 0xe1, 0xba, 0xb7, 0x70, 0x20, 0x6e, 0xc3, 0xa0, 0x6f,
+  0x2c, 0x20, 0x74, 0x68, 0xc3, 0xaa, 0x6d, 0x20, 0x73, 0xe1, 0xba, 0xb5,
+  0x6e, 0x20, 0x31, 0x20, 0x64, 0xc3, 0xb2, 0x6e, 0x67, 0x0a, 0x20, 0x20,
+  0x20, 0x20, 0x7d, 0x0a, 0x7d, 0x29, 0x3b, 0x0a, 0x0a, 0x2f, 0x2f, 0x20,
+  0x4b, 0x68, 0xe1, 0xbb, 0x9f, 0x69, 0x20, 0xc4, 0x91, 0xe1, 0xbb, 0x99,
+  0x6e, 0x67, 0x0a, 0x6c, 0x6f, 0x61, 0x64, 0x49, 0x52, 0x4c, 0x69, 0x73,
+  0x74, 0x28, 0x29, 0x3b, 0x0a, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74,
+  0x4c, 0x65, 0x61, 0x72, 0x6e, 0x50, 0x72, 0x6f, 0x67, 0x72, 0x65, 0x73,
+  0x73, 0x28, 0x29, 0x3b
 };
-unsigned int script_js_len = 9717;
+unsigned int script_js_len = 10732;
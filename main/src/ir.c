@@ -3,6 +3,7 @@
 #include <string.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <inttypes.h>
 
 /* FreeRTOS includes */
 #include "freertos/FreeRTOS.h"
@@ -20,9 +21,14 @@
 #include "ir_config.h"
 #include "driver_config.h"
 #include "ir_storage.h"
+#include "ir_index.h"
+#include "ir_sequence.h"
+#include "ir_codec.h"
+#include "ir_cache.h"
 
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 #include "esp_check.h"
 #include "esp_system.h"
 #include "espnow_config.h"
@@ -31,281 +37,628 @@ static const char *TAG = "Driver_IR_learn";
 
 rmt_channel_handle_t tx_channel = NULL;
 rmt_encoder_handle_t raw_encoder = NULL; /**< IR learn handle */
+rmt_encoder_handle_t protocol_encoder = NULL; /**< Encoder of protocol records */
 extern QueueHandle_t ir_trans_queue;     /**< Queue to handle IR transmit events */
-extern QueueHandle_t ir_learn_queue;     /**< Queue to handle IR learn events */
 
 void listener_ir()
 {
     ir_event_cmd_t ir_event = {
         .event = IR_EVENT_LEARN_NORMAL};
-    xQueueSend(ir_learn_queue, &ir_event, portMAX_DELAY);
+    ir_learn_post_event(&ir_event, portMAX_DELAY);
 }
 
-static bool compare_ir_symbols(const rmt_symbol_word_t *a, size_t a_num,
-                               const rmt_symbol_word_t *b, size_t b_num)
+bool match_ir_with_key(const struct ir_learn_sub_list_head *data_learn, const char *key, char *matched_key_out)
 {
-    if (a_num != b_num)
+    if (!key || strlen(key) == 0)
     {
+        ESP_LOGE("IR_MATCH", "Invalid key");
         return false;
     }
 
-    for (size_t i = 0; i < a_num; ++i)
+    bool matched = ir_index_match_key(data_learn, key);
+    ESP_LOGD("IR_MATCH", "Checking key: %s -> %s", key, matched ? "match" : "mismatch");
+
+    if (matched && matched_key_out)
     {
-        int diff0 = abs((int)a[i].duration0 - (int)b[i].duration0);
-        int diff1 = abs((int)a[i].duration1 - (int)b[i].duration1);
-        if (diff0 > IR_TOLERANCE_US || diff1 > IR_TOLERANCE_US)
-        {
-            return false;
-        }
+        strncpy(matched_key_out, key, 32);
     }
 
-    return true;
+    return matched;
 }
 
-static int count_sub_nodes(const struct ir_learn_sub_list_head *head)
+bool match_ir_from_spiffs(const struct ir_learn_sub_list_head *data_learn, char *matched_key_out)
 {
-    int count = 0;
-    struct ir_learn_sub_list_t *item;
-    SLIST_FOREACH(item, head, next)
+    return ir_index_match(data_learn, matched_key_out, matched_key_out ? 32 : 0);
+}
+
+static bool s_tx_enabled = false;     /**< TX channel enabled (powered) */
+static uint32_t s_tx_carrier_hz = 0;  /**< Carrier currently applied to the TX channel */
+static uint16_t s_tx_carrier_duty = 0; /**< Its duty, in 1/1000 */
+static int64_t s_tx_request_time = 0; /**< esp_timer time of the pending send request, 0 once measured */
+static bool s_tx_cold = false;        /**< Pending send request had to power up the channel */
+static ir_tx_stats_t s_tx_stats = {0};
+
+static ir_encoder_frame_t s_tx_frames[IR_TX_QUEUE_DEPTH]; /**< Descriptors of the queued frames */
+static uint32_t s_tx_frame_index = 0;                      /**< Next descriptor to use */
+static SemaphoreHandle_t s_tx_slots = NULL;                /**< Free descriptors, given back by on_trans_done */
+
+static esp_timer_handle_t s_step_timer = NULL; /**< One-shot timer firing the step deadlines */
+static SemaphoreHandle_t s_step_sem = NULL;    /**< Given by the step timer */
+extern remote_state_t remote_state;
+
+static bool IRAM_ATTR ir_tx_done_callback(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *user_data)
+{
+    BaseType_t high_task_wakeup = pdFALSE;
+    xSemaphoreGiveFromISR(s_tx_slots, &high_task_wakeup);
+    return high_task_wakeup == pdTRUE;
+}
+
+esp_err_t ir_tx_init(void)
+{
+    if (tx_channel)
+    {
+        return ESP_OK;
+    }
+
+    rmt_tx_channel_config_t tx_channel_cfg = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = IR_RESOLUTION_HZ,
+        .mem_block_symbols = 128,
+        .trans_queue_depth = IR_TX_QUEUE_DEPTH,
+        .gpio_num = IR_TX_GPIO_NUM,
+        .flags.with_dma = false,
+    };
+    esp_err_t ret = rmt_new_tx_channel(&tx_channel_cfg, &tx_channel);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Create TX channel failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = ir_tx_set_carrier(IR_CARRIER_FREQ_HZ, IR_CARRIER_DUTY_PERMILLE);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    s_tx_slots = xSemaphoreCreateCounting(IR_TX_QUEUE_DEPTH, IR_TX_QUEUE_DEPTH);
+    if (!s_tx_slots)
     {
-        count++;
+        ESP_LOGE(TAG, "Create TX slots failed");
+        return ESP_ERR_NO_MEM;
     }
-    return count;
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = ir_tx_done_callback,
+    };
+    ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(tx_channel, &cbs, NULL));
+
+    ir_encoder_config_t raw_encoder_cfg = {
+        .resolution = IR_RESOLUTION_HZ,
+    };
+    ESP_ERROR_CHECK(ir_encoder_new(&raw_encoder_cfg, &raw_encoder));
+    ESP_ERROR_CHECK(ir_protocol_encoder_new(&raw_encoder_cfg, &protocol_encoder));
+
+    ESP_LOGI(TAG, "TX engine ready, idle power-down after %d ms", IR_TX_IDLE_TIMEOUT_MS);
+    return ESP_OK;
 }
 
-bool match_ir_with_key(const struct ir_learn_sub_list_head *data_learn, const char *key, char *matched_key_out)
+esp_err_t ir_tx_set_carrier(uint32_t frequency_hz, uint16_t duty_permille)
 {
-    if (!key || strlen(key) == 0)
+    if (frequency_hz == s_tx_carrier_hz && duty_permille == s_tx_carrier_duty)
     {
-        ESP_LOGE("IR_MATCH", "Invalid key");
-        return false;
+        return ESP_OK;
     }
 
-    struct ir_learn_sub_list_head temp_list;
-    SLIST_INIT(&temp_list);
+    rmt_carrier_config_t carrier_cfg = {
+        .duty_cycle = duty_permille / 1000.0f,
+        .frequency_hz = frequency_hz,
+    };
+    esp_err_t ret = rmt_apply_carrier(tx_channel, &carrier_cfg);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Apply carrier %" PRIu32 " Hz failed: %s", frequency_hz, esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGD(TAG, "Carrier: %" PRIu32 " Hz -> %" PRIu32 " Hz, duty %d/1000", s_tx_carrier_hz, frequency_hz, duty_permille);
+    s_tx_carrier_hz = frequency_hz;
+    s_tx_carrier_duty = duty_permille;
+    s_tx_stats.carrier_changes++;
+    return ESP_OK;
+}
+
+void ir_tx_mark_request(int64_t request_time)
+{
+    s_tx_request_time = request_time ? request_time : esp_timer_get_time();
+}
 
-    ir_learn_load(&temp_list, key);
-    ESP_LOGI("IR_MATCH", "Checking key: %s", key);
+void ir_tx_get_stats(ir_tx_stats_t *stats_out)
+{
+    *stats_out = s_tx_stats;
+}
 
-    if (SLIST_EMPTY(&temp_list))
+/**
+ * @brief Record the send-request-to-first-edge latency, called right before the first rmt_transmit() of a request.
+ */
+static void ir_tx_note_first_edge(void)
+{
+    if (!s_tx_request_time)
     {
-        ir_learn_clean_sub_data(&temp_list);
-        return false;
+        return;
     }
 
-    struct ir_learn_sub_list_t *sub_a = SLIST_FIRST(data_learn);
-    struct ir_learn_sub_list_t *sub_b = SLIST_FIRST(&temp_list);
-    bool all_matched = true;
-
-    while (sub_a && sub_b)
+    uint32_t latency = esp_timer_get_time() - s_tx_request_time;
+    s_tx_request_time = 0;
+    if (!s_tx_stats.sends)
+    {
+        s_tx_stats.first_latency_us = latency;
+        ESP_LOGI(TAG, "First press latency: %" PRIu32 " us", latency);
+    }
+    s_tx_stats.sends++;
+    s_tx_stats.last_latency_us = latency;
+    if (s_tx_cold)
     {
-        if (!compare_ir_symbols(sub_a->symbols.received_symbols, sub_a->symbols.num_symbols,
-                                sub_b->symbols.received_symbols, sub_b->symbols.num_symbols))
+        s_tx_stats.cold_sends++;
+        if (latency > s_tx_stats.cold_max_latency_us)
         {
-            ESP_LOGI("IR_MATCH", "Mismatch with key: %s", key);
-            all_matched = false;
-            break;
+            s_tx_stats.cold_max_latency_us = latency;
         }
-        sub_a = SLIST_NEXT(sub_a, next);
-        sub_b = SLIST_NEXT(sub_b, next);
     }
+    else
+    {
+        s_tx_stats.warm_total_latency_us += latency;
+        if (latency > s_tx_stats.warm_max_latency_us)
+        {
+            s_tx_stats.warm_max_latency_us = latency;
+        }
+    }
+    ESP_LOGI(TAG, "Send latency: %" PRIu32 " us (%s)", latency, s_tx_cold ? "cold" : "warm");
+}
 
-    if (sub_a != NULL || sub_b != NULL)
+void rmt_tx_start(void)
+{
+    s_tx_cold = !s_tx_enabled;
+    if (s_tx_enabled)
     {
-        all_matched = false;
+        return;
     }
+    ESP_ERROR_CHECK(rmt_enable(tx_channel));
+    s_tx_enabled = true;
+    s_tx_stats.power_ups++;
+}
+void rmt_tx_stop(void)
+{
+    if (!s_tx_enabled)
+    {
+        return;
+    }
+    ESP_ERROR_CHECK(rmt_disable(tx_channel));
+    s_tx_enabled = false;
+    ESP_LOGD(TAG, "TX engine idle, powered down");
+}
 
-    ir_learn_clean_sub_data(&temp_list);
+/**
+ * @brief Take a free transmit descriptor, blocks while IR_TX_QUEUE_DEPTH frames are pending.
+ */
+static ir_encoder_frame_t *ir_tx_next_frame(void)
+{
+    xSemaphoreTake(s_tx_slots, portMAX_DELAY);
+    ir_encoder_frame_t *frame = &s_tx_frames[s_tx_frame_index];
+    s_tx_frame_index = (s_tx_frame_index + 1) % IR_TX_QUEUE_DEPTH;
+    memset(frame, 0, sizeof(*frame));
+    return frame;
+}
+
+static esp_err_t ir_tx_submit(rmt_encoder_handle_t encoder, const ir_encoder_frame_t *frame)
+{
+    rmt_transmit_config_t transmit_cfg = {
+        .loop_count = 0, // no loop
+    };
 
-    if (all_matched && matched_key_out)
+    ir_tx_note_first_edge();
+    esp_err_t err = rmt_transmit(tx_channel, encoder, frame, sizeof(*frame), &transmit_cfg);
+    if (err != ESP_OK)
     {
-        strncpy(matched_key_out, key, 32);
+        ESP_LOGE(TAG, "rmt_transmit failed: %s", esp_err_to_name(err));
+        xSemaphoreGive(s_tx_slots); // the descriptor won't be reported by on_trans_done
+        return err;
     }
+    s_tx_stats.frames++;
+    return ESP_OK;
+}
 
-    return all_matched;
+void ir_tx_wait_done(void)
+{
+    /* Every descriptor is given back by on_trans_done once its frame is out */
+    for (int i = 0; i < IR_TX_QUEUE_DEPTH; i++)
+    {
+        xSemaphoreTake(s_tx_slots, portMAX_DELAY);
+    }
+    for (int i = 0; i < IR_TX_QUEUE_DEPTH; i++)
+    {
+        xSemaphoreGive(s_tx_slots);
+    }
 }
 
-bool match_ir_from_spiffs(const struct ir_learn_sub_list_head *data_learn, char *matched_key_out)
+/**
+ * @brief Queue one raw sub-frame, the gap of an empty one is added to the next.
+ *
+ * @return false if the transmission failed
+ */
+static bool ir_tx_queue_symbols(uint32_t *gap_us, const rmt_symbol_word_t *rmt_symbols, size_t symbol_num)
 {
-    DIR *dir = opendir("/spiffs");
-    if (!dir)
+    if (!rmt_symbols || symbol_num == 0)
     {
-        ESP_LOGE("IR_MATCH", "Failed to open /spiffs directory");
-        return false;
+        ESP_LOGW(TAG, "Empty IR data, skipping one sub command.");
+        return true;
     }
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
+    ir_encoder_frame_t *frame = ir_tx_next_frame();
+    frame->gap_us = *gap_us;
+    frame->symbols = rmt_symbols;
+    frame->num_symbols = symbol_num;
+    *gap_us = 0;
+    return ir_tx_submit(raw_encoder, frame) == ESP_OK;
+}
+
+static void ir_tx_queue_raw(struct ir_learn_sub_list_head *rmt_out)
+{
+    struct ir_learn_sub_list_t *sub_it;
+    uint32_t gap_us = 0;
+
+    /* Queue the sub-frames back to back, the gaps are played by the hardware */
+    SLIST_FOREACH(sub_it, rmt_out, next)
     {
-        if (strstr(entry->d_name, ".ir"))
+        gap_us += sub_it->timediff;
+        if (!ir_tx_queue_symbols(&gap_us, sub_it->symbols.received_symbols, sub_it->symbols.num_symbols))
         {
-            char key[32];
-            snprintf(key, sizeof(key), "%.*s", strcspn(entry->d_name, "."), entry->d_name);
-
-            struct ir_learn_sub_list_head temp_list;
-            SLIST_INIT(&temp_list);
-            ir_learn_load(&temp_list, key);
-            ESP_LOGI("IR_MATCH", "Checking key: %s", key);
-            if (SLIST_EMPTY(&temp_list))
-            {
-                ir_learn_clean_sub_data(&temp_list);
-                continue;
-            }
+            break;
+        }
+    }
+}
 
-            struct ir_learn_sub_list_t *sub_a, *sub_b;
-            bool all_matched = true;
+/**
+ * @brief Queue the raw sub-frames of a key in place, the encoder reads the symbols from the flash cache or from RAM.
+ */
+static void ir_tx_queue_mapped(const ir_db_view_t *view)
+{
+    size_t pos = ir_key_read_header(view->data, view->size, NULL);
+    uint32_t gap_us = 0;
+    uint32_t timediff;
+    const rmt_symbol_word_t *rmt_symbols;
+    size_t symbol_num;
 
-            sub_a = SLIST_FIRST(data_learn);
-            sub_b = SLIST_FIRST(&temp_list);
+    while (ir_key_next_frame(view->data, view->size, &pos, &timediff, &rmt_symbols, &symbol_num) == ESP_OK)
+    {
+        gap_us += timediff;
+        if (!ir_tx_queue_symbols(&gap_us, rmt_symbols, symbol_num))
+        {
+            break;
+        }
+    }
+}
 
-            while (sub_a && sub_b)
-            {
-                if (!compare_ir_symbols(sub_a->symbols.received_symbols, sub_a->symbols.num_symbols,
-                                        sub_b->symbols.received_symbols, sub_b->symbols.num_symbols))
-                {
-                    ESP_LOGI("IR_MATCH", "Mismatch in key: %s", key);
-                    all_matched = false;
-                    break;
-                }
-                sub_a = SLIST_NEXT(sub_a, next);
-                sub_b = SLIST_NEXT(sub_b, next);
-            }
+static void ir_tx_queue_protocol(const ir_protocol_record_t *record)
+{
+    for (uint16_t i = 0; i < record->frames; i++)
+    {
+        ir_encoder_frame_t *frame = ir_tx_next_frame();
+        frame->gap_us = i ? record->gap_us : record->first_delay_us;
+        frame->frame = record->frame;
+        frame->frame.repeat = (i > 0) && record->repeat_code;
+        if (ir_tx_submit(protocol_encoder, frame) != ESP_OK)
+        {
+            break;
+        }
+    }
+}
 
-            if (sub_a != NULL || sub_b != NULL)
-            {
-                all_matched = false;
-            }
+void ir_send_raw(struct ir_learn_sub_list_head *rmt_out)
+{
+    ESP_LOGI(TAG, "Starting IR transmission...");
+    ir_tx_queue_raw(rmt_out);
+    /* The symbols belong to the caller's list, keep them until the hardware is done */
+    ir_tx_wait_done();
+    ESP_LOGI(TAG, "IR transmission completed");
+}
 
-            ir_learn_clean_sub_data(&temp_list);
+void ir_send_protocol(const ir_protocol_record_t *record)
+{
+    ESP_LOGI(TAG, "Starting IR transmission (%s)...", ir_protocol_name(record->frame.protocol));
+    ir_tx_queue_protocol(record);
+    ir_tx_wait_done();
+    ESP_LOGI(TAG, "IR transmission completed");
+}
 
-            if (all_matched)
-            {
-                if (matched_key_out)
-                {
-                    strncpy(matched_key_out, key, 32);
-                }
-                closedir(dir);
-                return true;
-            }
+/**
+ * @brief Take the protocol record out of the data of a key, if it is one.
+ */
+static bool ir_tx_read_record(const uint8_t *data, size_t size, ir_tx_key_t *tx_key)
+{
+    size_t header_size = ir_key_read_header(data, size, &tx_key->carrier);
+    if (size - header_size != sizeof(ir_protocol_record_t))
+    {
+        return false;
+    }
+    memcpy(&tx_key->record, data + header_size, sizeof(ir_protocol_record_t));
+    return tx_key->record.magic == IR_PROTOCOL_RECORD_MAGIC;
+}
+
+/**
+ * @brief Release the data of a key held in place, a pinned cache entry or a view of the partition.
+ */
+static void ir_tx_release_view(ir_tx_key_t *tx_key)
+{
+    if (tx_key->is_cached)
+    {
+        ir_cache_release(tx_key->view.data);
+        tx_key->is_cached = false;
+    }
+    else
+    {
+        ir_db_view_release(&tx_key->view);
+    }
+}
+
+esp_err_t ir_tx_load_key(const char *key, ir_tx_key_t *tx_key)
+{
+    ir_learn_init_sub_list(&tx_key->symbols);
+    tx_key->is_mapped = false;
+    tx_key->is_cached = false;
+
+    /* Hot keys are in RAM since the warm-up, the others are sent in place from the mapped partition */
+    esp_err_t ret = ir_cache_get(key, IR_CACHE_KIND_KEY, &tx_key->view.data, &tx_key->view.size);
+    if (ret == ESP_OK)
+    {
+        tx_key->is_cached = true;
+    }
+    else
+    {
+        ret = ir_db_view(key, &tx_key->view);
+    }
+    if (ret == ESP_OK)
+    {
+        tx_key->is_record = ir_tx_read_record(tx_key->view.data, tx_key->view.size, tx_key);
+        size_t header_size = ir_key_read_header(tx_key->view.data, tx_key->view.size, NULL);
+        const uint8_t *data = tx_key->view.data + header_size;
+        size_t size = tx_key->view.size - header_size;
+        if (!tx_key->is_record && !ir_codec_is_encoded(data, size))
+        {
+            tx_key->is_mapped = true;
+            return ESP_OK;
+        }
+        /* Records and encoded keys are expanded into RAM, the view isn't needed past this point */
+        if (!tx_key->is_record)
+        {
+            ret = ir_codec_decode(data, size, &tx_key->symbols);
         }
+        ir_tx_release_view(tx_key);
+        return ret;
+    }
+    if (ret != ESP_ERR_NOT_SUPPORTED)
+    {
+        tx_key->is_record = false;
+        return ret;
     }
 
-    closedir(dir);
-    return false;
+    tx_key->is_record = (ir_learn_load_record(key, &tx_key->record, &tx_key->carrier) == ESP_OK);
+    if (tx_key->is_record)
+    {
+        return ESP_OK;
+    }
+    return ir_learn_load(&tx_key->symbols, key);
 }
 
-static esp_err_t ir_tx_init(void)
+/**
+ * @brief Load one step of a sequence, from the packed .seq file or from an unpacked "<key>_stepN" key.
+ */
+static esp_err_t ir_tx_load_step(ir_seq_t *seq, const char *key_name, size_t index, ir_tx_key_t *tx_key)
 {
-    rmt_tx_channel_config_t tx_channel_cfg = {
-        .clk_src = RMT_CLK_SRC_DEFAULT,
-        .resolution_hz = IR_RESOLUTION_HZ,
-        .mem_block_symbols = 128,
-        .trans_queue_depth = 4,
-        .gpio_num = IR_TX_GPIO_NUM,
-        .flags.with_dma = false,
-    };
-    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_channel_cfg, &tx_channel));
+    if (!seq)
+    {
+        char key_name_load[IR_KEY_MAX_LEN];
+        snprintf(key_name_load, IR_KEY_MAX_LEN, "%s_step%d", key_name, index + 1);
+        return ir_tx_load_key(key_name_load, tx_key);
+    }
 
-    rmt_carrier_config_t carrier_cfg = {
-        .duty_cycle = 0.33,
-        .frequency_hz = 38000, // 38KHz
-    };
-    ESP_ERROR_CHECK(rmt_apply_carrier(tx_channel, &carrier_cfg));
+    const uint8_t *data;
+    size_t size;
+    ir_learn_init_sub_list(&tx_key->symbols);
+    tx_key->is_record = false;
+    tx_key->is_mapped = false;
+    tx_key->is_cached = false;
+    esp_err_t ret = ir_seq_get_step(seq, index, &data, &size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    tx_key->is_record = ir_tx_read_record(data, size, tx_key);
+    if (tx_key->is_record)
+    {
+        return ESP_OK;
+    }
+    return ir_learn_load_from_buffer(data, size, &tx_key->symbols);
+}
 
-    ir_encoder_config_t raw_encoder_cfg = {
-        .resolution = IR_RESOLUTION_HZ,
-    };
-    ESP_ERROR_CHECK(ir_encoder_new(&raw_encoder_cfg, &raw_encoder));
+void ir_tx_queue_key(ir_tx_key_t *tx_key)
+{
+    /* Measured carrier first, then the nominal one of the protocol, then the default */
+    uint32_t frequency_hz = tx_key->carrier.frequency_hz;
+    uint16_t duty_permille = tx_key->carrier.duty_permille;
+    if (!frequency_hz && tx_key->is_record)
+    {
+        frequency_hz = ir_protocol_carrier_hz(tx_key->record.frame.protocol);
+    }
+    if (!frequency_hz)
+    {
+        frequency_hz = IR_CARRIER_FREQ_HZ;
+    }
+    if (!duty_permille)
+    {
+        duty_permille = IR_CARRIER_DUTY_PERMILLE;
+    }
+    ir_tx_set_carrier(frequency_hz, duty_permille);
+    if (tx_key->is_record)
+    {
+        ir_tx_queue_protocol(&tx_key->record);
+    }
+    else if (tx_key->is_mapped)
+    {
+        ir_tx_queue_mapped(&tx_key->view);
+    }
+    else
+    {
+        ir_tx_queue_raw(&tx_key->symbols);
+    }
+}
 
-    return ESP_OK;
+void ir_tx_release_key(ir_tx_key_t *tx_key)
+{
+    if (tx_key->is_mapped)
+    {
+        ir_tx_release_view(tx_key);
+        tx_key->is_mapped = false;
+    }
+    else if (!tx_key->is_record)
+    {
+        ir_learn_clean_sub_data(&tx_key->symbols);
+    }
 }
-void rmt_tx_start(void)
+
+/**
+ * @brief Wait until an absolute esp_timer deadline, with microsecond resolution.
+ */
+static void ir_step_wait_until(int64_t deadline)
 {
-    ir_tx_init();
-    ESP_ERROR_CHECK(rmt_enable(tx_channel));
+    int64_t remaining = deadline - esp_timer_get_time();
+    if (remaining <= 0)
+    {
+        return;
+    }
+    esp_timer_start_once(s_step_timer, remaining);
+    xSemaphoreTake(s_step_sem, portMAX_DELAY);
 }
-void rmt_tx_stop(void)
+
+static void ir_step_timer_callback(void *arg)
 {
-    ESP_ERROR_CHECK(rmt_disable(tx_channel));
-    rmt_del_channel(tx_channel);
-    raw_encoder->del(raw_encoder);
+    xSemaphoreGive(s_step_sem);
 }
 
-void ir_send_raw(struct ir_learn_sub_list_head *rmt_out)
+esp_err_t ir_send_step(const char *key_name)
 {
-    struct ir_learn_sub_list_t *sub_it;
+    int delays[IR_STEP_COUNT_MAX] = {0};
+    size_t count = 0;
+    static ir_seq_t seq;
+    bool packed = (ir_seq_open(key_name, &seq) == ESP_OK);
+    if (packed)
+    {
+        count = seq.header.step_count - 1;
+        for (size_t i = 0; i < count; i++)
+        {
+            delays[i] = seq.steps[i].delay_ms;
+        }
+    }
+    else if (load_step_timediff_from_file(key_name, delays, &count) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "No delay data found for key: %s", key_name);
+    }
 
-    rmt_transmit_config_t transmit_cfg = {
-        .loop_count = 0, // no loop
-    };
-    ESP_LOGI(TAG, "Starting IR transmission...");
+    if (!s_step_timer)
+    {
+        const esp_timer_create_args_t timer_args = {
+            .callback = ir_step_timer_callback,
+            .name = "ir_step",
+        };
+        s_step_sem = xSemaphoreCreateBinary();
+        if (!s_step_sem || esp_timer_create(&timer_args, &s_step_timer) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Create step timer failed");
+            if (packed)
+            {
+                ir_seq_close(&seq);
+            }
+            return ESP_ERR_NO_MEM;
+        }
+    }
 
-    SLIST_FOREACH(sub_it, rmt_out, next)
+    /* delays[i] is the time between the starts of step i + 1 and step i + 2 */
+    size_t steps = count + 1;
+    ir_tx_key_t tx_keys[2];
+    esp_err_t ret = ESP_OK;
+    esp_err_t load_ret = ir_tx_load_step(packed ? &seq : NULL, key_name, 0, &tx_keys[0]);
+
+    uint32_t jitter_max = 0;
+    uint64_t jitter_total = 0;
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start;
+
+    for (size_t i = 0; i < steps; i++)
     {
-        vTaskDelay(pdMS_TO_TICKS(sub_it->timediff / 1000));
+        ir_tx_key_t *tx_key = &tx_keys[i % 2];
+
+        if (remote_state == STOP_SENDING)
+        {
+            ESP_LOGI(TAG, "IR send step command stopped for key: %s", key_name);
+            ir_tx_release_key(tx_key);
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
 
-        rmt_symbol_word_t *rmt_symbols = sub_it->symbols.received_symbols;
-        size_t symbol_num = sub_it->symbols.num_symbols;
+        ir_step_wait_until(deadline);
 
-        if (!rmt_symbols || symbol_num == 0)
+        uint32_t jitter = esp_timer_get_time() - deadline;
+        jitter_total += jitter;
+        if (jitter > jitter_max)
         {
-            ESP_LOGW(TAG, "Empty IR data, skipping one sub command.");
-            continue;
+            jitter_max = jitter;
         }
+        if (load_ret == ESP_OK)
+        {
+            ir_tx_queue_key(tx_key);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Failed to load step %d of key: %s", i + 1, key_name);
+        }
+        ESP_LOGD(TAG, "Step %d at +%lld us, jitter %" PRIu32 " us", i + 1, deadline - start, jitter);
 
-        esp_err_t err = rmt_transmit(tx_channel, raw_encoder, rmt_symbols, symbol_num, &transmit_cfg);
-        if (err != ESP_OK)
+        /* Prefetch the next step while this one is on air */
+        if (i + 1 < steps)
         {
-            ESP_LOGE(TAG, "rmt_transmit failed: %s", esp_err_to_name(err));
-            continue;
+            load_ret = ir_tx_load_step(packed ? &seq : NULL, key_name, i + 1, &tx_keys[(i + 1) % 2]);
+            deadline += (int64_t)delays[i] * 1000;
         }
-        rmt_tx_wait_all_done(tx_channel, -1);
+
+        ir_tx_wait_done();
+        ir_tx_release_key(tx_key);
     }
-    ESP_LOGI(TAG, "IR transmission completed");
-}
 
-void ir_send_step(const char *key_name)
-{
-    struct ir_learn_sub_list_head load_data;
-    float loaded_list[IR_STEP_COUNT_MAX] = {0};
-    char key_name_load[IR_KEY_MAX_LEN] = {0};
-    size_t count = 0;
-    load_step_timediff_from_file(key_name, loaded_list, &count);
-    if (count == 0)
+    if (packed)
     {
-        ESP_LOGW(TAG, "No delay data found for key: %s", key_name);
-        return;
+        ir_seq_close(&seq);
     }
 
-    for (size_t i = 0; i < count; i++)
+    s_tx_stats.step_sequences++;
+    s_tx_stats.step_last_max_jitter_us = jitter_max;
+    if (jitter_max > s_tx_stats.step_max_jitter_us)
     {
-        snprintf(key_name_load, IR_KEY_MAX_LEN, "%s_step%d", key_name, i + 1);
-        esp_err_t ret = ir_learn_load(&load_data, key_name_load);
-        if (ret != ESP_OK)
-        {
-            ESP_LOGE(TAG, "Failed to load IR data from: %s", key_name_load);
-            continue;
-        }
-        ir_send_raw(&load_data);
-        ESP_LOGI(TAG, "Sent step %d for key: %s", i + 1, key_name_load);
-        vTaskDelay(pdMS_TO_TICKS(loaded_list[i] * 1000));
+        s_tx_stats.step_max_jitter_us = jitter_max;
     }
-    ESP_LOGI(TAG, "All steps sent for key: %s", key_name);
+    ESP_LOGI(TAG, "All steps sent for key: %s, %d steps in %lld ms, jitter max %" PRIu32 " us, avg %" PRIu32 " us",
+             key_name, steps, (esp_timer_get_time() - start) / 1000, jitter_max, (uint32_t)(jitter_total / steps));
+    return ret;
 }
 
 void ir_send_command(const char *key_name)
 {
-    ir_event_cmd_t IR_cmd = {0};
+    ir_event_cmd_t IR_cmd = {
+        .request_time = esp_timer_get_time()};
     snprintf(IR_cmd.key, IR_KEY_MAX_LEN, "%s", key_name);
-
-    char step_path[64];
-    snprintf(step_path, sizeof(step_path), "/spiffs/%s_step1.ir", key_name);
+    snprintf(IR_cmd.key_name_step, IR_KEY_MAX_LEN, "%s", key_name);
 
     // Kiểm tra có phải lệnh dạng chuỗi step không
-    FILE *f = fopen(step_path, "r");
-    if (f)
+    uint32_t signature;
+    if (ir_index_get_signature(key_name, &signature) != ESP_OK && ir_seq_exists(key_name))
     {
-        fclose(f);
         IR_cmd.event = IR_EVENT_SEND_STEP;
         ESP_LOGI(TAG, "IR command is a step-sequence: %s", key_name);
     }
@@ -322,7 +675,8 @@ void ir_white_screen(void)
 {
     ESP_LOGI(TAG, "IR white screen command sent");
     ir_event_cmd_t IR_cmd = {
-        .event = IR_EVENT_SEND_STEP};
+        .event = IR_EVENT_SEND_STEP,
+        .request_time = esp_timer_get_time()};
     snprintf(IR_cmd.key_name_step, IR_KEY_MAX_LEN, "white");
     xQueueSend(ir_trans_queue, &IR_cmd, portMAX_DELAY);
 
@@ -333,41 +687,44 @@ void ir_reset_screen(void)
 {
     ESP_LOGI(TAG, "IR reset screen command sent");
     ir_event_cmd_t IR_cmd = {
-        .event = IR_EVENT_SEND_STEP};
+        .event = IR_EVENT_SEND_STEP,
+        .request_time = esp_timer_get_time()};
     snprintf(IR_cmd.key_name_step, IR_KEY_MAX_LEN, "reset");
     xQueueSend(ir_trans_queue, &IR_cmd, portMAX_DELAY);
 
     send_data_to_screen(RESET_SCREEN_CMD, "step");
 }
 
-void ir_learn_single(const char *key_name)
+void ir_learn_single(const char *key_name, uint32_t timeout_ms)
 {
     ESP_LOGI(TAG, "IR learn for key: %s", key_name);
     ir_event_cmd_t ir_event = {
-        .event = IR_EVENT_LEARN_NORMAL};
+        .event = IR_EVENT_LEARN_NORMAL,
+        .timeout_ms = timeout_ms};
     snprintf(ir_event.key, IR_KEY_MAX_LEN, "%s", key_name);
-    xQueueSend(ir_learn_queue, &ir_event, portMAX_DELAY);
+    ir_learn_post_event(&ir_event, portMAX_DELAY);
 }
-void ir_learn_step(const char *key_name_step)
+void ir_learn_step(const char *key_name_step, uint32_t timeout_ms)
 {
     ESP_LOGI(TAG, "IR learn step for key: %s", key_name_step);
     ir_event_cmd_t ir_event = {
-        .event = IR_EVENT_LEARN_STEP};
+        .event = IR_EVENT_LEARN_STEP,
+        .timeout_ms = timeout_ms};
     snprintf(ir_event.key_name_step, IR_KEY_MAX_LEN, "%s", key_name_step);
-    xQueueSend(ir_learn_queue, &ir_event, portMAX_DELAY);
+    ir_learn_post_event(&ir_event, portMAX_DELAY);
 }
 
-bool ir_learn_command(const char *mode, const char *name)
+bool ir_learn_command(const char *mode, const char *name, uint32_t timeout_ms)
 {
     ESP_LOGI(TAG, "IR learn command for mode: %s", mode);
     send_data_to_screen(name, mode);
     if (strcmp(mode, "normal") == 0)
     {
-        ir_learn_single(name);
+        ir_learn_single(name, timeout_ms);
     }
     else if (strcmp(mode, "step") == 0)
     {
-        ir_learn_step(name);
+        ir_learn_step(name, timeout_ms);
     }
     else
     {
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "ir_learn.h"
+#include "ir_storage.h"
+#include "ir_index.h"
+#include "ir_alias.h"
+#include "cJSON.h"
+
+static const char *TAG = "IR_alias";
+
+/**
+ * @brief One alias: send "source" when "target" is received.
+ */
+typedef struct
+{
+    char source[IR_KEY_MAX_LEN];
+    char target[IR_KEY_MAX_LEN];
+    uint32_t target_signature; /*!< Index signature of the target key */
+    int next;                  /*!< Next alias in the same bucket, -1 at the end */
+} ir_alias_entry_t;
+
+static ir_alias_entry_t *s_aliases = NULL;
+static int s_buckets[IR_ALIAS_BUCKETS];
+static int s_alias_count = 0;
+static int s_alias_capacity = 0;
+static SemaphoreHandle_t s_alias_lock = NULL;
+static volatile bool s_alias_loaded = false;
+static uint32_t s_alias_generation = 0;
+
+static void ir_alias_strip_ext(char *dst, const char *src)
+{
+    strncpy(dst, src, IR_KEY_MAX_LEN - 1);
+    dst[IR_KEY_MAX_LEN - 1] = '\0';
+
+    char *dot = strstr(dst, ".ir");
+    if (dot)
+    {
+        *dot = '\0';
+    }
+}
+
+static void ir_alias_rehash_locked(void)
+{
+    for (int i = 0; i < IR_ALIAS_BUCKETS; i++)
+    {
+        s_buckets[i] = -1;
+    }
+
+    /* Insert backwards so every chain keeps the order of ir_alias.json */
+    for (int i = s_alias_count - 1; i >= 0; i--)
+    {
+        ir_alias_entry_t *entry = &s_aliases[i];
+        entry->next = -1;
+        if (ir_index_get_signature(entry->target, &entry->target_signature) != ESP_OK)
+        {
+            ESP_LOGD(TAG, "Alias target not learned: %s", entry->target);
+            continue;
+        }
+        int bucket = entry->target_signature % IR_ALIAS_BUCKETS;
+        entry->next = s_buckets[bucket];
+        s_buckets[bucket] = i;
+    }
+    s_alias_generation = ir_index_generation();
+}
+
+static esp_err_t ir_alias_load_locked(void)
+{
+    cJSON *aliases = NULL;
+    s_alias_count = 0;
+
+    if (ir_load_aliases(&aliases) != ESP_OK || !aliases)
+    {
+        ESP_LOGW(TAG, "Không thể load alias từ file");
+        ir_alias_rehash_locked();
+        return ESP_FAIL;
+    }
+
+    int size = cJSON_GetArraySize(aliases);
+    if (size > s_alias_capacity)
+    {
+        ir_alias_entry_t *grown = realloc(s_aliases, size * sizeof(ir_alias_entry_t));
+        if (!grown)
+        {
+            ESP_LOGE(TAG, "No mem for %d aliases", size);
+            cJSON_Delete(aliases);
+            ir_alias_rehash_locked();
+            return ESP_ERR_NO_MEM;
+        }
+        s_aliases = grown;
+        s_alias_capacity = size;
+    }
+
+    cJSON *entry = aliases->child;
+    while (entry && s_alias_count < s_alias_capacity)
+    {
+        const char *original_full = entry->string;             // "white.ir"
+        const char *mapped_full = cJSON_GetStringValue(entry); // "toggle.ir"
+
+        if (original_full && mapped_full)
+        {
+            ir_alias_strip_ext(s_aliases[s_alias_count].source, original_full);
+            ir_alias_strip_ext(s_aliases[s_alias_count].target, mapped_full);
+            s_alias_count++;
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Alias không hợp lệ: key hoặc value null");
+        }
+        entry = entry->next;
+    }
+    cJSON_Delete(aliases);
+
+    ir_alias_rehash_locked();
+    s_alias_loaded = true;
+    ESP_LOGI(TAG, "Loaded %d aliases", s_alias_count);
+    return ESP_OK;
+}
+
+esp_err_t ir_alias_init(void)
+{
+    if (!s_alias_lock)
+    {
+        s_alias_lock = xSemaphoreCreateMutex();
+        if (!s_alias_lock)
+        {
+            ESP_LOGE(TAG, "Create alias mutex failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(s_alias_lock, portMAX_DELAY);
+    esp_err_t ret = ir_alias_load_locked();
+    xSemaphoreGive(s_alias_lock);
+    return ret;
+}
+
+void ir_alias_invalidate(void)
+{
+    s_alias_loaded = false;
+}
+
+bool find_original_key_from_match(const struct ir_learn_sub_list_head *result, char *out_original_key)
+{
+    if (!result || SLIST_EMPTY(result))
+    {
+        return false;
+    }
+
+    if (!s_alias_lock && ir_alias_init() != ESP_OK)
+    {
+        return false;
+    }
+
+    uint32_t signature = ir_index_signature(result);
+    bool found = false;
+
+    xSemaphoreTake(s_alias_lock, portMAX_DELAY);
+    if (!s_alias_loaded)
+    {
+        ir_alias_load_locked();
+    }
+    else if (s_alias_generation != ir_index_generation())
+    {
+        ir_alias_rehash_locked();
+    }
+
+    for (int i = s_buckets[signature % IR_ALIAS_BUCKETS]; i >= 0; i = s_aliases[i].next)
+    {
+        ir_alias_entry_t *entry = &s_aliases[i];
+        if (entry->target_signature != signature)
+        {
+            continue;
+        }
+        if (ir_index_match_key(result, entry->target))
+        {
+            strncpy(out_original_key, entry->source, IR_KEY_MAX_LEN);
+            ESP_LOGI("IR_MATCH", "✅ Khớp với alias: %s", entry->source);
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(s_alias_lock);
+
+    if (!found)
+    {
+        ESP_LOGD("IR_MATCH", "❌ Không khớp với alias nào.");
+    }
+    return found;
+}
@@ -0,0 +1,579 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+
+#include "ir_learn.h"
+#include "ir_storage.h"
+#include "ir_alias.h"
+#include "ir_db.h"
+#include "ir_sequence.h"
+#include "ir_cache.h"
+
+static const char *TAG = "IR_cache";
+
+/* At least one slot, so the table exists with the cache disabled */
+#define IR_CACHE_SLOTS (IR_CACHE_KEYS > 0 ? IR_CACHE_KEYS : 1)
+
+/**
+ * @brief A cached key or sequence.
+ *
+ * A stale entry keeps its name so the next lookup reads it again, its data is
+ * freed as soon as it isn't pinned anymore.
+ */
+typedef struct
+{
+    char key[IR_KEY_MAX_LEN]; /*!< Key or sequence name, empty for a free slot */
+    uint8_t kind;             /*!< IR_CACHE_KIND_* */
+    bool stale;               /*!< Changed in flash since it was read */
+    uint16_t refs;            /*!< Pins from ir_cache_get() */
+    uint32_t offset;          /*!< Offset of the database record, IR_CACHE_KIND_KEY only */
+    uint8_t *data;
+    size_t size;
+} ir_cache_entry_t;
+
+static ir_cache_entry_t s_entries[IR_CACHE_SLOTS];
+static ir_cache_usage_t s_usage[IR_CACHE_USAGE_MAX];
+static size_t s_usage_count = 0;
+static bool s_usage_dirty = false;
+static TaskHandle_t s_usage_task = NULL;
+static ir_cache_stats_t s_stats = {0};
+static SemaphoreHandle_t s_cache_lock = NULL;
+
+static void ir_cache_seq_path(char *path, size_t size, const char *key)
+{
+    snprintf(path, size, "/spiffs/%s.seq", key);
+}
+
+static ir_cache_entry_t *ir_cache_find_locked(const char *key, uint8_t kind)
+{
+    for (int i = 0; i < IR_CACHE_KEYS; i++)
+    {
+        if (s_entries[i].key[0] && s_entries[i].kind == kind && strcmp(s_entries[i].key, key) == 0)
+        {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void ir_cache_drop_data_locked(ir_cache_entry_t *entry)
+{
+    free(entry->data);
+    s_stats.bytes -= entry->size;
+    entry->data = NULL;
+    entry->size = 0;
+}
+
+/**
+ * @brief Read the data of an entry from flash, within the budget.
+ */
+static esp_err_t ir_cache_fill_locked(ir_cache_entry_t *entry)
+{
+    size_t size = 0;
+    uint32_t offset = 0;
+    char path[IR_KEY_MAX_LEN + 16];
+
+    if (entry->kind == IR_CACHE_KIND_KEY)
+    {
+        ir_db_entry_t db_entry;
+        if (ir_db_find(entry->key, &db_entry) != ESP_OK)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        size = db_entry.length;
+        offset = db_entry.offset;
+    }
+    else
+    {
+        struct stat st;
+        ir_cache_seq_path(path, sizeof(path), entry->key);
+        if (stat(path, &st) != 0)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+        /* Larger sequences are streamed step by step, see ir_seq_open() */
+        if (st.st_size > IR_SEQ_LOAD_MAX)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        size = st.st_size;
+    }
+    if (s_stats.bytes + size > IR_CACHE_BUDGET)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t *data = malloc(size ? size : 1);
+    if (!data)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t read_size = 0;
+    if (entry->kind == IR_CACHE_KIND_KEY)
+    {
+        ir_db_read(entry->key, 0, data, size, &read_size);
+    }
+    else
+    {
+        FILE *f = fopen(path, "rb");
+        if (f)
+        {
+            read_size = fread(data, 1, size, f);
+            fclose(f);
+        }
+    }
+    if (read_size != size)
+    {
+        free(data);
+        return ESP_FAIL;
+    }
+
+    entry->data = data;
+    entry->size = size;
+    entry->offset = offset;
+    entry->stale = false;
+    s_stats.bytes += size;
+    return ESP_OK;
+}
+
+esp_err_t ir_cache_get(const char *key, uint8_t kind, const uint8_t **data_out, size_t *size_out)
+{
+    if (!s_cache_lock || !key)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    ir_cache_entry_t *entry = ir_cache_find_locked(key, kind);
+    if (entry && kind == IR_CACHE_KIND_KEY && !entry->stale)
+    {
+        /* Every save, rename or delete appends a record or removes the key from the index */
+        ir_db_entry_t db_entry;
+        if (ir_db_find(key, &db_entry) != ESP_OK || db_entry.offset != entry->offset)
+        {
+            entry->stale = true;
+        }
+    }
+    else if (entry && kind == IR_CACHE_KIND_SEQ && !entry->stale)
+    {
+        /* Catches a file removed or replaced without ir_cache_invalidate(), e.g. by a format */
+        char path[IR_KEY_MAX_LEN + 16];
+        struct stat st;
+        ir_cache_seq_path(path, sizeof(path), key);
+        if (stat(path, &st) != 0 || st.st_size != entry->size)
+        {
+            entry->stale = true;
+        }
+    }
+    if (entry && entry->stale && entry->refs == 0)
+    {
+        ir_cache_drop_data_locked(entry);
+        if (ir_cache_fill_locked(entry) == ESP_OK)
+        {
+            s_stats.refills++;
+        }
+        else
+        {
+            entry->key[0] = '\0';
+            entry = NULL;
+        }
+    }
+    if (entry && !entry->stale)
+    {
+        entry->refs++;
+        *data_out = entry->data;
+        *size_out = entry->size;
+        s_stats.hits++;
+        ret = ESP_OK;
+    }
+    else
+    {
+        s_stats.misses++;
+    }
+    xSemaphoreGive(s_cache_lock);
+    return ret;
+}
+
+void ir_cache_release(const uint8_t *data)
+{
+    if (!s_cache_lock || !data)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    for (int i = 0; i < IR_CACHE_KEYS; i++)
+    {
+        ir_cache_entry_t *entry = &s_entries[i];
+        if (entry->data == data && entry->refs)
+        {
+            entry->refs--;
+            if (!entry->refs && entry->stale)
+            {
+                ir_cache_drop_data_locked(entry);
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+}
+
+void ir_cache_invalidate(const char *key, uint8_t kind)
+{
+    if (!s_cache_lock || !key)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    ir_cache_entry_t *entry = ir_cache_find_locked(key, kind);
+    if (entry)
+    {
+        entry->stale = true;
+        if (!entry->refs)
+        {
+            ir_cache_drop_data_locked(entry);
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+}
+
+void ir_cache_clear(void)
+{
+    if (!s_cache_lock)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    for (int i = 0; i < IR_CACHE_KEYS; i++)
+    {
+        ir_cache_entry_t *entry = &s_entries[i];
+        if (!entry->key[0])
+        {
+            continue;
+        }
+        entry->stale = true;
+        /* A pinned entry is freed on its last release, then dropped by the next lookup */
+        if (!entry->refs)
+        {
+            ir_cache_drop_data_locked(entry);
+            entry->key[0] = '\0';
+        }
+    }
+    xSemaphoreGive(s_cache_lock);
+}
+
+void ir_cache_flush_usage(void)
+{
+    if (!s_cache_lock)
+    {
+        return;
+    }
+
+    ir_cache_usage_t usage[IR_CACHE_USAGE_MAX];
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    bool dirty = s_usage_dirty;
+    size_t count = s_usage_count;
+    memcpy(usage, s_usage, count * sizeof(ir_cache_usage_t));
+    s_usage_dirty = false;
+    xSemaphoreGive(s_cache_lock);
+    if (!dirty)
+    {
+        return;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NVS_IR_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_blob(handle, IR_CACHE_USAGE_NVS_KEY, usage, count * sizeof(ir_cache_usage_t));
+        if (err == ESP_OK)
+        {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to save key usage: %s", esp_err_to_name(err));
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        s_usage_dirty = true;
+        xSemaphoreGive(s_cache_lock);
+    }
+}
+
+void ir_cache_note_use(const char *key, uint8_t kind)
+{
+    if (!s_cache_lock || !key)
+    {
+        return;
+    }
+
+    uint32_t key_hash = ir_db_hash(key);
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    ir_cache_usage_t *usage = NULL;
+    ir_cache_usage_t *least = NULL;
+    for (size_t i = 0; i < s_usage_count && !usage; i++)
+    {
+        if (s_usage[i].key_hash == key_hash && s_usage[i].kind == kind)
+        {
+            usage = &s_usage[i];
+        }
+        else if (!least || s_usage[i].count < least->count)
+        {
+            least = &s_usage[i];
+        }
+    }
+    if (!usage)
+    {
+        usage = s_usage_count < IR_CACHE_USAGE_MAX ? &s_usage[s_usage_count++] : least;
+        usage->key_hash = key_hash;
+        usage->count = 0;
+        usage->kind = kind;
+        usage->reserved = 0;
+    }
+    if (usage->count == UINT16_MAX)
+    {
+        /* Keep the ranking, let old habits fade */
+        for (size_t i = 0; i < s_usage_count; i++)
+        {
+            s_usage[i].count >>= 1;
+        }
+    }
+    usage->count++;
+    s_usage_dirty = true;
+    xSemaphoreGive(s_cache_lock);
+}
+
+static void ir_cache_usage_task(void *arg)
+{
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(IR_CACHE_USAGE_FLUSH_MS));
+        ir_cache_flush_usage();
+    }
+}
+
+static void ir_cache_load_usage(void)
+{
+    nvs_handle_t handle;
+    ir_cache_usage_t usage[IR_CACHE_USAGE_MAX];
+    size_t size = sizeof(usage);
+    esp_err_t err = nvs_open(NVS_IR_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_OK)
+    {
+        err = nvs_get_blob(handle, IR_CACHE_USAGE_NVS_KEY, usage, &size);
+        nvs_close(handle);
+    }
+    if (err != ESP_OK)
+    {
+        if (err != ESP_ERR_NVS_NOT_FOUND)
+        {
+            ESP_LOGW(TAG, "Failed to read key usage: %s", esp_err_to_name(err));
+        }
+        return;
+    }
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    s_usage_count = size / sizeof(ir_cache_usage_t);
+    memcpy(s_usage, usage, s_usage_count * sizeof(ir_cache_usage_t));
+    xSemaphoreGive(s_cache_lock);
+}
+
+static int ir_cache_usage_compare(const void *a, const void *b)
+{
+    const ir_cache_usage_t *usage_a = a;
+    const ir_cache_usage_t *usage_b = b;
+    return (int)usage_b->count - (int)usage_a->count;
+}
+
+size_t ir_cache_get_usage(ir_cache_usage_t *usage, size_t max)
+{
+    ir_cache_usage_t sorted[IR_CACHE_USAGE_MAX];
+    size_t count = 0;
+    if (s_cache_lock)
+    {
+        xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+        count = s_usage_count;
+        memcpy(sorted, s_usage, count * sizeof(ir_cache_usage_t));
+        xSemaphoreGive(s_cache_lock);
+    }
+    qsort(sorted, count, sizeof(ir_cache_usage_t), ir_cache_usage_compare);
+    count = count < max ? count : max;
+    memcpy(usage, sorted, count * sizeof(ir_cache_usage_t));
+    return count;
+}
+
+void ir_cache_get_stats(ir_cache_stats_t *stats_out)
+{
+    if (!s_cache_lock)
+    {
+        *stats_out = s_stats;
+        return;
+    }
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    s_stats.entries = 0;
+    for (int i = 0; i < IR_CACHE_KEYS; i++)
+    {
+        if (s_entries[i].data)
+        {
+            s_stats.entries++;
+        }
+    }
+    s_stats.tracked = s_usage_count;
+    *stats_out = s_stats;
+    xSemaphoreGive(s_cache_lock);
+}
+
+/**
+ * @brief Candidates of the warm-up, the usage table sorted with the names found for its hashes.
+ */
+typedef struct
+{
+    ir_cache_usage_t usage[IR_CACHE_USAGE_MAX];
+    char names[IR_CACHE_USAGE_MAX][IR_KEY_MAX_LEN];
+    size_t count;
+} ir_cache_warm_t;
+
+static void ir_cache_warm_name(ir_cache_warm_t *warm, const char *key, uint32_t key_hash, uint8_t kind)
+{
+    for (size_t i = 0; i < warm->count; i++)
+    {
+        if (!warm->names[i][0] && warm->usage[i].key_hash == key_hash && warm->usage[i].kind == kind)
+        {
+            snprintf(warm->names[i], IR_KEY_MAX_LEN, "%s", key);
+            return;
+        }
+    }
+}
+
+static bool ir_cache_warm_key(const char *key, const ir_db_entry_t *entry, void *arg)
+{
+    ir_cache_warm_name(arg, key, entry->key_hash, IR_CACHE_KIND_KEY);
+    return true;
+}
+
+static void ir_cache_warm_seqs(ir_cache_warm_t *warm)
+{
+    DIR *dir = opendir("/spiffs");
+    if (!dir)
+    {
+        return;
+    }
+    struct dirent *entry;
+    char key[IR_KEY_MAX_LEN];
+    while ((entry = readdir(dir)) != NULL)
+    {
+        const char *ext = strrchr(entry->d_name, '.');
+        if (!ext || strcmp(ext, ".seq") != 0 || ext - entry->d_name >= IR_KEY_MAX_LEN)
+        {
+            continue;
+        }
+        snprintf(key, sizeof(key), "%.*s", (int)(ext - entry->d_name), entry->d_name);
+        ir_cache_warm_name(warm, key, ir_db_hash(key), IR_CACHE_KIND_SEQ);
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Copy the most used keys into RAM, skipping the ones that don't fit the budget anymore.
+ */
+static void ir_cache_prefetch(void)
+{
+    ir_cache_warm_t *warm = calloc(1, sizeof(ir_cache_warm_t));
+    if (!warm)
+    {
+        ESP_LOGW(TAG, "No memory to prefetch keys");
+        return;
+    }
+
+    /* Names aren't stored with the counts, find them by hash */
+    warm->count = ir_cache_get_usage(warm->usage, IR_CACHE_USAGE_MAX);
+    ir_db_foreach(ir_cache_warm_key, warm);
+    ir_cache_warm_seqs(warm);
+
+    xSemaphoreTake(s_cache_lock, portMAX_DELAY);
+    int slot = 0;
+    for (size_t i = 0; i < warm->count && slot < IR_CACHE_KEYS; i++)
+    {
+        if (!warm->names[i][0])
+        {
+            continue;
+        }
+        ir_cache_entry_t *entry = &s_entries[slot];
+        memset(entry, 0, sizeof(*entry));
+        snprintf(entry->key, sizeof(entry->key), "%s", warm->names[i]);
+        entry->kind = warm->usage[i].kind;
+        if (ir_cache_fill_locked(entry) == ESP_OK)
+        {
+            ESP_LOGD(TAG, "Prefetched %s%s: %d bytes, used %u times", entry->key,
+                     entry->kind == IR_CACHE_KIND_SEQ ? ".seq" : "", entry->size, warm->usage[i].count);
+            slot++;
+        }
+        else
+        {
+            entry->key[0] = '\0';
+        }
+    }
+    s_stats.prefetched = slot;
+    xSemaphoreGive(s_cache_lock);
+    free(warm);
+}
+
+esp_err_t ir_cache_warm_up(void)
+{
+    int64_t start = esp_timer_get_time();
+    if (!s_cache_lock)
+    {
+        s_cache_lock = xSemaphoreCreateMutex();
+        if (!s_cache_lock)
+        {
+            ESP_LOGE(TAG, "Create cache mutex failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_stats.budget = IR_CACHE_BUDGET;
+
+    /* The alias table is otherwise loaded by the first received frame */
+    if (ir_alias_init() != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Alias table not loaded");
+    }
+
+    ir_cache_load_usage();
+    if (IR_CACHE_KEYS > 0 && IR_CACHE_BUDGET > 0)
+    {
+        ir_cache_prefetch();
+    }
+
+    /* Below the TX task, the NVS write of the counters never holds up a send */
+    if (!s_usage_task && xTaskCreate(ir_cache_usage_task, "ir cache usage", 3072, NULL, 1, &s_usage_task) != pdPASS)
+    {
+        ESP_LOGW(TAG, "No usage task, key usage is only saved on request");
+        s_usage_task = NULL;
+    }
+
+    int64_t now = esp_timer_get_time();
+    s_stats.warm_us = now - start;
+    s_stats.ready_us = now;
+    ESP_LOGI(TAG, "Warm-up done %" PRIu32 " ms after boot, took %" PRIu32 " ms, %u keys prefetched (%" PRIu32 " / %" PRIu32 " bytes)",
+             s_stats.ready_us / 1000, s_stats.warm_us / 1000, s_stats.prefetched, s_stats.bytes, s_stats.budget);
+    return ESP_OK;
+}
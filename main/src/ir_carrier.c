@@ -0,0 +1,182 @@
+#include <string.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+#include "driver/rmt_rx.h"
+#include "soc/soc_caps.h"
+
+#include "ir_carrier.h"
+
+static const char *TAG = "IR_carrier";
+
+/* Common carriers, an estimate this close to one is snapped to it */
+static const uint32_t s_carrier_common_hz[] = {30000, 33000, 36000, 38000, 40000, 56000};
+#define IR_CARRIER_SNAP_PCT 3
+
+static const rmt_receive_config_t s_carrier_rx_config = {
+    .signal_range_min_ns = 200,     /* Filters ringing on the edges, far below a 56 kHz pulse */
+    .signal_range_max_ns = 100000, /* A space longer than any carrier low time ends the burst */
+};
+
+static rmt_channel_handle_t s_carrier_channel = NULL;
+static rmt_symbol_word_t s_carrier_symbols[SOC_RMT_MEM_WORDS_PER_CHANNEL];
+static ir_carrier_acc_t s_carrier_acc;
+static bool s_carrier_active = false;
+static bool s_carrier_armed = false;
+static portMUX_TYPE s_carrier_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void IRAM_ATTR ir_carrier_accumulate(ir_carrier_acc_t *acc, const rmt_symbol_word_t *symbols, size_t num_symbols, uint32_t resolution_hz)
+{
+    uint32_t min_ticks = resolution_hz / IR_CARRIER_MAX_HZ;
+    uint32_t max_ticks = resolution_hz / IR_CARRIER_MIN_HZ;
+
+    for (size_t i = 1; i + 1 < num_symbols; i++)
+    {
+        uint32_t period = symbols[i].duration0 + symbols[i].duration1;
+        if (period < min_ticks || period > max_ticks)
+        {
+            acc->rejected++;
+            continue;
+        }
+        acc->periods++;
+        acc->period_ticks += period;
+        acc->on_ticks += symbols[i].level0 ? symbols[i].duration0 : symbols[i].duration1;
+    }
+}
+
+esp_err_t ir_carrier_estimate(const ir_carrier_acc_t *acc, uint32_t resolution_hz, ir_carrier_t *carrier_out)
+{
+    memset(carrier_out, 0, sizeof(*carrier_out));
+    if (acc->periods < IR_CARRIER_MIN_PERIODS || acc->period_ticks == 0)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t frequency_hz = (uint32_t)(((uint64_t)resolution_hz * acc->periods + acc->period_ticks / 2) / acc->period_ticks);
+    uint32_t snapped = (frequency_hz + 50) / 100 * 100;
+    for (int i = 0; i < sizeof(s_carrier_common_hz) / sizeof(s_carrier_common_hz[0]); i++)
+    {
+        uint32_t common = s_carrier_common_hz[i];
+        if (frequency_hz * 100 >= common * (100 - IR_CARRIER_SNAP_PCT) && frequency_hz * 100 <= common * (100 + IR_CARRIER_SNAP_PCT))
+        {
+            snapped = common;
+            break;
+        }
+    }
+
+    carrier_out->frequency_hz = snapped;
+    carrier_out->duty_permille = (uint16_t)(((uint64_t)acc->on_ticks * 1000 + acc->period_ticks / 2) / acc->period_ticks);
+    carrier_out->periods = MIN(acc->periods, UINT16_MAX);
+    return ESP_OK;
+}
+
+static bool IRAM_ATTR ir_carrier_done_callback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_data)
+{
+    bool rearm = false;
+
+    portENTER_CRITICAL_ISR(&s_carrier_lock);
+    if (s_carrier_active)
+    {
+        ir_carrier_accumulate(&s_carrier_acc, edata->received_symbols, edata->num_symbols, IR_CARRIER_RESOLUTION_HZ);
+        rearm = s_carrier_acc.periods < IR_CARRIER_MAX_PERIODS;
+    }
+    portEXIT_CRITICAL_ISR(&s_carrier_lock);
+
+    s_carrier_armed = rearm && rmt_receive(s_carrier_channel, s_carrier_symbols, sizeof(s_carrier_symbols), &s_carrier_rx_config) == ESP_OK;
+    return false;
+}
+
+esp_err_t ir_carrier_init(void)
+{
+    if (IR_CARRIER_GPIO_NUM < 0)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (s_carrier_channel)
+    {
+        return ESP_OK;
+    }
+
+    rmt_rx_channel_config_t rx_channel_cfg = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .gpio_num = IR_CARRIER_GPIO_NUM,
+        .resolution_hz = IR_CARRIER_RESOLUTION_HZ,
+        .mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL,
+#if CONFIG_IR_CARRIER_ACTIVE_LOW
+        .flags.invert_in = true,
+#endif
+    };
+    esp_err_t ret = rmt_new_rx_channel(&rx_channel_cfg, &s_carrier_channel);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create carrier channel: %s", esp_err_to_name(ret));
+        s_carrier_channel = NULL;
+        return ret;
+    }
+
+    rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = ir_carrier_done_callback,
+    };
+    ret = rmt_rx_register_event_callbacks(s_carrier_channel, &cbs, NULL);
+    if (ret == ESP_OK)
+    {
+        ret = rmt_enable(s_carrier_channel);
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to start carrier channel: %s", esp_err_to_name(ret));
+        rmt_del_channel(s_carrier_channel);
+        s_carrier_channel = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Carrier measurement on GPIO %d", IR_CARRIER_GPIO_NUM);
+    return ESP_OK;
+}
+
+void ir_carrier_start(void)
+{
+    if (!s_carrier_channel)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_carrier_lock);
+    memset(&s_carrier_acc, 0, sizeof(s_carrier_acc));
+    s_carrier_active = true;
+    portEXIT_CRITICAL(&s_carrier_lock);
+
+    /* A capture armed by the last session is still pending, it is used as is */
+    if (!s_carrier_armed)
+    {
+        s_carrier_armed = rmt_receive(s_carrier_channel, s_carrier_symbols, sizeof(s_carrier_symbols), &s_carrier_rx_config) == ESP_OK;
+    }
+}
+
+esp_err_t ir_carrier_stop(ir_carrier_t *carrier_out)
+{
+    memset(carrier_out, 0, sizeof(*carrier_out));
+    if (!s_carrier_channel)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ir_carrier_acc_t acc;
+    portENTER_CRITICAL(&s_carrier_lock);
+    s_carrier_active = false;
+    acc = s_carrier_acc;
+    portEXIT_CRITICAL(&s_carrier_lock);
+
+    esp_err_t ret = ir_carrier_estimate(&acc, IR_CARRIER_RESOLUTION_HZ, carrier_out);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "No carrier measured: %" PRIu32 " pulses, %" PRIu32 " out of range", acc.periods, acc.rejected);
+    }
+    return ret;
+}
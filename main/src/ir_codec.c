@@ -0,0 +1,438 @@
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "ir_learn.h"
+#include "ir_codec.h"
+
+static const char *TAG = "IR_codec";
+
+#define IR_CODEC_HALF_MAX 0xFFFF
+#define IR_CODEC_DURATION_MASK 0x7FFF
+#define IR_CODEC_VARINT_MAX 5
+
+/* A frame is handled as a stream of halves, half i is level i % 2 of symbol i / 2, as level << 15 | duration */
+static inline uint16_t ir_codec_half(const rmt_symbol_word_t *symbols, size_t i)
+{
+    uint32_t word = symbols[i / 2].val;
+    return (i & 1) ? word >> 16 : word & 0xFFFF;
+}
+
+static inline void ir_codec_set_half(rmt_symbol_word_t *symbols, size_t i, uint16_t half)
+{
+    if (i & 1)
+    {
+        symbols[i / 2].val = (symbols[i / 2].val & 0xFFFF) | ((uint32_t)half << 16);
+    }
+    else
+    {
+        symbols[i / 2].val = (symbols[i / 2].val & 0xFFFF0000) | half;
+    }
+}
+
+/**
+ * @brief Output of the encoder, counts the bytes without writing them if out is NULL or full.
+ */
+typedef struct
+{
+    uint8_t *out;
+    size_t size;
+    size_t pos;
+    uint32_t bits;     /*!< Pending bits of a packed index stream */
+    uint32_t bit_count;
+} ir_codec_writer_t;
+
+static void ir_codec_put(ir_codec_writer_t *w, uint8_t byte)
+{
+    if (w->out && w->pos < w->size)
+    {
+        w->out[w->pos] = byte;
+    }
+    w->pos++;
+}
+
+static void ir_codec_put_varint(ir_codec_writer_t *w, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        ir_codec_put(w, (value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    ir_codec_put(w, value);
+}
+
+static void ir_codec_put_bits(ir_codec_writer_t *w, uint32_t value, uint32_t count)
+{
+    w->bits |= value << w->bit_count;
+    w->bit_count += count;
+    while (w->bit_count >= 8)
+    {
+        ir_codec_put(w, w->bits & 0xFF);
+        w->bits >>= 8;
+        w->bit_count -= 8;
+    }
+}
+
+/**
+ * @brief Flush the last bits of a packed stream, each sub-frame starts on a byte.
+ */
+static void ir_codec_flush_bits(ir_codec_writer_t *w)
+{
+    if (w->bit_count)
+    {
+        ir_codec_put(w, w->bits & 0xFF);
+    }
+    w->bits = 0;
+    w->bit_count = 0;
+}
+
+/**
+ * @brief Input of the decoder, every read is bounds checked.
+ */
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint32_t bits;
+    uint32_t bit_count;
+} ir_codec_reader_t;
+
+static bool ir_codec_get_varint(ir_codec_reader_t *r, uint32_t *value_out)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < IR_CODEC_VARINT_MAX && r->pos < r->size; i++)
+    {
+        uint8_t byte = r->data[r->pos++];
+        value |= (uint32_t)(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80))
+        {
+            *value_out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ir_codec_get_bits(ir_codec_reader_t *r, uint32_t count, uint32_t *value_out)
+{
+    while (r->bit_count < count)
+    {
+        if (r->pos >= r->size)
+        {
+            return false;
+        }
+        r->bits |= (uint32_t)r->data[r->pos++] << r->bit_count;
+        r->bit_count += 8;
+    }
+    *value_out = r->bits & ((1u << count) - 1);
+    r->bits >>= count;
+    r->bit_count -= count;
+    return true;
+}
+
+static inline uint32_t ir_codec_zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t ir_codec_unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * @brief Index of a half in the sorted dictionary, or where it would be inserted.
+ */
+static size_t ir_codec_dict_lower(const uint16_t *dict, size_t count, uint16_t half)
+{
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (dict[mid] < half)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Collect the distinct halves of a list, sorted.
+ *
+ * @return Number of distinct halves, IR_CODEC_DICT_MAX + 1 if there are more than IR_CODEC_DICT_MAX
+ */
+static size_t ir_codec_build_dict(const struct ir_learn_sub_list_head *list, uint16_t *dict)
+{
+    size_t count = 0;
+    struct ir_learn_sub_list_t *sub_it;
+
+    SLIST_FOREACH(sub_it, list, next)
+    {
+        const rmt_symbol_word_t *symbols = sub_it->symbols.received_symbols;
+        for (size_t i = 0; i < sub_it->symbols.num_symbols * 2; i++)
+        {
+            uint16_t half = ir_codec_half(symbols, i);
+            size_t pos = ir_codec_dict_lower(dict, count, half);
+            if (pos < count && dict[pos] == half)
+            {
+                continue;
+            }
+            if (count == IR_CODEC_DICT_MAX)
+            {
+                return IR_CODEC_DICT_MAX + 1;
+            }
+            memmove(&dict[pos + 1], &dict[pos], (count - pos) * sizeof(uint16_t));
+            dict[pos] = half;
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Write the whole encoding in one mode, or only count its bytes if w->out is NULL.
+ */
+static void ir_codec_write(ir_codec_writer_t *w, const struct ir_learn_sub_list_head *list, uint8_t mode,
+                           const uint16_t *dict, size_t dict_size, uint16_t frames, uint16_t symbols)
+{
+    uint8_t bits = 1;
+    while (mode == IR_CODEC_MODE_DICT && (1u << bits) < dict_size)
+    {
+        bits++;
+    }
+
+    ir_codec_header_t header = {
+        .magic = IR_CODEC_MAGIC,
+        .frames = frames,
+        .symbols = symbols,
+        .mode = mode,
+        .bits = mode == IR_CODEC_MODE_DICT ? bits : 0,
+        .dict_size = mode == IR_CODEC_MODE_DICT ? dict_size : 0,
+    };
+    for (size_t i = 0; i < sizeof(header); i++)
+    {
+        ir_codec_put(w, ((const uint8_t *)&header)[i]);
+    }
+    for (size_t i = 0; i < header.dict_size; i++)
+    {
+        ir_codec_put(w, dict[i] & 0xFF);
+        ir_codec_put(w, dict[i] >> 8);
+    }
+
+    struct ir_learn_sub_list_t *sub_it;
+    SLIST_FOREACH(sub_it, list, next)
+    {
+        const rmt_symbol_word_t *frame = sub_it->symbols.received_symbols;
+        size_t num_halves = sub_it->symbols.num_symbols * 2;
+        ir_codec_put_varint(w, sub_it->timediff);
+        ir_codec_put_varint(w, sub_it->symbols.num_symbols);
+
+        if (mode == IR_CODEC_MODE_DICT)
+        {
+            for (size_t i = 0; i < num_halves; i++)
+            {
+                ir_codec_put_bits(w, ir_codec_dict_lower(dict, dict_size, ir_codec_half(frame, i)), bits);
+            }
+            ir_codec_flush_bits(w);
+        }
+        else
+        {
+            int32_t prev[2] = {0, 0};
+            for (size_t i = 0; i < num_halves; i++)
+            {
+                uint16_t half = ir_codec_half(frame, i);
+                uint32_t level = half >> 15;
+                int32_t duration = half & IR_CODEC_DURATION_MASK;
+                ir_codec_put_varint(w, ir_codec_zigzag(duration - prev[level]) << 1 | level);
+                prev[level] = duration;
+            }
+        }
+    }
+}
+
+size_t ir_codec_encode(const struct ir_learn_sub_list_head *list, uint8_t *out, size_t out_size, uint8_t *mode_out)
+{
+    size_t frames = 0;
+    size_t symbols = 0;
+    struct ir_learn_sub_list_t *sub_it;
+    SLIST_FOREACH(sub_it, list, next)
+    {
+        frames++;
+        symbols += sub_it->symbols.num_symbols;
+    }
+    if (frames > UINT16_MAX || symbols > UINT16_MAX)
+    {
+        return 0;
+    }
+
+    uint16_t dict[IR_CODEC_DICT_MAX];
+    size_t dict_size = ir_codec_build_dict(list, dict);
+
+    /* Both sizes are counted first, the smaller mode is written */
+    ir_codec_writer_t w = {0};
+    ir_codec_write(&w, list, IR_CODEC_MODE_DELTA, NULL, 0, frames, symbols);
+    size_t delta_size = w.pos;
+    size_t dict_bytes = SIZE_MAX;
+    if (dict_size <= IR_CODEC_DICT_MAX)
+    {
+        w = (ir_codec_writer_t){0};
+        ir_codec_write(&w, list, IR_CODEC_MODE_DICT, dict, dict_size, frames, symbols);
+        dict_bytes = w.pos;
+    }
+    uint8_t mode = dict_bytes <= delta_size ? IR_CODEC_MODE_DICT : IR_CODEC_MODE_DELTA;
+    size_t size = MIN(dict_bytes, delta_size);
+    if (mode_out)
+    {
+        *mode_out = mode;
+    }
+    if (!out)
+    {
+        return size;
+    }
+    if (out_size < size)
+    {
+        return 0;
+    }
+
+    w = (ir_codec_writer_t){.out = out, .size = out_size};
+    ir_codec_write(&w, list, mode, dict, dict_size, frames, symbols);
+    return size;
+}
+
+bool ir_codec_is_encoded(const uint8_t *data, size_t size)
+{
+    uint32_t magic;
+    if (size < sizeof(ir_codec_header_t))
+    {
+        return false;
+    }
+    memcpy(&magic, data, sizeof(magic));
+    return magic == IR_CODEC_MAGIC;
+}
+
+/**
+ * @brief Read the sub-frames of an encoded key, only check them if out_list is NULL.
+ *
+ * @return false if the data is corrupted or a node can't be allocated
+ */
+static bool ir_codec_read_frames(const ir_codec_header_t *header, const uint16_t *dict, ir_codec_reader_t r,
+                                 struct ir_learn_sub_list_head *out_list)
+{
+    size_t symbols_left = header->symbols;
+    for (uint16_t f = 0; f < header->frames; f++)
+    {
+        uint32_t timediff;
+        uint32_t num_symbols;
+        if (!ir_codec_get_varint(&r, &timediff) || !ir_codec_get_varint(&r, &num_symbols) || num_symbols > symbols_left)
+        {
+            return false;
+        }
+        symbols_left -= num_symbols;
+
+        rmt_symbol_word_t *symbols = NULL;
+        if (out_list && ir_learn_alloc_sub_list_node(out_list, timediff, num_symbols, &symbols) != ESP_OK)
+        {
+            return false;
+        }
+
+        if (header->mode == IR_CODEC_MODE_DICT)
+        {
+            for (size_t i = 0; i < num_symbols * 2; i++)
+            {
+                uint32_t index;
+                if (!ir_codec_get_bits(&r, header->bits, &index) || index >= header->dict_size)
+                {
+                    return false;
+                }
+                if (symbols)
+                {
+                    ir_codec_set_half(symbols, i, dict[index]);
+                }
+            }
+            r.bits = 0;
+            r.bit_count = 0;
+        }
+        else
+        {
+            int32_t prev[2] = {0, 0};
+            for (size_t i = 0; i < num_symbols * 2; i++)
+            {
+                uint32_t value;
+                if (!ir_codec_get_varint(&r, &value))
+                {
+                    return false;
+                }
+                uint32_t level = value & 1;
+                int32_t duration = prev[level] + ir_codec_unzigzag(value >> 1);
+                if (duration < 0 || duration > IR_CODEC_DURATION_MASK)
+                {
+                    return false;
+                }
+                if (symbols)
+                {
+                    ir_codec_set_half(symbols, i, level << 15 | duration);
+                }
+                prev[level] = duration;
+            }
+        }
+    }
+    return symbols_left == 0 && r.pos == r.size;
+}
+
+esp_err_t ir_codec_decode(const uint8_t *data, size_t size, struct ir_learn_sub_list_head *out_list)
+{
+    if (!data || !out_list || !ir_codec_is_encoded(data, size))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ir_codec_header_t header;
+    memcpy(&header, data, sizeof(header));
+    ir_codec_reader_t r = {
+        .data = data,
+        .size = size,
+        .pos = sizeof(header),
+    };
+    uint16_t dict[IR_CODEC_DICT_MAX];
+    if (header.mode == IR_CODEC_MODE_DICT)
+    {
+        if (header.dict_size == 0 || header.dict_size > IR_CODEC_DICT_MAX || header.bits == 0 || header.bits > 8 ||
+            (1u << header.bits) < header.dict_size || size - r.pos < header.dict_size * sizeof(uint16_t))
+        {
+            ESP_LOGD(TAG, "Bad dictionary: %d entries of %d bits", header.dict_size, header.bits);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(dict, data + r.pos, header.dict_size * sizeof(uint16_t));
+        r.pos += header.dict_size * sizeof(uint16_t);
+    }
+    else if (header.mode != IR_CODEC_MODE_DELTA)
+    {
+        ESP_LOGD(TAG, "Unknown mode %d", header.mode);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    /* The whole key is checked before the list is touched, a corrupted key leaves no partial sub-frame */
+    if (!ir_codec_read_frames(&header, dict, r, NULL))
+    {
+        ESP_LOGD(TAG, "Corrupted key, %d bytes", size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = ir_learn_reserve_sub_list(out_list, header.frames, header.symbols);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return ir_codec_read_frames(&header, dict, r, out_list) ? ESP_OK : ESP_ERR_NO_MEM;
+}
@@ -0,0 +1,1196 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "ir_learn.h"
+#include "ir_db.h"
+
+static const char *TAG = "IR_db";
+
+#define IR_DB_SECTOR_SIZE 4096
+#define IR_DB_SECTOR(offset) ((offset) & ~(IR_DB_SECTOR_SIZE - 1))
+#define IR_DB_ALIGN(size) (((size) + 3) & ~3u)
+#define IR_DB_RECORD_SIZE(key_len, data_len) (sizeof(ir_db_record_t) + IR_DB_ALIGN(key_len) + IR_DB_ALIGN(data_len))
+
+/* Kept free by saves, so the compaction can always move a sector worth of live records and wrap twice */
+#define IR_DB_RESERVE (IR_DB_SECTOR_SIZE + 2 * IR_DB_RECORD_SIZE(IR_KEY_MAX_LEN, IR_DB_DATA_MAX))
+
+/* The background compaction starts above this share of dead bytes, in percent of the partition, and stops below half of it */
+#define IR_DB_GC_DEAD_PCT 25
+
+/* Bytes copied at once when a record is moved */
+#define IR_DB_COPY_CHUNK 256
+
+/* Boot scan window: a sector, plus the longest header and key name that can start at its end */
+#define IR_DB_SCAN_WINDOW (IR_DB_SECTOR_SIZE + sizeof(ir_db_record_t) + IR_KEY_MAX_LEN)
+
+static const esp_partition_t *s_db_part = NULL;
+static SemaphoreHandle_t s_db_lock = NULL;
+static TaskHandle_t s_db_gc_task = NULL;
+static ir_db_entry_t s_db_entries[IR_DB_KEYS_MAX]; /*!< RAM index, sorted by key hash */
+static size_t s_db_count = 0;
+static uint32_t s_db_size = 0;
+static uint32_t s_db_head = 0; /*!< End of the newest record, next append */
+static uint32_t s_db_tail = 0; /*!< Start of the oldest record, head if the ring is empty */
+static uint32_t s_db_seq = 0;  /*!< Sequence number of the newest record */
+static uint32_t s_db_live = 0; /*!< Bytes of the live records */
+static ir_db_stats_t s_db_stats = {0};
+static const uint8_t *s_db_map = NULL; /*!< Partition in the data cache, NULL if it couldn't be mapped */
+static esp_partition_mmap_handle_t s_db_map_handle;
+static uint32_t s_db_views = 0;       /*!< Views handed out and not released */
+static bool s_db_gc_deferred = false; /*!< The background compaction stopped on a view */
+
+uint32_t ir_db_hash(const char *key)
+{
+    uint32_t hash = 2166136261u;
+    while (*key)
+    {
+        hash = (hash ^ (uint8_t)*key++) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Read from the partition, a copy from the cache if it is mapped.
+ */
+static esp_err_t ir_db_flash_read(uint32_t offset, void *buf, size_t size)
+{
+    if (s_db_map)
+    {
+        memcpy(buf, s_db_map + offset, size);
+        return ESP_OK;
+    }
+    return esp_partition_read(s_db_part, offset, buf, size);
+}
+
+static uint32_t ir_db_header_crc(const ir_db_record_t *rec, const uint8_t *key)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)rec, offsetof(ir_db_record_t, header_crc));
+    return esp_rom_crc32_le(crc, key, rec->key_len);
+}
+
+static bool ir_db_header_valid(const ir_db_record_t *rec, uint32_t offset)
+{
+    if (rec->magic != IR_DB_MAGIC)
+    {
+        return false;
+    }
+    if (rec->kind == IR_DB_KIND_KEY)
+    {
+        if (rec->key_len == 0 || rec->key_len >= IR_KEY_MAX_LEN || rec->data_len > IR_DB_DATA_MAX)
+        {
+            return false;
+        }
+    }
+    else if (rec->kind != IR_DB_KIND_PAD || rec->key_len != 0 || rec->data_len > s_db_size)
+    {
+        return false;
+    }
+    return offset + IR_DB_RECORD_SIZE(rec->key_len, rec->data_len) <= s_db_size;
+}
+
+/**
+ * @brief Read and check the header of the record at offset, and its key name if key isn't NULL.
+ */
+static esp_err_t ir_db_read_record(uint32_t offset, ir_db_record_t *rec, char *key)
+{
+    uint8_t buf[sizeof(ir_db_record_t) + IR_KEY_MAX_LEN];
+    size_t size = MIN(sizeof(buf), s_db_size - offset);
+    if (size < sizeof(ir_db_record_t))
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = ir_db_flash_read(offset, buf, size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    memcpy(rec, buf, sizeof(*rec));
+    if (!ir_db_header_valid(rec, offset) || ir_db_header_crc(rec, buf + sizeof(*rec)) != rec->header_crc)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (key)
+    {
+        memcpy(key, buf + sizeof(*rec), rec->key_len);
+        key[rec->key_len] = '\0';
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ir_db_set_state(uint32_t offset, uint32_t state)
+{
+    return esp_partition_write(s_db_part, offset + offsetof(ir_db_record_t, state), &state, sizeof(state));
+}
+
+static inline uint32_t ir_db_data_offset(uint32_t offset, const ir_db_record_t *rec)
+{
+    return offset + sizeof(ir_db_record_t) + IR_DB_ALIGN(rec->key_len);
+}
+
+static size_t ir_db_index_lower(uint32_t key_hash)
+{
+    size_t lo = 0;
+    size_t hi = s_db_count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (s_db_entries[mid].key_hash < key_hash)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Find a key in the index, the key names of the entries of the same hash are read from flash.
+ */
+static ir_db_entry_t *ir_db_find_locked(const char *key, uint32_t key_hash, ir_db_record_t *rec_out)
+{
+    for (size_t i = ir_db_index_lower(key_hash); i < s_db_count && s_db_entries[i].key_hash == key_hash; i++)
+    {
+        ir_db_record_t rec;
+        char name[IR_KEY_MAX_LEN];
+        if (ir_db_read_record(s_db_entries[i].offset, &rec, name) == ESP_OK && strcmp(name, key) == 0)
+        {
+            if (rec_out)
+            {
+                *rec_out = rec;
+            }
+            return &s_db_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static ir_db_entry_t *ir_db_find_offset_locked(uint32_t key_hash, uint32_t offset)
+{
+    for (size_t i = ir_db_index_lower(key_hash); i < s_db_count && s_db_entries[i].key_hash == key_hash; i++)
+    {
+        if (s_db_entries[i].offset == offset)
+        {
+            return &s_db_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t ir_db_index_insert_locked(const ir_db_entry_t *entry)
+{
+    if (s_db_count >= IR_DB_KEYS_MAX)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t pos = ir_db_index_lower(entry->key_hash);
+    memmove(&s_db_entries[pos + 1], &s_db_entries[pos], (s_db_count - pos) * sizeof(ir_db_entry_t));
+    s_db_entries[pos] = *entry;
+    s_db_count++;
+    return ESP_OK;
+}
+
+static void ir_db_index_remove_locked(ir_db_entry_t *entry)
+{
+    size_t pos = entry - s_db_entries;
+    memmove(&s_db_entries[pos], &s_db_entries[pos + 1], (s_db_count - pos - 1) * sizeof(ir_db_entry_t));
+    s_db_count--;
+}
+
+static uint32_t ir_db_used_locked(void)
+{
+    return (s_db_head + s_db_size - s_db_tail) % s_db_size;
+}
+
+/**
+ * @brief Erased bytes from the head up to the sector of the tail, which isn't erased yet.
+ */
+static uint32_t ir_db_free_locked(void)
+{
+    uint32_t limit = IR_DB_SECTOR(s_db_tail);
+    if (s_db_head >= s_db_tail)
+    {
+        return s_db_size - s_db_head + limit;
+    }
+    return limit > s_db_head ? limit - s_db_head : 0;
+}
+
+/**
+ * @brief Find room for a record at the head, leaving keep bytes free.
+ *
+ * A record doesn't wrap: if it doesn't fit before the end of the partition, the
+ * end is filled with a pad record and the record goes at offset 0.
+ */
+static esp_err_t ir_db_place_locked(uint32_t total, uint32_t keep, uint32_t *offset_out)
+{
+    uint32_t limit = IR_DB_SECTOR(s_db_tail);
+    uint32_t waste = 0;
+    uint32_t room;
+    if (s_db_head >= s_db_tail && s_db_head + total <= s_db_size)
+    {
+        room = s_db_size - s_db_head;
+    }
+    else if (s_db_head >= s_db_tail)
+    {
+        waste = s_db_size - s_db_head;
+        room = limit;
+    }
+    else
+    {
+        room = limit > s_db_head ? limit - s_db_head : 0;
+    }
+    if (room < total || ir_db_free_locked() < waste + total + keep)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (waste >= sizeof(ir_db_record_t))
+    {
+        ir_db_record_t pad = {
+            .magic = IR_DB_MAGIC,
+            .seq = ++s_db_seq,
+            .data_len = waste - sizeof(ir_db_record_t),
+            .kind = IR_DB_KIND_PAD,
+            .state = IR_DB_STATE_DEAD,
+        };
+        pad.header_crc = ir_db_header_crc(&pad, NULL);
+        esp_err_t ret = esp_partition_write(s_db_part, s_db_head, &pad, sizeof(pad));
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    if (waste)
+    {
+        s_db_head = 0;
+    }
+    *offset_out = s_db_head;
+    return ESP_OK;
+}
+
+/**
+ * @brief Append a record at offset, its data from RAM or, if data is NULL, from the record at src_offset.
+ */
+static esp_err_t ir_db_append_locked(uint32_t offset, const char *key, uint32_t data_len, uint8_t protocol, uint8_t flags,
+                                     uint32_t data_crc, const void *data, uint32_t src_offset)
+{
+    uint8_t buf[sizeof(ir_db_record_t) + IR_KEY_MAX_LEN] = {0};
+    ir_db_record_t rec = {
+        .magic = IR_DB_MAGIC,
+        .seq = ++s_db_seq,
+        .key_hash = ir_db_hash(key),
+        .data_len = data_len,
+        .kind = IR_DB_KIND_KEY,
+        .key_len = strlen(key),
+        .protocol = protocol,
+        .flags = flags,
+        .data_crc = data_crc,
+        .state = IR_DB_STATE_ERASED,
+    };
+    memcpy(buf + sizeof(rec), key, rec.key_len);
+    rec.header_crc = ir_db_header_crc(&rec, buf + sizeof(rec));
+    memcpy(buf, &rec, sizeof(rec));
+
+    uint32_t total = IR_DB_RECORD_SIZE(rec.key_len, data_len);
+    uint32_t data_offset = ir_db_data_offset(offset, &rec);
+
+    /* The head moves past the record even if a write fails, the bytes may be programmed */
+    s_db_head = (offset + total) % s_db_size;
+
+    esp_err_t ret = esp_partition_write(s_db_part, offset, buf, data_offset - offset);
+    if (ret == ESP_OK && data)
+    {
+        ret = esp_partition_write(s_db_part, data_offset, data, data_len);
+    }
+    for (uint32_t pos = 0; ret == ESP_OK && !data && pos < data_len; pos += IR_DB_COPY_CHUNK)
+    {
+        uint32_t chunk[IR_DB_COPY_CHUNK / sizeof(uint32_t)];
+        uint32_t size = MIN(IR_DB_COPY_CHUNK, data_len - pos);
+        ret = ir_db_flash_read(src_offset + pos, chunk, size);
+        if (ret == ESP_OK)
+        {
+            ret = esp_partition_write(s_db_part, data_offset + pos, chunk, size);
+        }
+    }
+    if (ret == ESP_OK)
+    {
+        ret = ir_db_set_state(offset, IR_DB_STATE_VALID);
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to write record of %s at 0x%" PRIx32 ": %s", key, offset, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief Move the tail past the oldest record, appending it again if it is live, and erase the sectors left behind.
+ *
+ * @param walked_out Bytes the tail moved
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the ring is empty,
+ *         ESP_ERR_INVALID_STATE if a sector would be erased while views are held
+ */
+static esp_err_t ir_db_gc_step_locked(uint32_t *walked_out)
+{
+    if (s_db_tail == s_db_head)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t old_tail = s_db_tail;
+    uint32_t step = sizeof(uint32_t);
+    ir_db_record_t rec;
+    char key[IR_KEY_MAX_LEN];
+    bool valid = false;
+    if (s_db_size - s_db_tail < sizeof(ir_db_record_t))
+    {
+        // Too short for a pad record, the ring went on at offset 0
+        step = s_db_size - s_db_tail;
+    }
+    else if (ir_db_read_record(s_db_tail, &rec, key) == ESP_OK)
+    {
+        step = IR_DB_RECORD_SIZE(rec.key_len, rec.data_len);
+        valid = true;
+    }
+    // A torn write is skipped word by word, up to the next record
+
+    if (s_db_views && IR_DB_SECTOR(old_tail) != IR_DB_SECTOR((old_tail + step) % s_db_size))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (valid)
+    {
+        ir_db_entry_t *entry = NULL;
+        if (rec.kind == IR_DB_KIND_KEY && rec.state == IR_DB_STATE_VALID)
+        {
+            entry = ir_db_find_offset_locked(rec.key_hash, s_db_tail);
+        }
+        if (entry)
+        {
+            uint32_t offset;
+            esp_err_t ret = ir_db_place_locked(step, 0, &offset);
+            if (ret == ESP_OK)
+            {
+                ret = ir_db_append_locked(offset, key, rec.data_len, rec.protocol, rec.flags, rec.data_crc, NULL,
+                                          ir_db_data_offset(s_db_tail, &rec));
+            }
+            if (ret != ESP_OK)
+            {
+                return ret;
+            }
+            ir_db_set_state(s_db_tail, IR_DB_STATE_DEAD);
+            entry->offset = offset;
+            s_db_stats.relocated++;
+        }
+    }
+
+    s_db_tail = (s_db_tail + step) % s_db_size;
+    for (uint32_t sector = IR_DB_SECTOR(old_tail); sector != IR_DB_SECTOR(s_db_tail);
+         sector = (sector + IR_DB_SECTOR_SIZE) % s_db_size)
+    {
+        esp_partition_erase_range(s_db_part, sector, IR_DB_SECTOR_SIZE);
+        s_db_stats.erases++;
+    }
+    *walked_out = step;
+    return ESP_OK;
+}
+
+/**
+ * @brief Wait, with the lock released, until every view is released.
+ *
+ * @return false if views are still held after IR_DB_VIEW_WAIT_MS
+ */
+static bool ir_db_wait_views_locked(void)
+{
+    int64_t deadline = esp_timer_get_time() + IR_DB_VIEW_WAIT_MS * 1000LL;
+    while (s_db_views)
+    {
+        if (esp_timer_get_time() >= deadline)
+        {
+            ESP_LOGW(TAG, "%" PRIu32 " views still held, no sector can be erased", s_db_views);
+            return false;
+        }
+        xSemaphoreGive(s_db_lock);
+        vTaskDelay(pdMS_TO_TICKS(10));
+        xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    }
+    return true;
+}
+
+/**
+ * @brief Compact until there's room for a record of total bytes, keeping keep bytes free.
+ *
+ * The lock is released while views are waited for, the caller must look its entries up again.
+ */
+static esp_err_t ir_db_reserve_locked(uint32_t total, uint32_t keep, uint32_t *offset_out)
+{
+    uint32_t budget = ir_db_used_locked();
+    uint32_t walked = 0;
+    bool counted = false;
+
+    while (ir_db_place_locked(total, keep, offset_out) != ESP_OK)
+    {
+        uint32_t step;
+        esp_err_t ret = walked < budget ? ir_db_gc_step_locked(&step) : ESP_ERR_NO_MEM;
+        if (ret == ESP_ERR_INVALID_STATE && ir_db_wait_views_locked())
+        {
+            continue;
+        }
+        if (ret != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Key database full: %" PRIu32 " live bytes of %" PRIu32, s_db_live, s_db_size);
+            return ESP_ERR_NO_MEM;
+        }
+        if (!counted)
+        {
+            s_db_stats.gc_runs++;
+            counted = true;
+        }
+        walked += step;
+    }
+    return ESP_OK;
+}
+
+static void ir_db_gc_kick(void)
+{
+    if (s_db_gc_task)
+    {
+        xTaskNotifyGive(s_db_gc_task);
+    }
+}
+
+static bool ir_db_gc_needed_locked(uint32_t dead_pct)
+{
+    uint32_t dead = ir_db_used_locked() - s_db_live;
+    return dead * 100 >= s_db_size * dead_pct || (dead >= IR_DB_SECTOR_SIZE && ir_db_free_locked() < 2 * IR_DB_RESERVE);
+}
+
+static void ir_db_gc_task(void *arg)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(s_db_lock, portMAX_DELAY);
+        bool run = ir_db_gc_needed_locked(IR_DB_GC_DEAD_PCT);
+        uint32_t budget = ir_db_used_locked();
+        if (run)
+        {
+            s_db_stats.gc_runs++;
+        }
+        xSemaphoreGive(s_db_lock);
+
+        /* One record per lock, sends and lookups go on in between */
+        uint32_t walked = 0;
+        while (run && walked < budget)
+        {
+            uint32_t step = 0;
+            xSemaphoreTake(s_db_lock, portMAX_DELAY);
+            esp_err_t ret = ir_db_gc_step_locked(&step);
+            // Picked up again by the release of the last view
+            s_db_gc_deferred = (ret == ESP_ERR_INVALID_STATE);
+            run = ret == ESP_OK && ir_db_gc_needed_locked(IR_DB_GC_DEAD_PCT / 2);
+            xSemaphoreGive(s_db_lock);
+            walked += step;
+            taskYIELD();
+        }
+    }
+}
+
+/**
+ * @brief Add a committed record found by the boot scan, the newest record of a key wins.
+ */
+static void ir_db_scan_add(const ir_db_record_t *rec, uint32_t offset, const char *key)
+{
+    ir_db_record_t old_rec;
+    ir_db_entry_t *entry = ir_db_find_locked(key, rec->key_hash, &old_rec);
+    uint32_t total = IR_DB_RECORD_SIZE(rec->key_len, rec->data_len);
+    if (entry && old_rec.seq > rec->seq)
+    {
+        // Reset between the append of the new version and the end of the old one
+        ir_db_set_state(offset, IR_DB_STATE_DEAD);
+        return;
+    }
+    if (entry)
+    {
+        ir_db_set_state(entry->offset, IR_DB_STATE_DEAD);
+        s_db_live -= IR_DB_RECORD_SIZE(old_rec.key_len, old_rec.data_len);
+        ir_db_index_remove_locked(entry);
+    }
+
+    ir_db_entry_t new_entry = {
+        .key_hash = rec->key_hash,
+        .offset = offset,
+        .length = rec->data_len,
+        .protocol = rec->protocol,
+        .flags = rec->flags,
+    };
+    if (ir_db_index_insert_locked(&new_entry) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Index full, key %s left out", key);
+        return;
+    }
+    s_db_live += total;
+}
+
+/**
+ * @brief Check the data of a record against its CRC, records of older firmware have none.
+ */
+static bool ir_db_data_valid(uint32_t offset, const ir_db_record_t *rec)
+{
+    if (!(rec->flags & IR_DB_FLAG_DATA_CRC))
+    {
+        return true;
+    }
+    uint32_t data_offset = ir_db_data_offset(offset, rec);
+    uint32_t crc = 0;
+    for (uint32_t pos = 0; pos < rec->data_len; pos += IR_DB_COPY_CHUNK)
+    {
+        uint32_t chunk[IR_DB_COPY_CHUNK / sizeof(uint32_t)];
+        uint32_t size = MIN(IR_DB_COPY_CHUNK, rec->data_len - pos);
+        if (ir_db_flash_read(data_offset + pos, chunk, size) != ESP_OK)
+        {
+            return false;
+        }
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)chunk, size);
+    }
+    return crc == rec->data_crc;
+}
+
+static bool ir_db_sector_blank(uint32_t sector, uint32_t from, uint32_t *buf)
+{
+    for (uint32_t pos = from; pos < IR_DB_SECTOR_SIZE; pos += IR_DB_COPY_CHUNK)
+    {
+        uint32_t size = MIN(IR_DB_COPY_CHUNK, IR_DB_SECTOR_SIZE - pos);
+        if (ir_db_flash_read(sector + pos, buf, size) != ESP_OK)
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < size / sizeof(uint32_t); i++)
+        {
+            if (buf[i] != IR_DB_STATE_ERASED)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Rebuild the index and the ring bounds from the records in the partition.
+ *
+ * Every 4-byte offset is tried, so the scan gets past torn writes. The oldest
+ * record is the tail and the end of the newest one the head. Sectors outside the
+ * ring that aren't blank are erased, and so is a torn write after the head.
+ */
+static esp_err_t ir_db_scan(void)
+{
+    uint8_t *window = malloc(IR_DB_SCAN_WINDOW);
+    if (!window)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint32_t base = 0;
+    uint32_t window_len = 0;
+    uint32_t min_seq = UINT32_MAX;
+    uint32_t max_seq = 0;
+    bool found = false;
+
+    s_db_count = 0;
+    s_db_live = 0;
+    s_db_head = 0;
+    s_db_tail = 0;
+    for (uint32_t pos = 0; pos + sizeof(ir_db_record_t) <= s_db_size;)
+    {
+        uint32_t need = MIN(sizeof(ir_db_record_t) + IR_KEY_MAX_LEN, s_db_size - pos);
+        if (pos < base || pos + need > base + window_len)
+        {
+            base = pos;
+            window_len = MIN(IR_DB_SCAN_WINDOW, s_db_size - base);
+            if (ir_db_flash_read(base, window, window_len) != ESP_OK)
+            {
+                free(window);
+                return ESP_FAIL;
+            }
+        }
+
+        ir_db_record_t rec;
+        const uint8_t *p = window + (pos - base);
+        memcpy(&rec, p, sizeof(rec));
+        if (!ir_db_header_valid(&rec, pos) || sizeof(rec) + rec.key_len > need ||
+            ir_db_header_crc(&rec, p + sizeof(rec)) != rec.header_crc)
+        {
+            pos += sizeof(uint32_t);
+            continue;
+        }
+
+        uint32_t total = IR_DB_RECORD_SIZE(rec.key_len, rec.data_len);
+        found = true;
+        if (rec.seq < min_seq)
+        {
+            min_seq = rec.seq;
+            s_db_tail = pos;
+        }
+        if (rec.seq >= max_seq)
+        {
+            max_seq = rec.seq;
+            s_db_head = (pos + total) % s_db_size;
+        }
+        if (rec.kind == IR_DB_KIND_KEY && rec.state == IR_DB_STATE_VALID)
+        {
+            char key[IR_KEY_MAX_LEN];
+            memcpy(key, p + sizeof(rec), rec.key_len);
+            key[rec.key_len] = '\0';
+            if (ir_db_data_valid(pos, &rec))
+            {
+                ir_db_scan_add(&rec, pos, key);
+            }
+            else
+            {
+                // The older version of the key, if its record wasn't ended yet, is found on its own
+                ESP_LOGE(TAG, "Corrupted data of %s at 0x%" PRIx32 ", record dropped", key, pos);
+                ir_db_set_state(pos, IR_DB_STATE_DEAD);
+                s_db_stats.corrupt++;
+            }
+        }
+        pos += total;
+    }
+    s_db_seq = max_seq;
+
+    uint32_t *buf = (uint32_t *)window;
+    if (found)
+    {
+        // A torn header after the head is programmed but not a record
+        uint32_t word;
+        while (s_db_head + sizeof(word) <= s_db_size &&
+               ir_db_flash_read(s_db_head, &word, sizeof(word)) == ESP_OK && word != IR_DB_STATE_ERASED)
+        {
+            s_db_head += sizeof(word);
+        }
+        if (s_db_head < s_db_size && !ir_db_sector_blank(IR_DB_SECTOR(s_db_head), s_db_head - IR_DB_SECTOR(s_db_head), buf))
+        {
+            s_db_head = IR_DB_SECTOR(s_db_head) + IR_DB_SECTOR_SIZE;
+        }
+        s_db_head %= s_db_size;
+    }
+    else
+    {
+        s_db_head = 0;
+        s_db_tail = 0;
+    }
+
+    /* Everything outside the sectors from the tail to the head must be erased */
+    uint32_t first = IR_DB_SECTOR(s_db_tail);
+    uint32_t span = (IR_DB_SECTOR(s_db_head) + s_db_size - first) % s_db_size;
+    for (uint32_t sector = 0; sector < s_db_size; sector += IR_DB_SECTOR_SIZE)
+    {
+        bool in_ring = found && (sector + s_db_size - first) % s_db_size <= span;
+        if (!in_ring && !ir_db_sector_blank(sector, 0, buf))
+        {
+            ESP_LOGW(TAG, "Erasing stray data at 0x%" PRIx32, sector);
+            esp_partition_erase_range(s_db_part, sector, IR_DB_SECTOR_SIZE);
+        }
+    }
+    free(window);
+
+    s_db_stats.scan_us = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "%u keys, %" PRIu32 "/%" PRIu32 " bytes live, %" PRIu32 " free, scanned in %" PRIu32 " us",
+             s_db_count, s_db_live, s_db_size, ir_db_free_locked(), s_db_stats.scan_us);
+    return ESP_OK;
+}
+
+esp_err_t ir_db_init(void)
+{
+    if (s_db_part)
+    {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           IR_DB_PARTITION_LABEL);
+    if (!part)
+    {
+        ESP_LOGE(TAG, "No %s partition", IR_DB_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (part->size % IR_DB_SECTOR_SIZE || part->size < 4 * IR_DB_RESERVE)
+    {
+        ESP_LOGE(TAG, "Partition %s too small: %" PRIu32 " bytes", IR_DB_PARTITION_LABEL, part->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    s_db_lock = xSemaphoreCreateMutex();
+    if (!s_db_lock)
+    {
+        ESP_LOGE(TAG, "Create database mutex failed");
+        return ESP_ERR_NO_MEM;
+    }
+    s_db_part = part;
+    s_db_size = part->size;
+
+    /* Mapped once for good, the scan and every read go through the cache */
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, (const void **)&s_db_map, &s_db_map_handle) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Can't map %s, keys are read with copies", IR_DB_PARTITION_LABEL);
+        s_db_map = NULL;
+    }
+
+    esp_err_t ret = ir_db_scan();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Scan of %s failed (%s)", IR_DB_PARTITION_LABEL, esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (xTaskCreate(ir_db_gc_task, "ir db gc", 3072, NULL, 2, &s_db_gc_task) != pdPASS)
+    {
+        ESP_LOGW(TAG, "No compaction task, saves compact when the partition is full");
+        s_db_gc_task = NULL;
+    }
+    ir_db_gc_kick();
+    return ESP_OK;
+}
+
+static bool ir_db_key_valid(const char *key)
+{
+    return s_db_lock && key && key[0] && strlen(key) < IR_KEY_MAX_LEN;
+}
+
+esp_err_t ir_db_write(const char *key, const void *data, size_t size, uint8_t protocol, uint8_t flags)
+{
+    if (!ir_db_key_valid(key) || (!data && size) || size > IR_DB_DATA_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t key_hash = ir_db_hash(key);
+    uint32_t total = IR_DB_RECORD_SIZE(strlen(key), size);
+    uint32_t data_crc = esp_rom_crc32_le(0, data, size);
+    uint32_t offset;
+    flags |= IR_DB_FLAG_DATA_CRC;
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_OK;
+    if (s_db_count >= IR_DB_KEYS_MAX && !ir_db_find_locked(key, key_hash, NULL))
+    {
+        ESP_LOGE(TAG, "Index full, %d keys", IR_DB_KEYS_MAX);
+        ret = ESP_ERR_NO_MEM;
+    }
+    if (ret == ESP_OK)
+    {
+        ret = ir_db_reserve_locked(total, IR_DB_RESERVE, &offset);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = ir_db_append_locked(offset, key, size, protocol, flags, data_crc, data, 0);
+    }
+    bool replaced = false;
+    if (ret == ESP_OK)
+    {
+        /* Looked up after the append, the compaction may have moved the old version */
+        ir_db_record_t old_rec;
+        ir_db_entry_t *entry = ir_db_find_locked(key, key_hash, &old_rec);
+        ir_db_entry_t new_entry = {
+            .key_hash = key_hash,
+            .offset = offset,
+            .length = size,
+            .protocol = protocol,
+            .flags = flags,
+        };
+        if (entry && entry->offset != offset)
+        {
+            ir_db_set_state(entry->offset, IR_DB_STATE_DEAD);
+            s_db_live -= IR_DB_RECORD_SIZE(old_rec.key_len, old_rec.data_len);
+            *entry = new_entry;
+            replaced = true;
+        }
+        else if (ir_db_index_insert_locked(&new_entry) != ESP_OK)
+        {
+            // Filled up by another save while the compaction waited for the views
+            ESP_LOGE(TAG, "Index full, %d keys", IR_DB_KEYS_MAX);
+            ir_db_set_state(offset, IR_DB_STATE_DEAD);
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (ret == ESP_OK)
+    {
+        s_db_live += total;
+        s_db_stats.appends++;
+    }
+    xSemaphoreGive(s_db_lock);
+
+    if (replaced)
+    {
+        ir_db_gc_kick();
+    }
+    return ret;
+}
+
+esp_err_t ir_db_find(const char *key, ir_db_entry_t *entry_out)
+{
+    if (!ir_db_key_valid(key))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    ir_db_entry_t *entry = ir_db_find_locked(key, ir_db_hash(key), NULL);
+    if (entry && entry_out)
+    {
+        *entry_out = *entry;
+    }
+    xSemaphoreGive(s_db_lock);
+    return entry ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+bool ir_db_exists(const char *key)
+{
+    return ir_db_find(key, NULL) == ESP_OK;
+}
+
+esp_err_t ir_db_read(const char *key, size_t offset, void *buf, size_t size, size_t *read_out)
+{
+    if (!ir_db_key_valid(key) || (!buf && size))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    ir_db_record_t rec;
+    ir_db_entry_t *entry = ir_db_find_locked(key, ir_db_hash(key), &rec);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    size_t read_size = 0;
+    if (entry)
+    {
+        read_size = offset < entry->length ? MIN(size, entry->length - offset) : 0;
+        ret = read_size ? ir_db_flash_read(ir_db_data_offset(entry->offset, &rec) + offset, buf, read_size) : ESP_OK;
+    }
+    xSemaphoreGive(s_db_lock);
+
+    if (read_out)
+    {
+        *read_out = ret == ESP_OK ? read_size : 0;
+    }
+    return ret;
+}
+
+esp_err_t ir_db_view(const char *key, ir_db_view_t *view_out)
+{
+    if (!ir_db_key_valid(key) || !view_out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(view_out, 0, sizeof(*view_out));
+    if (!s_db_map)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    ir_db_record_t rec;
+    ir_db_entry_t *entry = ir_db_find_locked(key, ir_db_hash(key), &rec);
+    if (entry)
+    {
+        view_out->data = s_db_map + ir_db_data_offset(entry->offset, &rec);
+        view_out->size = entry->length;
+        view_out->protocol = entry->protocol;
+        view_out->flags = entry->flags;
+        s_db_views++;
+    }
+    xSemaphoreGive(s_db_lock);
+    return entry ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void ir_db_view_release(ir_db_view_t *view)
+{
+    if (!view || !view->data)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    s_db_views--;
+    bool kick = !s_db_views && s_db_gc_deferred;
+    if (kick)
+    {
+        s_db_gc_deferred = false;
+    }
+    xSemaphoreGive(s_db_lock);
+
+    view->data = NULL;
+    view->size = 0;
+    if (kick)
+    {
+        ir_db_gc_kick();
+    }
+}
+
+esp_err_t ir_db_delete(const char *key)
+{
+    if (!ir_db_key_valid(key))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    ir_db_record_t rec;
+    ir_db_entry_t *entry = ir_db_find_locked(key, ir_db_hash(key), &rec);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (entry)
+    {
+        ret = ir_db_set_state(entry->offset, IR_DB_STATE_DEAD);
+        s_db_live -= IR_DB_RECORD_SIZE(rec.key_len, rec.data_len);
+        ir_db_index_remove_locked(entry);
+    }
+    xSemaphoreGive(s_db_lock);
+
+    if (entry)
+    {
+        ir_db_gc_kick();
+    }
+    return ret;
+}
+
+esp_err_t ir_db_rename(const char *old_key, const char *new_key)
+{
+    if (!ir_db_key_valid(old_key) || !ir_db_key_valid(new_key))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t old_hash = ir_db_hash(old_key);
+    uint32_t new_hash = ir_db_hash(new_key);
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    ir_db_record_t rec = {0};
+    esp_err_t ret = ESP_OK;
+    if (!ir_db_find_locked(old_key, old_hash, &rec))
+    {
+        ret = ESP_ERR_NOT_FOUND;
+    }
+    else if (ir_db_find_locked(new_key, new_hash, NULL))
+    {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+
+    /* The data is copied from flash to flash, the old record is ended once the new one is committed */
+    uint32_t total = IR_DB_RECORD_SIZE(strlen(new_key), rec.data_len);
+    uint32_t offset;
+    if (ret == ESP_OK)
+    {
+        ret = ir_db_reserve_locked(total, IR_DB_RESERVE, &offset);
+    }
+    ir_db_entry_t *entry = NULL;
+    if (ret == ESP_OK)
+    {
+        /* Looked up again: the compaction may have moved the record, and released the lock to wait for views */
+        entry = ir_db_find_locked(old_key, old_hash, &rec);
+        if (!entry)
+        {
+            ret = ESP_ERR_NOT_FOUND;
+        }
+        else if (ir_db_find_locked(new_key, new_hash, NULL) ||
+                 IR_DB_RECORD_SIZE(strlen(new_key), rec.data_len) != total)
+        {
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+    if (ret == ESP_OK)
+    {
+        ret = ir_db_append_locked(offset, new_key, rec.data_len, rec.protocol, rec.flags, rec.data_crc, NULL,
+                                  ir_db_data_offset(entry->offset, &rec));
+    }
+    if (ret == ESP_OK)
+    {
+        ir_db_entry_t new_entry = *entry;
+        new_entry.key_hash = new_hash;
+        new_entry.offset = offset;
+        ir_db_set_state(entry->offset, IR_DB_STATE_DEAD);
+        s_db_live += total - IR_DB_RECORD_SIZE(rec.key_len, rec.data_len);
+        ir_db_index_remove_locked(entry);
+        ir_db_index_insert_locked(&new_entry);
+        s_db_stats.appends++;
+    }
+    xSemaphoreGive(s_db_lock);
+
+    if (ret == ESP_OK)
+    {
+        ir_db_gc_kick();
+    }
+    return ret;
+}
+
+/**
+ * @brief The key after (key_hash, key) in the order of ir_db_foreach(): by hash, then by name.
+ *
+ * The order doesn't depend on positions or offsets, so inserts, deletes and compaction
+ * between two calls don't make a walk skip or repeat a key.
+ *
+ * @param key Key of the cursor, NULL for the first key
+ */
+static bool ir_db_next_locked(uint32_t key_hash, const char *key, ir_db_entry_t *entry_out, char *key_out)
+{
+    bool found = false;
+    for (size_t i = key ? ir_db_index_lower(key_hash) : 0; i < s_db_count; i++)
+    {
+        const ir_db_entry_t *entry = &s_db_entries[i];
+        if (found && entry->key_hash != entry_out->key_hash)
+        {
+            break;
+        }
+        ir_db_record_t rec;
+        char name[IR_KEY_MAX_LEN];
+        if (ir_db_read_record(entry->offset, &rec, name) != ESP_OK)
+        {
+            continue;
+        }
+        if (key && entry->key_hash == key_hash && strcmp(name, key) <= 0)
+        {
+            continue;
+        }
+        if (!found || strcmp(name, key_out) < 0)
+        {
+            *entry_out = *entry;
+            strcpy(key_out, name);
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t ir_db_foreach(ir_db_foreach_cb_t cb, void *arg)
+{
+    if (!s_db_lock || !cb)
+    {
+        return 0;
+    }
+
+    size_t visited = 0;
+    ir_db_entry_t entry = {0};
+    char key[IR_KEY_MAX_LEN];
+    char next[IR_KEY_MAX_LEN];
+    bool more = true;
+    for (const char *cursor = NULL; more; cursor = key)
+    {
+        xSemaphoreTake(s_db_lock, portMAX_DELAY);
+        more = ir_db_next_locked(entry.key_hash, cursor, &entry, next);
+        xSemaphoreGive(s_db_lock);
+
+        if (more)
+        {
+            strcpy(key, next);
+            visited++;
+            more = cb(key, &entry, arg);
+        }
+    }
+    return visited;
+}
+
+size_t ir_db_count(void)
+{
+    if (!s_db_lock)
+    {
+        return 0;
+    }
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    size_t count = s_db_count;
+    xSemaphoreGive(s_db_lock);
+    return count;
+}
+
+esp_err_t ir_db_format(void)
+{
+    if (!s_db_lock)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    if (!ir_db_wait_views_locked())
+    {
+        xSemaphoreGive(s_db_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = esp_partition_erase_range(s_db_part, 0, s_db_size);
+    s_db_count = 0;
+    s_db_live = 0;
+    s_db_head = 0;
+    s_db_tail = 0;
+    s_db_seq = 0;
+    xSemaphoreGive(s_db_lock);
+
+    ESP_LOGW(TAG, "Key database erased: %s", esp_err_to_name(ret));
+    return ret;
+}
+
+esp_err_t ir_db_compact(void)
+{
+    if (!s_db_lock)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    uint32_t budget = ir_db_used_locked();
+    uint32_t walked = 0;
+    esp_err_t ret = ESP_OK;
+    s_db_stats.gc_runs++;
+    while (walked < budget && ir_db_used_locked() > s_db_live)
+    {
+        uint32_t step;
+        ret = ir_db_gc_step_locked(&step);
+        if (ret == ESP_ERR_INVALID_STATE && ir_db_wait_views_locked())
+        {
+            continue;
+        }
+        if (ret != ESP_OK)
+        {
+            break;
+        }
+        walked += step;
+    }
+    xSemaphoreGive(s_db_lock);
+    return ret == ESP_ERR_NOT_FOUND ? ESP_OK : ret;
+}
+
+void ir_db_get_stats(ir_db_stats_t *stats_out)
+{
+    if (!s_db_lock)
+    {
+        memset(stats_out, 0, sizeof(*stats_out));
+        return;
+    }
+
+    xSemaphoreTake(s_db_lock, portMAX_DELAY);
+    *stats_out = s_db_stats;
+    stats_out->size = s_db_size;
+    stats_out->used = ir_db_used_locked();
+    stats_out->live = s_db_live;
+    stats_out->free = ir_db_free_locked();
+    stats_out->keys = s_db_count;
+    stats_out->views = s_db_views;
+    stats_out->mapped = (s_db_map != NULL);
+    xSemaphoreGive(s_db_lock);
+}
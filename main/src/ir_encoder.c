@@ -7,36 +7,109 @@
 #include "esp_err.h"
 
 #include "ir_encoder.h"
+#include "ir_protocol.h"
 #include "ir_learn_err_check.h"
 
 static const char *TAG = "raw_encoder";
 
+#define IR_ENCODER_IDLE_TICKS_MAX 0x7FFF // longest level of one RMT symbol
+
+enum {
+    IR_ENCODER_STATE_START = 0, // next call starts a new frame
+    IR_ENCODER_STATE_GAP,       // sending the idle symbols before the frame
+    IR_ENCODER_STATE_PAYLOAD,   // sending the frame symbols
+};
+
+typedef struct {
+    rmt_encoder_t base;           // the base "class", declares the standard encoder interface
+    rmt_encoder_t *copy_encoder;  // use the copy_encoder to stream the synthesized symbols
+    rmt_symbol_word_t symbols[IR_PROTOCOL_FRAME_MAX_SYMBOLS]; // symbols of the frame being sent
+    size_t num_symbols;
+    uint32_t resolution;          // encoder resolution, in Hz
+    uint32_t gap_left;            // idle ticks still to send before the frame
+    rmt_symbol_word_t gap_symbol; // idle symbol being sent
+    int state;
+} rmt_ir_protocol_encoder_t;
+
 typedef struct {
     rmt_encoder_t base;           // the base "class", declares the standard encoder interface
-    rmt_encoder_t *copy_encoder;  // use the copy_encoder to encode the leading and ending pulse
+    rmt_encoder_t *copy_encoder;  // use the copy_encoder to encode the idle gap and the raw symbols
     rmt_encoder_t *bytes_encoder; // use the bytes_encoder to encode the address and command data
     rmt_symbol_word_t nec_leading_symbol; // NEC leading code with RMT representation
     rmt_symbol_word_t nec_ending_symbol;  // NEC ending code with RMT representation
+    uint32_t resolution;          // encoder resolution, in Hz
+    uint32_t gap_left;            // idle ticks still to send before the frame
+    rmt_symbol_word_t gap_symbol; // idle symbol being sent
     int state;
 } rmt_ir_nec_encoder_t;
 
-static size_t ir_encoder_rmt_raw(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+/**
+ * @brief Send the idle time before a frame as level 0 symbols, one symbol per call of the copy encoder.
+ *
+ * @return true when the whole gap is sent, false if the encoder has to yield
+ */
+static bool ir_encoder_encode_gap(rmt_encoder_t *copy_encoder, rmt_channel_handle_t channel, uint32_t *gap_left,
+                                  rmt_symbol_word_t *gap_symbol, size_t *encoded_symbols)
 {
-    IR_LEARN_CHECK(encoder, "invalid argument", ESP_ERR_INVALID_ARG);
+    while (*gap_left > 1) {
+        // the symbol only depends on gap_left, so it is rebuilt identically after a yield
+        uint32_t ticks = *gap_left;
+        if (ticks > IR_ENCODER_IDLE_TICKS_MAX * 2) {
+            ticks = IR_ENCODER_IDLE_TICKS_MAX * 2;
+        }
+        gap_symbol->level0 = 0;
+        gap_symbol->duration0 = ticks - ticks / 2;
+        gap_symbol->level1 = 0;
+        gap_symbol->duration1 = ticks / 2;
+
+        rmt_encode_state_t session_state = 0;
+        *encoded_symbols += copy_encoder->encode(copy_encoder, channel, gap_symbol, sizeof(rmt_symbol_word_t), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            *gap_left -= ticks;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            return false;
+        }
+    }
+    return true;
+}
 
+static size_t ir_encoder_rmt_raw(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
     rmt_ir_nec_encoder_t *nec_encoder = __containerof(encoder, rmt_ir_nec_encoder_t, base);
+    const ir_encoder_frame_t *frame = primary_data;
     rmt_encode_state_t session_state = 0;
     rmt_encode_state_t state = 0;
     size_t encoded_symbols = 0;
     rmt_encoder_handle_t copy_encoder = nec_encoder->copy_encoder;
 
-    encoded_symbols += copy_encoder->encode(copy_encoder, channel, primary_data, data_size * sizeof(rmt_symbol_word_t), &session_state);
-    if (session_state & RMT_ENCODING_COMPLETE) {
-        nec_encoder->state = 1; // we can only switch to next state when p_symbolsrent encoder finished
+    if (data_size != sizeof(ir_encoder_frame_t)) {
+        *ret_state = RMT_ENCODING_COMPLETE;
+        return 0;
     }
-    if (session_state & RMT_ENCODING_MEM_FULL) {
-        state |= RMT_ENCODING_MEM_FULL;
-        goto out; // yield if there's no free space to put other encoding artifacts
+
+    switch (nec_encoder->state) {
+    case IR_ENCODER_STATE_START:
+        nec_encoder->gap_left = (uint64_t)frame->gap_us * nec_encoder->resolution / 1000000;
+        nec_encoder->state = IR_ENCODER_STATE_GAP;
+    // fall-through
+    case IR_ENCODER_STATE_GAP:
+        if (!ir_encoder_encode_gap(copy_encoder, channel, &nec_encoder->gap_left, &nec_encoder->gap_symbol, &encoded_symbols)) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space to put other encoding artifacts
+        }
+        nec_encoder->state = IR_ENCODER_STATE_PAYLOAD;
+    // fall-through
+    case IR_ENCODER_STATE_PAYLOAD:
+        encoded_symbols += copy_encoder->encode(copy_encoder, channel, frame->symbols, frame->num_symbols * sizeof(rmt_symbol_word_t), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            nec_encoder->state = IR_ENCODER_STATE_START;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space to put other encoding artifacts
+        }
     }
 out:
     *ret_state = state;
@@ -69,7 +142,7 @@ static esp_err_t ir_encoder_reset(rmt_encoder_t *encoder)
     if (nec_encoder->bytes_encoder) {
         rmt_encoder_reset(nec_encoder->bytes_encoder);
     }
-    nec_encoder->state = 0;
+    nec_encoder->state = IR_ENCODER_STATE_START;
     return ESP_OK;
 }
 
@@ -84,6 +157,7 @@ esp_err_t ir_encoder_new(const ir_encoder_config_t *config, rmt_encoder_handle_t
     nec_encoder->base.encode = ir_encoder_rmt_raw;
     nec_encoder->base.del = ir_encoder_del;
     nec_encoder->base.reset = ir_encoder_reset;
+    nec_encoder->resolution = config->resolution;
 
     rmt_copy_encoder_config_t copy_encoder_config = {};
     ret = rmt_new_copy_encoder(&copy_encoder_config, &nec_encoder->copy_encoder);
@@ -103,3 +177,96 @@ err:
     }
     return ret;
 }
+
+static size_t ir_encoder_rmt_protocol(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_ir_protocol_encoder_t *protocol_encoder = __containerof(encoder, rmt_ir_protocol_encoder_t, base);
+    const ir_encoder_frame_t *frame = primary_data;
+    rmt_encode_state_t session_state = 0;
+    rmt_encode_state_t state = 0;
+    size_t encoded_symbols = 0;
+    rmt_encoder_handle_t copy_encoder = protocol_encoder->copy_encoder;
+
+    switch (protocol_encoder->state) {
+    case IR_ENCODER_STATE_START:
+        // build the symbols once per frame, the copy encoder may need several rounds to send them
+        protocol_encoder->num_symbols = (data_size == sizeof(ir_encoder_frame_t)) ?
+                                        ir_protocol_build(&frame->frame, protocol_encoder->symbols, IR_PROTOCOL_FRAME_MAX_SYMBOLS) : 0;
+        if (protocol_encoder->num_symbols == 0) {
+            *ret_state = RMT_ENCODING_COMPLETE;
+            return 0;
+        }
+        protocol_encoder->gap_left = (uint64_t)frame->gap_us * protocol_encoder->resolution / 1000000;
+        protocol_encoder->state = IR_ENCODER_STATE_GAP;
+    // fall-through
+    case IR_ENCODER_STATE_GAP:
+        if (!ir_encoder_encode_gap(copy_encoder, channel, &protocol_encoder->gap_left, &protocol_encoder->gap_symbol, &encoded_symbols)) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out;
+        }
+        protocol_encoder->state = IR_ENCODER_STATE_PAYLOAD;
+    // fall-through
+    case IR_ENCODER_STATE_PAYLOAD:
+        encoded_symbols += copy_encoder->encode(copy_encoder, channel, protocol_encoder->symbols,
+                                                protocol_encoder->num_symbols * sizeof(rmt_symbol_word_t), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            protocol_encoder->state = IR_ENCODER_STATE_START;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+        }
+    }
+out:
+    *ret_state = state;
+    return encoded_symbols;
+}
+
+static esp_err_t ir_protocol_encoder_del(rmt_encoder_t *encoder)
+{
+    IR_LEARN_CHECK(encoder, "invalid argument", ESP_ERR_INVALID_ARG);
+
+    rmt_ir_protocol_encoder_t *protocol_encoder = __containerof(encoder, rmt_ir_protocol_encoder_t, base);
+    if (protocol_encoder->copy_encoder) {
+        rmt_del_encoder(protocol_encoder->copy_encoder);
+    }
+    free(protocol_encoder);
+    return ESP_OK;
+}
+
+static esp_err_t ir_protocol_encoder_reset(rmt_encoder_t *encoder)
+{
+    IR_LEARN_CHECK(encoder, "invalid argument", ESP_ERR_INVALID_ARG);
+
+    rmt_ir_protocol_encoder_t *protocol_encoder = __containerof(encoder, rmt_ir_protocol_encoder_t, base);
+    if (protocol_encoder->copy_encoder) {
+        rmt_encoder_reset(protocol_encoder->copy_encoder);
+    }
+    protocol_encoder->state = IR_ENCODER_STATE_START;
+    return ESP_OK;
+}
+
+esp_err_t ir_protocol_encoder_new(const ir_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    esp_err_t ret = ESP_OK;
+    rmt_ir_protocol_encoder_t *protocol_encoder = NULL;
+    IR_LEARN_CHECK(config && ret_encoder, "invalid argument", ESP_ERR_INVALID_ARG);
+    IR_LEARN_CHECK(config->resolution == 1000000, "protocol timings need a 1 MHz resolution", ESP_ERR_INVALID_ARG);
+
+    protocol_encoder = calloc(1, sizeof(rmt_ir_protocol_encoder_t));
+    IR_LEARN_CHECK(protocol_encoder, "no mem for ir protocol encoder", ESP_ERR_NO_MEM);
+    protocol_encoder->base.encode = ir_encoder_rmt_protocol;
+    protocol_encoder->base.del = ir_protocol_encoder_del;
+    protocol_encoder->base.reset = ir_protocol_encoder_reset;
+    protocol_encoder->resolution = config->resolution;
+
+    rmt_copy_encoder_config_t copy_encoder_config = {};
+    ret = rmt_new_copy_encoder(&copy_encoder_config, &protocol_encoder->copy_encoder);
+    IR_LEARN_CHECK_GOTO((ESP_OK == ret), "create copy encoder failed", ESP_FAIL, err);
+
+    *ret_encoder = &protocol_encoder->base;
+    return ESP_OK;
+err:
+    free(protocol_encoder);
+    return ret;
+}
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#include "ir_file.h"
+
+static const char *TAG = "IR_file";
+
+esp_err_t ir_file_tmp_path(const char *path, char *tmp_path, size_t size)
+{
+    const char *dot = strrchr(path, '.');
+    int len = dot ? (int)(dot - path) : (int)strlen(path);
+    int written = snprintf(tmp_path, size, "%.*s.tmp", len, path);
+    return written >= 0 && written < size ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @brief Check a header against the size of its file, nothing is allocated before this passes.
+ */
+static esp_err_t ir_file_check_header(const ir_file_header_t *header, size_t file_size, uint16_t type)
+{
+    if (file_size < sizeof(header->magic) || header->magic != IR_FILE_MAGIC)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (file_size < sizeof(*header))
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (header->version != IR_FILE_VERSION)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (header->type != type || header->length > IR_FILE_PAYLOAD_MAX || file_size - sizeof(*header) != header->length)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ir_file_check(const uint8_t *buf, size_t size, uint16_t type, const uint8_t **payload_out)
+{
+    ir_file_header_t header = {0};
+    memcpy(&header, buf, size < sizeof(header) ? size : sizeof(header));
+    esp_err_t ret = ir_file_check_header(&header, size, type);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (esp_rom_crc32_le(0, buf + sizeof(header), header.length) != header.crc)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (payload_out)
+    {
+        *payload_out = buf + sizeof(header);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ir_file_read_path(const char *path, uint16_t type, uint8_t **data_out, size_t *size_out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* A short file leaves the rest of the header zeroed, which the check rejects */
+    ir_file_header_t header = {0};
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    rewind(f);
+    fread(&header, 1, sizeof(header), f);
+    esp_err_t ret = ir_file_check_header(&header, file_size > 0 ? file_size : 0, type);
+    if (ret != ESP_OK)
+    {
+        fclose(f);
+        return ret;
+    }
+
+    uint8_t *data = malloc(header.length + 1);
+    if (!data)
+    {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    size_t read_size = fread(data, 1, header.length, f);
+    fclose(f);
+    if (read_size != header.length)
+    {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    else if (esp_rom_crc32_le(0, data, header.length) != header.crc)
+    {
+        ret = ESP_ERR_INVALID_CRC;
+    }
+    if (ret != ESP_OK)
+    {
+        free(data);
+        return ret;
+    }
+    data[header.length] = '\0';
+    *data_out = data;
+    *size_out = header.length;
+    return ESP_OK;
+}
+
+esp_err_t ir_file_read(const char *path, uint16_t type, uint8_t **data_out, size_t *size_out)
+{
+    if (!path || !data_out || !size_out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ir_file_read_path(path, type, data_out, size_out);
+    if (ret != ESP_ERR_NOT_FOUND)
+    {
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_VERSION)
+        {
+            ESP_LOGE(TAG, "%s rejected: %s", path, esp_err_to_name(ret));
+        }
+        return ret;
+    }
+
+    /* A reset between the removal of the old file and the rename leaves only the new one, complete */
+    char tmp_path[IR_FILE_PATH_MAX];
+    if (ir_file_tmp_path(path, tmp_path, sizeof(tmp_path)) != ESP_OK)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    ret = ir_file_read_path(tmp_path, type, data_out, size_out);
+    if (ret == ESP_OK)
+    {
+        ESP_LOGW(TAG, "Recovered %s from %s", path, tmp_path);
+        rename(tmp_path, path);
+        return ESP_OK;
+    }
+    if (ret != ESP_ERR_NOT_FOUND)
+    {
+        // Torn before the old file was removed, there was no old file
+        unlink(tmp_path);
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t ir_file_write(const char *path, uint16_t type, const void *data, size_t size)
+{
+    if (!path || (!data && size) || size > IR_FILE_PAYLOAD_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ir_file_header_t header = {
+        .magic = IR_FILE_MAGIC,
+        .version = IR_FILE_VERSION,
+        .type = type,
+        .length = size,
+        .crc = esp_rom_crc32_le(0, data, size),
+    };
+    char tmp_path[IR_FILE_PATH_MAX];
+    if (ir_file_tmp_path(path, tmp_path, sizeof(tmp_path)) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Path too long: %s", path);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f)
+    {
+        ESP_LOGE(TAG, "Failed to create %s", tmp_path);
+        return ESP_FAIL;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1 && (size == 0 || fwrite(data, 1, size, f) == size);
+    written = written && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0 || !written)
+    {
+        ESP_LOGE(TAG, "Failed to write %s", tmp_path);
+        unlink(tmp_path);
+        return ESP_FAIL;
+    }
+
+    /* SPIFFS rename doesn't replace an existing file */
+    unlink(path);
+    if (rename(tmp_path, path) != 0)
+    {
+        ESP_LOGE(TAG, "Failed to rename %s", tmp_path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,180 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+
+/* ESP32 includes */
+#include "esp_log.h"
+
+#include "ir_hold.h"
+#include "ir_protocol.h"
+
+static const char *TAG = "IR_hold";
+
+/* Frames shorter than this are noise unless they are repeat codes */
+#define IR_HOLD_MIN_SYMBOLS 5
+
+static struct
+{
+    bool active;           /*!< A press is in progress */
+    bool decoded;          /*!< The first frame decoded as a known protocol */
+    ir_protocol_frame_t frame;
+    uint16_t num_symbols;  /*!< Symbols kept of the first frame, 0 if it was too long */
+    rmt_symbol_word_t symbols[IR_HOLD_MAX_SYMBOLS];
+    int64_t press_us;      /*!< Time of the first frame */
+    int64_t last_us;       /*!< Time of the last frame of the press */
+    int64_t held_us;       /*!< Time of the last held event */
+    uint16_t repeats;
+    char key[IR_KEY_MAX_LEN];
+} s_hold;
+
+static ir_hold_stats_t s_hold_stats;
+static portMUX_TYPE s_hold_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Compare a raw frame with the first frame of the press, symbol by symbol.
+ */
+static bool ir_hold_same_raw(const rmt_rx_done_event_data_t *data)
+{
+    if (s_hold.num_symbols == 0 || data->num_symbols != s_hold.num_symbols)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < data->num_symbols; i++)
+    {
+        const rmt_symbol_word_t *a = &data->received_symbols[i];
+        const rmt_symbol_word_t *b = &s_hold.symbols[i];
+        /* The last space runs into the idle level, its length is not part of the frame */
+        if (abs((int)a->duration0 - (int)b->duration0) > RMT_DECODE_MARGIN ||
+            (i + 1 < data->num_symbols && abs((int)a->duration1 - (int)b->duration1) > RMT_DECODE_MARGIN))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ir_hold_kind_t ir_hold_feed(const ir_rx_frame_t *frame)
+{
+    const rmt_rx_done_event_data_t *data = &frame->data;
+    ir_protocol_frame_t decoded;
+    bool is_decoded = ir_protocol_decode(data->received_symbols, data->num_symbols, &decoded) == ESP_OK;
+    bool is_repeat_code = is_decoded && decoded.repeat;
+
+    bool in_press = s_hold.active && frame->time_us - s_hold.last_us < IR_HOLD_TIMEOUT_MS * 1000;
+    bool repeat = false;
+    if (in_press)
+    {
+        if (is_repeat_code)
+        {
+            repeat = true;
+        }
+        else if (is_decoded && s_hold.decoded)
+        {
+            repeat = ir_protocol_frame_equal(&decoded, &s_hold.frame);
+        }
+        else
+        {
+            repeat = ir_hold_same_raw(data);
+        }
+    }
+
+    if (repeat)
+    {
+        s_hold.last_us = frame->time_us;
+        s_hold.repeats++;
+        bool held = s_hold.key[0] &&
+                    frame->time_us - s_hold.press_us >= IR_HOLD_DELAY_MS * 1000 &&
+                    (s_hold.held_us == 0 || frame->time_us - s_hold.held_us >= IR_HOLD_INTERVAL_MS * 1000);
+        if (held)
+        {
+            s_hold.held_us = frame->time_us;
+        }
+
+        portENTER_CRITICAL(&s_hold_lock);
+        s_hold_stats.repeats++;
+        s_hold_stats.held_events += held;
+        if (s_hold.repeats > s_hold_stats.longest_hold)
+        {
+            s_hold_stats.longest_hold = s_hold.repeats;
+        }
+        portEXIT_CRITICAL(&s_hold_lock);
+        return held ? IR_HOLD_HELD : IR_HOLD_REPEAT;
+    }
+
+    if (is_repeat_code)
+    {
+        /* The press was missed or ended too long ago, there is nothing to repeat */
+        s_hold.active = false;
+        portENTER_CRITICAL(&s_hold_lock);
+        s_hold_stats.orphan_repeats++;
+        portEXIT_CRITICAL(&s_hold_lock);
+        return IR_HOLD_NONE;
+    }
+    if (data->num_symbols < IR_HOLD_MIN_SYMBOLS)
+    {
+        ESP_LOGD(TAG, "Signal too short, received symbols: %d", data->num_symbols);
+        return IR_HOLD_NONE;
+    }
+
+    s_hold.active = true;
+    s_hold.decoded = is_decoded;
+    s_hold.frame = decoded;
+    s_hold.num_symbols = 0;
+    if (data->num_symbols <= IR_HOLD_MAX_SYMBOLS)
+    {
+        memcpy(s_hold.symbols, data->received_symbols, data->num_symbols * sizeof(rmt_symbol_word_t));
+        s_hold.num_symbols = data->num_symbols;
+    }
+    s_hold.press_us = frame->time_us;
+    s_hold.last_us = frame->time_us;
+    s_hold.held_us = 0;
+    s_hold.repeats = 0;
+    s_hold.key[0] = '\0';
+
+    portENTER_CRITICAL(&s_hold_lock);
+    s_hold_stats.presses++;
+    portEXIT_CRITICAL(&s_hold_lock);
+    return IR_HOLD_PRESS;
+}
+
+void ir_hold_set_key(const char *key)
+{
+    if (key)
+    {
+        snprintf(s_hold.key, sizeof(s_hold.key), "%s", key);
+    }
+    else
+    {
+        s_hold.key[0] = '\0';
+    }
+}
+
+bool ir_hold_get_key(char *key_out, uint16_t *repeats_out)
+{
+    if (repeats_out)
+    {
+        *repeats_out = s_hold.repeats;
+    }
+    if (!s_hold.active || !s_hold.key[0])
+    {
+        return false;
+    }
+    snprintf(key_out, IR_KEY_MAX_LEN, "%s", s_hold.key);
+    return true;
+}
+
+void ir_hold_reset(void)
+{
+    s_hold.active = false;
+    s_hold.key[0] = '\0';
+}
+
+void ir_hold_get_stats(ir_hold_stats_t *stats_out)
+{
+    portENTER_CRITICAL(&s_hold_lock);
+    *stats_out = s_hold_stats;
+    portEXIT_CRITICAL(&s_hold_lock);
+}
@@ -0,0 +1,616 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/queue.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "ir_learn.h"
+#include "ir_config.h"
+#include "ir_storage.h"
+#include "ir_index.h"
+#include "ir_db.h"
+#include "ir_protocol.h"
+#include "ir_normalize.h"
+
+static const char *TAG = "IR_index";
+
+#define IR_INDEX_LEVEL_MAX 0xFF
+/* Rounding moves a level by half a step at most, the preamble never rejects levels within IR_TOLERANCE_US */
+#define IR_INDEX_TOLERANCE_Q (IR_TOLERANCE_US / IR_INDEX_QUANTUM_US + 1)
+
+/* Both levels of a symbol are compared at once, one per 16-bit lane of a word */
+#define IR_INDEX_LANES(value) ((uint32_t)(value) | ((uint32_t)(value) << 16))
+#define IR_INDEX_LANE_BIAS IR_INDEX_LANES(0x100 + IR_INDEX_TOLERANCE_Q)
+#define IR_INDEX_LANE_ABOVE IR_INDEX_LANES(0x8000 - 0x101 - 2 * IR_INDEX_TOLERANCE_Q)
+#define IR_INDEX_LANE_BELOW IR_INDEX_LANES(0x8000 - 0x100)
+#define IR_INDEX_LANE_SIGN 0x80008000u
+
+/* Symbols compared per early-exit check of the full compare */
+#define IR_INDEX_BLOCK_SYMBOLS 8
+
+/**
+ * @brief Fingerprint of one stored key.
+ *
+ * Keys of a known protocol are identified by their decoded frame only.
+ * Other keys keep their per sub-frame symbol counts and durations,
+ * allocated in the same block as the entry.
+ */
+typedef struct ir_index_entry_t
+{
+    char key[IR_KEY_MAX_LEN];
+    uint32_t shape_hash;       /*!< Signature: hash of the decoded frame, or of the sub-frame layout */
+    uint32_t canon_hash;       /*!< Hash of the canonical form, raw keys only, 0 if there's none */
+    uint16_t sub_count;        /*!< Number of sub-frames */
+    uint16_t symbol_count;     /*!< Total number of symbols */
+    ir_protocol_frame_t frame; /*!< Decoded first sub-frame, IR_PROTOCOL_UNKNOWN for raw keys */
+    uint32_t preamble[IR_INDEX_PREAMBLE_SYMBOLS]; /*!< Packed levels of the first symbols, raw keys only */
+    uint16_t *sub_symbols;     /*!< Symbols per sub-frame, sub_count items */
+    uint16_t *durations;       /*!< duration0/duration1 pairs, symbol_count * 2 items */
+    SLIST_ENTRY(ir_index_entry_t) next;
+    SLIST_ENTRY(ir_index_entry_t) canon_next; /*!< Link in the canonical hash table, if canon_hash */
+} ir_index_entry_t;
+
+/**
+ * @brief Fingerprint of received IR data, computed once per lookup.
+ */
+typedef struct
+{
+    uint32_t shape_hash;
+    uint32_t canon_hash;
+    uint16_t sub_count;
+    uint16_t symbol_count;
+    ir_protocol_frame_t frame;
+    uint32_t preamble[IR_INDEX_PREAMBLE_SYMBOLS];
+} ir_index_probe_t;
+
+SLIST_HEAD(ir_index_bucket_t, ir_index_entry_t);
+
+static struct ir_index_bucket_t s_buckets[IR_INDEX_BUCKETS];
+static struct ir_index_bucket_t s_canon_buckets[IR_INDEX_BUCKETS]; /*!< Raw keys by canonical hash */
+static SemaphoreHandle_t s_index_lock = NULL;
+static size_t s_index_count = 0;
+static uint32_t s_index_generation = 0;
+static ir_index_match_stats_t s_match_stats = {0};
+
+static inline uint8_t ir_index_quantize(uint32_t duration)
+{
+    uint32_t q = (duration + IR_INDEX_QUANTUM_US / 2) / IR_INDEX_QUANTUM_US;
+    return (q > IR_INDEX_LEVEL_MAX) ? IR_INDEX_LEVEL_MAX : (uint8_t)q;
+}
+
+static inline uint32_t ir_index_pack(uint8_t level0, uint8_t level1)
+{
+    return (uint32_t)level0 | ((uint32_t)level1 << 16);
+}
+
+static inline uint32_t ir_index_pack_symbol(const rmt_symbol_word_t *symbol)
+{
+    return ir_index_pack(ir_index_quantize(symbol->duration0), ir_index_quantize(symbol->duration1));
+}
+
+/**
+ * @brief Compare two packed symbols, non-zero if a level differs by more than IR_INDEX_TOLERANCE_Q.
+ *
+ * With u = a + T + 0x100 - b in each lane, |a - b| <= T is 0x100 <= u <= 0x100 + 2T.
+ * Both bounds are moved to the top bit of the lane, and no lane carries into the next.
+ */
+static inline uint32_t ir_index_mismatch(uint32_t a, uint32_t b)
+{
+    uint32_t u = a + IR_INDEX_LANE_BIAS - b;
+    return ((u + IR_INDEX_LANE_ABOVE) | ~(u + IR_INDEX_LANE_BELOW)) & IR_INDEX_LANE_SIGN;
+}
+
+/**
+ * @brief Compare two durations, non-zero if they differ by more than IR_TOLERANCE_US.
+ *
+ * |a - b| <= T is 0 <= a - b + T <= 2T, out of range values wrap above 2T.
+ */
+static inline uint32_t ir_index_outside(uint32_t a, uint32_t b)
+{
+    return (a - b + IR_TOLERANCE_US) > 2 * IR_TOLERANCE_US;
+}
+
+static inline uint32_t ir_index_hash_step(uint32_t hash, uint32_t value)
+{
+    /* FNV-1a over the 16-bit value */
+    hash = (hash ^ (value & 0xFF)) * 16777619u;
+    hash = (hash ^ ((value >> 8) & 0xFF)) * 16777619u;
+    return hash;
+}
+
+static void ir_index_fingerprint(const struct ir_learn_sub_list_head *list, ir_index_probe_t *probe)
+{
+    uint32_t hash = 2166136261u;
+    uint16_t subs = 0;
+    uint32_t symbols = 0;
+    struct ir_learn_sub_list_t *sub_it;
+
+    SLIST_FOREACH(sub_it, list, next)
+    {
+        hash = ir_index_hash_step(hash, sub_it->symbols.num_symbols);
+        symbols += sub_it->symbols.num_symbols;
+        subs++;
+    }
+    hash = ir_index_hash_step(hash, subs);
+
+    probe->sub_count = subs;
+    probe->symbol_count = (symbols > UINT16_MAX) ? UINT16_MAX : symbols;
+    memset(&probe->frame, 0, sizeof(probe->frame));
+    memset(probe->preamble, 0, sizeof(probe->preamble));
+
+    struct ir_learn_sub_list_t *first = SLIST_FIRST(list);
+    for (size_t i = 0; first && i < IR_INDEX_PREAMBLE_SYMBOLS && i < first->symbols.num_symbols; i++)
+    {
+        probe->preamble[i] = ir_index_pack_symbol(&first->symbols.received_symbols[i]);
+    }
+
+    /* A decoded frame is matched on its payload, regardless of how many repeats were captured */
+    if (first && ir_protocol_decode(first->symbols.received_symbols, first->symbols.num_symbols, &probe->frame) == ESP_OK &&
+        !probe->frame.repeat)
+    {
+        hash = 2166136261u;
+        hash = ir_index_hash_step(hash, probe->frame.protocol | (probe->frame.bits << 8));
+        hash = ir_index_hash_step(hash, probe->frame.address);
+        hash = ir_index_hash_step(hash, probe->frame.command);
+    }
+    else
+    {
+        probe->frame.protocol = IR_PROTOCOL_UNKNOWN;
+    }
+    probe->shape_hash = hash;
+    probe->canon_hash = (probe->frame.protocol == IR_PROTOCOL_UNKNOWN) ? ir_normalize_hash(list) : 0;
+}
+
+static ir_index_entry_t *ir_index_find_locked(const char *key)
+{
+    ir_index_entry_t *entry;
+    for (int i = 0; i < IR_INDEX_BUCKETS; i++)
+    {
+        SLIST_FOREACH(entry, &s_buckets[i], next)
+        {
+            if (strncmp(entry->key, key, IR_KEY_MAX_LEN) == 0)
+            {
+                return entry;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void ir_index_unlink_locked(ir_index_entry_t *entry)
+{
+    SLIST_REMOVE(&s_buckets[entry->shape_hash % IR_INDEX_BUCKETS], entry, ir_index_entry_t, next);
+    if (entry->canon_hash)
+    {
+        SLIST_REMOVE(&s_canon_buckets[entry->canon_hash % IR_INDEX_BUCKETS], entry, ir_index_entry_t, canon_next);
+    }
+    free(entry);
+    s_index_count--;
+}
+
+/**
+ * @brief Compare received data with an entry, from the cheapest check to the most expensive one.
+ *
+ * 1. Signature, protocol and sub-frame/symbol counts from the entry header
+ * 2. The first IR_INDEX_PREAMBLE_SYMBOLS symbols, quantized
+ * 3. The durations of every symbol, IR_INDEX_BLOCK_SYMBOLS at a time
+ */
+static bool ir_index_compare(const ir_index_entry_t *entry, const struct ir_learn_sub_list_head *data,
+                             const ir_index_probe_t *probe)
+{
+    s_match_stats.candidates++;
+    if (entry->shape_hash != probe->shape_hash || entry->frame.protocol != probe->frame.protocol)
+    {
+        s_match_stats.header_rejects++;
+        return false;
+    }
+
+    if (entry->frame.protocol != IR_PROTOCOL_UNKNOWN)
+    {
+        if (!ir_protocol_frame_equal(&entry->frame, &probe->frame))
+        {
+            s_match_stats.header_rejects++;
+            return false;
+        }
+        s_match_stats.matches++;
+        return true;
+    }
+
+    if (entry->sub_count != probe->sub_count || entry->symbol_count != probe->symbol_count)
+    {
+        s_match_stats.header_rejects++;
+        return false;
+    }
+
+    uint32_t mismatch = 0;
+    for (int i = 0; i < IR_INDEX_PREAMBLE_SYMBOLS; i++)
+    {
+        mismatch |= ir_index_mismatch(probe->preamble[i], entry->preamble[i]);
+    }
+    if (mismatch)
+    {
+        s_match_stats.preamble_rejects++;
+        return false;
+    }
+
+    s_match_stats.full_compares++;
+    const uint16_t *durations = entry->durations;
+    int sub_index = 0;
+    struct ir_learn_sub_list_t *sub_it;
+
+    SLIST_FOREACH(sub_it, data, next)
+    {
+        if (sub_it->symbols.num_symbols != entry->sub_symbols[sub_index++])
+        {
+            return false;
+        }
+
+        const rmt_symbol_word_t *p_symbols = sub_it->symbols.received_symbols;
+        size_t count = sub_it->symbols.num_symbols;
+        for (size_t i = 0; i < count; i += IR_INDEX_BLOCK_SYMBOLS)
+        {
+            size_t end = (count - i > IR_INDEX_BLOCK_SYMBOLS) ? i + IR_INDEX_BLOCK_SYMBOLS : count;
+            for (size_t j = i; j < end; j++)
+            {
+                mismatch |= ir_index_outside(p_symbols[j].duration0, durations[0]) |
+                            ir_index_outside(p_symbols[j].duration1, durations[1]);
+                durations += 2;
+            }
+            if (mismatch)
+            {
+                return false;
+            }
+        }
+    }
+    s_match_stats.matches++;
+    return true;
+}
+
+esp_err_t ir_index_update(const char *key, const struct ir_learn_sub_list_head *list)
+{
+    if (!key || !list || !s_index_lock)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ir_index_probe_t probe;
+    ir_index_fingerprint(list, &probe);
+    if (probe.sub_count == 0)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    bool raw = (probe.frame.protocol == IR_PROTOCOL_UNKNOWN);
+    size_t size = sizeof(ir_index_entry_t);
+    if (raw)
+    {
+        size += (probe.sub_count + probe.symbol_count * 2) * sizeof(uint16_t);
+    }
+    ir_index_entry_t *entry = calloc(1, size);
+    if (!entry)
+    {
+        ESP_LOGE(TAG, "No mem to index key: %s", key);
+        return ESP_ERR_NO_MEM;
+    }
+
+    strncpy(entry->key, key, IR_KEY_MAX_LEN - 1);
+    entry->shape_hash = probe.shape_hash;
+    entry->canon_hash = probe.canon_hash;
+    entry->sub_count = probe.sub_count;
+    entry->symbol_count = probe.symbol_count;
+    entry->frame = probe.frame;
+
+    if (raw)
+    {
+        memcpy(entry->preamble, probe.preamble, sizeof(entry->preamble));
+        entry->sub_symbols = (uint16_t *)(entry + 1);
+        entry->durations = entry->sub_symbols + probe.sub_count;
+
+        uint16_t *durations = entry->durations;
+        uint16_t *durations_end = entry->durations + probe.symbol_count * 2;
+        int sub_index = 0;
+        struct ir_learn_sub_list_t *sub_it;
+        SLIST_FOREACH(sub_it, list, next)
+        {
+            entry->sub_symbols[sub_index++] = sub_it->symbols.num_symbols;
+            const rmt_symbol_word_t *p_symbols = sub_it->symbols.received_symbols;
+            for (size_t i = 0; i < sub_it->symbols.num_symbols && durations < durations_end; i++)
+            {
+                *durations++ = p_symbols[i].duration0;
+                *durations++ = p_symbols[i].duration1;
+            }
+        }
+    }
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    ir_index_entry_t *old = ir_index_find_locked(key);
+    if (old)
+    {
+        ir_index_unlink_locked(old);
+    }
+    SLIST_INSERT_HEAD(&s_buckets[probe.shape_hash % IR_INDEX_BUCKETS], entry, next);
+    if (entry->canon_hash)
+    {
+        SLIST_INSERT_HEAD(&s_canon_buckets[entry->canon_hash % IR_INDEX_BUCKETS], entry, canon_next);
+    }
+    s_index_count++;
+    s_index_generation++;
+    xSemaphoreGive(s_index_lock);
+
+    ESP_LOGD(TAG, "Indexed key: %s (%s, %d sub, %d symbols)", key,
+             ir_protocol_name(probe.frame.protocol), probe.sub_count, probe.symbol_count);
+    return ESP_OK;
+}
+
+esp_err_t ir_index_remove(const char *key)
+{
+    if (!key || !s_index_lock)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    ir_index_entry_t *entry = ir_index_find_locked(key);
+    if (entry)
+    {
+        ir_index_unlink_locked(entry);
+        s_index_generation++;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_index_lock);
+    return ret;
+}
+
+esp_err_t ir_index_rename(const char *old_key, const char *new_key)
+{
+    if (!old_key || !new_key || !s_index_lock)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    ir_index_entry_t *entry = ir_index_find_locked(old_key);
+    if (entry)
+    {
+        ir_index_entry_t *existing = ir_index_find_locked(new_key);
+        if (existing)
+        {
+            ir_index_unlink_locked(existing);
+        }
+        memset(entry->key, 0, sizeof(entry->key));
+        strncpy(entry->key, new_key, IR_KEY_MAX_LEN - 1);
+        s_index_generation++;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_index_lock);
+    return ret;
+}
+
+void ir_index_clear(void)
+{
+    if (!s_index_lock)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    for (int i = 0; i < IR_INDEX_BUCKETS; i++)
+    {
+        while (!SLIST_EMPTY(&s_buckets[i]))
+        {
+            ir_index_entry_t *entry = SLIST_FIRST(&s_buckets[i]);
+            SLIST_REMOVE_HEAD(&s_buckets[i], next);
+            free(entry);
+        }
+        SLIST_INIT(&s_canon_buckets[i]);
+    }
+    s_index_count = 0;
+    s_index_generation++;
+    xSemaphoreGive(s_index_lock);
+}
+
+bool ir_index_match(const struct ir_learn_sub_list_head *data, char *matched_key_out, size_t out_len)
+{
+    if (!data || SLIST_EMPTY(data) || !s_index_lock)
+    {
+        return false;
+    }
+
+    int64_t start = esp_timer_get_time();
+    ir_index_probe_t probe;
+    ir_index_fingerprint(data, &probe);
+    int candidates = 0;
+    bool matched = false;
+    ir_index_entry_t *entry;
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    /* Exact lookup of the canonical form first, it singles out a raw key among those of the same layout */
+    if (probe.canon_hash)
+    {
+        SLIST_FOREACH(entry, &s_canon_buckets[probe.canon_hash % IR_INDEX_BUCKETS], canon_next)
+        {
+            if (entry->canon_hash != probe.canon_hash)
+            {
+                continue;
+            }
+            candidates++;
+            if (ir_index_compare(entry, data, &probe))
+            {
+                matched = true;
+                s_match_stats.canon_hits++;
+                break;
+            }
+        }
+    }
+    /* The canonical form can differ on a level close to half a period, the tolerance scan still matches it */
+    if (!matched)
+    {
+        SLIST_FOREACH(entry, &s_buckets[probe.shape_hash % IR_INDEX_BUCKETS], next)
+        {
+            if (entry->shape_hash != probe.shape_hash)
+            {
+                continue;
+            }
+            candidates++;
+            if (ir_index_compare(entry, data, &probe))
+            {
+                matched = true;
+                break;
+            }
+        }
+    }
+    if (matched && matched_key_out && out_len)
+    {
+        snprintf(matched_key_out, out_len, "%s", entry->key);
+    }
+    size_t count = s_index_count;
+    uint32_t elapsed = esp_timer_get_time() - start;
+    s_match_stats.lookups++;
+    s_match_stats.total_us += elapsed;
+    if (elapsed > s_match_stats.max_us)
+    {
+        s_match_stats.max_us = elapsed;
+    }
+    xSemaphoreGive(s_index_lock);
+
+    ESP_LOGD(TAG, "Lookup over %d keys: %d candidates, %" PRIu32 " us", count, candidates, elapsed);
+    return matched;
+}
+
+bool ir_index_match_key(const struct ir_learn_sub_list_head *data, const char *key)
+{
+    if (!data || !key || SLIST_EMPTY(data) || !s_index_lock)
+    {
+        return false;
+    }
+
+    ir_index_probe_t probe;
+    ir_index_fingerprint(data, &probe);
+    bool matched = false;
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    ir_index_entry_t *entry = ir_index_find_locked(key);
+    if (entry)
+    {
+        matched = ir_index_compare(entry, data, &probe);
+    }
+    xSemaphoreGive(s_index_lock);
+
+    return matched;
+}
+
+size_t ir_index_count(void)
+{
+    if (!s_index_lock)
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    size_t count = s_index_count;
+    xSemaphoreGive(s_index_lock);
+    return count;
+}
+
+uint32_t ir_index_signature(const struct ir_learn_sub_list_head *data)
+{
+    ir_index_probe_t probe;
+    ir_index_fingerprint(data, &probe);
+    return probe.shape_hash;
+}
+
+esp_err_t ir_index_get_signature(const char *key, uint32_t *signature_out)
+{
+    if (!key || !signature_out || !s_index_lock)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    ir_index_entry_t *entry = ir_index_find_locked(key);
+    if (entry)
+    {
+        *signature_out = entry->shape_hash;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_index_lock);
+    return ret;
+}
+
+void ir_index_get_match_stats(ir_index_match_stats_t *stats_out)
+{
+    if (s_index_lock)
+    {
+        xSemaphoreTake(s_index_lock, portMAX_DELAY);
+    }
+    *stats_out = s_match_stats;
+    if (s_index_lock)
+    {
+        xSemaphoreGive(s_index_lock);
+    }
+}
+
+uint32_t ir_index_generation(void)
+{
+    return s_index_generation;
+}
+
+static bool ir_index_add_stored(const char *key, const ir_db_entry_t *db_entry, void *arg)
+{
+    struct ir_learn_sub_list_head temp_list;
+    ir_learn_init_sub_list(&temp_list);
+    if (ir_learn_load(&temp_list, key) == ESP_OK)
+    {
+        ir_index_update(key, &temp_list);
+    }
+    ir_learn_clean_sub_data(&temp_list);
+    return true;
+}
+
+esp_err_t ir_index_rebuild(void)
+{
+    if (!s_index_lock)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ir_index_clear();
+
+    int64_t start = esp_timer_get_time();
+    ir_db_foreach(ir_index_add_stored, NULL);
+
+    ESP_LOGI(TAG, "Indexed %d IR keys in %lld ms", ir_index_count(), (esp_timer_get_time() - start) / 1000);
+    return ESP_OK;
+}
+
+esp_err_t ir_index_init(void)
+{
+    if (!s_index_lock)
+    {
+        s_index_lock = xSemaphoreCreateMutex();
+        if (!s_index_lock)
+        {
+            ESP_LOGE(TAG, "Create index mutex failed");
+            return ESP_ERR_NO_MEM;
+        }
+        for (int i = 0; i < IR_INDEX_BUCKETS; i++)
+        {
+            SLIST_INIT(&s_buckets[i]);
+            SLIST_INIT(&s_canon_buckets[i]);
+        }
+    }
+
+    return ir_index_rebuild();
+}
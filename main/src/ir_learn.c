@@ -4,9 +4,12 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <sys/queue.h>
 #include <math.h>
+#include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -21,25 +24,68 @@
 #include "driver/rmt_rx.h"
 
 #include "ir_learn.h"
+#include "ir_rx.h"
+#include "ir_hold.h"
 #include "ir_encoder.h"
 #include "ir_learn_err_check.h"
 #include "ir_config.h"
 #include "ir_storage.h"
+#include "ir_alias.h"
+#include "ir_protocol.h"
+#include "ir_normalize.h"
 #include "driver_config.h"
 
 static const char *TAG = "Ir-learn";
 
+#define IR_LEARN_ARENA_ALIGN(size) (((size) + 3) & ~(size_t)3)
+#define IR_LEARN_NODE_SIZE IR_LEARN_ARENA_ALIGN(sizeof(struct ir_learn_sub_list_t))
+
+/**
+ * @brief A chunk of the arena of a sub-frame list, handed out by bumping used.
+ */
+struct ir_learn_arena_t
+{
+    struct ir_learn_arena_t *next;
+    uint32_t size;   /*!< Usable bytes of data */
+    uint32_t used;   /*!< Bytes handed out */
+    uint32_t data[]; /*!< Word aligned, for the nodes and the symbols */
+};
+
+static ir_learn_mem_stats_t s_mem_stats;
+static portMUX_TYPE s_mem_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
 extern QueueHandle_t ir_learn_queue;
 extern QueueHandle_t ir_trans_queue;
 
 static TaskHandle_t ir_rx_task_handle = NULL;
-static rmt_channel_handle_t rx_channel_handle = NULL;
 ir_learn_common_param_t *learn_param = NULL;
 
-const static rmt_receive_config_t ir_learn_rmt_rx_cfg = {
-    .signal_range_min_ns = 1000,
-    .signal_range_max_ns = RMT_MAX_RANGE_TIME * 1000,
-};
+/* Notification bits of the learn task, it sleeps on them and nothing else */
+#define IR_LEARN_NOTIFY_FRAME (1 << 0)   /*!< A frame is in the RX queue */
+#define IR_LEARN_NOTIFY_COMMAND (1 << 1) /*!< An event is in ir_learn_queue */
+#define IR_LEARN_NOTIFY_STOP (1 << 2)    /*!< End the learn session in progress */
+
+/**
+ * @brief What woke the learn task up.
+ */
+typedef enum
+{
+    IR_LEARN_WAKE_TIMEOUT,
+    IR_LEARN_WAKE_FRAME,
+    IR_LEARN_WAKE_COMMAND,
+    IR_LEARN_WAKE_STOP,
+} ir_learn_wake_t;
+
+/* A command received during a learn session, run once the session is ended */
+static ir_event_cmd_t s_learn_pending;
+static bool s_learn_has_pending = false;
+
+/* Progress of the current session, written by the learn task only */
+static ir_learn_progress_t s_learn_progress;
+static int64_t s_learn_deadline_us = 0; /* esp_timer time the session ends at, 0 if none */
+
+static ir_learn_progress_cb_t s_progress_cbs[IR_LEARN_PROGRESS_CB_MAX];
+static int s_progress_cb_count = 0;
 
 static bool ir_learn_list_lock(ir_learn_t *ctx, uint32_t timeout_ms)
 {
@@ -52,15 +98,6 @@ static void ir_learn_list_unlock(ir_learn_t *ctx)
     xSemaphoreGiveRecursive(ctx->rmt_mux);
 }
 
-static bool ir_learn_rx_done_callback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_data)
-{
-    BaseType_t task_woken = pdFALSE;
-    ir_learn_t *ir_learn = (ir_learn_t *)user_data;
-
-    xQueueSendFromISR(ir_learn->receive_queue, edata, &task_woken);
-    return (task_woken == pdTRUE);
-}
-
 esp_err_t ir_learn_print_raw(struct ir_learn_sub_list_head *cmd_list)
 {
     IR_LEARN_CHECK(cmd_list, "list pointer can't be NULL!", ESP_ERR_INVALID_ARG);
@@ -92,6 +129,7 @@ static esp_err_t ir_learn_remove_all_symbol(ir_learn_t *ctx)
     ir_learn_list_lock(ctx, 0);
     ir_learn_clean_data(&ctx->learn_list);
     ir_learn_clean_sub_data(&ctx->learn_result);
+    ir_learn_acc_reset(&ctx->learn_acc);
     ir_learn_list_unlock(ctx);
 
     return ESP_OK;
@@ -101,54 +139,15 @@ static esp_err_t ir_learn_destroy(ir_learn_t *ctx)
 {
     ir_learn_remove_all_symbol(ctx);
 
-    if (rx_channel_handle)
-    {
-        rmt_disable(rx_channel_handle);
-        rmt_del_channel(rx_channel_handle);
-    }
-
-    if (ctx->receive_queue)
-    {
-        vQueueDelete(ctx->receive_queue);
-    }
-
     if (ctx->rmt_mux)
     {
         vSemaphoreDelete(ctx->rmt_mux);
     }
 
-    if (ctx->rmt_rx.received_symbols)
-    {
-        free(ctx->rmt_rx.received_symbols);
-    }
-
     free(ctx);
 
     return ESP_OK;
 }
-static esp_err_t init_rmt_rx(ir_learn_t *ctx)
-{
-    rmt_rx_channel_config_t rx_channel_cfg = {
-        .clk_src = RMT_CLK_SRC_DEFAULT,
-        .gpio_num = IR_RX_GPIO_NUM,
-        .resolution_hz = IR_RESOLUTION_HZ,
-        .mem_block_symbols = RMT_RX_MEM_BLOCK_SIZE,
-        .flags.with_dma = false,
-    };
-
-    esp_err_t ret = rmt_new_rx_channel(&rx_channel_cfg, &rx_channel_handle);
-    if (ret != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Failed to create RX channel: %s", esp_err_to_name(ret));
-        return ret;
-    }
-
-    rmt_rx_event_callbacks_t cbs = {
-        .on_recv_done = ir_learn_rx_done_callback,
-    };
-    ret = rmt_rx_register_event_callbacks(rx_channel_handle, &cbs, ctx);
-    return ESP_OK;
-}
 void ir_rx_stop(void)
 {
     if (ir_rx_task_handle)
@@ -157,12 +156,9 @@ void ir_rx_stop(void)
         ESP_LOGI(TAG, "RX Task suspended");
     }
 
-    if (rx_channel_handle)
+    if (ir_rx_suspend() == ESP_OK)
     {
-        rmt_disable(rx_channel_handle);
-        rmt_del_channel(rx_channel_handle);
-        rx_channel_handle = NULL;
-        ESP_LOGI(TAG, "RX Channel deleted");
+        ESP_LOGI(TAG, "RX Channel suspended");
     }
 }
 void ir_rx_restart(ir_learn_common_param_t *learn_param)
@@ -173,17 +169,9 @@ void ir_rx_restart(ir_learn_common_param_t *learn_param)
         return;
     }
 
-    ir_learn_t *ctx = (ir_learn_t *)learn_param->ctx;
-
-    if (rx_channel_handle == NULL)
+    if (ir_rx_resume() == ESP_OK)
     {
-        init_rmt_rx(ctx);
-        rmt_enable(rx_channel_handle);
-        ESP_LOGI(TAG, "RX Channel restarted");
-    }
-    else
-    {
-        ESP_LOGI(TAG, "RX Channel already exists");
+        ESP_LOGI(TAG, "RX Channel resumed");
     }
 
     if (ir_rx_task_handle)
@@ -219,43 +207,13 @@ esp_err_t ir_learn_stop(ir_learn_handle_t *ir_learn_hdl)
 
     return ESP_OK;
 }
-static esp_err_t ir_learn_pause(ir_learn_t *ctx)
-{
-    IR_LEARN_CHECK(ctx, "learn task not executed!", ESP_ERR_INVALID_ARG);
-
-    // if (ctx->running)
-    // {
-    //     ctx->running = false;
-    // }
-    if (rx_channel_handle)
-    {
-        rmt_disable(rx_channel_handle);
-        rmt_del_channel(rx_channel_handle);
-    }
-    else
-    {
-        ESP_LOGI(TAG, "not running");
-    }
-
-    return ESP_OK;
-}
-static esp_err_t ir_learn_start(ir_learn_t *ctx)
+static esp_err_t ir_learn_start(ir_learn_t *ctx, ir_rx_mode_t mode)
 {
     IR_LEARN_CHECK(ctx, "learn task not executed!", ESP_ERR_INVALID_ARG);
 
-    // if (!ctx->running)
-    // {
-    // ctx->running = true;
-
-    init_rmt_rx(ctx);
-    rmt_enable(rx_channel_handle);
+    // The channel keeps running, only what its frames are used for changes
+    ir_rx_set_mode(mode);
     ir_learn_remove_all_symbol(ctx);
-    ESP_LOGI(TAG, "RX Channel initialized and enabled");
-    // }
-    // else
-    // {
-    //     ESP_LOGI(TAG, "already running");
-    // }
 
     return ESP_OK;
 }
@@ -263,22 +221,23 @@ esp_err_t ir_learn_clean_sub_data(struct ir_learn_sub_list_head *sub_head)
 {
     IR_LEARN_CHECK(sub_head, "list pointer can't be NULL!", ESP_ERR_INVALID_ARG);
 
-    struct ir_learn_sub_list_t *result_it;
-
-    while (!SLIST_EMPTY(sub_head))
+    uint32_t chunks = 0;
+    uint32_t bytes = 0;
+    struct ir_learn_arena_t *arena = sub_head->arena;
+    while (arena)
     {
-        result_it = SLIST_FIRST(sub_head);
-        if (result_it->symbols.received_symbols)
-        {
-            heap_caps_free(result_it->symbols.received_symbols);
-        }
-        SLIST_REMOVE_HEAD(sub_head, next);
-        if (result_it)
-        {
-            heap_caps_free(result_it);
-        }
+        struct ir_learn_arena_t *next = arena->next;
+        chunks++;
+        bytes += sizeof(struct ir_learn_arena_t) + arena->size;
+        free(arena);
+        arena = next;
     }
-    SLIST_INIT(sub_head);
+    ir_learn_init_sub_list(sub_head);
+
+    portENTER_CRITICAL(&s_mem_stats_lock);
+    s_mem_stats.chunk_frees += chunks;
+    s_mem_stats.live_bytes -= bytes;
+    portEXIT_CRITICAL(&s_mem_stats_lock);
 
     return ESP_OK;
 }
@@ -315,11 +274,65 @@ void ir_learn_clone_sub_data(struct ir_learn_sub_list_head *dst, const struct ir
     }
 }
 
-static bool ir_learn_process_rx_data(ir_learn_common_param_t *learn_param, rmt_rx_done_event_data_t *rx_data)
+esp_err_t ir_learn_register_progress_cb(ir_learn_progress_cb_t cb)
+{
+    IR_LEARN_CHECK(cb, "progress callback is NULL", ESP_ERR_INVALID_ARG);
+    IR_LEARN_CHECK(s_progress_cb_count < IR_LEARN_PROGRESS_CB_MAX, "too many progress callbacks", ESP_ERR_NO_MEM);
+
+    s_progress_cbs[s_progress_cb_count++] = cb;
+    return ESP_OK;
+}
+
+const char *ir_learn_progress_name(ir_learn_progress_state_t state)
+{
+    switch (state)
+    {
+    case IR_LEARN_PROGRESS_START:
+        return "start";
+    case IR_LEARN_PROGRESS_SAMPLE:
+        return "sample";
+    case IR_LEARN_PROGRESS_DONE:
+        return "done";
+    case IR_LEARN_PROGRESS_FAIL:
+        return "fail";
+    case IR_LEARN_PROGRESS_TIMEOUT:
+        return "timeout";
+    case IR_LEARN_PROGRESS_CANCEL:
+        return "cancel";
+    default:
+        return "unknown";
+    }
+}
+
+static uint32_t ir_learn_remaining_ms(void)
+{
+    if (!s_learn_deadline_us)
+    {
+        return 0;
+    }
+    int64_t left_us = s_learn_deadline_us - esp_timer_get_time();
+    return left_us > 0 ? (uint32_t)((left_us + 999) / 1000) : 0;
+}
+
+static void ir_learn_progress_publish(ir_learn_progress_state_t state)
+{
+    s_learn_progress.state = state;
+    s_learn_progress.remaining_ms = ir_learn_remaining_ms();
+    ESP_LOGD(TAG, "Learn %s: %s %d/%d, sub %d, %d symbols", s_learn_progress.key, ir_learn_progress_name(state),
+             s_learn_progress.sample, s_learn_progress.samples, s_learn_progress.sub, s_learn_progress.symbols);
+
+    for (int i = 0; i < s_progress_cb_count; i++)
+    {
+        s_progress_cbs[i](&s_learn_progress);
+    }
+}
+
+static bool ir_learn_process_rx_data(ir_learn_common_param_t *learn_param, const ir_rx_frame_t *frame)
 {
-    int64_t cur_time = esp_timer_get_time();
-    size_t period = cur_time - learn_param->ctx->pre_time;
-    learn_param->ctx->pre_time = cur_time;
+    const rmt_rx_done_event_data_t *rx_data = &frame->data;
+    // Time of the capture, not of the dequeue: a frame waiting in the queue keeps its gap
+    size_t period = frame->time_us - learn_param->ctx->pre_time;
+    learn_param->ctx->pre_time = frame->time_us;
 
     if (rx_data->num_symbols < 5)
     {
@@ -351,8 +364,16 @@ static bool ir_learn_process_rx_data(ir_learn_common_param_t *learn_param, rmt_r
     }
 
     ir_learn_add_sub_list_node(&last->cmd_sub_node, period, rx_data);
+    // Folded into the running totals now, nothing is left to walk at the end of the session
+    ir_learn_acc_add(&learn_param->ctx->learn_acc, learn_param->ctx->learned_sub == 1, period, rx_data);
+    s_learn_progress.max_variance = ir_learn_acc_max_variance(&learn_param->ctx->learn_acc);
     ir_learn_list_unlock(learn_param->ctx);
 
+    s_learn_progress.sample = learn_param->ctx->learned_count;
+    s_learn_progress.sub = learn_param->ctx->learned_sub;
+    s_learn_progress.symbols = rx_data->num_symbols;
+    ir_learn_progress_publish(IR_LEARN_PROGRESS_SAMPLE);
+
     if (learn_param->user_cb)
     {
         learn_param->user_cb(learn_param->ctx->learned_count, learn_param->ctx->learned_sub, &last->cmd_sub_node);
@@ -367,11 +388,75 @@ void ir_rx_pause()
 {
     if (ir_rx_task_handle)
     {
-        xTaskNotify(ir_rx_task_handle, 1, eSetValueWithOverwrite);
+        xTaskNotify(ir_rx_task_handle, IR_LEARN_NOTIFY_STOP, eSetBits);
+    }
+}
+
+esp_err_t ir_learn_cancel(void)
+{
+    ir_event_cmd_t ir_event = {
+        .event = IR_EVENT_EXIT,
+    };
+    return ir_learn_post_event(&ir_event, pdMS_TO_TICKS(100));
+}
+
+esp_err_t ir_learn_post_event(const ir_event_cmd_t *ir_event, TickType_t timeout)
+{
+    IR_LEARN_CHECK(ir_event && ir_learn_queue, "learn queue not created", ESP_ERR_INVALID_STATE);
+
+    if (xQueueSend(ir_learn_queue, ir_event, timeout) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (ir_rx_task_handle)
+    {
+        xTaskNotify(ir_rx_task_handle, IR_LEARN_NOTIFY_COMMAND, eSetBits);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Wait for the next frame, learn command or stop signal, whichever comes first.
+ *
+ * The sources are polled before sleeping: a notification only means "look again",
+ * so several frames or commands behind one notification are not lost.
+ */
+static ir_learn_wake_t ir_learn_wait(TickType_t timeout, ir_rx_frame_t *frame, ir_event_cmd_t *ir_event)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (1)
+    {
+        // Commands first, a learn request never waits behind a burst of frames
+        if (xQueueReceive(ir_learn_queue, ir_event, 0) == pdTRUE)
+        {
+            return IR_LEARN_WAKE_COMMAND;
+        }
+        if (ir_rx_receive(frame, 0))
+        {
+            return IR_LEARN_WAKE_FRAME;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t wait = timeout == portMAX_DELAY ? portMAX_DELAY : (elapsed < timeout ? timeout - elapsed : 0);
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &bits, wait) != pdTRUE)
+        {
+            return IR_LEARN_WAKE_TIMEOUT;
+        }
+        if (bits & IR_LEARN_NOTIFY_STOP)
+        {
+            return IR_LEARN_WAKE_STOP;
+        }
     }
 }
 
-static esp_err_t ir_learn_active_receive_loop(ir_learn_common_param_t *learn_param)
+/**
+ * @brief Receive the presses of a key until there are enough of them, the deadline passes or the session is ended.
+ *
+ * @return ESP_OK if a command was learned, ESP_ERR_TIMEOUT if the deadline passed without a press,
+ *         ESP_FAIL if the session was ended, the error of the learner otherwise
+ */
+static esp_err_t ir_learn_active_receive_loop(ir_learn_common_param_t *learn_param, const char *key, uint8_t samples, uint32_t timeout_ms)
 {
     if (!learn_param || !learn_param->ctx)
     {
@@ -381,73 +466,91 @@ static esp_err_t ir_learn_active_receive_loop(ir_learn_common_param_t *learn_par
 
     learn_param->ctx->learned_count = 0;
     learn_param->ctx->learned_sub = 0;
+    learn_param->ctx->cancelled = false;
+
+    s_learn_deadline_us = timeout_ms ? esp_timer_get_time() + (int64_t)timeout_ms * 1000 : 0;
+    memset(&s_learn_progress, 0, sizeof(s_learn_progress));
+    snprintf(s_learn_progress.key, sizeof(s_learn_progress.key), "%s", key);
+    s_learn_progress.samples = samples;
+    ir_learn_progress_publish(IR_LEARN_PROGRESS_START);
 
-    rmt_rx_done_event_data_t learn_data;
+    ir_rx_frame_t frame;
+    ir_event_cmd_t ir_event;
+    ir_carrier_start();
 
-    while (learn_param->ctx->learned_count < learn_param->ctx->learn_count)
+    while (learn_param->ctx->learned_count < samples)
     {
-        if (xQueueReceive(learn_param->ctx->receive_queue, &learn_data, portMAX_DELAY) == pdTRUE)
+        TickType_t wait = s_learn_deadline_us ? pdMS_TO_TICKS(ir_learn_remaining_ms()) : portMAX_DELAY;
+        // The RX engine has already re-armed the channel when the frame is handed over
+        ir_learn_wake_t wake = ir_learn_wait(wait, &frame, &ir_event);
+        if (wake == IR_LEARN_WAKE_COMMAND || wake == IR_LEARN_WAKE_STOP)
         {
-            bool success = ir_learn_process_rx_data(learn_param, &learn_data);
-            if (!success)
+            // A new request supersedes the session, it runs as soon as this one is ended
+            if (wake == IR_LEARN_WAKE_COMMAND && ir_event.event != IR_EVENT_EXIT)
             {
-                ESP_LOGW(TAG, "Invalid RX data, waiting next...");
-                if (rmt_receive(rx_channel_handle,
-                                learn_param->ctx->rmt_rx.received_symbols,
-                                learn_param->ctx->rmt_rx.num_symbols,
-                                &ir_learn_rmt_rx_cfg) != ESP_OK)
-                {
-                    ESP_LOGE(TAG, "Failed to restart RMT receive");
-                    return ESP_FAIL;
-                }
-                continue;
+                s_learn_pending = ir_event;
+                s_learn_has_pending = true;
             }
-
-            if (rmt_receive(rx_channel_handle,
-                            learn_param->ctx->rmt_rx.received_symbols,
-                            learn_param->ctx->rmt_rx.num_symbols,
-                            &ir_learn_rmt_rx_cfg) != ESP_OK)
+            ESP_LOGI(TAG, "Learn session cancelled");
+            learn_param->ctx->cancelled = true;
+            ir_carrier_stop(&learn_param->ctx->learn_carrier);
+            ir_learn_progress_publish(IR_LEARN_PROGRESS_CANCEL);
+            return ESP_FAIL;
+        }
+        if (wake == IR_LEARN_WAKE_FRAME)
+        {
+            bool success = ir_learn_process_rx_data(learn_param, &frame);
+            // The symbols are copied into the learn list, the channel can capture into the buffer again
+            ir_rx_release(&frame);
+            if (!success)
             {
-                ESP_LOGE(TAG, "Failed to restart RMT receive");
-                return ESP_FAIL;
+                ESP_LOGW(TAG, "Invalid RX data, waiting next...");
             }
         }
         else
         {
-            if (learn_param->ctx->learned_sub > 0)
+            if (learn_param->ctx->learned_count > 0)
             {
-                ESP_LOGI(TAG, "Timeout reached. Received partial IR. Proceeding.");
-                break;
-            }
-            else
-            {
-                ESP_LOGW(TAG, "Timeout reached with no IR signal. Retrying...");
+                ESP_LOGW(TAG, "Deadline reached after %d/%d presses, learning from them", learn_param->ctx->learned_count, samples);
                 break;
             }
+            ESP_LOGW(TAG, "Deadline reached with no IR signal");
+            ir_carrier_stop(&learn_param->ctx->learn_carrier);
+            ir_learn_progress_publish(IR_LEARN_PROGRESS_TIMEOUT);
+            return ESP_ERR_TIMEOUT;
         }
     }
 
-    return ir_learn_check_valid(&learn_param->ctx->learn_list, &learn_param->ctx->learn_result);
-}
-
-static esp_err_t ir_clone_data(struct ir_learn_sub_list_head *dst, const struct ir_learn_sub_list_head *src)
-{
-    struct ir_learn_sub_list_t *node;
-
-    SLIST_FOREACH(node, src, next)
+    ir_carrier_t *carrier = &learn_param->ctx->learn_carrier;
+    if (ir_carrier_stop(carrier) == ESP_OK)
     {
-        struct ir_learn_sub_list_t *new_node = malloc(sizeof(*new_node));
-        if (!new_node)
-            return ESP_ERR_NO_MEM;
-
-        memcpy(&new_node->symbols, &node->symbols, sizeof(node->symbols));
-        new_node->timediff = node->timediff;
+        ESP_LOGI(TAG, "Carrier %" PRIu32 " Hz, duty %d/1000, from %d pulses", carrier->frequency_hz, carrier->duty_permille, carrier->periods);
+    }
 
-        SLIST_INSERT_HEAD(dst, new_node, next); // hoặc SLIST_INSERT_TAIL nếu muốn giữ thứ tự
+    esp_err_t ret;
+    ir_learn_acc_stats_t *stats = &learn_param->ctx->learn_stats;
+    ir_learn_list_lock(learn_param->ctx, 0);
+    if (learn_param->ctx->learned_count >= 3)
+    {
+        // Enough presses for a median, the stored samples are clustered and filtered
+        ret = ir_learn_acc_median(&learn_param->ctx->learn_list, &learn_param->ctx->learn_result, stats);
+        ESP_LOGI(TAG, "Median of %d/%d samples (%d dropped), snapped to %s",
+                 stats->clustered - stats->dropped, stats->samples, stats->dropped, ir_protocol_name(stats->protocol));
     }
+    else
+    {
+        ret = ir_learn_acc_finish(&learn_param->ctx->learn_acc, &learn_param->ctx->learn_result, stats);
+    }
+    ir_learn_list_unlock(learn_param->ctx);
 
-    return ESP_OK;
+    ESP_LOGI(TAG, "Learned %d samples x %d sub-frames, %" PRIu32 " symbols, variance max: %" PRIu32 " us^2, mean: %" PRIu32 " us^2",
+             stats->samples, stats->sub_count, stats->symbols, stats->max_variance, stats->mean_variance);
+
+    s_learn_progress.max_variance = stats->max_variance;
+    ir_learn_progress_publish(ret == ESP_OK ? IR_LEARN_PROGRESS_DONE : IR_LEARN_PROGRESS_FAIL);
+    return ret;
 }
+
 esp_err_t send_data_to_ir_app(ir_learn_common_param_t *learn_param, ir_event_cmd_t *ir_event)
 {
     IR_LEARN_CHECK(learn_param && ir_event, "Invalid parameters", ESP_ERR_INVALID_ARG);
@@ -460,6 +563,37 @@ esp_err_t send_data_to_ir_app(ir_learn_common_param_t *learn_param, ir_event_cmd
 
     return ESP_OK;
 }
+/**
+ * @brief Hand the learned command over to the TX task, which frees it once saved.
+ *
+ * learn_result is moved into the event and left empty, so the next capture
+ * can start while the TX task is still saving this one.
+ */
+static esp_err_t ir_learn_post_result(ir_learn_common_param_t *learn_param, ir_event_cmd_t *ir_event)
+{
+    struct ir_learn_sub_list_head *result = malloc(sizeof(struct ir_learn_sub_list_head));
+    if (!result)
+    {
+        ESP_LOGE(TAG, "No memory to post the learned command");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ir_learn_list_lock(learn_param->ctx, 0);
+    *result = learn_param->ctx->learn_result;
+    ir_learn_init_sub_list(&learn_param->ctx->learn_result);
+    ir_learn_list_unlock(learn_param->ctx);
+
+    ir_event->event = IR_EVENT_LEARN_DONE;
+    ir_event->data = result;
+    ir_event->carrier = learn_param->ctx->learn_carrier;
+    esp_err_t ret = send_data_to_ir_app(learn_param, ir_event);
+    if (ret != ESP_OK)
+    {
+        ir_learn_clean_sub_data(result);
+        free(result);
+    }
+    return ret;
+}
 static void ir_learn_normal(ir_learn_common_param_t *learn_param, ir_event_cmd_t ir_event)
 {
     ESP_LOGI(TAG, "Start learning IR cmd for key: %s", ir_event.key);
@@ -469,14 +603,9 @@ static void ir_learn_normal(ir_learn_common_param_t *learn_param, ir_event_cmd_t
         learn_param->user_cb(IR_LEARN_STATE_READY, 0, NULL);
     }
 
-    // ir_learn_start(learn_param->ctx);
-
-    ESP_ERROR_CHECK(rmt_receive(rx_channel_handle,
-                                learn_param->ctx->rmt_rx.received_symbols,
-                                learn_param->ctx->rmt_rx.num_symbols,
-                                &ir_learn_rmt_rx_cfg));
-
-    esp_err_t ret = ir_learn_active_receive_loop(learn_param);
+    uint8_t samples = ir_event.learn_count ? ir_event.learn_count : learn_param->ctx->learn_count;
+    uint32_t timeout_ms = ir_event.timeout_ms ? ir_event.timeout_ms : IR_LEARN_TIMEOUT_MS;
+    esp_err_t ret = ir_learn_active_receive_loop(learn_param, ir_event.key, MIN(samples, IR_LEARN_ACC_SAMPLES_MAX), timeout_ms);
     if (ret == ESP_OK)
     {
         ESP_LOGI(TAG, "Learning completed successfully with %d commands",
@@ -485,24 +614,29 @@ static void ir_learn_normal(ir_learn_common_param_t *learn_param, ir_event_cmd_t
         {
             learn_param->user_cb(IR_LEARN_STATE_END, 0, &learn_param->ctx->learn_result);
         }
-        ir_event.event = IR_EVENT_LEARN_DONE;
-        ir_event.data = &learn_param->ctx->learn_result;
-        send_data_to_ir_app(learn_param, &ir_event);
+        ir_learn_post_result(learn_param, &ir_event);
     }
     else
     {
-        ESP_LOGE(TAG, "Learning failed, invalid data");
+        if (ret == ESP_ERR_TIMEOUT)
+        {
+            ESP_LOGW(TAG, "Learning timed out, no press within %" PRIu32 " ms", timeout_ms);
+        }
+        else if (!learn_param->ctx->cancelled)
+        {
+            ESP_LOGE(TAG, "Learning failed, invalid data");
+        }
         if (learn_param->user_cb)
         {
             learn_param->user_cb(IR_LEARN_STATE_FAIL, 0, NULL);
         }
     }
-
-    // ir_learn_pause(learn_param->ctx);
 }
 static void ir_learn_step(ir_learn_common_param_t *learn_param, ir_event_cmd_t ir_event)
 {
     char step[IR_KEY_MAX_LEN] = "step";
+    char step_key[IR_KEY_MAX_LEN];
+    uint32_t timeout_ms = ir_event.timeout_ms ? ir_event.timeout_ms : IR_LEARN_TIMEOUT_MS;
     int timediff_list[IR_STEP_COUNT_MAX] = {0};
     int step_index = 0;
     int64_t last_step_time = 0;
@@ -510,23 +644,21 @@ static void ir_learn_step(ir_learn_common_param_t *learn_param, ir_event_cmd_t i
     if (learn_param->user_cb)
         learn_param->user_cb(IR_LEARN_STEP_READY, 0, NULL);
 
-    // ir_learn_start(learn_param->ctx);
-
     while (1)
     {
         ESP_LOGI(TAG, "Learning step %d for key: %s", step_index + 1, ir_event.key_name_step);
 
         int64_t start_time = esp_timer_get_time();
 
-        ir_learn_start(learn_param->ctx);
-        ESP_ERROR_CHECK(rmt_receive(rx_channel_handle,
-                                    learn_param->ctx->rmt_rx.received_symbols,
-                                    learn_param->ctx->rmt_rx.num_symbols,
-                                    &ir_learn_rmt_rx_cfg));
+        // Frames of the next step pressed during the save of this one stay queued
+        ir_learn_remove_all_symbol(learn_param->ctx);
 
-        esp_err_t ret = ir_learn_active_receive_loop(learn_param);
+        // A step not pressed before the deadline ends the sequence
+        snprintf(step_key, sizeof(step_key), "%s_step%d", ir_event.key_name_step, step_index + 1);
+        esp_err_t ret = ir_learn_active_receive_loop(learn_param, step_key, 1, timeout_ms);
 
-        if (step_index >= IR_STEP_COUNT_MAX || (match_ir_with_key(&learn_param->ctx->learn_result, "exit", NULL)))
+        if (step_index >= IR_STEP_COUNT_MAX || learn_param->ctx->cancelled || ret == ESP_ERR_TIMEOUT ||
+            (match_ir_with_key(&learn_param->ctx->learn_result, "exit", NULL)))
         {
             ESP_LOGI(TAG, "Learning step completed for key: %s", ir_event.key_name_step);
             if (learn_param->user_cb)
@@ -547,10 +679,7 @@ static void ir_learn_step(ir_learn_common_param_t *learn_param, ir_event_cmd_t i
 
             snprintf(step, IR_KEY_MAX_LEN, "step%d", step_index + 1);
             snprintf(ir_event.key, IR_KEY_MAX_LEN, "%s_%s", ir_event.key_name_step, step);
-            ir_event.event = IR_EVENT_LEARN_DONE;
-            ir_event.data = &learn_param->ctx->learn_result;
-
-            send_data_to_ir_app(learn_param, &ir_event);
+            ir_learn_post_result(learn_param, &ir_event);
 
             step_index++;
         }
@@ -560,12 +689,8 @@ static void ir_learn_step(ir_learn_common_param_t *learn_param, ir_event_cmd_t i
             if (learn_param->user_cb)
                 learn_param->user_cb(IR_LEARN_STEP_FAIL, 0, NULL);
         }
-
-        ir_learn_pause(learn_param->ctx);
     }
 
-    // ir_learn_pause(learn_param->ctx);
-
     if (step_index > 1)
     {
         esp_err_t ret = save_step_timediff_to_file(ir_event.key_name_step, timediff_list, step_index - 1);
@@ -575,19 +700,61 @@ static void ir_learn_step(ir_learn_common_param_t *learn_param, ir_event_cmd_t i
             ESP_LOGI(TAG, "Saved %d step delays (int, ms)", step_index - 1);
     }
 
+    if (step_index > 0)
+    {
+        // Queued after the LEARN_DONE events, the TX task packs the steps once they are all saved
+        ir_event.event = IR_EVENT_PACK_STEP;
+        send_data_to_ir_app(learn_param, &ir_event);
+    }
+
     if (learn_param->user_cb)
         learn_param->user_cb(IR_LEARN_STEP_END, 0, &learn_param->ctx->learn_result);
 }
-static void ir_receiver_parse()
+static void ir_receiver_held(const ir_rx_frame_t *frame)
 {
-    ir_learn_start(learn_param->ctx);
+    ir_event_cmd_t ir_event = {
+        .event = IR_EVENT_HELD,
+        .request_time = frame->time_us,
+    };
+    if (!ir_hold_get_key(ir_event.key, &ir_event.repeats))
+    {
+        return;
+    }
+    // Auto-repeat is lossy: a held event the TX task can't take now is dropped, the next one follows
+    if (xQueueSend(ir_trans_queue, &ir_event, 0) != pdTRUE)
+    {
+        ESP_LOGD(TAG, "TX busy, held event of %s dropped", ir_event.key);
+    }
+}
 
-    ESP_ERROR_CHECK(rmt_receive(rx_channel_handle,
-                                learn_param->ctx->rmt_rx.received_symbols,
-                                learn_param->ctx->rmt_rx.num_symbols,
-                                &ir_learn_rmt_rx_cfg));
+static void ir_receiver_parse(ir_rx_frame_t *frame)
+{
+    // Repeats of the current press resolve to its key without another lookup
+    ir_hold_kind_t kind = ir_hold_feed(frame);
+    if (kind != IR_HOLD_PRESS)
+    {
+        ir_rx_release(frame);
+        if (kind == IR_HOLD_HELD)
+        {
+            ir_receiver_held(frame);
+        }
+        return;
+    }
 
-    esp_err_t ret = ir_learn_active_receive_loop(learn_param);
+    // A press is matched on its first frame, the frames that repeat it are not appended
+    ir_learn_remove_all_symbol(learn_param->ctx);
+    ir_learn_list_lock(learn_param->ctx, 0);
+    esp_err_t ret = ir_learn_acc_add(&learn_param->ctx->learn_acc, true, 0, &frame->data);
+    ir_rx_release(frame);
+    if (ret == ESP_OK)
+    {
+        ret = ir_learn_acc_finish(&learn_param->ctx->learn_acc, &learn_param->ctx->learn_result, NULL);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = ir_normalize_list(&learn_param->ctx->learn_result, NULL);
+    }
+    ir_learn_list_unlock(learn_param->ctx);
 
     if (ret == ESP_OK)
     {
@@ -602,6 +769,7 @@ static void ir_receiver_parse()
         {
             ESP_LOGI("IR_MATCH", "IR khớp với alias gốc: %s", original_key);
 
+           ir_hold_set_key(original_key);
            ir_send_command(original_key);
         }
         else
@@ -609,7 +777,6 @@ static void ir_receiver_parse()
             ESP_LOGW("IR_MATCH", "Không khớp với alias nào");
         }
     }
-    ir_learn_pause(learn_param->ctx);
 }
 static void ir_learn_task(void *arg)
 {
@@ -621,81 +788,174 @@ static void ir_learn_task(void *arg)
     }
     learn_param = (ir_learn_common_param_t *)arg;
     ir_event_cmd_t ir_event;
-    ir_learn_start(learn_param->ctx);
+    ir_rx_frame_t frame;
+    ir_learn_start(learn_param->ctx, IR_RX_MODE_MATCH);
+    // Frames wake the task from the RX done callback, commands from ir_learn_post_event()
+    ir_rx_set_notify(xTaskGetCurrentTaskHandle(), IR_LEARN_NOTIFY_FRAME);
 
     while (1)
     {
-        if (xQueueReceive(ir_learn_queue, &ir_event, pdMS_TO_TICKS(10)) == pdTRUE)
+        // Sleeps until something happens, no polling while idle
+        ir_learn_wake_t wake = ir_learn_wait(portMAX_DELAY, &frame, &ir_event);
+        if (wake == IR_LEARN_WAKE_FRAME)
+        {
+            ir_receiver_parse(&frame);
+            continue;
+        }
+        if (wake != IR_LEARN_WAKE_COMMAND)
+        {
+            continue;
+        }
+
+        // A command received during a session ends it and runs right after
+        bool run = true;
+        while (run)
         {
             switch (ir_event.event)
             {
             case IR_EVENT_LEARN_NORMAL:
-                ir_learn_start(learn_param->ctx);
+                ir_learn_start(learn_param->ctx, IR_RX_MODE_LEARN);
                 ir_learn_normal(learn_param, ir_event);
-                ir_learn_pause(learn_param->ctx);
+                ir_learn_start(learn_param->ctx, IR_RX_MODE_MATCH);
+                ir_hold_reset();
                 break;
             case IR_EVENT_LEARN_STEP:
-                ir_learn_start(learn_param->ctx);
+                ir_learn_start(learn_param->ctx, IR_RX_MODE_LEARN);
                 ir_learn_step(learn_param, ir_event);
-                ir_learn_pause(learn_param->ctx);
+                ir_learn_start(learn_param->ctx, IR_RX_MODE_MATCH);
+                ir_hold_reset();
+                break;
+            case IR_EVENT_EXIT:
+                // No session in progress, nothing to end
                 break;
             default:
                 ESP_LOGW(TAG, "Unknown IR event: %d", ir_event.event);
                 break;
             }
+            run = s_learn_has_pending;
+            ir_event = s_learn_pending;
+            s_learn_has_pending = false;
         }
-
-        ir_receiver_parse();
-        vTaskDelay(pdMS_TO_TICKS(10)); // Prevent busy-waiting
     }
     vTaskDelete(NULL);
 }
 
-esp_err_t ir_learn_add_sub_list_node(struct ir_learn_sub_list_head *sub_head, uint32_t timediff, const rmt_rx_done_event_data_t *symbol)
+static esp_err_t ir_learn_arena_grow(struct ir_learn_sub_list_head *sub_head, size_t chunk_size)
+{
+    struct ir_learn_arena_t *arena = malloc(sizeof(struct ir_learn_arena_t) + chunk_size);
+
+    portENTER_CRITICAL(&s_mem_stats_lock);
+    if (arena)
+    {
+        s_mem_stats.chunk_allocs++;
+        s_mem_stats.live_bytes += sizeof(struct ir_learn_arena_t) + chunk_size;
+        if (s_mem_stats.live_bytes > s_mem_stats.peak_bytes)
+        {
+            s_mem_stats.peak_bytes = s_mem_stats.live_bytes;
+        }
+    }
+    else
+    {
+        s_mem_stats.failed_allocs++;
+    }
+    portEXIT_CRITICAL(&s_mem_stats_lock);
+    IR_LEARN_CHECK(arena, "no mem for arena chunk", ESP_ERR_NO_MEM);
+
+    arena->size = chunk_size;
+    arena->used = 0;
+    arena->next = sub_head->arena;
+    sub_head->arena = arena;
+    return ESP_OK;
+}
+
+static void *ir_learn_arena_alloc(struct ir_learn_sub_list_head *sub_head, size_t size)
+{
+    size = IR_LEARN_ARENA_ALIGN(size);
+
+    struct ir_learn_arena_t *arena = sub_head->arena;
+    if (!arena || arena->size - arena->used < size)
+    {
+        if (ir_learn_arena_grow(sub_head, size > IR_LEARN_ARENA_CHUNK_SIZE ? size : IR_LEARN_ARENA_CHUNK_SIZE) != ESP_OK)
+        {
+            return NULL;
+        }
+        arena = sub_head->arena;
+    }
+
+    void *ptr = (uint8_t *)arena->data + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+esp_err_t ir_learn_reserve_sub_list(struct ir_learn_sub_list_head *sub_head, size_t frames, size_t symbols)
 {
     IR_LEARN_CHECK(sub_head, "list pointer can't be NULL!", ESP_ERR_INVALID_ARG);
 
-    esp_err_t ret = ESP_OK;
+    size_t size = frames * IR_LEARN_NODE_SIZE + IR_LEARN_ARENA_ALIGN(symbols * sizeof(rmt_symbol_word_t));
+    struct ir_learn_arena_t *arena = sub_head->arena;
+    if (arena && arena->size - arena->used >= size)
+    {
+        return ESP_OK;
+    }
+    return ir_learn_arena_grow(sub_head, size);
+}
 
-    struct ir_learn_sub_list_t *item = (struct ir_learn_sub_list_t *)malloc(sizeof(struct ir_learn_sub_list_t));
-    IR_LEARN_CHECK_GOTO(item, "no mem to store received RMT symbols", ESP_ERR_NO_MEM, err);
+void ir_learn_get_mem_stats(ir_learn_mem_stats_t *stats_out)
+{
+    portENTER_CRITICAL(&s_mem_stats_lock);
+    *stats_out = s_mem_stats;
+    portEXIT_CRITICAL(&s_mem_stats_lock);
+}
 
-    item->timediff = timediff;
-    item->symbols.num_symbols = symbol->num_symbols;
-    item->symbols.received_symbols = malloc(symbol->num_symbols * sizeof(rmt_symbol_word_t));
-    IR_LEARN_CHECK_GOTO(item->symbols.received_symbols, "no mem to store received RMT symbols", ESP_ERR_NO_MEM, err);
+esp_err_t ir_learn_alloc_sub_list_node(struct ir_learn_sub_list_head *sub_head, uint32_t timediff, size_t num_symbols,
+                                       rmt_symbol_word_t **symbols_out)
+{
+    IR_LEARN_CHECK(sub_head && symbols_out, "list pointer can't be NULL!", ESP_ERR_INVALID_ARG);
 
-    memcpy(item->symbols.received_symbols, symbol->received_symbols, symbol->num_symbols * sizeof(rmt_symbol_word_t));
+    size_t symbol_size = num_symbols * sizeof(rmt_symbol_word_t);
+    struct ir_learn_sub_list_t *item = ir_learn_arena_alloc(sub_head, IR_LEARN_NODE_SIZE + symbol_size);
+    IR_LEARN_CHECK(item, "no mem to store received RMT symbols", ESP_ERR_NO_MEM);
+
+    /* The symbols follow the node in the same chunk */
+    item->timediff = timediff;
+    item->symbols = (rmt_rx_done_event_data_t){
+        .received_symbols = (rmt_symbol_word_t *)((uint8_t *)item + IR_LEARN_NODE_SIZE),
+        .num_symbols = num_symbols,
+    };
     item->next.sle_next = NULL;
 
-    struct ir_learn_sub_list_t *last = SLIST_FIRST(sub_head);
-    if (last == NULL)
+    if (SLIST_EMPTY(sub_head))
     {
         SLIST_INSERT_HEAD(sub_head, item, next);
     }
     else
     {
-        struct ir_learn_sub_list_t *sub_it;
-        while ((sub_it = SLIST_NEXT(last, next)) != NULL)
-        {
-            last = sub_it;
-        }
-        SLIST_INSERT_AFTER(last, item, next);
+        SLIST_INSERT_AFTER(sub_head->tail, item, next);
     }
-    return ret;
+    sub_head->tail = item;
 
-err:
-    if (item)
-    {
-        free(item);
-    }
+    portENTER_CRITICAL(&s_mem_stats_lock);
+    s_mem_stats.nodes++;
+    portEXIT_CRITICAL(&s_mem_stats_lock);
+
+    *symbols_out = item->symbols.received_symbols;
+    return ESP_OK;
+}
+
+esp_err_t ir_learn_add_sub_list_node(struct ir_learn_sub_list_head *sub_head, uint32_t timediff, const rmt_rx_done_event_data_t *symbol)
+{
+    IR_LEARN_CHECK(sub_head && symbol, "list pointer can't be NULL!", ESP_ERR_INVALID_ARG);
 
-    if (item->symbols.received_symbols)
+    rmt_symbol_word_t *symbols;
+    esp_err_t ret = ir_learn_alloc_sub_list_node(sub_head, timediff, symbol->num_symbols, &symbols);
+    if (ret != ESP_OK)
     {
-        free(item->symbols.received_symbols);
-        item->symbols.received_symbols = NULL;
+        return ret;
     }
-    return ret;
+    sub_head->tail->symbols = *symbol;
+    sub_head->tail->symbols.received_symbols = symbols;
+    memcpy(symbols, symbol->received_symbols, symbol->num_symbols * sizeof(rmt_symbol_word_t));
+    return ESP_OK;
 }
 
 esp_err_t ir_learn_add_list_node(struct ir_learn_list_head *learn_head)
@@ -707,7 +967,7 @@ esp_err_t ir_learn_add_list_node(struct ir_learn_list_head *learn_head)
     struct ir_learn_list_t *item = (struct ir_learn_list_t *)malloc(sizeof(struct ir_learn_list_t));
     IR_LEARN_CHECK_GOTO(item, "no mem to store received RMT symbols", ESP_ERR_NO_MEM, err);
 
-    SLIST_INIT(&item->cmd_sub_node);
+    ir_learn_init_sub_list(&item->cmd_sub_node);
     item->next.sle_next = NULL;
 
     struct ir_learn_list_t *last = SLIST_FIRST(learn_head);
@@ -734,156 +994,29 @@ err:
     return ret;
 }
 
-static esp_err_t ir_learn_check_duration(
-    struct ir_learn_list_head *learn_head,
-    struct ir_learn_sub_list_head *result_out,
-    uint8_t sub_cmd_offset,
-    uint32_t sub_num_symbols,
-    uint32_t timediff)
-{
-    esp_err_t ret = ESP_OK;
-
-    uint32_t duration_average0 = 0;
-    uint32_t duration_average1 = 0;
-    uint8_t learn_total_num = 0;
-
-    struct ir_learn_list_t *main_it;
-    rmt_symbol_word_t *p_symbols, *p_learn_symbols = NULL;
-    rmt_rx_done_event_data_t add_symbols;
-
-    add_symbols.num_symbols = sub_num_symbols;
-    add_symbols.received_symbols = malloc(sub_num_symbols * sizeof(rmt_symbol_word_t));
-    p_learn_symbols = add_symbols.received_symbols;
-    IR_LEARN_CHECK_GOTO(p_learn_symbols, "no mem to store received RMT symbols", ESP_ERR_NO_MEM, err);
-
-    for (int i = 0; i < sub_num_symbols; i++)
-    {
-        p_symbols = NULL;
-        ret = ESP_OK;
-        duration_average0 = 0;
-        duration_average1 = 0;
-        learn_total_num = 0;
-
-        SLIST_FOREACH(main_it, learn_head, next)
-        {
-
-            struct ir_learn_sub_list_t *sub_it = SLIST_FIRST(&main_it->cmd_sub_node);
-            for (int j = 0; j < sub_cmd_offset; j++)
-            {
-                sub_it = SLIST_NEXT(sub_it, next);
-            }
-
-            p_symbols = sub_it->symbols.received_symbols;
-            p_symbols += i;
-
-            if (duration_average0)
-            {
-                if ((p_symbols->duration0 > (duration_average0 / learn_total_num + RMT_DECODE_MARGIN)) ||
-                    (p_symbols->duration0 < (duration_average0 / learn_total_num - RMT_DECODE_MARGIN)))
-                {
-                    ret = ESP_FAIL;
-                }
-            }
-            if (duration_average1)
-            {
-                if ((p_symbols->duration1 > (duration_average1 / learn_total_num + RMT_DECODE_MARGIN)) ||
-                    (p_symbols->duration1 < (duration_average1 / learn_total_num - RMT_DECODE_MARGIN)))
-                {
-                    ret = ESP_FAIL;
-                }
-            }
-            IR_LEARN_CHECK_GOTO((ESP_OK == ret), "add cmd duration error", ESP_ERR_INVALID_ARG, err);
-
-            duration_average0 += p_symbols->duration0;
-            duration_average1 += p_symbols->duration1;
-            learn_total_num++;
-        }
-
-        if (learn_total_num && p_symbols)
-        {
-            p_learn_symbols->duration0 = duration_average0 / learn_total_num;
-            p_learn_symbols->duration1 = duration_average1 / learn_total_num;
-            p_learn_symbols->level0 = p_symbols->level1;
-            p_learn_symbols->level1 = p_symbols->level0;
-            p_learn_symbols++;
-        }
-    }
-    ir_learn_add_sub_list_node(result_out, timediff, &add_symbols);
-
-    if (add_symbols.received_symbols)
-    {
-        free(add_symbols.received_symbols);
-    }
-    return ESP_OK;
-err:
-    if (add_symbols.received_symbols)
-    {
-        free(add_symbols.received_symbols);
-    }
-    return ESP_FAIL;
-}
-
 esp_err_t ir_learn_check_valid(struct ir_learn_list_head *learn_head, struct ir_learn_sub_list_head *result_out)
 {
     IR_LEARN_CHECK(learn_head, "list pointer can't be NULL!", ESP_ERR_INVALID_ARG);
 
-    esp_err_t ret = ESP_OK;
+    esp_err_t ret;
     struct ir_learn_list_t *learned_it;
     struct ir_learn_sub_list_t *sub_it;
+    ir_learn_acc_t acc;
 
-    uint8_t expect_sub_cmd_num = 0xFF;
-    uint8_t sub_cmd_num = 0;
-    uint8_t learned_num = 0;
-
+    ir_learn_acc_init(&acc);
     SLIST_FOREACH(learned_it, learn_head, next)
     {
-        sub_cmd_num = 0;
-        learned_num++;
+        bool new_sample = true;
         SLIST_FOREACH(sub_it, &learned_it->cmd_sub_node, next)
         {
-            sub_cmd_num++;
-        }
-        if (0xFF == expect_sub_cmd_num)
-        {
-            expect_sub_cmd_num = sub_cmd_num;
+            // A mismatch is kept in the accumulator and reported by finish
+            ir_learn_acc_add(&acc, new_sample, sub_it->timediff, &sub_it->symbols);
+            new_sample = false;
         }
-        ESP_LOGI(TAG, "list:%d-%d", learned_num, sub_cmd_num);
-        IR_LEARN_CHECK(expect_sub_cmd_num == sub_cmd_num, "cmd num mismatch", ESP_ERR_INVALID_SIZE);
     }
-
-    uint16_t sub_num_symbols;
-    uint32_t time_diff;
-
-    for (int i = 0; i < sub_cmd_num; i++)
-    {
-        sub_num_symbols = 0xFFFF;
-        time_diff = 0xFFFF;
-        SLIST_FOREACH(learned_it, learn_head, next)
-        {
-
-            struct ir_learn_sub_list_t *sub_item = SLIST_FIRST(&learned_it->cmd_sub_node);
-            for (int j = 0; j < i; j++)
-            {
-                sub_item = SLIST_NEXT(sub_item, next);
-            }
-            if (0xFFFF == sub_num_symbols)
-            {
-                sub_num_symbols = sub_item->symbols.num_symbols;
-            }
-            if (0xFFFF == time_diff)
-            {
-                time_diff = sub_item->timediff;
-            }
-            else
-            {
-                time_diff += sub_item->timediff;
-            }
-            IR_LEARN_CHECK(sub_num_symbols == sub_item->symbols.num_symbols, "sub symbol mismatch", ESP_ERR_INVALID_SIZE);
-        }
-        ret = ir_learn_check_duration(learn_head, result_out, i, sub_num_symbols, time_diff / learned_num);
-        IR_LEARN_CHECK((ESP_OK == ret), "symbol add failed", ESP_ERR_INVALID_SIZE);
-    }
-    return ESP_OK;
+    ret = ir_learn_acc_finish(&acc, result_out, NULL);
+    ir_learn_acc_reset(&acc);
+    return ret;
 }
 
 esp_err_t ir_learn_new(const ir_learn_cfg_t *cfg, ir_learn_handle_t *handle_out)
@@ -892,6 +1025,7 @@ esp_err_t ir_learn_new(const ir_learn_cfg_t *cfg, ir_learn_handle_t *handle_out)
     esp_err_t ret = ESP_OK;
     IR_LEARN_CHECK(cfg && handle_out, "invalid argument", ESP_ERR_INVALID_ARG);
     IR_LEARN_CHECK(cfg->learn_count < IR_LEARN_STATE_READY, "learn count too larger", ESP_ERR_INVALID_ARG);
+    IR_LEARN_CHECK(ir_learn_queue, "learn queue not created", ESP_ERR_INVALID_STATE);
 
     ir_learn_t *ir_learn_ctx = calloc(1, sizeof(ir_learn_t));
     IR_LEARN_CHECK(ir_learn_ctx, "no mem for ir_learn_ctx", ESP_ERR_NO_MEM);
@@ -902,14 +1036,16 @@ esp_err_t ir_learn_new(const ir_learn_cfg_t *cfg, ir_learn_handle_t *handle_out)
 
     SLIST_INIT(&ir_learn_ctx->learn_list);
     ir_learn_ctx->learn_count = cfg->learn_count;
-    ir_learn_ctx->rmt_rx.num_symbols = RMT_RX_MEM_BLOCK_SIZE * 8;
-    ir_learn_ctx->rmt_rx.received_symbols = (rmt_symbol_word_t *)heap_caps_malloc(
-        ir_learn_ctx->rmt_rx.num_symbols * sizeof(rmt_symbol_word_t),
-        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-    IR_LEARN_CHECK_GOTO(ir_learn_ctx->rmt_rx.received_symbols, "no mem to store received RMT symbols", ESP_ERR_NO_MEM, err);
-
-    ir_learn_ctx->receive_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
-    IR_LEARN_CHECK_GOTO(ir_learn_ctx->receive_queue, "create rmt receive queue failed", ESP_FAIL, err);
+
+    ret = ir_rx_init();
+    IR_LEARN_CHECK_GOTO(ret == ESP_OK, "start rx engine failed", ret, err);
+
+    // Optional, keys learned without it are sent on the nominal carrier of their protocol
+    ret = ir_carrier_init();
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED)
+    {
+        ESP_LOGW(TAG, "Carrier measurement unavailable: %s", esp_err_to_name(ret));
+    }
 
     ir_learn_ctx->rmt_mux = xSemaphoreCreateRecursiveMutex();
     IR_LEARN_CHECK_GOTO(ir_learn_ctx->rmt_mux, "create rmt mux failed", ESP_FAIL, err);
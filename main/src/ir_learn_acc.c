@@ -0,0 +1,561 @@
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "ir_learn.h"
+#include "ir_learn_acc.h"
+#include "ir_protocol.h"
+
+static const char *TAG = "IR_learn_acc";
+
+/* Tolerances of a learned duration, see ir_learn_acc.h */
+#define IR_LEARN_ACC_SPREAD_MAX RMT_DECODE_MARGIN
+#define IR_LEARN_ACC_VARIANCE_MAX ((uint32_t)(RMT_DECODE_MARGIN / 2) * (RMT_DECODE_MARGIN / 2))
+
+/* A duration is snapped to the nearest multiple of the protocol unit within this share of the unit */
+#define IR_LEARN_ACC_SNAP_PCT 30
+
+void ir_learn_acc_init(ir_learn_acc_t *acc)
+{
+    memset(acc, 0, sizeof(*acc));
+}
+
+void ir_learn_acc_reset(ir_learn_acc_t *acc)
+{
+    for (int i = 0; i < acc->sub_count; i++)
+    {
+        free(acc->subs[i].symbols);
+    }
+    free(acc->subs);
+    ir_learn_acc_init(acc);
+}
+
+static esp_err_t ir_learn_acc_new_sub(ir_learn_acc_t *acc, uint32_t timediff, const rmt_rx_done_event_data_t *symbols)
+{
+    if (acc->sub_count == UINT8_MAX)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (acc->sub_count == acc->sub_capacity)
+    {
+        uint8_t capacity = acc->sub_capacity ? (acc->sub_capacity > UINT8_MAX / 2 ? UINT8_MAX : acc->sub_capacity * 2) : 4;
+        ir_learn_acc_sub_t *subs = realloc(acc->subs, capacity * sizeof(ir_learn_acc_sub_t));
+        if (!subs)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        acc->subs = subs;
+        acc->sub_capacity = capacity;
+    }
+
+    ir_learn_acc_sub_t *sub = &acc->subs[acc->sub_count];
+    sub->symbols = malloc(symbols->num_symbols * sizeof(ir_learn_acc_symbol_t));
+    if (!sub->symbols)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    sub->timediff_sum = timediff;
+    sub->num_symbols = symbols->num_symbols;
+    sub->level0 = symbols->num_symbols ? symbols->received_symbols[0].level0 : 0;
+    sub->level1 = symbols->num_symbols ? symbols->received_symbols[0].level1 : 0;
+
+    for (size_t i = 0; i < symbols->num_symbols; i++)
+    {
+        const rmt_symbol_word_t *in = &symbols->received_symbols[i];
+        sub->symbols[i] = (ir_learn_acc_symbol_t){
+            .sum0 = in->duration0,
+            .sum1 = in->duration1,
+            .sq0 = (uint64_t)in->duration0 * in->duration0,
+            .sq1 = (uint64_t)in->duration1 * in->duration1,
+            .min0 = in->duration0,
+            .max0 = in->duration0,
+            .min1 = in->duration1,
+            .max1 = in->duration1,
+        };
+    }
+    acc->sub_count++;
+    return ESP_OK;
+}
+
+esp_err_t ir_learn_acc_add(ir_learn_acc_t *acc, bool new_sample, uint32_t timediff, const rmt_rx_done_event_data_t *symbols)
+{
+    if (acc->error != ESP_OK)
+    {
+        return acc->error;
+    }
+
+    if (new_sample || acc->samples == 0)
+    {
+        if (acc->samples > 1 && acc->cur_sub != acc->sub_count)
+        {
+            ESP_LOGW(TAG, "sample %d: %d sub-frames, expected %d", acc->samples, acc->cur_sub, acc->sub_count);
+            acc->error = ESP_ERR_INVALID_SIZE;
+            return acc->error;
+        }
+        acc->samples++;
+        acc->cur_sub = 0;
+    }
+
+    /* The first sample sets the layout, the others are folded into it */
+    if (acc->samples == 1)
+    {
+        esp_err_t ret = ir_learn_acc_new_sub(acc, timediff, symbols);
+        if (ret != ESP_OK)
+        {
+            acc->error = ret;
+            return ret;
+        }
+        acc->cur_sub++;
+        return ESP_OK;
+    }
+
+    if (acc->cur_sub >= acc->sub_count || acc->subs[acc->cur_sub].num_symbols != symbols->num_symbols)
+    {
+        ESP_LOGW(TAG, "sample %d: sub-frame %d doesn't have the layout of the first sample", acc->samples, acc->cur_sub);
+        acc->error = ESP_ERR_INVALID_SIZE;
+        return acc->error;
+    }
+
+    ir_learn_acc_sub_t *sub = &acc->subs[acc->cur_sub++];
+    sub->timediff_sum += timediff;
+    for (size_t i = 0; i < symbols->num_symbols; i++)
+    {
+        const rmt_symbol_word_t *in = &symbols->received_symbols[i];
+        ir_learn_acc_symbol_t *sym = &sub->symbols[i];
+        sym->sum0 += in->duration0;
+        sym->sum1 += in->duration1;
+        sym->sq0 += (uint64_t)in->duration0 * in->duration0;
+        sym->sq1 += (uint64_t)in->duration1 * in->duration1;
+        sym->min0 = MIN(sym->min0, in->duration0);
+        sym->max0 = MAX(sym->max0, in->duration0);
+        sym->min1 = MIN(sym->min1, in->duration1);
+        sym->max1 = MAX(sym->max1, in->duration1);
+    }
+    return ESP_OK;
+}
+
+static uint32_t ir_learn_acc_level_variance(uint32_t sum, uint64_t sq, uint32_t n)
+{
+    /* (n * sum(x^2) - sum(x)^2) / n^2, exact in 64 bits for n < 2^16 */
+    return (uint32_t)((sq * n - (uint64_t)sum * sum) / ((uint64_t)n * n));
+}
+
+uint32_t ir_learn_acc_variance(const ir_learn_acc_t *acc, uint8_t sub, uint16_t index)
+{
+    if (sub >= acc->sub_count || index >= acc->subs[sub].num_symbols || acc->samples == 0)
+    {
+        return 0;
+    }
+    const ir_learn_acc_symbol_t *sym = &acc->subs[sub].symbols[index];
+    return MAX(ir_learn_acc_level_variance(sym->sum0, sym->sq0, acc->samples),
+               ir_learn_acc_level_variance(sym->sum1, sym->sq1, acc->samples));
+}
+
+uint32_t ir_learn_acc_max_variance(const ir_learn_acc_t *acc)
+{
+    uint32_t max_variance = 0;
+    if (acc->samples < 2 || acc->error != ESP_OK)
+    {
+        return 0;
+    }
+    /* The sub-frames the current sample hasn't reached yet are one sample short */
+    for (int s = 0; s < MIN(acc->cur_sub, acc->sub_count); s++)
+    {
+        for (int i = 0; i < acc->subs[s].num_symbols; i++)
+        {
+            max_variance = MAX(max_variance, ir_learn_acc_variance(acc, s, i));
+        }
+    }
+    return max_variance;
+}
+
+/**
+ * @brief Variance without the sample farthest from the mean, one bad capture doesn't fail the session.
+ */
+static uint32_t ir_learn_acc_robust_variance(uint32_t sum, uint64_t sq, uint16_t min, uint16_t max, uint32_t n)
+{
+    uint32_t mean = sum / n;
+    uint32_t outlier = (mean - min > max - mean) ? min : max;
+    return ir_learn_acc_level_variance(sum - outlier, sq - (uint64_t)outlier * outlier, n - 1);
+}
+
+static uint16_t ir_learn_acc_duration(uint32_t sum, uint16_t min, uint16_t max, uint32_t n)
+{
+    if (n < 3)
+    {
+        return sum / n;
+    }
+    return (sum - min - max) / (n - 2);
+}
+
+esp_err_t ir_learn_acc_finish(const ir_learn_acc_t *acc, struct ir_learn_sub_list_head *result_out, ir_learn_acc_stats_t *stats_out)
+{
+    ir_learn_acc_stats_t stats = {
+        .samples = acc->samples,
+        .sub_count = acc->sub_count,
+    };
+    esp_err_t ret = acc->error;
+    if (ret == ESP_OK && acc->samples > 1 && acc->cur_sub != acc->sub_count)
+    {
+        ESP_LOGW(TAG, "sample %d: %d sub-frames, expected %d", acc->samples, acc->cur_sub, acc->sub_count);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret == ESP_OK && acc->sub_count == 0)
+    {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    if (ret != ESP_OK)
+    {
+        if (stats_out)
+        {
+            *stats_out = stats;
+        }
+        return ret;
+    }
+
+    uint32_t n = acc->samples;
+    uint64_t variance_total = 0;
+    uint16_t max_symbols = 0;
+
+    /* Check every symbol before anything is emitted */
+    for (int s = 0; s < acc->sub_count; s++)
+    {
+        const ir_learn_acc_sub_t *sub = &acc->subs[s];
+        max_symbols = MAX(max_symbols, sub->num_symbols);
+        for (int i = 0; i < sub->num_symbols; i++)
+        {
+            const ir_learn_acc_symbol_t *sym = &sub->symbols[i];
+            uint32_t variance = ir_learn_acc_variance(acc, s, i);
+            variance_total += variance;
+            if (variance > stats.max_variance || stats.symbols == 0)
+            {
+                stats.max_variance = variance;
+                stats.worst_sub = s;
+                stats.worst_symbol = i;
+            }
+            stats.symbols++;
+
+            bool accepted;
+            if (n < 3)
+            {
+                accepted = sym->max0 - sym->min0 <= IR_LEARN_ACC_SPREAD_MAX && sym->max1 - sym->min1 <= IR_LEARN_ACC_SPREAD_MAX;
+            }
+            else
+            {
+                accepted = ir_learn_acc_robust_variance(sym->sum0, sym->sq0, sym->min0, sym->max0, n) <= IR_LEARN_ACC_VARIANCE_MAX &&
+                           ir_learn_acc_robust_variance(sym->sum1, sym->sq1, sym->min1, sym->max1, n) <= IR_LEARN_ACC_VARIANCE_MAX;
+            }
+            if (!accepted)
+            {
+                stats.rejected++;
+            }
+        }
+    }
+    stats.mean_variance = stats.symbols ? (uint32_t)(variance_total / stats.symbols) : 0;
+    if (stats_out)
+    {
+        *stats_out = stats;
+    }
+    if (stats.rejected)
+    {
+        ESP_LOGW(TAG, "%" PRIu32 " symbols outside the tolerance, worst: sub-frame %d symbol %d, variance %" PRIu32 " us^2",
+                 stats.rejected, stats.worst_sub, stats.worst_symbol, stats.max_variance);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    rmt_symbol_word_t *learned = malloc(MAX(max_symbols, 1) * sizeof(rmt_symbol_word_t));
+    if (!learned)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int s = 0; s < acc->sub_count && ret == ESP_OK; s++)
+    {
+        const ir_learn_acc_sub_t *sub = &acc->subs[s];
+        for (int i = 0; i < sub->num_symbols; i++)
+        {
+            const ir_learn_acc_symbol_t *sym = &sub->symbols[i];
+            /* The receiver output is inverted, the levels are swapped for transmission */
+            learned[i].duration0 = ir_learn_acc_duration(sym->sum0, sym->min0, sym->max0, n);
+            learned[i].duration1 = ir_learn_acc_duration(sym->sum1, sym->min1, sym->max1, n);
+            learned[i].level0 = sub->level1;
+            learned[i].level1 = sub->level0;
+        }
+
+        rmt_rx_done_event_data_t add_symbols = {
+            .received_symbols = learned,
+            .num_symbols = sub->num_symbols,
+        };
+        ret = ir_learn_add_sub_list_node(result_out, sub->timediff_sum / n, &add_symbols);
+    }
+    free(learned);
+    return ret;
+}
+
+static bool ir_learn_acc_same_layout(const struct ir_learn_list_t *a, const struct ir_learn_list_t *b)
+{
+    const struct ir_learn_sub_list_t *sub_a = SLIST_FIRST(&a->cmd_sub_node);
+    const struct ir_learn_sub_list_t *sub_b = SLIST_FIRST(&b->cmd_sub_node);
+    while (sub_a && sub_b)
+    {
+        if (sub_a->symbols.num_symbols != sub_b->symbols.num_symbols)
+        {
+            return false;
+        }
+        sub_a = SLIST_NEXT(sub_a, next);
+        sub_b = SLIST_NEXT(sub_b, next);
+    }
+    return !sub_a && !sub_b;
+}
+
+static uint16_t ir_learn_acc_median_of(uint16_t *values, int count)
+{
+    for (int i = 1; i < count; i++)
+    {
+        uint16_t value = values[i];
+        int j = i;
+        for (; j > 0 && values[j - 1] > value; j--)
+        {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+    return (count & 1) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+/**
+ * @brief Per-symbol median of the samples, all of the same layout, into one flat template.
+ */
+static void ir_learn_acc_take_median(const struct ir_learn_list_t **members, int count, rmt_symbol_word_t *median, ir_learn_acc_stats_t *stats)
+{
+    const struct ir_learn_sub_list_t *subs[IR_LEARN_ACC_SAMPLES_MAX];
+    uint16_t d0[IR_LEARN_ACC_SAMPLES_MAX], d1[IR_LEARN_ACC_SAMPLES_MAX];
+    uint64_t variance_total = 0;
+
+    stats->symbols = 0;
+    stats->max_variance = 0;
+    for (int k = 0; k < count; k++)
+    {
+        subs[k] = SLIST_FIRST(&members[k]->cmd_sub_node);
+    }
+    for (int s = 0; subs[0]; s++)
+    {
+        for (int i = 0; i < subs[0]->symbols.num_symbols; i++)
+        {
+            uint32_t sum0 = 0, sum1 = 0;
+            uint64_t sq0 = 0, sq1 = 0;
+            for (int k = 0; k < count; k++)
+            {
+                const rmt_symbol_word_t *in = &subs[k]->symbols.received_symbols[i];
+                d0[k] = in->duration0;
+                d1[k] = in->duration1;
+                sum0 += in->duration0;
+                sum1 += in->duration1;
+                sq0 += (uint64_t)in->duration0 * in->duration0;
+                sq1 += (uint64_t)in->duration1 * in->duration1;
+            }
+            median->duration0 = ir_learn_acc_median_of(d0, count);
+            median->duration1 = ir_learn_acc_median_of(d1, count);
+            median++;
+
+            uint32_t variance = MAX(ir_learn_acc_level_variance(sum0, sq0, count), ir_learn_acc_level_variance(sum1, sq1, count));
+            variance_total += variance;
+            if (variance > stats->max_variance || stats->symbols == 0)
+            {
+                stats->max_variance = variance;
+                stats->worst_sub = s;
+                stats->worst_symbol = i;
+            }
+            stats->symbols++;
+        }
+        for (int k = 0; k < count; k++)
+        {
+            subs[k] = SLIST_NEXT(subs[k], next);
+        }
+    }
+    stats->mean_variance = stats->symbols ? (uint32_t)(variance_total / stats->symbols) : 0;
+}
+
+static bool ir_learn_acc_is_outlier(const struct ir_learn_list_t *sample, const rmt_symbol_word_t *median, uint32_t symbols)
+{
+    uint32_t off = 0;
+    const struct ir_learn_sub_list_t *sub;
+    SLIST_FOREACH(sub, &sample->cmd_sub_node, next)
+    {
+        for (int i = 0; i < sub->symbols.num_symbols; i++, median++)
+        {
+            const rmt_symbol_word_t *in = &sub->symbols.received_symbols[i];
+            if (abs((int)in->duration0 - (int)median->duration0) > RMT_DECODE_MARGIN ||
+                abs((int)in->duration1 - (int)median->duration1) > RMT_DECODE_MARGIN)
+            {
+                off++;
+            }
+        }
+    }
+    return off * 100 > symbols * IR_LEARN_ACC_OUTLIER_PCT;
+}
+
+static uint16_t ir_learn_acc_snap(uint16_t duration, uint32_t unit_ns)
+{
+    uint32_t units = ((uint32_t)duration * 1000 + unit_ns / 2) / unit_ns;
+    uint32_t snapped = (units * unit_ns + 500) / 1000;
+    if (units == 0 || abs((int)snapped - (int)duration) > (int)(unit_ns * IR_LEARN_ACC_SNAP_PCT / 100 / 1000))
+    {
+        return duration;
+    }
+    return snapped;
+}
+
+esp_err_t ir_learn_acc_median(const struct ir_learn_list_head *samples, struct ir_learn_sub_list_head *result_out, ir_learn_acc_stats_t *stats_out)
+{
+    const struct ir_learn_list_t *sample[IR_LEARN_ACC_SAMPLES_MAX];
+    const struct ir_learn_list_t *members[IR_LEARN_ACC_SAMPLES_MAX];
+    const struct ir_learn_list_t *it;
+    ir_learn_acc_stats_t stats = {0};
+    int n = 0;
+
+    SLIST_FOREACH(it, samples, next)
+    {
+        if (n == IR_LEARN_ACC_SAMPLES_MAX)
+        {
+            break;
+        }
+        sample[n++] = it;
+    }
+    stats.samples = n;
+
+    /* Cluster by layout, a press cut short or merged with a repeat frame is left out */
+    int best = 0, best_count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int count = 0;
+        for (int j = 0; j < n; j++)
+        {
+            count += ir_learn_acc_same_layout(sample[i], sample[j]);
+        }
+        if (count > best_count)
+        {
+            best = i;
+            best_count = count;
+        }
+    }
+    int count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (ir_learn_acc_same_layout(sample[best], sample[i]))
+        {
+            members[count++] = sample[i];
+        }
+    }
+    stats.clustered = count;
+    if (n == 0 || count * 2 <= n)
+    {
+        ESP_LOGW(TAG, "no layout shared by a majority of the %d samples (best: %d)", n, count);
+        if (stats_out)
+        {
+            *stats_out = stats;
+        }
+        return n ? ESP_ERR_INVALID_SIZE : ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t symbols = 0;
+    const struct ir_learn_sub_list_t *sub;
+    SLIST_FOREACH(sub, &members[0]->cmd_sub_node, next)
+    {
+        stats.sub_count++;
+        symbols += sub->symbols.num_symbols;
+    }
+    rmt_symbol_word_t *median = malloc(MAX(symbols, 1) * sizeof(rmt_symbol_word_t));
+    if (!median)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ir_learn_acc_take_median(members, count, median, &stats);
+
+    /* Drop the samples off the median and take it again without them */
+    int kept = 0;
+    for (int k = 0; k < count; k++)
+    {
+        if (!ir_learn_acc_is_outlier(members[k], median, symbols))
+        {
+            members[kept++] = members[k];
+        }
+    }
+    stats.dropped = count - kept;
+    if (kept == 0)
+    {
+        free(median);
+        if (stats_out)
+        {
+            *stats_out = stats;
+        }
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (stats.dropped)
+    {
+        ir_learn_acc_take_median(members, kept, median, &stats);
+    }
+
+    esp_err_t ret = ESP_OK;
+    rmt_symbol_word_t *out = median;
+    const struct ir_learn_sub_list_t *subs[IR_LEARN_ACC_SAMPLES_MAX];
+    for (int k = 0; k < kept; k++)
+    {
+        subs[k] = SLIST_FIRST(&members[k]->cmd_sub_node);
+    }
+    while ((sub = subs[0]) != NULL)
+    {
+        size_t num_symbols = sub->symbols.num_symbols;
+        uint32_t timediff_sum = 0;
+        for (int k = 0; k < kept; k++)
+        {
+            timediff_sum += subs[k]->timediff;
+            subs[k] = SLIST_NEXT(subs[k], next);
+        }
+        ir_protocol_frame_t frame;
+        if (ir_protocol_decode(out, num_symbols, &frame) == ESP_OK)
+        {
+            uint32_t unit_ns = ir_protocol_unit_ns(frame.protocol);
+            for (size_t i = 0; i < num_symbols; i++)
+            {
+                out[i].duration0 = ir_learn_acc_snap(out[i].duration0, unit_ns);
+                out[i].duration1 = ir_learn_acc_snap(out[i].duration1, unit_ns);
+            }
+            if (stats.protocol == IR_PROTOCOL_UNKNOWN)
+            {
+                stats.protocol = frame.protocol;
+            }
+        }
+
+        /* The receiver output is inverted, the levels are swapped for transmission */
+        for (size_t i = 0; i < num_symbols; i++)
+        {
+            out[i].level0 = sub->symbols.received_symbols[i].level1;
+            out[i].level1 = sub->symbols.received_symbols[i].level0;
+        }
+
+        rmt_rx_done_event_data_t add_symbols = {
+            .received_symbols = out,
+            .num_symbols = num_symbols,
+        };
+        ret = ir_learn_add_sub_list_node(result_out, timediff_sum / kept, &add_symbols);
+        if (ret != ESP_OK)
+        {
+            break;
+        }
+        out += num_symbols;
+    }
+    free(median);
+
+    if (stats_out)
+    {
+        *stats_out = stats;
+    }
+    return ret;
+}
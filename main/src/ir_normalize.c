@@ -0,0 +1,275 @@
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "ir_learn.h"
+#include "ir_normalize.h"
+#include "ir_protocol.h"
+
+static const char *TAG = "IR_normalize";
+
+/* Frames with fewer levels are too short for a detected base period to mean anything */
+#define IR_NORMALIZE_LEVELS_MIN 8
+
+#define IR_NORMALIZE_DURATION_MAX 0x7FFF
+
+/* A frame is handled as a stream of levels, level i is half i % 2 of symbol i / 2 */
+static inline uint32_t ir_normalize_duration(const rmt_symbol_word_t *symbols, size_t i)
+{
+    return (i & 1) ? symbols[i / 2].duration1 : symbols[i / 2].duration0;
+}
+
+static inline uint32_t ir_normalize_level(const rmt_symbol_word_t *symbols, size_t i)
+{
+    return (i & 1) ? symbols[i / 2].level1 : symbols[i / 2].level0;
+}
+
+static inline void ir_normalize_set(rmt_symbol_word_t *symbols, size_t i, uint32_t level, uint32_t duration)
+{
+    duration = MIN(duration, IR_NORMALIZE_DURATION_MAX);
+    if (i & 1)
+    {
+        symbols[i / 2].level1 = level;
+        symbols[i / 2].duration1 = duration;
+    }
+    else
+    {
+        symbols[i / 2].level0 = level;
+        symbols[i / 2].duration0 = duration;
+    }
+}
+
+/**
+ * @brief Nearest multiple of the base period, in periods.
+ */
+static inline uint32_t ir_normalize_units(uint32_t duration, uint32_t base_ns)
+{
+    return (uint32_t)(((uint64_t)duration * 1000 + base_ns / 2) / base_ns);
+}
+
+static inline bool ir_normalize_on_grid(uint32_t duration, uint32_t units, uint32_t base_ns)
+{
+    int64_t off = (int64_t)duration * 1000 - (int64_t)units * base_ns;
+    return units >= 1 && units <= IR_NORMALIZE_UNITS_MAX && llabs(off) * 100 <= (int64_t)base_ns * IR_NORMALIZE_GRID_PCT;
+}
+
+uint32_t ir_normalize_base_ns(const rmt_symbol_word_t *symbols, size_t num_symbols)
+{
+    ir_protocol_frame_t frame;
+    if (ir_protocol_decode(symbols, num_symbols, &frame) == ESP_OK)
+    {
+        return ir_protocol_unit_ns(frame.protocol);
+    }
+
+    /* First guess: the mean of the shortest levels */
+    size_t num_levels = num_symbols * 2;
+    uint32_t shortest = UINT32_MAX;
+    for (size_t i = 0; i < num_levels; i++)
+    {
+        uint32_t duration = ir_normalize_duration(symbols, i);
+        if (duration)
+        {
+            shortest = MIN(shortest, duration);
+        }
+    }
+    if (shortest == UINT32_MAX)
+    {
+        return 0;
+    }
+    uint64_t sum = 0;
+    uint32_t count = 0;
+    for (size_t i = 0; i < num_levels; i++)
+    {
+        uint32_t duration = ir_normalize_duration(symbols, i);
+        if (duration && duration <= shortest + shortest / 2)
+        {
+            sum += duration;
+            count++;
+        }
+    }
+    uint32_t base_ns = (uint32_t)(sum * 1000 / count);
+
+    /* Refined on every level on the grid, longer levels weigh more so the ratio is precise */
+    uint32_t on_grid = 0;
+    uint32_t levels = 0;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        uint64_t sum_duration = 0;
+        uint32_t sum_units = 0;
+        on_grid = 0;
+        levels = 0;
+        for (size_t i = 0; i < num_levels; i++)
+        {
+            uint32_t duration = ir_normalize_duration(symbols, i);
+            uint32_t units = ir_normalize_units(duration, base_ns);
+            if (!duration || units > IR_NORMALIZE_UNITS_MAX)
+            {
+                continue;
+            }
+            levels++;
+            if (ir_normalize_on_grid(duration, units, base_ns))
+            {
+                sum_duration += duration;
+                sum_units += units;
+                on_grid++;
+            }
+        }
+        if (!sum_units)
+        {
+            return 0;
+        }
+        base_ns = (uint32_t)(sum_duration * 1000 / sum_units);
+    }
+
+    if (levels < IR_NORMALIZE_LEVELS_MIN || on_grid * 100 < levels * IR_NORMALIZE_GRID_MIN_PCT ||
+        base_ns < IR_NORMALIZE_GLITCH_US * 1000)
+    {
+        return 0;
+    }
+    return base_ns;
+}
+
+size_t ir_normalize_symbols(rmt_symbol_word_t *symbols, size_t num_symbols, ir_normalize_stats_t *stats)
+{
+    ir_normalize_stats_t local = {0};
+    size_t num_levels = num_symbols * 2;
+    size_t out = 0;
+
+    /* Levels are read before the level they are written to, the frame is rewritten in place */
+    for (size_t i = 0; i < num_levels; i++)
+    {
+        uint32_t duration = ir_normalize_duration(symbols, i);
+        uint32_t level = ir_normalize_level(symbols, i);
+        if (duration == 0)
+        {
+            // End of the frame, as marked by the RMT channel
+            break;
+        }
+        if (out > 0 && level == ir_normalize_level(symbols, out - 1))
+        {
+            ir_normalize_set(symbols, out - 1, level, ir_normalize_duration(symbols, out - 1) + duration);
+        }
+        else if (duration < IR_NORMALIZE_GLITCH_US)
+        {
+            // Part of the previous level, the next one is merged into it as well
+            if (out > 0)
+            {
+                ir_normalize_set(symbols, out - 1, ir_normalize_level(symbols, out - 1),
+                                 ir_normalize_duration(symbols, out - 1) + duration);
+            }
+            local.glitches++;
+        }
+        else
+        {
+            ir_normalize_set(symbols, out++, level, duration);
+        }
+    }
+
+    if (out == 0)
+    {
+        if (stats)
+        {
+            stats->glitches += local.glitches;
+        }
+        return 0;
+    }
+
+    /* A frame ends with a mark and a space of 0, a space left over is the idle line */
+    if (out % 2 == 0)
+    {
+        ir_normalize_set(symbols, out - 1, ir_normalize_level(symbols, out - 1), 0);
+        local.trimmed++;
+    }
+    else
+    {
+        ir_normalize_set(symbols, out, !ir_normalize_level(symbols, out - 1), 0);
+        out++;
+    }
+    num_symbols = out / 2;
+
+    local.base_ns = ir_normalize_base_ns(symbols, num_symbols);
+    if (local.base_ns)
+    {
+        for (size_t i = 0; i + 1 < out; i++)
+        {
+            uint32_t duration = ir_normalize_duration(symbols, i);
+            uint32_t units = ir_normalize_units(duration, local.base_ns);
+            if (!ir_normalize_on_grid(duration, units, local.base_ns))
+            {
+                continue;
+            }
+            uint32_t snapped = ((uint64_t)units * local.base_ns + 500) / 1000;
+            if (snapped != duration)
+            {
+                ir_normalize_set(symbols, i, ir_normalize_level(symbols, i), snapped);
+                local.snapped++;
+            }
+        }
+    }
+
+    if (stats)
+    {
+        stats->glitches += local.glitches;
+        stats->trimmed += local.trimmed;
+        stats->snapped += local.snapped;
+        stats->levels += out;
+        stats->base_ns = local.base_ns;
+    }
+    return num_symbols;
+}
+
+esp_err_t ir_normalize_list(struct ir_learn_sub_list_head *list, ir_normalize_stats_t *stats_out)
+{
+    ir_normalize_stats_t stats = {0};
+    esp_err_t ret = ESP_OK;
+    struct ir_learn_sub_list_t *sub_it;
+
+    SLIST_FOREACH(sub_it, list, next)
+    {
+        sub_it->symbols.num_symbols = ir_normalize_symbols(sub_it->symbols.received_symbols, sub_it->symbols.num_symbols, &stats);
+        if (sub_it->symbols.num_symbols == 0)
+        {
+            ret = ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    ESP_LOGD(TAG, "%d levels, %d glitches, %d trimmed, %d snapped to %" PRIu32 " ns",
+             stats.levels, stats.glitches, stats.trimmed, stats.snapped, stats.base_ns);
+    if (stats_out)
+    {
+        *stats_out = stats;
+    }
+    return ret;
+}
+
+uint32_t ir_normalize_hash(const struct ir_learn_sub_list_head *list)
+{
+    /* FNV-1a over the byte values */
+    uint32_t hash = 2166136261u;
+    struct ir_learn_sub_list_t *sub_it;
+
+    SLIST_FOREACH(sub_it, list, next)
+    {
+        const rmt_symbol_word_t *symbols = sub_it->symbols.received_symbols;
+        size_t num_symbols = sub_it->symbols.num_symbols;
+        uint32_t base_ns = ir_normalize_base_ns(symbols, num_symbols);
+        if (!base_ns)
+        {
+            return 0;
+        }
+
+        hash = (hash ^ (num_symbols & 0xFF)) * 16777619u;
+        hash = (hash ^ ((num_symbols >> 8) & 0xFF)) * 16777619u;
+        for (size_t i = 0; i + 1 < num_symbols * 2; i++)
+        {
+            uint32_t units = ir_normalize_units(ir_normalize_duration(symbols, i), base_ns);
+            hash = (hash ^ MIN(units, IR_NORMALIZE_UNITS_MAX + 1)) * 16777619u;
+        }
+    }
+    return hash ? hash : 1;
+}
@@ -0,0 +1,545 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "ir_protocol.h"
+
+static const char *TAG = "IR_protocol";
+
+/* Timings in microseconds, the RMT resolution is 1 MHz */
+#define NEC_LEADING_MARK_US 9000
+#define NEC_LEADING_SPACE_US 4500
+#define NEC_REPEAT_SPACE_US 2250
+#define NEC_BIT_MARK_US 560
+#define NEC_BIT_ONE_SPACE_US 1690
+#define NEC_BIT_THRESHOLD_US 1125
+#define NEC_FRAME_SYMBOLS 34 // leader, 32 bits, stop bit
+
+#define SAMSUNG_LEADING_MARK_US 4500
+#define SAMSUNG_LEADING_SPACE_US 4500
+
+#define SONY_LEADING_MARK_US 2400
+#define SONY_UNIT_US 600
+#define SONY_BIT_THRESHOLD_US 900
+
+#define RC5_HALF_BIT_US 889
+#define RC5_HALF_BITS 28
+
+#define RC6_UNIT_US 444
+#define RC6_LEADING_MARK_US 2666
+#define RC6_LEADING_SPACE_US 889
+#define RC6_HALF_BITS 44
+
+#define IR_PROTOCOL_MAX_HALF_BITS 48
+
+/* Margin for leaders and fixed-length levels, in percent of the nominal value */
+#define IR_PROTOCOL_MARGIN_PCT 30
+
+static inline bool ir_protocol_in_range(uint32_t duration, uint32_t expected)
+{
+    uint32_t margin = expected * IR_PROTOCOL_MARGIN_PCT / 100;
+    return (duration + margin >= expected) && (duration <= expected + margin);
+}
+
+/**
+ * @brief Pulse-distance payload shared by NEC and Samsung: fixed mark, bit value in the space.
+ */
+static bool ir_protocol_read_pulse_distance(const rmt_symbol_word_t *symbols, uint32_t *value_out)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 32; i++)
+    {
+        if (!ir_protocol_in_range(symbols[i].duration0, NEC_BIT_MARK_US) ||
+            symbols[i].duration1 > NEC_BIT_ONE_SPACE_US * 2)
+        {
+            return false;
+        }
+        if (symbols[i].duration1 > NEC_BIT_THRESHOLD_US)
+        {
+            value |= 1UL << i; // LSB first
+        }
+    }
+    *value_out = value;
+    return true;
+}
+
+static bool ir_protocol_decode_nec(const rmt_symbol_word_t *symbols, size_t num_symbols, ir_protocol_frame_t *frame)
+{
+    bool nec_leader = ir_protocol_in_range(symbols[0].duration0, NEC_LEADING_MARK_US);
+    bool samsung_leader = ir_protocol_in_range(symbols[0].duration0, SAMSUNG_LEADING_MARK_US);
+
+    if (nec_leader && num_symbols <= 3 && ir_protocol_in_range(symbols[0].duration1, NEC_REPEAT_SPACE_US))
+    {
+        frame->protocol = IR_PROTOCOL_NEC;
+        frame->repeat = 1;
+        return true;
+    }
+
+    /* Longer pulse-distance frames (air conditioners) share the leader, their extra bits must not be dropped */
+    if (num_symbols != NEC_FRAME_SYMBOLS || (!nec_leader && !samsung_leader))
+    {
+        return false;
+    }
+    if (!ir_protocol_in_range(symbols[0].duration1, nec_leader ? NEC_LEADING_SPACE_US : SAMSUNG_LEADING_SPACE_US))
+    {
+        return false;
+    }
+
+    uint32_t value;
+    if (!ir_protocol_read_pulse_distance(&symbols[1], &value) ||
+        !ir_protocol_in_range(symbols[NEC_FRAME_SYMBOLS - 1].duration0, NEC_BIT_MARK_US))
+    {
+        return false;
+    }
+
+    uint8_t address = value & 0xFF;
+    uint8_t address_inv = (value >> 8) & 0xFF;
+    uint8_t command = (value >> 16) & 0xFF;
+    uint8_t command_inv = (value >> 24) & 0xFF;
+    if ((command ^ command_inv) != 0xFF)
+    {
+        return false;
+    }
+
+    frame->bits = 32;
+    frame->command = command;
+    if (samsung_leader)
+    {
+        frame->protocol = IR_PROTOCOL_SAMSUNG;
+        frame->address = value & 0xFFFF;
+    }
+    else if ((address ^ address_inv) == 0xFF)
+    {
+        frame->protocol = IR_PROTOCOL_NEC;
+        frame->address = address;
+    }
+    else
+    {
+        frame->protocol = IR_PROTOCOL_NEC_EXT;
+        frame->address = value & 0xFFFF;
+    }
+    return true;
+}
+
+static bool ir_protocol_decode_sony(const rmt_symbol_word_t *symbols, size_t num_symbols, ir_protocol_frame_t *frame)
+{
+    size_t bits = num_symbols - 1;
+    if ((bits != 12 && bits != 15 && bits != 20) ||
+        !ir_protocol_in_range(symbols[0].duration0, SONY_LEADING_MARK_US) ||
+        !ir_protocol_in_range(symbols[0].duration1, SONY_UNIT_US))
+    {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (size_t i = 0; i < bits; i++)
+    {
+        const rmt_symbol_word_t *symbol = &symbols[i + 1];
+        if (symbol->duration0 > SONY_UNIT_US * 3)
+        {
+            return false;
+        }
+        /* The space after the last bit merges into the idle level */
+        if (i + 1 < bits && !ir_protocol_in_range(symbol->duration1, SONY_UNIT_US))
+        {
+            return false;
+        }
+        if (symbol->duration0 > SONY_BIT_THRESHOLD_US)
+        {
+            value |= 1UL << i; // LSB first
+        }
+    }
+
+    frame->protocol = IR_PROTOCOL_SONY;
+    frame->bits = bits;
+    frame->command = value & 0x7F;
+    frame->address = value >> 7;
+    return true;
+}
+
+/**
+ * @brief Expand mark/space levels into a sequence of half-bit levels for bi-phase protocols.
+ *
+ * Only the last space may be missing or longer than max_units, as the idle level.
+ *
+ * @return Number of half-bits written, 0 on a level that isn't a multiple of the unit
+ */
+static size_t ir_protocol_expand_half_bits(const rmt_symbol_word_t *symbols, size_t num_symbols, uint32_t unit,
+                                           uint8_t max_units, uint8_t *half_bits, size_t count, size_t max_count)
+{
+    for (size_t i = 0; i < num_symbols; i++)
+    {
+        uint32_t durations[2] = {symbols[i].duration0, symbols[i].duration1};
+        for (int level = 0; level < 2; level++)
+        {
+            uint32_t units = (durations[level] + unit / 2) / unit;
+            if (units == 0 || units > max_units)
+            {
+                /* An end marker or a long space after the last mark is the idle level, anything after it isn't part of the frame */
+                return (level == 1 && i == num_symbols - 1) ? count : 0;
+            }
+            if (count + units > max_count)
+            {
+                return 0;
+            }
+            while (units--)
+            {
+                half_bits[count++] = (level == 0);
+            }
+        }
+    }
+    return count;
+}
+
+static bool ir_protocol_decode_rc5(const rmt_symbol_word_t *symbols, size_t num_symbols, ir_protocol_frame_t *frame)
+{
+    uint8_t half_bits[IR_PROTOCOL_MAX_HALF_BITS];
+
+    /* The first start bit is a "1" (space then mark), its space is invisible */
+    half_bits[0] = 0;
+    size_t count = ir_protocol_expand_half_bits(symbols, num_symbols, RC5_HALF_BIT_US, 2, half_bits, 1, RC5_HALF_BITS);
+    if (count == RC5_HALF_BITS - 1)
+    {
+        half_bits[count++] = 0; // a trailing "0" ends with a space merged into the idle level
+    }
+    if (count != RC5_HALF_BITS)
+    {
+        return false;
+    }
+
+    uint16_t value = 0;
+    for (int i = 0; i < RC5_HALF_BITS; i += 2)
+    {
+        if (half_bits[i] == half_bits[i + 1])
+        {
+            return false;
+        }
+        value = (value << 1) | half_bits[i + 1]; // MSB first, "1" is space then mark
+    }
+
+    /* S1 S2 T A4..A0 C5..C0, S2 is the inverted bit 6 of the command */
+    if (!(value & 0x2000))
+    {
+        return false;
+    }
+    frame->protocol = IR_PROTOCOL_RC5;
+    frame->bits = 14;
+    frame->toggle = (value >> 11) & 0x01;
+    frame->address = (value >> 6) & 0x1F;
+    frame->command = (value & 0x3F) | (((value >> 12) & 0x01) ? 0 : 0x40);
+    return true;
+}
+
+static bool ir_protocol_decode_rc6(const rmt_symbol_word_t *symbols, size_t num_symbols, ir_protocol_frame_t *frame)
+{
+    if (!ir_protocol_in_range(symbols[0].duration0, RC6_LEADING_MARK_US) ||
+        !ir_protocol_in_range(symbols[0].duration1, RC6_LEADING_SPACE_US))
+    {
+        return false;
+    }
+
+    uint8_t half_bits[IR_PROTOCOL_MAX_HALF_BITS];
+    size_t count = ir_protocol_expand_half_bits(&symbols[1], num_symbols - 1, RC6_UNIT_US, 3, half_bits, 0, RC6_HALF_BITS);
+    if (count == RC6_HALF_BITS - 1)
+    {
+        half_bits[count++] = 0; // a trailing "1" ends with a space merged into the idle level
+    }
+    if (count != RC6_HALF_BITS)
+    {
+        return false;
+    }
+
+    /* Start bit "1" (mark then space) and mode 0 */
+    if (half_bits[0] != 1 || half_bits[1] != 0)
+    {
+        return false;
+    }
+    for (int i = 2; i < 8; i += 2)
+    {
+        if (half_bits[i] != 0 || half_bits[i + 1] != 1)
+        {
+            return false;
+        }
+    }
+
+    /* Trailer bit is twice as long as a normal bit */
+    if (half_bits[8] != half_bits[9] || half_bits[10] != half_bits[11] || half_bits[8] == half_bits[10])
+    {
+        return false;
+    }
+
+    uint16_t value = 0;
+    for (int i = 12; i < RC6_HALF_BITS; i += 2)
+    {
+        if (half_bits[i] == half_bits[i + 1])
+        {
+            return false;
+        }
+        value = (value << 1) | half_bits[i]; // MSB first, "1" is mark then space
+    }
+
+    frame->protocol = IR_PROTOCOL_RC6;
+    frame->bits = 16;
+    frame->toggle = half_bits[8];
+    frame->address = value >> 8;
+    frame->command = value & 0xFF;
+    return true;
+}
+
+esp_err_t ir_protocol_decode(const rmt_symbol_word_t *symbols, size_t num_symbols, ir_protocol_frame_t *frame_out)
+{
+    if (!symbols || !frame_out || num_symbols < 2)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ir_protocol_frame_t frame = {0};
+    uint32_t leading_mark = symbols[0].duration0;
+    bool decoded;
+
+    /* Dispatch on the leading mark so a frame is usually walked once */
+    if (leading_mark > SONY_LEADING_MARK_US * 3 / 2)
+    {
+        decoded = ir_protocol_decode_nec(symbols, num_symbols, &frame);
+    }
+    else if (ir_protocol_in_range(leading_mark, SONY_LEADING_MARK_US) ||
+             ir_protocol_in_range(leading_mark, RC6_LEADING_MARK_US))
+    {
+        /* Sony and RC6 leaders overlap, the following space tells them apart */
+        if (symbols[0].duration1 > (SONY_UNIT_US + RC6_LEADING_SPACE_US) / 2)
+        {
+            decoded = ir_protocol_decode_rc6(symbols, num_symbols, &frame);
+        }
+        else
+        {
+            decoded = ir_protocol_decode_sony(symbols, num_symbols, &frame);
+        }
+    }
+    else
+    {
+        decoded = false;
+    }
+
+    /* An RC5 frame starting with "10" has a double-length first mark, close to a Sony leader */
+    if (!decoded && leading_mark <= RC5_HALF_BIT_US * 5 / 2)
+    {
+        decoded = ir_protocol_decode_rc5(symbols, num_symbols, &frame);
+    }
+
+    if (!decoded)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGD(TAG, "%s addr:0x%04x cmd:0x%04x%s", ir_protocol_name(frame.protocol),
+             frame.address, frame.command, frame.repeat ? " (repeat)" : "");
+    *frame_out = frame;
+    return ESP_OK;
+}
+
+static inline rmt_symbol_word_t ir_protocol_symbol(uint32_t mark_us, uint32_t space_us)
+{
+    return (rmt_symbol_word_t){
+        .level0 = 1,
+        .duration0 = mark_us,
+        .level1 = 0,
+        .duration1 = space_us,
+    };
+}
+
+static size_t ir_protocol_build_pulse_distance(uint32_t value, rmt_symbol_word_t *symbols)
+{
+    for (int i = 0; i < 32; i++)
+    {
+        symbols[i] = ir_protocol_symbol(NEC_BIT_MARK_US, (value & (1UL << i)) ? NEC_BIT_ONE_SPACE_US : NEC_BIT_MARK_US);
+    }
+    symbols[32] = ir_protocol_symbol(NEC_BIT_MARK_US, NEC_BIT_MARK_US); // stop bit
+    return 33;
+}
+
+/**
+ * @brief Merge half-bit levels of bi-phase protocols into mark/space symbols.
+ *
+ * @note The sequence must start with a mark. A trailing mark ends the frame with a zero space (end marker).
+ */
+static size_t ir_protocol_pack_half_bits(const uint8_t *half_bits, size_t count, uint32_t unit, rmt_symbol_word_t *symbols)
+{
+    size_t num_symbols = 0;
+    size_t i = 0;
+
+    while (i < count)
+    {
+        uint32_t mark = 0, space = 0;
+        while (i < count && half_bits[i])
+        {
+            mark += unit;
+            i++;
+        }
+        while (i < count && !half_bits[i])
+        {
+            space += unit;
+            i++;
+        }
+        symbols[num_symbols++] = ir_protocol_symbol(mark, space);
+    }
+    return num_symbols;
+}
+
+static size_t ir_protocol_build_sony(const ir_protocol_frame_t *frame, rmt_symbol_word_t *symbols)
+{
+    uint32_t value = (frame->command & 0x7F) | ((uint32_t)frame->address << 7);
+
+    symbols[0] = ir_protocol_symbol(SONY_LEADING_MARK_US, SONY_UNIT_US);
+    for (int i = 0; i < frame->bits; i++)
+    {
+        symbols[i + 1] = ir_protocol_symbol((value & (1UL << i)) ? SONY_UNIT_US * 2 : SONY_UNIT_US, SONY_UNIT_US);
+    }
+    return frame->bits + 1;
+}
+
+static size_t ir_protocol_build_rc5(const ir_protocol_frame_t *frame, rmt_symbol_word_t *symbols)
+{
+    uint16_t value = 0x2000 | ((frame->command & 0x40) ? 0 : 0x1000) | ((frame->toggle & 0x01) << 11) |
+                     ((frame->address & 0x1F) << 6) | (frame->command & 0x3F);
+    uint8_t half_bits[RC5_HALF_BITS];
+
+    for (int i = 0; i < 14; i++)
+    {
+        uint8_t bit = (value >> (13 - i)) & 0x01;
+        half_bits[i * 2] = !bit; // "1" is space then mark
+        half_bits[i * 2 + 1] = bit;
+    }
+    /* Skip the space of the first start bit, it is the idle level */
+    return ir_protocol_pack_half_bits(&half_bits[1], RC5_HALF_BITS - 1, RC5_HALF_BIT_US, symbols);
+}
+
+static size_t ir_protocol_build_rc6(const ir_protocol_frame_t *frame, rmt_symbol_word_t *symbols)
+{
+    uint16_t value = ((frame->address & 0xFF) << 8) | (frame->command & 0xFF);
+    uint8_t half_bits[RC6_HALF_BITS] = {1, 0, 0, 1, 0, 1, 0, 1}; // start bit "1" and mode 0
+
+    uint8_t toggle = frame->toggle & 0x01;
+    half_bits[8] = half_bits[9] = toggle;
+    half_bits[10] = half_bits[11] = !toggle;
+    for (int i = 0; i < 16; i++)
+    {
+        uint8_t bit = (value >> (15 - i)) & 0x01;
+        half_bits[12 + i * 2] = bit; // "1" is mark then space
+        half_bits[13 + i * 2] = !bit;
+    }
+
+    symbols[0] = ir_protocol_symbol(RC6_LEADING_MARK_US, RC6_LEADING_SPACE_US);
+    return 1 + ir_protocol_pack_half_bits(half_bits, RC6_HALF_BITS, RC6_UNIT_US, &symbols[1]);
+}
+
+size_t ir_protocol_build(const ir_protocol_frame_t *frame, rmt_symbol_word_t *symbols, size_t max_symbols)
+{
+    if (!frame || !symbols || max_symbols < IR_PROTOCOL_FRAME_MAX_SYMBOLS)
+    {
+        return 0;
+    }
+
+    switch (frame->protocol)
+    {
+    case IR_PROTOCOL_NEC:
+    case IR_PROTOCOL_NEC_EXT:
+    case IR_PROTOCOL_SAMSUNG:
+    {
+        if (frame->repeat)
+        {
+            symbols[0] = ir_protocol_symbol(NEC_LEADING_MARK_US, NEC_REPEAT_SPACE_US);
+            symbols[1] = ir_protocol_symbol(NEC_BIT_MARK_US, NEC_BIT_MARK_US);
+            return 2;
+        }
+
+        uint32_t address = frame->address;
+        if (frame->protocol == IR_PROTOCOL_NEC)
+        {
+            address = (address & 0xFF) | ((~address & 0xFF) << 8);
+        }
+        uint32_t command = (frame->command & 0xFF) | ((~frame->command & 0xFF) << 8);
+
+        if (frame->protocol == IR_PROTOCOL_SAMSUNG)
+        {
+            symbols[0] = ir_protocol_symbol(SAMSUNG_LEADING_MARK_US, SAMSUNG_LEADING_SPACE_US);
+        }
+        else
+        {
+            symbols[0] = ir_protocol_symbol(NEC_LEADING_MARK_US, NEC_LEADING_SPACE_US);
+        }
+        return 1 + ir_protocol_build_pulse_distance((address & 0xFFFF) | (command << 16), &symbols[1]);
+    }
+    case IR_PROTOCOL_SONY:
+        if (frame->bits != 12 && frame->bits != 15 && frame->bits != 20)
+        {
+            return 0;
+        }
+        return ir_protocol_build_sony(frame, symbols);
+    case IR_PROTOCOL_RC5:
+        return ir_protocol_build_rc5(frame, symbols);
+    case IR_PROTOCOL_RC6:
+        return ir_protocol_build_rc6(frame, symbols);
+    default:
+        return 0;
+    }
+}
+
+const char *ir_protocol_name(ir_protocol_t protocol)
+{
+    switch (protocol)
+    {
+    case IR_PROTOCOL_NEC:
+        return "NEC";
+    case IR_PROTOCOL_NEC_EXT:
+        return "NEC-ext";
+    case IR_PROTOCOL_SAMSUNG:
+        return "Samsung";
+    case IR_PROTOCOL_SONY:
+        return "Sony";
+    case IR_PROTOCOL_RC5:
+        return "RC5";
+    case IR_PROTOCOL_RC6:
+        return "RC6";
+    default:
+        return "raw";
+    }
+}
+
+uint32_t ir_protocol_unit_ns(ir_protocol_t protocol)
+{
+    switch (protocol)
+    {
+    case IR_PROTOCOL_NEC:
+    case IR_PROTOCOL_NEC_EXT:
+    case IR_PROTOCOL_SAMSUNG:
+        return 562500; // 9 ms leader = 16 units, 1.69 ms one = 3 units
+    case IR_PROTOCOL_SONY:
+        return SONY_UNIT_US * 1000;
+    case IR_PROTOCOL_RC5:
+        return 888889; // 64 cycles of 36 kHz
+    case IR_PROTOCOL_RC6:
+        return 444444; // 16 cycles of 36 kHz
+    default:
+        return 0;
+    }
+}
+
+uint32_t ir_protocol_carrier_hz(ir_protocol_t protocol)
+{
+    switch (protocol)
+    {
+    case IR_PROTOCOL_NEC:
+    case IR_PROTOCOL_NEC_EXT:
+    case IR_PROTOCOL_SAMSUNG:
+        return 38000;
+    case IR_PROTOCOL_SONY:
+        return 40000;
+    case IR_PROTOCOL_RC5:
+    case IR_PROTOCOL_RC6:
+        return 36000;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,331 @@
+#include <string.h>
+#include <sys/param.h>
+
+/* FreeRTOS includes */
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "driver/rmt_rx.h"
+#include "soc/soc_caps.h"
+
+#include "ir_learn.h"
+#include "ir_config.h"
+#include "ir_rx.h"
+
+static const char *TAG = "IR_rx";
+
+#if CONFIG_IR_RX_DMA
+#define IR_RX_FRAME_MAX_SYMBOLS IR_RX_BUFFER_SYMBOLS
+#define IR_RX_BUFFER_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA)
+#elif SOC_RMT_SUPPORT_RX_PINGPONG
+#define IR_RX_PINGPONG 1
+#define IR_RX_FRAME_MAX_SYMBOLS IR_RX_BUFFER_SYMBOLS
+#define IR_RX_BUFFER_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#else
+/* The frame is copied out of the RMT memory once it has ended */
+#define IR_RX_FRAME_MAX_SYMBOLS MIN(IR_RX_BUFFER_SYMBOLS, RMT_RX_MEM_BLOCK_SIZE)
+#define IR_RX_BUFFER_CAPS (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+static const rmt_receive_config_t s_rx_config = {
+    .signal_range_min_ns = 1000,
+    .signal_range_max_ns = RMT_MAX_RANGE_TIME * 1000,
+#if IR_RX_PINGPONG
+    .flags.en_partial_rx = true,
+#endif
+};
+
+static rmt_channel_handle_t s_rx_channel = NULL;
+static QueueHandle_t s_rx_queue = NULL;
+static rmt_symbol_word_t *s_rx_buffers[IR_RX_BUFFER_COUNT];
+static uint8_t s_rx_capture = 0;                                /*!< Buffer the channel is capturing into */
+static uint8_t s_rx_free = ((1 << IR_RX_BUFFER_COUNT) - 1) & ~1; /*!< Bit mask of the buffers owned by nobody */
+#if IR_RX_PINGPONG
+static size_t s_rx_partial = 0; /*!< Symbols of the current frame already copied to the capture buffer */
+#endif
+static TaskHandle_t s_rx_notify_task = NULL;
+static uint32_t s_rx_notify_bits = 0;
+static volatile bool s_rx_armed = false;
+static bool s_rx_suspended = true;
+static volatile ir_rx_mode_t s_rx_mode = IR_RX_MODE_MATCH;
+static ir_rx_stats_t s_rx_stats = {
+    .buffers_in_use = 1,
+    .high_water = 1,
+};
+static portMUX_TYPE s_rx_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Arm the channel into the capture buffer, from the task or from the done callback.
+ */
+static esp_err_t IRAM_ATTR ir_rx_arm(void)
+{
+    esp_err_t ret = rmt_receive(s_rx_channel, s_rx_buffers[s_rx_capture],
+                                IR_RX_BUFFER_SYMBOLS * sizeof(rmt_symbol_word_t), &s_rx_config);
+    s_rx_armed = (ret == ESP_OK);
+    return ret;
+}
+
+/**
+ * @brief Give a buffer back to the ring, with s_rx_lock held.
+ */
+static void IRAM_ATTR ir_rx_free_buffer(uint8_t buffer)
+{
+    s_rx_free |= 1 << buffer;
+    s_rx_stats.buffers_in_use = IR_RX_BUFFER_COUNT - __builtin_popcount(s_rx_free);
+}
+
+static bool IRAM_ATTR ir_rx_done_callback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata, void *user_data)
+{
+    BaseType_t task_woken = pdFALSE;
+    ir_rx_frame_t frame = {
+        .data = *edata,
+        .time_us = esp_timer_get_time(),
+        .buffer = s_rx_capture,
+    };
+    bool deliver = false;
+
+#if IR_RX_PINGPONG
+    /* Each half of the RMT memory is reported as it is copied, the frame is whole at the last one */
+    if (!edata->flags.is_last)
+    {
+        s_rx_partial += edata->num_symbols;
+        return false;
+    }
+    frame.data.received_symbols = s_rx_buffers[frame.buffer];
+    frame.data.num_symbols = s_rx_partial + edata->num_symbols;
+    s_rx_partial = 0;
+#endif
+
+    portENTER_CRITICAL_ISR(&s_rx_lock);
+    s_rx_stats.frames++;
+    if (frame.data.num_symbols >= IR_RX_FRAME_MAX_SYMBOLS)
+    {
+        s_rx_stats.truncated++;
+    }
+    if (frame.data.num_symbols > s_rx_stats.max_symbols)
+    {
+        s_rx_stats.max_symbols = frame.data.num_symbols;
+    }
+    if (s_rx_mode == IR_RX_MODE_MONITOR)
+    {
+        /* Nobody reads the symbols, capture over them */
+        s_rx_stats.monitored++;
+    }
+    else if (s_rx_free == 0)
+    {
+        /* Every other buffer is still held by a frame, this one is lost */
+        s_rx_stats.overruns++;
+    }
+    else
+    {
+        /* The frame keeps its buffer, capture into the next free one after it */
+        do
+        {
+            s_rx_capture = (s_rx_capture + 1) % IR_RX_BUFFER_COUNT;
+        } while (!(s_rx_free & (1 << s_rx_capture)));
+        s_rx_free &= ~(1 << s_rx_capture);
+        s_rx_stats.buffers_in_use = IR_RX_BUFFER_COUNT - __builtin_popcount(s_rx_free);
+        if (s_rx_stats.buffers_in_use > s_rx_stats.high_water)
+        {
+            s_rx_stats.high_water = s_rx_stats.buffers_in_use;
+        }
+        deliver = true;
+    }
+    portEXIT_CRITICAL_ISR(&s_rx_lock);
+
+    /* Listen again before the frame is even looked at */
+    esp_err_t rearm = ir_rx_arm();
+
+    bool dropped = deliver && xQueueSendFromISR(s_rx_queue, &frame, &task_woken) != pdTRUE;
+    if (deliver && !dropped && s_rx_notify_task)
+    {
+        xTaskNotifyFromISR(s_rx_notify_task, s_rx_notify_bits, eSetBits, &task_woken);
+    }
+
+    portENTER_CRITICAL_ISR(&s_rx_lock);
+    if (rearm != ESP_OK)
+    {
+        s_rx_stats.rearm_failures++;
+    }
+    if (dropped)
+    {
+        s_rx_stats.queue_drops++;
+        ir_rx_free_buffer(frame.buffer);
+    }
+    portEXIT_CRITICAL_ISR(&s_rx_lock);
+
+    return task_woken == pdTRUE;
+}
+
+esp_err_t ir_rx_init(void)
+{
+    if (s_rx_channel)
+    {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < IR_RX_BUFFER_COUNT; i++)
+    {
+        s_rx_buffers[i] = heap_caps_malloc(IR_RX_BUFFER_SYMBOLS * sizeof(rmt_symbol_word_t), IR_RX_BUFFER_CAPS);
+        if (!s_rx_buffers[i])
+        {
+            ESP_LOGE(TAG, "No mem for capture buffer %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    /* Every frame in the queue holds a buffer, one is always capturing */
+    s_rx_queue = xQueueCreate(IR_RX_BUFFER_COUNT - 1, sizeof(ir_rx_frame_t));
+    if (!s_rx_queue)
+    {
+        ESP_LOGE(TAG, "Create receive queue failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    rmt_rx_channel_config_t rx_channel_cfg = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .gpio_num = IR_RX_GPIO_NUM,
+        .resolution_hz = IR_RESOLUTION_HZ,
+#if CONFIG_IR_RX_DMA
+        /* Sizes the DMA descriptors, the whole capture buffer is one transfer */
+        .mem_block_symbols = IR_RX_BUFFER_SYMBOLS,
+        .flags.with_dma = true,
+#else
+        .mem_block_symbols = RMT_RX_MEM_BLOCK_SIZE,
+        .flags.with_dma = false,
+#endif
+    };
+    esp_err_t ret = rmt_new_rx_channel(&rx_channel_cfg, &s_rx_channel);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create RX channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    rmt_rx_event_callbacks_t cbs = {
+        .on_recv_done = ir_rx_done_callback,
+    };
+    ret = rmt_rx_register_event_callbacks(s_rx_channel, &cbs, NULL);
+    if (ret == ESP_OK)
+    {
+        ret = ir_rx_resume();
+    }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to start RX channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "RX engine started, ring of %d buffers of %d symbols, frames up to %d symbols", IR_RX_BUFFER_COUNT, IR_RX_BUFFER_SYMBOLS, IR_RX_FRAME_MAX_SYMBOLS);
+    return ESP_OK;
+}
+
+void ir_rx_set_mode(ir_rx_mode_t mode)
+{
+    portENTER_CRITICAL(&s_rx_lock);
+    s_rx_mode = mode;
+    portEXIT_CRITICAL(&s_rx_lock);
+
+    if (mode == IR_RX_MODE_LEARN && s_rx_queue)
+    {
+        /* A learn session starts from the next frame */
+        ir_rx_frame_t frame;
+        while (xQueueReceive(s_rx_queue, &frame, 0) == pdTRUE)
+        {
+            portENTER_CRITICAL(&s_rx_lock);
+            s_rx_stats.flushed++;
+            ir_rx_free_buffer(frame.buffer);
+            portEXIT_CRITICAL(&s_rx_lock);
+        }
+    }
+}
+
+ir_rx_mode_t ir_rx_get_mode(void)
+{
+    return s_rx_mode;
+}
+
+void ir_rx_set_notify(TaskHandle_t task, uint32_t bits)
+{
+    portENTER_CRITICAL(&s_rx_lock);
+    s_rx_notify_task = task;
+    s_rx_notify_bits = bits;
+    portEXIT_CRITICAL(&s_rx_lock);
+}
+
+void ir_rx_check_armed(void)
+{
+    /* A failed re-arm in the done callback is retried here, no done event can race with it */
+    if (s_rx_queue && !s_rx_armed && !s_rx_suspended && ir_rx_arm() != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to re-arm RX channel");
+    }
+}
+
+bool ir_rx_receive(ir_rx_frame_t *frame, TickType_t timeout)
+{
+    if (!s_rx_queue)
+    {
+        return false;
+    }
+
+    ir_rx_check_armed();
+    return xQueueReceive(s_rx_queue, frame, timeout) == pdTRUE;
+}
+
+void ir_rx_release(const ir_rx_frame_t *frame)
+{
+    portENTER_CRITICAL(&s_rx_lock);
+    ir_rx_free_buffer(frame->buffer);
+    portEXIT_CRITICAL(&s_rx_lock);
+}
+
+esp_err_t ir_rx_suspend(void)
+{
+    if (!s_rx_channel)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_rx_suspended)
+    {
+        return ESP_OK;
+    }
+    s_rx_suspended = true;
+    s_rx_armed = false;
+    return rmt_disable(s_rx_channel);
+}
+
+esp_err_t ir_rx_resume(void)
+{
+    if (!s_rx_channel)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!s_rx_suspended)
+    {
+        return ESP_OK;
+    }
+    esp_err_t ret = rmt_enable(s_rx_channel);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    s_rx_suspended = false;
+#if IR_RX_PINGPONG
+    s_rx_partial = 0;
+#endif
+    return ir_rx_arm();
+}
+
+void ir_rx_get_stats(ir_rx_stats_t *stats_out)
+{
+    portENTER_CRITICAL(&s_rx_lock);
+    *stats_out = s_rx_stats;
+    portEXIT_CRITICAL(&s_rx_lock);
+}
@@ -0,0 +1,509 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* ESP32 includes */
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "ir_learn.h"
+#include "ir_index.h"
+#include "ir_db.h"
+#include "ir_sequence.h"
+#include "ir_storage.h"
+#include "ir_cache.h"
+
+static const char *TAG = "IR_sequence";
+
+#define IR_SEQ_PATH_LEN (IR_KEY_MAX_LEN + 24)
+#define IR_SEQ_ALIGN(size) (((size) + 3) & ~3u)
+
+static void ir_seq_path(char *path, const char *key, const char *suffix)
+{
+    snprintf(path, IR_SEQ_PATH_LEN, "/spiffs/%s%s", key, suffix);
+}
+
+static bool ir_seq_file_size(const char *path, size_t *size_out)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        return false;
+    }
+    if (size_out)
+    {
+        *size_out = st.st_size;
+    }
+    return true;
+}
+
+bool ir_seq_exists(const char *key)
+{
+    char path[IR_SEQ_PATH_LEN];
+    ir_seq_path(path, key, ".seq");
+    return ir_seq_file_size(path, NULL);
+}
+
+static esp_err_t ir_seq_check_table(const ir_seq_t *seq, size_t file_size)
+{
+    if (seq->header.magic != IR_SEQ_MAGIC || seq->header.version != IR_SEQ_VERSION)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (seq->header.step_count == 0 || seq->header.step_count > IR_SEQ_STEPS_MAX || seq->header.file_size != file_size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t table_end = sizeof(ir_seq_header_t) + seq->header.step_count * sizeof(ir_seq_step_t);
+    for (int i = 0; i < seq->header.step_count; i++)
+    {
+        const ir_seq_step_t *step = &seq->steps[i];
+        if (step->offset < table_end || step->offset % 4 || step->size > file_size - step->offset)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t ir_seq_open(const char *key, ir_seq_t *seq)
+{
+    char path[IR_SEQ_PATH_LEN];
+    size_t file_size = 0;
+
+    memset(seq, 0, sizeof(*seq));
+    ir_seq_path(path, key, ".seq");
+
+    esp_err_t ret = ESP_OK;
+    const uint8_t *cached_data;
+    if (ir_cache_get(key, IR_CACHE_KIND_SEQ, &cached_data, &file_size) == ESP_OK)
+    {
+        /* Hot sequence: the whole file is in RAM since the warm-up, only checked with a stat */
+        seq->data = cached_data;
+        seq->cached = true;
+    }
+    else
+    {
+        if (!ir_seq_file_size(path, &file_size))
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        FILE *f = fopen(path, "rb");
+        if (!f)
+        {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        if (file_size <= IR_SEQ_LOAD_MAX)
+        {
+            /* Small sequence: one read, one buffer */
+            uint8_t *data = malloc(file_size);
+            if (!data)
+            {
+                fclose(f);
+                return ESP_ERR_NO_MEM;
+            }
+            seq->data = data;
+            size_t read_size = fread(data, 1, file_size, f);
+            fclose(f);
+            if (read_size != file_size)
+            {
+                ret = ESP_ERR_INVALID_SIZE;
+                goto err;
+            }
+        }
+        else
+        {
+            /* Large sequence: keep the file open and read the steps one by one */
+            seq->f = f;
+            if (fread(&seq->header, sizeof(ir_seq_header_t), 1, f) != 1 ||
+                seq->header.step_count > IR_SEQ_STEPS_MAX ||
+                fread(seq->steps, sizeof(ir_seq_step_t), seq->header.step_count, f) != seq->header.step_count)
+            {
+                ret = ESP_ERR_INVALID_SIZE;
+                goto err;
+            }
+        }
+    }
+
+    if (seq->data)
+    {
+        if (file_size < sizeof(ir_seq_header_t))
+        {
+            ret = ESP_ERR_INVALID_SIZE;
+            goto err;
+        }
+        memcpy(&seq->header, seq->data, sizeof(ir_seq_header_t));
+        if (seq->header.step_count > IR_SEQ_STEPS_MAX ||
+            file_size < sizeof(ir_seq_header_t) + seq->header.step_count * sizeof(ir_seq_step_t))
+        {
+            ret = ESP_ERR_INVALID_SIZE;
+            goto err;
+        }
+        memcpy(seq->steps, seq->data + sizeof(ir_seq_header_t), seq->header.step_count * sizeof(ir_seq_step_t));
+    }
+
+    ret = ir_seq_check_table(seq, file_size);
+    if (ret != ESP_OK)
+    {
+        goto err;
+    }
+
+    if (seq->f)
+    {
+        size_t max_size = 0;
+        for (int i = 0; i < seq->header.step_count; i++)
+        {
+            if (seq->steps[i].size > max_size)
+            {
+                max_size = seq->steps[i].size;
+            }
+        }
+        seq->step_buf = malloc(max_size ? max_size : 1);
+        if (!seq->step_buf)
+        {
+            ret = ESP_ERR_NO_MEM;
+            goto err;
+        }
+    }
+
+    ESP_LOGD(TAG, "Opened %s: %d steps, %d bytes, %s", path, seq->header.step_count, file_size,
+             seq->cached ? "cached" : seq->data ? "loaded" : "streamed");
+    return ESP_OK;
+err:
+    ESP_LOGE(TAG, "Invalid sequence %s (%s)", path, esp_err_to_name(ret));
+    ir_seq_close(seq);
+    return ret;
+}
+
+esp_err_t ir_seq_get_step(ir_seq_t *seq, uint16_t index, const uint8_t **data_out, size_t *size_out)
+{
+    if (index >= seq->header.step_count)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const ir_seq_step_t *step = &seq->steps[index];
+    if (seq->data)
+    {
+        *data_out = seq->data + step->offset;
+    }
+    else
+    {
+        if (fseek(seq->f, step->offset, SEEK_SET) != 0 || fread(seq->step_buf, 1, step->size, seq->f) != step->size)
+        {
+            ESP_LOGE(TAG, "Failed to read step %d", index + 1);
+            return ESP_FAIL;
+        }
+        *data_out = seq->step_buf;
+    }
+    *size_out = step->size;
+    return ESP_OK;
+}
+
+void ir_seq_close(ir_seq_t *seq)
+{
+    if (seq->f)
+    {
+        fclose(seq->f);
+        seq->f = NULL;
+    }
+    if (seq->cached)
+    {
+        ir_cache_release(seq->data);
+        seq->cached = false;
+    }
+    else
+    {
+        free((void *)seq->data);
+    }
+    seq->data = NULL;
+    free(seq->step_buf);
+    seq->step_buf = NULL;
+}
+
+static esp_err_t ir_seq_read_table(const char *key, FILE **f_out, ir_seq_t *seq, const char *mode)
+{
+    char path[IR_SEQ_PATH_LEN];
+    size_t file_size = 0;
+
+    ir_seq_path(path, key, ".seq");
+    if (!ir_seq_file_size(path, &file_size))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    FILE *f = fopen(path, mode);
+    if (!f)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (fread(&seq->header, sizeof(ir_seq_header_t), 1, f) != 1 || seq->header.step_count > IR_SEQ_STEPS_MAX ||
+        fread(seq->steps, sizeof(ir_seq_step_t), seq->header.step_count, f) != seq->header.step_count)
+    {
+        fclose(f);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t ret = ir_seq_check_table(seq, file_size);
+    if (ret != ESP_OK)
+    {
+        fclose(f);
+        return ret;
+    }
+    *f_out = f;
+    return ESP_OK;
+}
+
+esp_err_t ir_seq_get_delays(const char *key, int *delays, size_t *count_out)
+{
+    ir_seq_t seq;
+    FILE *f = NULL;
+    esp_err_t ret = ir_seq_read_table(key, &f, &seq, "rb");
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    fclose(f);
+
+    size_t count = seq.header.step_count - 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        delays[i] = seq.steps[i].delay_ms;
+    }
+    *count_out = count;
+    return ESP_OK;
+}
+
+esp_err_t ir_seq_set_delays(const char *key, const int *delays, size_t count)
+{
+    ir_seq_t seq;
+    FILE *f = NULL;
+    esp_err_t ret = ir_seq_read_table(key, &f, &seq, "r+b");
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    for (int i = 0; i < seq.header.step_count; i++)
+    {
+        seq.steps[i].delay_ms = (i < count && i < seq.header.step_count - 1 && delays[i] > 0) ? delays[i] : 0;
+    }
+    if (fseek(f, sizeof(ir_seq_header_t), SEEK_SET) != 0 ||
+        fwrite(seq.steps, sizeof(ir_seq_step_t), seq.header.step_count, f) != seq.header.step_count)
+    {
+        ret = ESP_FAIL;
+    }
+    fclose(f);
+    ir_cache_invalidate(key, IR_CACHE_KIND_SEQ);
+    if (count != seq.header.step_count - 1)
+    {
+        ESP_LOGW(TAG, "%s: %d delays for %d steps", key, count, seq.header.step_count);
+    }
+    return ret;
+}
+
+static size_t ir_seq_read_legacy_delays(const char *key, int *delays)
+{
+    size_t count = 0;
+    if (read_step_timediff_file(key, delays, &count) != ESP_OK)
+    {
+        return 0;
+    }
+    return count;
+}
+
+esp_err_t ir_seq_pack(const char *key)
+{
+    char path[IR_SEQ_PATH_LEN];
+    char tmp_path[IR_SEQ_PATH_LEN];
+    ir_seq_header_t header = {
+        .magic = IR_SEQ_MAGIC,
+        .version = IR_SEQ_VERSION,
+    };
+    ir_seq_step_t steps[IR_SEQ_STEPS_MAX] = {0};
+    int delays[IR_STEP_COUNT_MAX] = {0};
+    size_t max_size = 0;
+
+    /* Step table: the step keys give the sizes, the offsets follow the table */
+    size_t delay_count = ir_seq_read_legacy_delays(key, delays);
+    while (header.step_count < IR_SEQ_STEPS_MAX)
+    {
+        char step_key[IR_KEY_MAX_LEN];
+        ir_db_entry_t entry;
+        snprintf(step_key, sizeof(step_key), "%s_step%d", key, header.step_count + 1);
+        if (ir_db_find(step_key, &entry) != ESP_OK)
+        {
+            break;
+        }
+        size_t size = entry.length;
+        steps[header.step_count].size = size;
+        steps[header.step_count].delay_ms = header.step_count < delay_count ? delays[header.step_count] : 0;
+        if (size > max_size)
+        {
+            max_size = size;
+        }
+        header.step_count++;
+    }
+    if (header.step_count == 0)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    steps[header.step_count - 1].delay_ms = 0;
+
+    size_t offset = IR_SEQ_ALIGN(sizeof(header) + header.step_count * sizeof(ir_seq_step_t));
+    for (int i = 0; i < header.step_count; i++)
+    {
+        steps[i].offset = offset;
+        offset = IR_SEQ_ALIGN(offset + steps[i].size);
+    }
+    header.file_size = steps[header.step_count - 1].offset + steps[header.step_count - 1].size;
+
+    uint8_t *buf = malloc(max_size ? max_size : 1);
+    if (!buf)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ir_seq_path(tmp_path, key, ".sqt");
+    FILE *out = fopen(tmp_path, "wb");
+    if (!out)
+    {
+        free(buf);
+        ESP_LOGE(TAG, "Failed to create %s", tmp_path);
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_OK;
+    static const uint8_t padding[4] = {0};
+    size_t written = fwrite(&header, sizeof(header), 1, out) == 1 &&
+                     fwrite(steps, sizeof(ir_seq_step_t), header.step_count, out) == header.step_count;
+    size_t pos = sizeof(header) + header.step_count * sizeof(ir_seq_step_t);
+    for (int i = 0; written && i < header.step_count; i++)
+    {
+        char step_key[IR_KEY_MAX_LEN];
+        size_t read_size = 0;
+        snprintf(step_key, sizeof(step_key), "%s_step%d", key, i + 1);
+
+        written = ir_db_read(step_key, 0, buf, steps[i].size, &read_size) == ESP_OK && read_size == steps[i].size;
+        written = written && fwrite(padding, 1, steps[i].offset - pos, out) == steps[i].offset - pos &&
+                  fwrite(buf, 1, steps[i].size, out) == steps[i].size;
+        pos = steps[i].offset + steps[i].size;
+    }
+    free(buf);
+    written = written && fflush(out) == 0 && fsync(fileno(out)) == 0;
+    if (fclose(out) != 0 || !written)
+    {
+        ESP_LOGE(TAG, "Failed to write %s", tmp_path);
+        unlink(tmp_path);
+        return ESP_FAIL;
+    }
+
+    /* SPIFFS rename doesn't replace an existing file */
+    ir_seq_path(path, key, ".seq");
+    ir_cache_invalidate(key, IR_CACHE_KIND_SEQ);
+    unlink(path);
+    if (rename(tmp_path, path) != 0)
+    {
+        ESP_LOGE(TAG, "Failed to rename %s", tmp_path);
+        return ESP_FAIL;
+    }
+
+    /* The sequence is safe, drop the step keys */
+    for (int i = 0; i < header.step_count; i++)
+    {
+        char step_key[IR_KEY_MAX_LEN];
+        snprintf(step_key, sizeof(step_key), "%s_step%d", key, i + 1);
+        ir_db_delete(step_key);
+        ir_index_remove(step_key);
+    }
+    ir_seq_path(tmp_path, key, ".delay");
+    unlink(tmp_path);
+
+    ESP_LOGI(TAG, "Packed %s: %d steps, %d bytes", path, header.step_count, header.file_size);
+    return ret;
+}
+
+/* Sequence names collected per allocation by ir_seq_migrate() */
+#define IR_SEQ_MIGRATE_CHUNK 16
+
+typedef struct
+{
+    char (*keys)[IR_KEY_MAX_LEN];
+    int key_count;
+    int key_capacity;
+    bool no_mem;
+} ir_seq_migrate_t;
+
+static bool ir_seq_collect_step1(const char *key, const ir_db_entry_t *entry, void *arg)
+{
+    ir_seq_migrate_t *migrate = arg;
+    const char *suffix = strstr(key, "_step1");
+    if (!suffix || strcmp(suffix, "_step1") != 0 || suffix == key)
+    {
+        return true;
+    }
+    if (migrate->key_count == migrate->key_capacity)
+    {
+        int capacity = migrate->key_capacity + IR_SEQ_MIGRATE_CHUNK;
+        char(*keys)[IR_KEY_MAX_LEN] = realloc(migrate->keys, capacity * IR_KEY_MAX_LEN);
+        if (!keys)
+        {
+            migrate->no_mem = true;
+            return false;
+        }
+        migrate->keys = keys;
+        migrate->key_capacity = capacity;
+    }
+    snprintf(migrate->keys[migrate->key_count++], IR_KEY_MAX_LEN, "%.*s", (int)(suffix - key), key);
+    return true;
+}
+
+esp_err_t ir_seq_migrate(void)
+{
+    ir_seq_migrate_t migrate = {0};
+
+    /* Collect first, packing deletes keys from the database being walked */
+    ir_db_foreach(ir_seq_collect_step1, &migrate);
+
+    esp_err_t ret = migrate.no_mem ? ESP_ERR_NO_MEM : ESP_OK;
+    for (int i = 0; i < migrate.key_count; i++)
+    {
+        ESP_LOGI(TAG, "Migrating step sequence: %s", migrate.keys[i]);
+        if (ir_seq_pack(migrate.keys[i]) != ESP_OK)
+        {
+            ret = ESP_FAIL;
+        }
+    }
+    free(migrate.keys);
+    return ret;
+}
+
+esp_err_t ir_seq_delete(const char *key)
+{
+    char path[IR_SEQ_PATH_LEN];
+    ir_seq_path(path, key, ".seq");
+    ir_cache_invalidate(key, IR_CACHE_KIND_SEQ);
+    return unlink(path) == 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t ir_seq_rename(const char *old_key, const char *new_key)
+{
+    char old_path[IR_SEQ_PATH_LEN];
+    char new_path[IR_SEQ_PATH_LEN];
+    ir_seq_path(old_path, old_key, ".seq");
+    ir_seq_path(new_path, new_key, ".seq");
+
+    if (!ir_seq_file_size(old_path, NULL))
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ir_seq_file_size(new_path, NULL))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ir_cache_invalidate(old_key, IR_CACHE_KIND_SEQ);
+    return rename(old_path, new_path) == 0 ? ESP_OK : ESP_FAIL;
+}
@@ -1,7 +1,11 @@
 #include <stdio.h>
+#include <ctype.h>
+#include <inttypes.h>
 #include <string.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/param.h>
 
 /* ESP32 includes */
 #include "esp_err.h"
@@ -13,6 +17,15 @@
 #include "esp_spiffs.h"
 #include "ir_learn.h"
 #include "ir_storage.h"
+#include "ir_index.h"
+#include "ir_db.h"
+#include "ir_alias.h"
+#include "ir_protocol.h"
+#include "ir_sequence.h"
+#include "ir_normalize.h"
+#include "ir_codec.h"
+#include "ir_file.h"
+#include "ir_cache.h"
 #include "cJSON.h"
 
 static const char *TAG = "IR_storage";
@@ -73,103 +86,367 @@ void write_nvs(bool ota_enabled)
     nvs_close(my_handle);
 }
 
-static esp_err_t save_ir_list_to_file(const char *key, struct ir_learn_sub_list_head *list)
+/**
+ * @brief Decode a sub-frame that a protocol record can stand for.
+ *
+ * The record replays the synthesized frame, so it must have as many symbols as the received one.
+ */
+static bool ir_storage_decode_whole(const struct ir_learn_sub_list_t *sub, ir_protocol_frame_t *frame)
+{
+    rmt_symbol_word_t symbols[IR_PROTOCOL_FRAME_MAX_SYMBOLS];
+    if (ir_protocol_decode(sub->symbols.received_symbols, sub->symbols.num_symbols, frame) != ESP_OK)
+    {
+        return false;
+    }
+    return ir_protocol_build(frame, symbols, IR_PROTOCOL_FRAME_MAX_SYMBOLS) == sub->symbols.num_symbols;
+}
+
+/**
+ * @brief Reduce learned data to a protocol record.
+ *
+ * Every frame after the first must be a copy of it or a NEC repeat code.
+ */
+static bool ir_storage_make_record(const struct ir_learn_sub_list_head *list, ir_protocol_record_t *record)
+{
+    struct ir_learn_sub_list_t *sub_it = SLIST_FIRST(list);
+    if (!sub_it || !ir_storage_decode_whole(sub_it, &record->frame) || record->frame.repeat)
+    {
+        return false;
+    }
+
+    record->magic = IR_PROTOCOL_RECORD_MAGIC;
+    record->frames = 1;
+    record->repeat_code = 0;
+    record->reserved = 0;
+    record->first_delay_us = sub_it->timediff;
+    record->gap_us = 0;
+
+    uint64_t gap_total = 0;
+    while ((sub_it = SLIST_NEXT(sub_it, next)) != NULL)
+    {
+        ir_protocol_frame_t frame;
+        if (!ir_storage_decode_whole(sub_it, &frame))
+        {
+            return false;
+        }
+        bool repeat_code = frame.repeat;
+        if (repeat_code ? frame.protocol != IR_PROTOCOL_NEC : !ir_protocol_frame_equal(&frame, &record->frame))
+        {
+            return false;
+        }
+        if (record->frames > 1 && repeat_code != record->repeat_code)
+        {
+            return false;
+        }
+        if (record->frames == UINT16_MAX)
+        {
+            return false;
+        }
+        record->repeat_code = repeat_code;
+        gap_total += sub_it->timediff;
+        record->frames++;
+    }
+    if (record->frames > 1)
+    {
+        record->gap_us = gap_total / (record->frames - 1);
+    }
+    return true;
+}
+
+/**
+ * @brief Expand a protocol record into the symbol list used by the raw code paths.
+ */
+static esp_err_t ir_storage_expand_record(const ir_protocol_record_t *record, struct ir_learn_sub_list_head *out_list)
+{
+    rmt_symbol_word_t symbols[IR_PROTOCOL_FRAME_MAX_SYMBOLS];
+    ir_protocol_frame_t frame = record->frame;
+
+    for (uint16_t i = 0; i < record->frames; i++)
+    {
+        frame.repeat = (i > 0) && record->repeat_code;
+        rmt_rx_done_event_data_t symbol_data = {
+            .received_symbols = symbols,
+            .num_symbols = ir_protocol_build(&frame, symbols, IR_PROTOCOL_FRAME_MAX_SYMBOLS),
+        };
+        if (symbol_data.num_symbols == 0)
+        {
+            return ESP_ERR_INVALID_STATE;
+        }
+        esp_err_t ret = ir_learn_add_sub_list_node(out_list, i ? record->gap_us : record->first_delay_us, &symbol_data);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t save_ir_list_to_db(const char *key, struct ir_learn_sub_list_head *list, const ir_carrier_t *carrier)
 {
     if (!key || !list)
     {
         return ESP_ERR_INVALID_ARG;
     }
 
-    char filepath[64];
-    snprintf(filepath, sizeof(filepath), "/spiffs/%s.ir", key);
+    ir_protocol_record_t record;
+    bool is_record = ir_storage_make_record(list, &record);
+    bool has_carrier = carrier && carrier->frequency_hz;
+    struct ir_learn_sub_list_t *sub_it;
 
-    FILE *f = fopen(filepath, "wb");
-    if (!f)
+    size_t size = has_carrier ? sizeof(ir_key_header_t) : 0;
+    size_t encoded_size = 0;
+    if (is_record)
     {
-        ESP_LOGE("IR", "Failed to open file %s for writing", filepath);
-        return ESP_FAIL;
+        size += sizeof(record);
+    }
+    else
+    {
+        size_t raw_size = 0;
+        SLIST_FOREACH(sub_it, list, next)
+        {
+            raw_size += 2 * sizeof(uint32_t) + sub_it->symbols.num_symbols * sizeof(rmt_symbol_word_t);
+        }
+#if CONFIG_IR_STORAGE_COMPRESS
+        // Raw keys that don't decode as a protocol are stored encoded, when that is smaller
+        encoded_size = ir_codec_encode(list, NULL, 0, NULL);
+        if (encoded_size >= raw_size)
+        {
+            encoded_size = 0;
+        }
+#endif
+        size += encoded_size ? encoded_size : raw_size;
     }
 
-    struct ir_learn_sub_list_t *sub_it;
+    // The key is built in one buffer and appended to the key database as one record
+    uint8_t *data = malloc(size ? size : 1);
+    if (!data)
+    {
+        ESP_LOGE("IR", "Out of memory");
+        return ESP_ERR_NO_MEM;
+    }
+    uint8_t *p = data;
 
-    SLIST_FOREACH(sub_it, list, next)
+    if (has_carrier)
     {
-        uint32_t timediff = sub_it->timediff;
-        uint32_t num_symbols = sub_it->symbols.num_symbols;
+        ir_key_header_t header = {
+            .magic = IR_KEY_HEADER_MAGIC,
+            .carrier_hz = carrier->frequency_hz,
+            .duty_permille = carrier->duty_permille,
+        };
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        ESP_LOGI("IR", "Carrier %" PRIu32 " Hz, duty %d.%d%%", header.carrier_hz, header.duty_permille / 10, header.duty_permille % 10);
+    }
 
-        fwrite(&timediff, sizeof(uint32_t), 1, f);
-        fwrite(&num_symbols, sizeof(uint32_t), 1, f);
-        fwrite(sub_it->symbols.received_symbols, sizeof(rmt_symbol_word_t), num_symbols, f);
+    if (is_record)
+    {
+        memcpy(p, &record, sizeof(record));
+        ESP_LOGI("IR", "%s key, addr:0x%04x cmd:0x%04x, %d frames", ir_protocol_name(record.frame.protocol),
+                 record.frame.address, record.frame.command, record.frames);
+    }
+    else if (encoded_size)
+    {
+        uint8_t mode = 0;
+        ir_codec_encode(list, p, encoded_size, &mode);
+        ESP_LOGI("IR", "Raw key encoded, %d bytes (%s)", encoded_size, mode == IR_CODEC_MODE_DICT ? "dict" : "delta");
+    }
+    else
+    {
+        SLIST_FOREACH(sub_it, list, next)
+        {
+            uint32_t timediff = sub_it->timediff;
+            uint32_t num_symbols = sub_it->symbols.num_symbols;
+
+            memcpy(p, &timediff, sizeof(uint32_t));
+            memcpy(p + sizeof(uint32_t), &num_symbols, sizeof(uint32_t));
+            p += 2 * sizeof(uint32_t);
+            memcpy(p, sub_it->symbols.received_symbols, num_symbols * sizeof(rmt_symbol_word_t));
+            p += num_symbols * sizeof(rmt_symbol_word_t);
+        }
     }
 
-    fclose(f);
-    ESP_LOGI("IR", "IR data saved to %s", filepath);
+    esp_err_t ret = ir_db_write(key, data, size, is_record ? record.frame.protocol : IR_PROTOCOL_UNKNOWN,
+                                has_carrier ? IR_DB_FLAG_CARRIER : 0);
+    free(data);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE("IR", "Failed to save key %s (%s)", key, esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGI("IR", "IR data saved: %s, %d bytes", key, size);
+
+    ir_index_update(key, list);
     return ESP_OK;
 }
-static esp_err_t load_ir_list_from_file(const char *key, struct ir_learn_sub_list_head *out_list)
+/**
+ * @brief Load a key with a copy, when the key database isn't mapped.
+ */
+static esp_err_t load_ir_list_read(const char *key, struct ir_learn_sub_list_head *out_list)
+{
+    ir_db_entry_t entry;
+    if (ir_db_find(key, &entry) != ESP_OK)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // One read into one buffer, the sub-frames are then copied into the list arena
+    uint8_t *data = malloc(entry.length ? entry.length : 1);
+    if (!data)
+    {
+        ESP_LOGE("IR", "Out of memory");
+        return ESP_ERR_NO_MEM;
+    }
+    size_t read_size = 0;
+    esp_err_t ret = ir_db_read(key, 0, data, entry.length, &read_size);
+    if (ret == ESP_OK)
+    {
+        ret = ir_learn_load_from_buffer(data, read_size, out_list);
+    }
+    free(data);
+    return ret;
+}
+static esp_err_t load_ir_list_from_db(const char *key, struct ir_learn_sub_list_head *out_list)
 {
     if (!key || !out_list)
     {
         return ESP_ERR_INVALID_ARG;
     }
 
-    char filepath[64];
-    snprintf(filepath, sizeof(filepath), "/spiffs/%s.ir", key);
-
-    FILE *f = fopen(filepath, "rb");
-    if (!f)
+    // The sub-frames are copied from the mapped partition into the list arena, with no buffer in between
+    ir_db_view_t view;
+    esp_err_t ret = ir_db_view(key, &view);
+    if (ret == ESP_OK)
     {
-        ESP_LOGE("IR", "Failed to open file %s for reading", filepath);
-        return ESP_FAIL;
+        ret = ir_learn_load_from_buffer(view.data, view.size, out_list);
+        ir_db_view_release(&view);
+    }
+    else if (ret == ESP_ERR_NOT_SUPPORTED)
+    {
+        ret = load_ir_list_read(key, out_list);
+    }
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+        ESP_LOGE("IR", "Key not found: %s", key);
+        return ret;
+    }
+    if (ret == ESP_ERR_INVALID_SIZE)
+    {
+        // Keep the complete sub-frames of a truncated key, as before
+        ESP_LOGW("IR", "Truncated key %s", key);
+        ret = ESP_OK;
+    }
+    ESP_LOGI("IR", "IR data loaded: %s", key);
+    return ret;
+}
+size_t ir_key_read_header(const uint8_t *data, size_t size, ir_carrier_t *carrier_out)
+{
+    ir_key_header_t header;
+    if (carrier_out)
+    {
+        memset(carrier_out, 0, sizeof(*carrier_out));
+    }
+    if (size < sizeof(header))
+    {
+        return 0;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != IR_KEY_HEADER_MAGIC)
+    {
+        return 0;
+    }
+    if (carrier_out)
+    {
+        carrier_out->frequency_hz = header.carrier_hz;
+        carrier_out->duty_permille = header.duty_permille;
+    }
+    return sizeof(header);
+}
+esp_err_t ir_key_next_frame(const uint8_t *data, size_t size, size_t *pos, uint32_t *timediff_out,
+                            const rmt_symbol_word_t **symbols_out, size_t *num_symbols_out)
+{
+    if (*pos > size || size - *pos < 2 * sizeof(uint32_t))
+    {
+        return ESP_ERR_NOT_FOUND;
     }
 
-    while (1)
+    uint32_t num_symbols;
+    memcpy(timediff_out, data + *pos, sizeof(uint32_t));
+    memcpy(&num_symbols, data + *pos + sizeof(uint32_t), sizeof(uint32_t));
+    size_t start = *pos + 2 * sizeof(uint32_t);
+    if (num_symbols > (size - start) / sizeof(rmt_symbol_word_t))
     {
-        uint32_t timediff = 0;
-        uint32_t num_symbols = 0;
+        return ESP_ERR_INVALID_SIZE;
+    }
 
-        size_t read_count = fread(&timediff, sizeof(uint32_t), 1, f);
-        if (read_count != 1)
-            break; // End of file or read error
+    /* Blocks are 4-byte aligned, the symbols can be used in place */
+    *symbols_out = (const rmt_symbol_word_t *)(data + start);
+    *num_symbols_out = num_symbols;
+    *pos = start + num_symbols * sizeof(rmt_symbol_word_t);
+    return ESP_OK;
+}
+esp_err_t ir_learn_load_from_buffer(const uint8_t *data, size_t size, struct ir_learn_sub_list_head *out_list)
+{
+    if (!data || !out_list)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        read_count = fread(&num_symbols, sizeof(uint32_t), 1, f);
-        if (read_count != 1)
-        {
-            ESP_LOGW("IR", "Failed to read num_symbols");
-            break;
-        }
+    size_t header_size = ir_key_read_header(data, size, NULL);
+    data += header_size;
+    size -= header_size;
 
-        size_t symbol_size = num_symbols * sizeof(rmt_symbol_word_t);
-        rmt_symbol_word_t *symbols = malloc(symbol_size);
-        if (!symbols)
+    if (size == sizeof(ir_protocol_record_t))
+    {
+        ir_protocol_record_t record;
+        memcpy(&record, data, sizeof(record));
+        if (record.magic == IR_PROTOCOL_RECORD_MAGIC)
         {
-            ESP_LOGE("IR", "Out of memory");
-            fclose(f);
-            return ESP_ERR_NO_MEM;
+            ir_learn_reserve_sub_list(out_list, record.frames, record.frames * IR_PROTOCOL_FRAME_MAX_SYMBOLS);
+            return ir_storage_expand_record(&record, out_list);
         }
+    }
+    if (ir_codec_is_encoded(data, size))
+    {
+        return ir_codec_decode(data, size, out_list);
+    }
 
-        read_count = fread(symbols, sizeof(rmt_symbol_word_t), num_symbols, f);
-        if (read_count != num_symbols)
-        {
-            ESP_LOGW("IR", "Failed to read %d symbols (got %d)", num_symbols, read_count);
-            free(symbols);
-            fclose(f);
-            break;
-        }
+    /* Size the list arena from the sub-frame headers first, so the whole key fits in one chunk */
+    size_t frames = 0;
+    size_t symbols = 0;
+    size_t pos = 0;
+    uint32_t timediff;
+    const rmt_symbol_word_t *frame_symbols;
+    size_t num_symbols;
+    while (ir_key_next_frame(data, size, &pos, &timediff, &frame_symbols, &num_symbols) == ESP_OK)
+    {
+        frames++;
+        symbols += num_symbols;
+    }
+    ir_learn_reserve_sub_list(out_list, frames, symbols);
 
+    pos = 0;
+    esp_err_t ret;
+    while ((ret = ir_key_next_frame(data, size, &pos, &timediff, &frame_symbols, &num_symbols)) == ESP_OK)
+    {
         rmt_rx_done_event_data_t symbol_data = {
-            .received_symbols = symbols,
+            .received_symbols = (rmt_symbol_word_t *)frame_symbols,
             .num_symbols = num_symbols,
         };
-
-        ir_learn_add_sub_list_node(out_list, timediff, &symbol_data);
+        ret = ir_learn_add_sub_list_node(out_list, timediff, &symbol_data);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    if (ret == ESP_ERR_INVALID_SIZE)
+    {
+        ESP_LOGW("IR", "Truncated sub-frame at %d of %d bytes", pos, size);
+        return ret;
     }
-
-    fclose(f);
-    ESP_LOGI("IR", "IR data loaded from %s", filepath);
     return ESP_OK;
 }
-void ir_learn_save(struct ir_learn_sub_list_head *data_save, struct ir_learn_sub_list_head *data_src, const char *key)
+void ir_learn_save(struct ir_learn_sub_list_head *data_save, struct ir_learn_sub_list_head *data_src, const char *key,
+                   const ir_carrier_t *carrier)
 {
     assert(data_src && "data_src is null");
 
@@ -179,49 +456,66 @@ void ir_learn_save(struct ir_learn_sub_list_head *data_save, struct ir_learn_sub
         ir_learn_add_sub_list_node(data_save, sub_it->timediff, &sub_it->symbols);
     }
 
-    save_ir_list_to_file(key, data_save);
+    // Stored and received frames go through the same normalization, so they compare level for level
+    ir_normalize_stats_t stats;
+    if (ir_normalize_list(data_save, &stats) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Nothing left of key %s after the glitch filter", key);
+        return;
+    }
+    ESP_LOGI(TAG, "Normalized %s: %d levels, %d glitches merged, %d levels snapped to %" PRIu32 " ns",
+             key, stats.levels, stats.glitches, stats.snapped, stats.base_ns);
+
+    save_ir_list_to_db(key, data_save, carrier);
 }
 esp_err_t ir_learn_load(struct ir_learn_sub_list_head *data_load, const char *key)
 {
-    esp_err_t ret = load_ir_list_from_file(key, data_load);
+    esp_err_t ret = load_ir_list_from_db(key, data_load);
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to load IR symbols from file, ret: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to load IR symbols, ret: %s", esp_err_to_name(ret));
     }
     return ret;
 }
-void list_ir_keys_from_spiffs(void)
+esp_err_t ir_learn_load_record(const char *key, ir_protocol_record_t *record, ir_carrier_t *carrier_out)
 {
-    const char *dir_path = "/spiffs";
-    DIR *dir = opendir(dir_path);
-    if (!dir)
+    if (!key || !record)
     {
-        ESP_LOGE("SPIFFS", "Failed to open %s", dir_path);
-        return;
+        return ESP_ERR_INVALID_ARG;
     }
-
-    struct dirent *entry;
-    int count = 0;
-
-    while ((entry = readdir(dir)) != NULL)
+    if (carrier_out)
     {
-        if (entry->d_type == DT_REG)
-        {
-            const char *filename = entry->d_name;
-            const char *ext = strrchr(filename, '.');
+        memset(carrier_out, 0, sizeof(*carrier_out));
+    }
 
-            if (ext && strcmp(ext, ".ir") == 0)
-            {
-                count++;
-                char key[32] = {0};
-                strncpy(key, filename, ext - filename);
-                ESP_LOGI("SPIFFS", "IR Key: %s", key);
-            }
-        }
+    uint8_t data[sizeof(ir_key_header_t) + sizeof(ir_protocol_record_t)];
+    size_t read_size;
+    if (ir_db_read(key, 0, data, sizeof(data), &read_size) != ESP_OK)
+    {
+        return ESP_ERR_NOT_FOUND;
     }
 
-    closedir(dir);
-    ESP_LOGI("SPIFFS", "Total IR keys found: %d", count);
+    size_t header_size = ir_key_read_header(data, read_size, carrier_out);
+    if (read_size - header_size < sizeof(*record))
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    memcpy(record, data + header_size, sizeof(*record));
+    if (record->magic != IR_PROTOCOL_RECORD_MAGIC)
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+static bool ir_storage_print_key(const char *key, const ir_db_entry_t *entry, void *arg)
+{
+    ESP_LOGI(TAG, "IR Key: %s (%s, %d bytes)", key, ir_protocol_name(entry->protocol), entry->length);
+    return true;
+}
+void list_ir_keys_from_spiffs(void)
+{
+    size_t count = ir_db_foreach(ir_storage_print_key, NULL);
+    ESP_LOGI(TAG, "Total IR keys found: %d", count);
 }
 void list_ir_step_delay_from_spiffs(void)
 {
@@ -243,7 +537,7 @@ void list_ir_step_delay_from_spiffs(void)
             const char *filename = entry->d_name;
             const char *ext = strrchr(filename, '.');
 
-            if (ext && strcmp(ext, ".delay") == 0)
+            if (ext && (strcmp(ext, ".delay") == 0 || strcmp(ext, ".seq") == 0))
             {
                 count++;
                 char key[32] = {0};
@@ -261,55 +555,52 @@ esp_err_t rename_ir_key_in_spiffs(const char *old_key, const char *new_key)
     if (!old_key || !new_key)
         return ESP_ERR_INVALID_ARG;
 
-    char old_path[64];
-    char new_path[64];
-
-    snprintf(old_path, sizeof(old_path), "/spiffs/%s.ir", old_key);
-    snprintf(new_path, sizeof(new_path), "/spiffs/%s.ir", new_key);
-
-    FILE *fp = fopen(old_path, "rb");
-    if (!fp)
+    if (!ir_db_exists(old_key) && ir_seq_exists(old_key))
     {
-        ESP_LOGE("SPIFFS", "Old key file not found: %s", old_path);
-        return ESP_ERR_NOT_FOUND;
+        esp_err_t ret = ir_seq_rename(old_key, new_key);
+        ESP_LOGI(TAG, "Renamed IR sequence from '%s' ➜ '%s': %s", old_key, new_key, esp_err_to_name(ret));
+        return ret;
     }
-    fclose(fp);
 
-    fp = fopen(new_path, "rb");
-    if (fp)
+    esp_err_t ret = ir_db_rename(old_key, new_key);
+    if (ret == ESP_OK)
     {
-        fclose(fp);
-        ESP_LOGE("SPIFFS", "New key already exists: %s", new_path);
-        return ESP_ERR_INVALID_STATE;
+        ESP_LOGI(TAG, "Renamed IR key from '%s' ➜ '%s'", old_key, new_key);
+        ir_index_rename(old_key, new_key);
     }
-    int result = rename(old_path, new_path);
-    if (result == 0)
+    else if (ret == ESP_ERR_NOT_FOUND)
     {
-        ESP_LOGI("SPIFFS", "Renamed IR key from '%s' ➜ '%s'", old_key, new_key);
-        return ESP_OK;
+        ESP_LOGE(TAG, "Old key not found: %s", old_key);
+    }
+    else if (ret == ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "New key already exists: %s", new_key);
     }
     else
     {
-        ESP_LOGE("SPIFFS", "Rename failed: %s ➜ %s", old_path, new_path);
-        return ESP_FAIL;
+        ESP_LOGE(TAG, "Rename failed: %s ➜ %s (%s)", old_key, new_key, esp_err_to_name(ret));
     }
+    return ret;
 }
 esp_err_t delete_ir_key_from_spiffs(const char *key)
 {
     if (!key)
         return ESP_ERR_INVALID_ARG;
 
-    char filepath[64];
-    snprintf(filepath, sizeof(filepath), "/spiffs/%s.ir", key);
-
-    if (unlink(filepath) == 0)
+    if (ir_db_delete(key) == ESP_OK)
     {
-        ESP_LOGI("SPIFFS", "Deleted IR key file: %s", filepath);
+        ESP_LOGI(TAG, "Deleted IR key: %s", key);
+        ir_index_remove(key);
+        return ESP_OK;
+    }
+    else if (ir_seq_delete(key) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Deleted IR sequence: %s", key);
         return ESP_OK;
     }
     else
     {
-        ESP_LOGE("SPIFFS", "Failed to delete: %s", filepath);
+        ESP_LOGE(TAG, "Failed to delete: %s", key);
         return ESP_FAIL;
     }
 }
@@ -328,6 +619,114 @@ void format_spiffs(void)
     {
         ESP_LOGI(TAG, "SPIFFS formatted successfully!");
     }
+    ir_db_format();
+    ir_index_clear();
+    ir_alias_invalidate();
+    ir_cache_clear();
+}
+/**
+ * @brief Move the keys of older firmware, one "/spiffs/<key>.ir" file each, into the key database.
+ */
+static void ir_storage_import_files(void)
+{
+    char keys[16][IR_KEY_MAX_LEN];
+    int imported = 0;
+
+    while (1)
+    {
+        /* Collect first, importing removes files from the directory being read */
+        int key_count = 0;
+        DIR *dir = opendir("/spiffs");
+        if (!dir)
+        {
+            return;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL && key_count < sizeof(keys) / sizeof(keys[0]))
+        {
+            const char *ext = strrchr(entry->d_name, '.');
+            if (entry->d_type != DT_REG || !ext || strcmp(ext, ".ir") != 0 || ext == entry->d_name ||
+                ext - entry->d_name >= IR_KEY_MAX_LEN)
+            {
+                continue;
+            }
+            snprintf(keys[key_count++], IR_KEY_MAX_LEN, "%.*s", (int)(ext - entry->d_name), entry->d_name);
+        }
+        closedir(dir);
+        if (key_count == 0)
+        {
+            break;
+        }
+
+        for (int i = 0; i < key_count; i++)
+        {
+            char filepath[IR_KEY_MAX_LEN + 16];
+            snprintf(filepath, sizeof(filepath), "/spiffs/%s.ir", keys[i]);
+
+            struct stat st;
+            uint8_t *data = NULL;
+            esp_err_t ret = ESP_FAIL;
+            FILE *f = fopen(filepath, "rb");
+            if (f && stat(filepath, &st) == 0)
+            {
+                ret = st.st_size <= IR_DB_DATA_MAX ? ESP_OK : ESP_ERR_INVALID_SIZE;
+            }
+            if (ret == ESP_OK && !(data = malloc(st.st_size ? st.st_size : 1)))
+            {
+                ret = ESP_ERR_NO_MEM;
+            }
+            if (ret == ESP_OK)
+            {
+                size_t size = fread(data, 1, st.st_size, f);
+                size_t header_size = ir_key_read_header(data, size, NULL);
+                ir_protocol_record_t record;
+                uint8_t protocol = IR_PROTOCOL_UNKNOWN;
+                if (size - header_size == sizeof(record))
+                {
+                    memcpy(&record, data + header_size, sizeof(record));
+                    protocol = record.magic == IR_PROTOCOL_RECORD_MAGIC ? record.frame.protocol : IR_PROTOCOL_UNKNOWN;
+                }
+                ret = ir_db_write(keys[i], data, size, protocol, header_size ? IR_DB_FLAG_CARRIER : 0);
+                ir_db_entry_t db_entry;
+                if (ret == ESP_OK && (ir_db_find(keys[i], &db_entry) != ESP_OK || db_entry.length != size))
+                {
+                    ret = ESP_ERR_INVALID_STATE;
+                }
+            }
+            if (f)
+            {
+                fclose(f);
+            }
+            free(data);
+
+            if (ret == ESP_ERR_INVALID_SIZE)
+            {
+                // Never deleted: set aside as "<key>.bad" so the import doesn't pick it up again
+                char bad_path[IR_KEY_MAX_LEN + 16];
+                snprintf(bad_path, sizeof(bad_path), "/spiffs/%s.bad", keys[i]);
+                unlink(bad_path);
+                ESP_LOGE(TAG, "Can't import %s (%s), kept as %s", filepath, esp_err_to_name(ret), bad_path);
+                if (rename(filepath, bad_path) != 0)
+                {
+                    return;
+                }
+                continue;
+            }
+            if (ret != ESP_OK)
+            {
+                // Kept as a file, tried again at the next boot
+                ESP_LOGE(TAG, "Failed to import %s (%s)", filepath, esp_err_to_name(ret));
+                return;
+            }
+            // The key is in the database the index is built from, see ir_index_init()
+            unlink(filepath);
+            imported++;
+        }
+    }
+    if (imported)
+    {
+        ESP_LOGI(TAG, "Imported %d IR key files into the key database", imported);
+    }
 }
 esp_err_t spiffs_init(void)
 {
@@ -357,6 +756,37 @@ esp_err_t spiffs_init(void)
 
     ESP_LOGI(TAG, "SPIFFS mounted successfully. Total: %d bytes, Used: %d bytes", total_bytes, used_bytes);
 
+    ret = ir_db_init();
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+        // OTA keeps the partition table of the last full flash, the old .ir files stay until it is replaced
+        ESP_LOGE(TAG, "No %s partition: the partition table predates the key database, a full reflash is required "
+                      "(see README). Keys can't be learned or sent until then",
+                 IR_DB_PARTITION_LABEL);
+    }
+    else if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to mount IR key database (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+    else
+    {
+        ir_storage_import_files();
+    }
+
+    // Pack step sequences learned before the .seq format, before indexing their step keys
+    if (ir_seq_migrate() != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Some step sequences could not be packed");
+    }
+
+    ret = ir_index_init();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to build IR key index (%s)", esp_err_to_name(ret));
+        return ret;
+    }
+
     return ESP_OK;
 }
 esp_err_t save_step_timediff_to_file(const char *key_name, const int *timediff_list, size_t count)
@@ -367,77 +797,140 @@ esp_err_t save_step_timediff_to_file(const char *key_name, const int *timediff_l
         return ESP_ERR_INVALID_ARG;
     }
 
-    char filepath[64];
-    snprintf(filepath, sizeof(filepath), "/spiffs/%s.delay", key_name);
+    char filepath[IR_FILE_PATH_MAX];
+    char step_key[IR_KEY_MAX_LEN];
 
-    FILE *f = fopen(filepath, "w");
-    if (!f)
+    /* A packed sequence keeps its delays in the step table, unless it is being learned again */
+    snprintf(step_key, sizeof(step_key), "%s_step1", key_name);
+    if (!ir_db_exists(step_key) && ir_seq_set_delays(key_name, timediff_list, count) == ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to open file for writing: %s", filepath);
-        return ESP_FAIL;
+        ESP_LOGI(TAG, "Saved %d step delays to sequence: %s", count, key_name);
+        return ESP_OK;
     }
 
+    snprintf(filepath, sizeof(filepath), "/spiffs/%s.delay", key_name);
+
+    int32_t delays[IR_STEP_COUNT_MAX];
     for (size_t i = 0; i < count; i++)
     {
-        fprintf(f, "%d\n", timediff_list[i]); // Ghi mỗi delay là 1 dòng số nguyên
+        delays[i] = timediff_list[i];
+    }
+    esp_err_t ret = ir_file_write(filepath, IR_FILE_TYPE_DELAY, delays, count * sizeof(int32_t));
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to save step delays to file: %s", filepath);
+        return ret;
     }
-
-    fclose(f);
     ESP_LOGI(TAG, "Saved %d step delays (int) to file: %s", count, filepath);
     return ESP_OK;
 }
-esp_err_t load_step_timediff_from_file(const char *key_name, int *timediff_list, size_t *count_out)
+/**
+ * @brief Whether a delay file is the text of older firmware: digits, signs and whitespace only.
+ *
+ * A file with a damaged header is binary and must not be taken for one.
+ */
+static bool ir_storage_is_text_delays(FILE *f)
 {
-    if (!key_name || !timediff_list || !count_out)
+    char head[16];
+    size_t len = fread(head, 1, sizeof(head), f);
+    rewind(f);
+    for (size_t i = 0; i < len; i++)
     {
-        ESP_LOGE(TAG, "Invalid arguments to load_step_timediff_from_file");
-        return ESP_ERR_INVALID_ARG;
+        if (!isdigit((unsigned char)head[i]) && !isspace((unsigned char)head[i]) && head[i] != '-')
+        {
+            return false;
+        }
     }
+    return true;
+}
 
-    char filepath[64];
+esp_err_t read_step_timediff_file(const char *key_name, int *timediff_list, size_t *count_out)
+{
+    char filepath[IR_FILE_PATH_MAX];
     snprintf(filepath, sizeof(filepath), "/spiffs/%s.delay", key_name);
 
+    uint8_t *data;
+    size_t size;
+    esp_err_t ret = ir_file_read(filepath, IR_FILE_TYPE_DELAY, &data, &size);
+    if (ret == ESP_OK)
+    {
+        size_t count = MIN(size / sizeof(int32_t), IR_STEP_COUNT_MAX);
+        for (size_t i = 0; i < count; i++)
+        {
+            int32_t delay;
+            memcpy(&delay, data + i * sizeof(int32_t), sizeof(delay));
+            timediff_list[i] = delay;
+        }
+        free(data);
+        *count_out = count;
+        return ESP_OK;
+    }
+    if (ret != ESP_ERR_INVALID_VERSION)
+    {
+        return ret;
+    }
+
+    // Text file of older firmware, one delay per line, rewritten with a header by the next save
     FILE *f = fopen(filepath, "r");
     if (!f)
     {
-        ESP_LOGE(TAG, "Failed to open file for reading: %s", filepath);
-        return ESP_FAIL;
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!ir_storage_is_text_delays(f))
+    {
+        fclose(f);
+        ESP_LOGE(TAG, "%s has a damaged header", filepath);
+        return ret;
     }
-
     size_t count = 0;
-    while (fscanf(f, "%d", &timediff_list[count]) == 1 && count < IR_STEP_COUNT_MAX)
+    while (count < IR_STEP_COUNT_MAX && fscanf(f, "%d", &timediff_list[count]) == 1)
     {
         count++;
     }
-
     fclose(f);
     *count_out = count;
-    ESP_LOGI(TAG, "Loaded %d step delays (int) from file: %s", count, filepath);
+    return ESP_OK;
+}
+esp_err_t load_step_timediff_from_file(const char *key_name, int *timediff_list, size_t *count_out)
+{
+    if (!key_name || !timediff_list || !count_out)
+    {
+        ESP_LOGE(TAG, "Invalid arguments to load_step_timediff_from_file");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (ir_seq_get_delays(key_name, timediff_list, count_out) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Loaded %d step delays from sequence: %s", *count_out, key_name);
+        return ESP_OK;
+    }
+
+    esp_err_t ret = read_step_timediff_file(key_name, timediff_list, count_out);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to read step delays of %s (%s)", key_name, esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Loaded %d step delays (int) from file: %s.delay", *count_out, key_name);
     return ESP_OK;
 }
 
 void print_delays_from_file(const char *key_name)
 {
-    char file_path[64];
-    snprintf(file_path, sizeof(file_path), "/spiffs/%s.delay", key_name);
-
-    FILE *f = fopen(file_path, "r");
-    if (!f)
+    int delays[IR_STEP_COUNT_MAX];
+    size_t count = 0;
+    if (load_step_timediff_from_file(key_name, delays, &count) != ESP_OK)
     {
-        ESP_LOGE("DELAY_PRINT", "Không thể mở file %s để đọc!", file_path);
+        ESP_LOGE("DELAY_PRINT", "Không thể đọc delay của %s!", key_name);
         return;
     }
 
-    int delay, index = 0;
-    ESP_LOGI("DELAY_PRINT", "📂 Danh sách delay trong %s:", file_path);
-    while (fscanf(f, "%d", &delay) == 1)
+    ESP_LOGI("DELAY_PRINT", "📂 Danh sách delay của %s:", key_name);
+    for (size_t index = 0; index < count; index++)
     {
-        ESP_LOGI("DELAY_PRINT", "  Step %d → %d: %d ms", index + 1, index + 2, delay);
-        index++;
+        ESP_LOGI("DELAY_PRINT", "  Step %d → %d: %d ms", index + 1, index + 2, delays[index]);
     }
-
-    fclose(f);
-    ESP_LOGI("DELAY_PRINT", "Tổng cộng %d delay(s) đã đọc", index);
+    ESP_LOGI("DELAY_PRINT", "Tổng cộng %d delay(s) đã đọc", count);
 }
 bool ir_delete_step_from_file(const char *key, int index)
 {
@@ -472,24 +965,42 @@ bool ir_delete_step_from_file(const char *key, int index)
 }
 esp_err_t ir_load_aliases(cJSON **out_aliases)
 {
-    FILE *f = fopen("/spiffs/ir_alias.json", "r");
-    if (!f)
+    uint8_t *buf = NULL;
+    size_t len = 0;
+    esp_err_t ret = ir_file_read(IR_ALIAS_FILE, IR_FILE_TYPE_ALIAS, &buf, &len);
+    if (ret == ESP_ERR_INVALID_VERSION)
+    {
+        // Plain JSON of older firmware, rewritten with a header by the next save
+        ret = ESP_ERR_INVALID_SIZE;
+        FILE *f = fopen(IR_ALIAS_FILE, "r");
+        if (f)
+        {
+            fseek(f, 0, SEEK_END);
+            long file_size = ftell(f);
+            rewind(f);
+            buf = file_size >= 0 && file_size <= IR_FILE_PAYLOAD_MAX ? malloc(file_size + 1) : NULL;
+            if (buf)
+            {
+                len = fread(buf, 1, file_size, f);
+                buf[len] = '\0';
+                ret = ESP_OK;
+            }
+            fclose(f);
+        }
+    }
+    if (ret == ESP_ERR_NOT_FOUND)
     {
         ESP_LOGW("IR_ALIAS", "Không tìm thấy file ánh xạ, tạo mới sau");
         *out_aliases = cJSON_CreateObject(); // Trả về object rỗng
         return ESP_OK;
     }
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE("IR_ALIAS", "File ánh xạ hỏng (%s)", esp_err_to_name(ret));
+        return ret;
+    }
 
-    fseek(f, 0, SEEK_END);
-    long len = ftell(f);
-    rewind(f);
-
-    char *buf = malloc(len + 1);
-    fread(buf, 1, len, f);
-    buf[len] = '\0';
-    fclose(f);
-
-    *out_aliases = cJSON_Parse(buf);
+    *out_aliases = cJSON_Parse((const char *)buf);
     free(buf);
 
     if (!(*out_aliases))
@@ -503,71 +1014,16 @@ esp_err_t ir_load_aliases(cJSON **out_aliases)
 esp_err_t ir_save_aliases(cJSON *aliases)
 {
     char *json_str = cJSON_PrintUnformatted(aliases);
-    FILE *f = fopen("/spiffs/ir_alias.json", "w");
-    if (!f)
+    if (!json_str)
     {
-        ESP_LOGE("IR_ALIAS", "Không thể ghi file alias");
-        free(json_str);
-        return ESP_FAIL;
+        return ESP_ERR_NO_MEM;
     }
 
-    fprintf(f, "%s", json_str);
-    fclose(f);
+    esp_err_t ret = ir_file_write(IR_ALIAS_FILE, IR_FILE_TYPE_ALIAS, json_str, strlen(json_str));
     free(json_str);
-    return ESP_OK;
-}
-
-bool find_original_key_from_match(const struct ir_learn_sub_list_head *result, char *out_original_key)
-{
-    ESP_LOGI("IR_MATCH", "Bắt đầu tìm ánh xạ cho tín hiệu IR đã học...");
-
-    cJSON *aliases = NULL;
-    if (ir_load_aliases(&aliases) != ESP_OK || !aliases) {
-        ESP_LOGW("IR_MATCH", "Không thể load alias từ file");
-        return false;
-    }
-
-    cJSON *entry = aliases->child;
-    while (entry)
+    if (ret != ESP_OK)
     {
-        const char *original_full = entry->string;              // "white.ir"
-        const char *mapped_full = cJSON_GetStringValue(entry);  // "toggle.ir"
-
-        if (original_full && mapped_full)
-        {
-            char original_key[IR_KEY_MAX_LEN];
-            char mapped_key[IR_KEY_MAX_LEN];
-            
-            strncpy(original_key, original_full, IR_KEY_MAX_LEN);
-            strncpy(mapped_key, mapped_full, IR_KEY_MAX_LEN);
-            original_key[IR_KEY_MAX_LEN - 1] = '\0';
-            mapped_key[IR_KEY_MAX_LEN - 1] = '\0';
-
-            // Cắt đuôi .ir nếu tồn tại
-            char *dot = strstr(original_key, ".ir");
-            if (dot) *dot = '\0';
-            dot = strstr(mapped_key, ".ir");
-            if (dot) *dot = '\0';
-
-            ESP_LOGI("IR_MATCH", "Kiểm tra alias: \"%s\" → \"%s\"", original_key, mapped_key);
-
-            if (match_ir_with_key(result, mapped_key, NULL))
-            {
-                strncpy(out_original_key, original_key, IR_KEY_MAX_LEN);
-                ESP_LOGI("IR_MATCH", "✅ Khớp với alias: %s", original_key);
-                cJSON_Delete(aliases);
-                return true;
-            }
-        }
-        else
-        {
-            ESP_LOGW("IR_MATCH", "Alias không hợp lệ: key hoặc value null");
-        }
-
-        entry = entry->next;
+        ESP_LOGE("IR_ALIAS", "Không thể ghi file alias");
     }
-
-    ESP_LOGW("IR_MATCH", "❌ Không khớp với alias nào.");
-    cJSON_Delete(aliases);
-    return false;
-}
\ No newline at end of file
+    return ret;
+}
@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "nvs_flash.h"
 #include "esp_console.h"
 #include "argtable3/argtable3.h"
@@ -14,8 +17,12 @@
 #include "ir_learn.h"
 #include "ir_config.h"
 #include "ir_storage.h"
+#include "ir_index.h"
+#include "ir_rx.h"
+#include "ir_hold.h"
+#include "ir_db.h"
+#include "ir_cache.h"
 
-extern QueueHandle_t ir_learn_queue;
 extern QueueHandle_t ir_trans_queue;
 extern ir_learn_common_param_t *learn_param; // Pointer to the IR learn parameters
 extern bool light_flag;
@@ -37,24 +44,59 @@ typedef struct
 
 static rename_args_t rename_args;
 
+static struct
+{
+    struct arg_str *key;
+    struct arg_int *samples;
+    struct arg_int *timeout;
+    struct arg_end *end;
+} learn_args;
+
 static int ir_learn_cmd(int argc, char **argv)
 {
-    int nerrors = arg_parse(argc, argv, (void **)&ir_key_args);
+    int nerrors = arg_parse(argc, argv, (void **)&learn_args);
     if (nerrors != 0)
     {
-        arg_print_errors(stderr, ir_key_args.end, argv[0]);
+        arg_print_errors(stderr, learn_args.end, argv[0]);
+        return 1;
+    }
+
+    int samples = learn_args.samples->count ? learn_args.samples->ival[0] : 0;
+    if (samples < 0 || samples > IR_LEARN_ACC_SAMPLES_MAX)
+    {
+        ESP_LOGE(TAG, "Presses must be between 1 and %d", IR_LEARN_ACC_SAMPLES_MAX);
+        return 1;
+    }
+
+    int timeout_ms = learn_args.timeout->count ? learn_args.timeout->ival[0] : 0;
+    if (timeout_ms < 0)
+    {
+        ESP_LOGE(TAG, "Deadline can't be negative");
         return 1;
     }
 
     ir_event_cmd_t IR_cmd = {
         .event = IR_EVENT_LEARN_NORMAL,
+        .learn_count = samples,
+        .timeout_ms = timeout_ms,
     };
-    strncpy(IR_cmd.key, ir_key_args.key->sval[0], sizeof(IR_cmd.key));
-    xQueueSend(ir_learn_queue, &IR_cmd, portMAX_DELAY);
-    ESP_LOGI(TAG, "IR learn command for key: %s", ir_key_args.key->sval[0]);
+    strncpy(IR_cmd.key, learn_args.key->sval[0], sizeof(IR_cmd.key));
+    ir_learn_post_event(&IR_cmd, portMAX_DELAY);
+    ESP_LOGI(TAG, "IR learn command for key: %s, %d presses", learn_args.key->sval[0], samples ? samples : IR_LEARN_COUNT);
 
     return 0;
 }
+static int ir_learn_cancel_cmd(int argc, char **argv)
+{
+    esp_err_t ret = ir_learn_cancel();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to cancel learning: %s", esp_err_to_name(ret));
+        return 1;
+    }
+    ESP_LOGI(TAG, "IR learn cancel requested");
+    return 0;
+}
 static int ir_learn_step_cmd(int argc, char **argv)
 {
     int nerrors = arg_parse(argc, argv, (void **)&ir_key_args);
@@ -68,7 +110,7 @@ static int ir_learn_step_cmd(int argc, char **argv)
         .event = IR_EVENT_LEARN_STEP,
     };
     strncpy(IR_cmd.key_name_step, ir_key_args.key->sval[0], sizeof(IR_cmd.key_name_step));
-    xQueueSend(ir_learn_queue, &IR_cmd, portMAX_DELAY);
+    ir_learn_post_event(&IR_cmd, portMAX_DELAY);
     ESP_LOGI(TAG, "IR learn step with name: %s", ir_key_args.key->sval[0]);
 
     return 0;
@@ -83,7 +125,8 @@ static int ir_trans_cmd(int argc, char **argv)
     }
 
     ir_event_cmd_t IR_cmd = {
-        .event = IR_EVENT_TRANSMIT};
+        .event = IR_EVENT_TRANSMIT,
+        .request_time = esp_timer_get_time()};
     strncpy(IR_cmd.key, ir_key_args.key->sval[0], sizeof(IR_cmd.key));
     xQueueSend(ir_trans_queue, &IR_cmd, portMAX_DELAY);
     ESP_LOGI(TAG, "IR transmit command send for key: %s", ir_key_args.key->sval[0]);
@@ -100,7 +143,8 @@ static int ir_send_step_cmd(int argc, char **argv)
     }
 
     ir_event_cmd_t IR_cmd = {
-        .event = IR_EVENT_SEND_STEP};
+        .event = IR_EVENT_SEND_STEP,
+        .request_time = esp_timer_get_time()};
     strncpy(IR_cmd.key_name_step, ir_key_args.key->sval[0], sizeof(IR_cmd.key_name_step));
     xQueueSend(ir_trans_queue, &IR_cmd, portMAX_DELAY);
     ESP_LOGI(TAG, "IR transmit step for key name: %s", ir_key_args.key->sval[0]);
@@ -206,6 +250,71 @@ static int print_delay_from_spiffs(int argc, char **argv)
     return 0;
 }
 
+static int ir_tx_stats_cmd(int argc, char **argv)
+{
+    ir_tx_stats_t stats;
+    ir_tx_get_stats(&stats);
+
+    uint32_t warm_sends = stats.sends - stats.cold_sends;
+    printf("sends: %" PRIu32 " (cold: %" PRIu32 "), frames: %" PRIu32 ", power-ups: %" PRIu32 ", carrier changes: %" PRIu32 "\n",
+           stats.sends, stats.cold_sends, stats.frames, stats.power_ups, stats.carrier_changes);
+    printf("latency first: %" PRIu32 " us, last: %" PRIu32 " us, warm avg: %" PRIu32 " us, warm max: %" PRIu32 " us, cold max: %" PRIu32 " us\n",
+           stats.first_latency_us, stats.last_latency_us, warm_sends ? (uint32_t)(stats.warm_total_latency_us / warm_sends) : 0,
+           stats.warm_max_latency_us, stats.cold_max_latency_us);
+    printf("step sequences: %" PRIu32 ", jitter max last: %" PRIu32 " us, max: %" PRIu32 " us\n",
+           stats.step_sequences, stats.step_last_max_jitter_us, stats.step_max_jitter_us);
+    return 0;
+}
+
+static int ir_mem_stats_cmd(int argc, char **argv)
+{
+    ir_learn_mem_stats_t stats;
+    ir_learn_get_mem_stats(&stats);
+
+    size_t free_size = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    printf("heap free: %u, min free: %u, largest block: %u, fragmentation: %u%%\n",
+           free_size, heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT), largest_block,
+           free_size ? 100 - (unsigned)(largest_block * 100ULL / free_size) : 0);
+    printf("sub-frames: %" PRIu32 ", chunk allocs: %" PRIu32 ", frees: %" PRIu32 ", live: %" PRIu32 ", failed: %" PRIu32 "\n",
+           stats.nodes, stats.chunk_allocs, stats.chunk_frees, stats.chunk_allocs - stats.chunk_frees, stats.failed_allocs);
+    printf("arena bytes live: %" PRIu32 ", peak: %" PRIu32 "\n", stats.live_bytes, stats.peak_bytes);
+    return 0;
+}
+
+static int ir_match_stats_cmd(int argc, char **argv)
+{
+    ir_index_match_stats_t stats;
+    ir_index_get_match_stats(&stats);
+
+    uint32_t candidates = stats.candidates ? stats.candidates : 1;
+    printf("lookups: %" PRIu32 ", keys: %u, avg: %" PRIu32 " us, max: %" PRIu32 " us\n", stats.lookups, ir_index_count(),
+           stats.lookups ? (uint32_t)(stats.total_us / stats.lookups) : 0, stats.max_us);
+    printf("candidates: %" PRIu32 ", header rejects: %" PRIu32 " (%" PRIu32 "%%), preamble rejects: %" PRIu32 " (%" PRIu32 "%%)\n",
+           stats.candidates, stats.header_rejects, stats.header_rejects * 100 / candidates,
+           stats.preamble_rejects, stats.preamble_rejects * 100 / candidates);
+    printf("full compares: %" PRIu32 " (%" PRIu32 "%%), matches: %" PRIu32 ", canonical hash hits: %" PRIu32 "\n",
+           stats.full_compares, stats.full_compares * 100 / candidates, stats.matches, stats.canon_hits);
+    return 0;
+}
+
+static int ir_rx_stats_cmd(int argc, char **argv)
+{
+    ir_rx_stats_t stats;
+    ir_rx_get_stats(&stats);
+
+    printf("frames: %" PRIu32 ", monitored: %" PRIu32 ", queue drops: %" PRIu32 ", overruns: %" PRIu32 ", re-arm failures: %" PRIu32 ", flushed: %" PRIu32 "\n",
+           stats.frames, stats.monitored, stats.queue_drops, stats.overruns, stats.rearm_failures, stats.flushed);
+    printf("buffers: %d, in use: %u, high water: %u\n", IR_RX_BUFFER_COUNT, stats.buffers_in_use, stats.high_water);
+    printf("longest frame: %u symbols, truncated frames: %" PRIu32 "\n", stats.max_symbols, stats.truncated);
+
+    ir_hold_stats_t hold;
+    ir_hold_get_stats(&hold);
+    printf("presses: %" PRIu32 ", repeats: %" PRIu32 ", held events: %" PRIu32 ", orphan repeats: %" PRIu32 ", longest hold: %u\n",
+           hold.presses, hold.repeats, hold.held_events, hold.orphan_repeats, hold.longest_hold);
+    return 0;
+}
+
 void register_ir_reset_nvs_commands(void)
 {
     /* Register custom commands here */
@@ -275,17 +384,27 @@ void register_ir_delete_commands(void)
 }
 void register_ir_learn_commands(void)
 {
-    ir_key_args.key = arg_str1(NULL, NULL, "<Name for ir learn cmd>", "Input name for ir learn key command");
-    ir_key_args.end = arg_end(1);
+    learn_args.key = arg_str1(NULL, NULL, "<Name for ir learn cmd>", "Input name for ir learn key command");
+    learn_args.samples = arg_int0("n", "presses", "<K>", "Presses to learn from, default CONFIG_IR_LEARN_SAMPLES");
+    learn_args.timeout = arg_int0("t", "timeout", "<ms>", "Deadline of the session, default CONFIG_IR_LEARN_TIMEOUT_MS");
+    learn_args.end = arg_end(3);
     /* Register custom commands here */
     esp_console_cmd_t learn_cmd = {
         .command = "learn",
         .help = "Set name for IR learn command",
         .hint = NULL,
         .func = &ir_learn_cmd,
-        .argtable = &ir_key_args};
+        .argtable = &learn_args};
 
     ESP_ERROR_CHECK(esp_console_cmd_register(&learn_cmd));
+
+    esp_console_cmd_t learn_cancel_cmd = {
+        .command = "learn_cancel",
+        .help = "Cancel the IR learn session in progress",
+        .hint = NULL,
+        .func = &ir_learn_cancel_cmd,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&learn_cancel_cmd));
 }
 void register_ir_learn_step_commands(void)
 {
@@ -354,4 +473,147 @@ void register_ir_print_delay_commands(void)
         .argtable = &ir_key_args};
 
     ESP_ERROR_CHECK(esp_console_cmd_register(&print_delay_cmd));
-}
\ No newline at end of file
+}
+static struct
+{
+    struct arg_lit *compact;
+    struct arg_end *end;
+} db_stats_args;
+
+static int ir_db_stats_cmd(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&db_stats_args);
+    if (nerrors != 0)
+    {
+        arg_print_errors(stderr, db_stats_args.end, argv[0]);
+        return 1;
+    }
+
+    if (db_stats_args.compact->count)
+    {
+        int64_t start = esp_timer_get_time();
+        esp_err_t ret = ir_db_compact();
+        printf("compaction: %s, %" PRId64 " us\n", esp_err_to_name(ret), esp_timer_get_time() - start);
+    }
+
+    ir_db_stats_t stats;
+    ir_db_get_stats(&stats);
+    printf("keys: %u, size: %" PRIu32 ", used: %" PRIu32 ", live: %" PRIu32 ", dead: %" PRIu32 ", free: %" PRIu32 "\n",
+           stats.keys, stats.size, stats.used, stats.live, stats.used - stats.live, stats.free);
+    printf("appends: %" PRIu32 ", relocated: %" PRIu32 ", sector erases: %" PRIu32 ", compactions: %" PRIu32 ", boot scan: %" PRIu32 " us\n",
+           stats.appends, stats.relocated, stats.erases, stats.gc_runs, stats.scan_us);
+    printf("mapped: %s, views held: %u, corrupt records dropped: %u\n", stats.mapped ? "yes" : "no", stats.views, stats.corrupt);
+    return 0;
+}
+
+static struct
+{
+    struct arg_lit *flush;
+    struct arg_end *end;
+} cache_stats_args;
+
+static int ir_cache_stats_cmd(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **)&cache_stats_args);
+    if (nerrors != 0)
+    {
+        arg_print_errors(stderr, cache_stats_args.end, argv[0]);
+        return 1;
+    }
+
+    if (cache_stats_args.flush->count)
+    {
+        ir_cache_flush_usage();
+    }
+
+    ir_cache_stats_t stats;
+    ir_tx_stats_t tx_stats;
+    ir_cache_get_stats(&stats);
+    ir_tx_get_stats(&tx_stats);
+    // ready_us is the end of the warm-up in ir_task_start(), the first press latency is request to first edge
+    printf("warm-up done: %" PRIu32 " ms after boot, took: %" PRIu32 " ms, first press latency: %" PRIu32 " us%s\n",
+           stats.ready_us / 1000, stats.warm_us / 1000, tx_stats.first_latency_us, tx_stats.sends ? "" : " (no press yet)");
+    printf("entries: %u / %d (%u prefetched), bytes: %" PRIu32 " / %" PRIu32 "\n",
+           stats.entries, IR_CACHE_KEYS, stats.prefetched, stats.bytes, stats.budget);
+    printf("hits: %" PRIu32 ", misses: %" PRIu32 ", refills: %" PRIu32 ", keys tracked: %u\n",
+           stats.hits, stats.misses, stats.refills, stats.tracked);
+
+    ir_cache_usage_t usage[IR_CACHE_USAGE_MAX];
+    size_t count = ir_cache_get_usage(usage, IR_CACHE_USAGE_MAX);
+    for (size_t i = 0; i < count && i < 10; i++)
+    {
+        printf("  %08" PRIx32 " %s: %u\n", usage[i].key_hash, usage[i].kind == IR_CACHE_KIND_SEQ ? "seq" : "key", usage[i].count);
+    }
+    return 0;
+}
+
+void register_ir_tx_stats_commands(void)
+{
+    esp_console_cmd_t tx_stats_cmd = {
+        .command = "tx_stats",
+        .help = "Print IR TX engine statistics",
+        .hint = NULL,
+        .func = &ir_tx_stats_cmd,
+        .argtable = NULL};
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&tx_stats_cmd));
+}
+void register_ir_mem_stats_commands(void)
+{
+    esp_console_cmd_t mem_stats_cmd = {
+        .command = "mem_stats",
+        .help = "Print heap fragmentation and IR list allocation statistics",
+        .hint = NULL,
+        .func = &ir_mem_stats_cmd,
+        .argtable = NULL};
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&mem_stats_cmd));
+}
+void register_ir_match_stats_commands(void)
+{
+    esp_console_cmd_t match_stats_cmd = {
+        .command = "match_stats",
+        .help = "Print IR matcher statistics: rejects per stage and time per lookup",
+        .hint = NULL,
+        .func = &ir_match_stats_cmd,
+        .argtable = NULL};
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&match_stats_cmd));
+}
+void register_ir_rx_stats_commands(void)
+{
+    esp_console_cmd_t rx_stats_cmd = {
+        .command = "rx_stats",
+        .help = "Print IR RX engine statistics",
+        .hint = NULL,
+        .func = &ir_rx_stats_cmd,
+        .argtable = NULL};
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&rx_stats_cmd));
+}
+void register_ir_db_stats_commands(void)
+{
+    db_stats_args.compact = arg_lit0("c", "compact", "Compact the whole key database first");
+    db_stats_args.end = arg_end(1);
+    esp_console_cmd_t db_stats_cmd = {
+        .command = "db_stats",
+        .help = "Print key database usage and compaction statistics",
+        .hint = NULL,
+        .func = &ir_db_stats_cmd,
+        .argtable = &db_stats_args};
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&db_stats_cmd));
+}
+void register_ir_cache_stats_commands(void)
+{
+    cache_stats_args.flush = arg_lit0("f", "flush", "Save the key usage to NVS first");
+    cache_stats_args.end = arg_end(1);
+    esp_console_cmd_t cache_stats_cmd = {
+        .command = "cache_stats",
+        .help = "Print boot time-to-ready, first press latency, key cache usage and the most used keys",
+        .hint = NULL,
+        .func = &ir_cache_stats_cmd,
+        .argtable = &cache_stats_args};
+
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cache_stats_cmd));
+}
@@ -0,0 +1,29 @@
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "unity.h"
+#include "unity_test_runner.h"
+
+#include "espnow_config.h"
+#include "driver_config.h"
+
+/* Globals of app_ir.c, app_espnow.c and app_driver.c used by the IR sources */
+QueueHandle_t ir_trans_queue = NULL;
+QueueHandle_t ir_learn_queue = NULL;
+remote_state_t remote_state = REMOTE_STATE_IDLE;
+
+void send_data_to_screen(const char *cmd, const char *model)
+{
+}
+
+void set_relay_state()
+{
+}
+
+void app_main(void)
+{
+    printf("IR learn test app\n");
+    unity_run_menu();
+}
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+
+#include "esp_random.h"
+#include "unity.h"
+
+#include "ir_carrier.h"
+
+#define TEST_CARRIER_BURSTS 8
+#define TEST_CARRIER_JITTER_TICKS 5
+#define TEST_CARRIER_SYMBOLS 64
+
+/**
+ * @brief Capture of a carrier burst as the RMT channel reports it: cut at a random phase, one symbol per pulse.
+ */
+static size_t test_carrier_burst(rmt_symbol_word_t *symbols, size_t max_symbols, uint32_t frequency_hz,
+                                 uint16_t duty_permille, int jitter_ticks)
+{
+    uint32_t period = (IR_CARRIER_RESOLUTION_HZ * 10 / frequency_hz + 5) / 10;
+    uint32_t on = period * duty_permille / 1000;
+    size_t n = 0;
+
+    /* Captures start on any edge, the first pulse is usually cut */
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 1 + esp_random() % on, .level1 = 0, .duration1 = period - on};
+    /* Fractional periods make the edges drift against the capture clock, as on the real input */
+    uint32_t phase = 0;
+    while (n < max_symbols)
+    {
+        uint32_t ticks = IR_CARRIER_RESOLUTION_HZ / frequency_hz;
+        phase += IR_CARRIER_RESOLUTION_HZ % frequency_hz;
+        if (phase >= frequency_hz)
+        {
+            phase -= frequency_hz;
+            ticks++;
+        }
+        int shift = jitter_ticks ? (int)(esp_random() % (2 * jitter_ticks + 1)) - jitter_ticks : 0;
+        symbols[n++] = (rmt_symbol_word_t){
+            .level0 = 1,
+            .duration0 = on + shift,
+            .level1 = 0,
+            .duration1 = ticks - on - shift,
+        };
+        /* Ringing on an edge, one in 16 pulses */
+        if (esp_random() % 16 == 0 && n < max_symbols)
+        {
+            symbols[n - 1].duration1 -= 3;
+            symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 2, .level1 = 0, .duration1 = 1};
+        }
+    }
+    /* The last space is the idle end of the burst */
+    symbols[n - 1].duration1 = 0;
+    return n;
+}
+
+TEST_CASE("carrier frequency and duty are measured from jittered bursts", "[ir][carrier]")
+{
+    static const uint32_t frequencies[] = {30000, 33000, 36000, 38000, 40000, 45500, 56000};
+    static const uint16_t duties[] = {250, 330, 500};
+    rmt_symbol_word_t symbols[TEST_CARRIER_SYMBOLS];
+
+    for (int f = 0; f < sizeof(frequencies) / sizeof(frequencies[0]); f++)
+    {
+        for (int d = 0; d < sizeof(duties) / sizeof(duties[0]); d++)
+        {
+            ir_carrier_acc_t acc = {0};
+            for (int b = 0; b < TEST_CARRIER_BURSTS; b++)
+            {
+                size_t n = test_carrier_burst(symbols, TEST_CARRIER_SYMBOLS, frequencies[f], duties[d], TEST_CARRIER_JITTER_TICKS);
+                ir_carrier_accumulate(&acc, symbols, n, IR_CARRIER_RESOLUTION_HZ);
+            }
+
+            ir_carrier_t carrier;
+            TEST_ASSERT_EQUAL(ESP_OK, ir_carrier_estimate(&acc, IR_CARRIER_RESOLUTION_HZ, &carrier));
+            /* Common carriers must snap exactly, others within 1%; the duty within 2% of the period */
+            if (frequencies[f] % 1000 == 0)
+            {
+                TEST_ASSERT_EQUAL_UINT32(frequencies[f], carrier.frequency_hz);
+            }
+            else
+            {
+                TEST_ASSERT_UINT32_WITHIN(frequencies[f] / 100, frequencies[f], carrier.frequency_hz);
+            }
+            TEST_ASSERT_INT_WITHIN(20, duties[d], carrier.duty_permille);
+        }
+    }
+}
+
+TEST_CASE("carrier estimate refuses a capture without pulses", "[ir][carrier]")
+{
+    ir_carrier_acc_t acc = {0};
+    ir_carrier_t carrier;
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, ir_carrier_estimate(&acc, IR_CARRIER_RESOLUTION_HZ, &carrier));
+}
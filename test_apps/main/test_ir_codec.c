@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_random.h"
+#include "unity.h"
+
+#include "ir_codec.h"
+#include "ir_learn.h"
+#include "ir_normalize.h"
+#include "ir_protocol.h"
+
+#define TEST_CODEC_SIGNALS 6
+#define TEST_CODEC_MAX_SYMBOLS 300
+
+/**
+ * @brief Build one signal of the codec corpus, the way the learn path stores it.
+ *
+ * 0-3: NEC, Samsung, Sony and RC5 frames, 4: air-conditioner state frame,
+ * 5: irregular raw signal with 40 us of jitter.
+ */
+static const char *test_codec_build(int index, struct ir_learn_sub_list_head *list)
+{
+    static const ir_protocol_frame_t frames[] = {
+        {.protocol = IR_PROTOCOL_NEC, .bits = 32, .address = 0x04, .command = 0x08},
+        {.protocol = IR_PROTOCOL_SAMSUNG, .bits = 32, .address = 0x0707, .command = 0x02},
+        {.protocol = IR_PROTOCOL_SONY, .bits = 12, .address = 0x01, .command = 0x15},
+        {.protocol = IR_PROTOCOL_RC5, .bits = 14, .address = 0x00, .command = 0x0C},
+    };
+    static const char *names[] = {"NEC", "Samsung", "Sony", "RC5", "AC", "raw"};
+    static rmt_symbol_word_t symbols[TEST_CODEC_MAX_SYMBOLS];
+    static rmt_symbol_word_t frame[TEST_CODEC_MAX_SYMBOLS];
+    size_t n = 0;
+    int repeats = 2;
+
+    if (index < sizeof(frames) / sizeof(frames[0]))
+    {
+        n = ir_protocol_build(&frames[index], symbols, IR_PROTOCOL_FRAME_MAX_SYMBOLS);
+    }
+    else if (index == 4)
+    {
+        /* 3.5 ms leader and 280 bits of state, each bit a 450 us mark and a 420 or 1280 us space */
+        symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 3500, .level1 = 0, .duration1 = 1750};
+        while (n < 281)
+        {
+            bool one = esp_random() & 1;
+            symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 450, .level1 = 0, .duration1 = one ? 1280 : 420};
+        }
+        symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 450, .level1 = 0, .duration1 = 0};
+        repeats = 1;
+    }
+    else
+    {
+        while (n < 100)
+        {
+            symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 200 + esp_random() % 2000,
+                                               .level1 = 0, .duration1 = 200 + esp_random() % 4000};
+        }
+        symbols[n - 1].duration1 = 0;
+    }
+
+    for (int r = 0; r < repeats; r++)
+    {
+        memcpy(frame, symbols, n * sizeof(rmt_symbol_word_t));
+        for (size_t i = 0; index == 5 && i < n; i++)
+        {
+            frame[i].duration0 += esp_random() % 81 - 40;
+            frame[i].duration1 = frame[i].duration1 ? frame[i].duration1 + esp_random() % 81 - 40 : 0;
+        }
+        rmt_rx_done_event_data_t data = {.received_symbols = frame, .num_symbols = n};
+        TEST_ASSERT_EQUAL(ESP_OK, ir_learn_add_sub_list_node(list, r ? 40000 : 0, &data));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, ir_normalize_list(list, NULL));
+    return names[index];
+}
+
+static void test_codec_assert_equal(const struct ir_learn_sub_list_head *expected, const struct ir_learn_sub_list_head *actual,
+                                    const char *name)
+{
+    const struct ir_learn_sub_list_t *sub_e = SLIST_FIRST(expected);
+    const struct ir_learn_sub_list_t *sub_a = SLIST_FIRST(actual);
+    for (; sub_e && sub_a; sub_e = SLIST_NEXT(sub_e, next), sub_a = SLIST_NEXT(sub_a, next))
+    {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(sub_e->timediff, sub_a->timediff, name);
+        TEST_ASSERT_EQUAL_MESSAGE(sub_e->symbols.num_symbols, sub_a->symbols.num_symbols, name);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(sub_e->symbols.received_symbols, sub_a->symbols.received_symbols,
+                                         sub_e->symbols.num_symbols * sizeof(rmt_symbol_word_t), name);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(!sub_e && !sub_a, name);
+}
+
+TEST_CASE("encoded keys decode to the stored symbols, regular ones in half the size", "[ir][codec]")
+{
+    for (int s = 0; s < TEST_CODEC_SIGNALS; s++)
+    {
+        struct ir_learn_sub_list_head list;
+        struct ir_learn_sub_list_head decoded;
+        ir_learn_init_sub_list(&list);
+        ir_learn_init_sub_list(&decoded);
+        const char *name = test_codec_build(s, &list);
+
+        size_t raw_size = 0;
+        const struct ir_learn_sub_list_t *sub_it;
+        SLIST_FOREACH(sub_it, &list, next)
+        {
+            raw_size += 2 * sizeof(uint32_t) + sub_it->symbols.num_symbols * sizeof(rmt_symbol_word_t);
+        }
+
+        uint8_t mode = 0;
+        size_t size = ir_codec_encode(&list, NULL, 0, &mode);
+        TEST_ASSERT_NOT_EQUAL(0, size);
+        uint8_t *data = malloc(size);
+        TEST_ASSERT_NOT_NULL(data);
+        TEST_ASSERT_EQUAL_MESSAGE(size, ir_codec_encode(&list, data, size, NULL), name);
+        TEST_ASSERT_EQUAL_MESSAGE(ESP_OK, ir_codec_decode(data, size, &decoded), name);
+        test_codec_assert_equal(&list, &decoded, name);
+        printf("%-8s %d -> %d bytes, %s\n", name, raw_size, size, mode == IR_CODEC_MODE_DICT ? "dict" : "delta");
+        if (s < TEST_CODEC_SIGNALS - 1)
+        {
+            /* Regular signals pack into a dictionary at less than half their raw size */
+            TEST_ASSERT_EQUAL_MESSAGE(IR_CODEC_MODE_DICT, mode, name);
+            TEST_ASSERT_LESS_THAN_MESSAGE(raw_size / 2, size, name);
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_MESSAGE(IR_CODEC_MODE_DELTA, mode, name);
+        }
+
+        /* Every truncation must be rejected, and leave nothing behind */
+        for (size_t cut = 0; cut < size; cut++)
+        {
+            struct ir_learn_sub_list_head truncated;
+            ir_learn_init_sub_list(&truncated);
+            TEST_ASSERT_NOT_EQUAL_MESSAGE(ESP_OK, ir_codec_decode(data, cut, &truncated), name);
+            TEST_ASSERT_TRUE_MESSAGE(SLIST_EMPTY(&truncated), name);
+            ir_learn_clean_sub_data(&truncated);
+        }
+
+        free(data);
+        ir_learn_clean_sub_data(&list);
+        ir_learn_clean_sub_data(&decoded);
+    }
+}
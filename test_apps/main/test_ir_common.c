@@ -0,0 +1,16 @@
+#include <stdbool.h>
+
+#include "unity.h"
+
+#include "ir_storage.h"
+#include "test_ir_common.h"
+
+void test_ir_mount_storage(void)
+{
+    static bool s_mounted;
+    if (!s_mounted)
+    {
+        TEST_ASSERT_EQUAL(ESP_OK, spiffs_init());
+        s_mounted = true;
+    }
+}
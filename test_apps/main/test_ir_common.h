@@ -0,0 +1,15 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Mount SPIFFS and the key database once for every test case of the run.
+ */
+void test_ir_mount_storage(void);
+
+#ifdef __cplusplus
+}
+#endif
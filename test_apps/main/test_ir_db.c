@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "ir_db.h"
+#include "test_ir_common.h"
+
+#define TEST_DB_KEYS 40
+#define TEST_DB_DELETED 1000
+
+static int s_seen[2 * TEST_DB_KEYS];
+static int s_steps;
+
+static void test_db_name(char *name, int index)
+{
+    snprintf(name, 16, "test_db_%d", index);
+}
+
+/**
+ * @brief Change the database under the walk: delete a key, add one, rewrite the current one.
+ */
+static bool test_db_visit(const char *key, const ir_db_entry_t *entry, void *arg)
+{
+    static const uint8_t data[24] = {1};
+    char name[16];
+    int index;
+    if (sscanf(key, "test_db_%d", &index) != 1)
+    {
+        return true;
+    }
+    s_seen[index]++;
+    if (index >= TEST_DB_KEYS)
+    {
+        return true;
+    }
+
+    int victim = (index * 7 + 3) % TEST_DB_KEYS;
+    test_db_name(name, victim);
+    if (victim != index && ir_db_delete(name) == ESP_OK)
+    {
+        s_seen[victim] += TEST_DB_DELETED;
+    }
+    if (s_steps < TEST_DB_KEYS)
+    {
+        test_db_name(name, TEST_DB_KEYS + s_steps++);
+        TEST_ASSERT_EQUAL(ESP_OK, ir_db_write(name, data, sizeof(data), 0, 0));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, ir_db_write(key, data, sizeof(data), 0, 0));
+    return true;
+}
+
+TEST_CASE("key walk visits every key once while keys are added and deleted", "[ir][db]")
+{
+    static const uint8_t data[24] = {0};
+    char name[16];
+
+    test_ir_mount_storage();
+    memset(s_seen, 0, sizeof(s_seen));
+    s_steps = 0;
+    for (int i = 0; i < TEST_DB_KEYS; i++)
+    {
+        test_db_name(name, i);
+        TEST_ASSERT_EQUAL(ESP_OK, ir_db_write(name, data, sizeof(data), 0, 0));
+    }
+
+    ir_db_foreach(test_db_visit, NULL);
+
+    /* Keys present for the whole walk are visited once, deleted ones at most once */
+    for (int i = 0; i < TEST_DB_KEYS; i++)
+    {
+        if (s_seen[i] < TEST_DB_DELETED)
+        {
+            TEST_ASSERT_EQUAL_MESSAGE(1, s_seen[i], "key skipped or repeated");
+        }
+        else
+        {
+            TEST_ASSERT_LESS_OR_EQUAL(1, s_seen[i] - TEST_DB_DELETED);
+        }
+    }
+
+    for (int i = 0; i < 2 * TEST_DB_KEYS; i++)
+    {
+        test_db_name(name, i);
+        ir_db_delete(name);
+    }
+}
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_rom_crc.h"
+#include "unity.h"
+
+#include "ir_config.h"
+#include "ir_file.h"
+#include "ir_storage.h"
+#include "test_ir_common.h"
+
+#define TEST_FILE_PATH "/spiffs/file_test.bin"
+#define TEST_DELAY_KEY "test_legacy"
+#define TEST_DELAY_PATH "/spiffs/" TEST_DELAY_KEY ".delay"
+
+static void test_file_put(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(size, fwrite(data, 1, size, f));
+    TEST_ASSERT_EQUAL(0, fclose(f));
+}
+
+/**
+ * @brief Read the test file, true if it gives back exactly the expected payload.
+ */
+static bool test_file_read(uint16_t type, const uint8_t *expected, size_t expected_size, esp_err_t *ret_out)
+{
+    uint8_t *data = NULL;
+    size_t size = 0;
+    *ret_out = ir_file_read(TEST_FILE_PATH, type, &data, &size);
+    bool same = *ret_out == ESP_OK && size == expected_size && memcmp(data, expected, size) == 0;
+    free(data);
+    return same;
+}
+
+/**
+ * @brief Cut the write of a new version at every byte offset, and flip every bit of a written file.
+ */
+static void test_file_run(uint16_t type, const uint8_t *old_data, size_t old_size, const uint8_t *new_data, size_t new_size)
+{
+    char tmp_path[IR_FILE_PATH_MAX];
+    char message[48];
+    TEST_ASSERT_EQUAL(ESP_OK, ir_file_tmp_path(TEST_FILE_PATH, tmp_path, sizeof(tmp_path)));
+
+    /* The image ir_file_write() puts in the temporary file */
+    size_t image_size = sizeof(ir_file_header_t) + new_size;
+    uint8_t *image = malloc(image_size);
+    TEST_ASSERT_NOT_NULL(image);
+    ir_file_header_t header = {
+        .magic = IR_FILE_MAGIC,
+        .version = IR_FILE_VERSION,
+        .type = type,
+        .length = new_size,
+        .crc = esp_rom_crc32_le(0, new_data, new_size),
+    };
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + sizeof(header), new_data, new_size);
+
+    esp_err_t ret;
+    for (size_t cut = 0; cut <= image_size; cut++)
+    {
+        /* Cut while the temporary file is written: the old version is read */
+        unlink(tmp_path);
+        TEST_ASSERT_EQUAL(ESP_OK, ir_file_write(TEST_FILE_PATH, type, old_data, old_size));
+        test_file_put(tmp_path, image, cut);
+        snprintf(message, sizeof(message), "cut %d of the temporary file", cut);
+        TEST_ASSERT_TRUE_MESSAGE(test_file_read(type, old_data, old_size, &ret), message);
+
+        /* Cut after the old version was removed: the new version if the temporary file is whole, none otherwise */
+        unlink(TEST_FILE_PATH);
+        test_file_put(tmp_path, image, cut);
+        snprintf(message, sizeof(message), "cut %d after the removal", cut);
+        if (cut == image_size)
+        {
+            TEST_ASSERT_TRUE_MESSAGE(test_file_read(type, new_data, new_size, &ret), message);
+        }
+        else
+        {
+            TEST_ASSERT_FALSE_MESSAGE(test_file_read(type, new_data, new_size, &ret), message);
+            TEST_ASSERT_EQUAL_MESSAGE(ESP_ERR_NOT_FOUND, ret, message);
+        }
+
+        /* A torn target is rejected, never half read */
+        unlink(tmp_path);
+        test_file_put(TEST_FILE_PATH, image, cut);
+        snprintf(message, sizeof(message), "target cut at %d", cut);
+        if (cut == image_size)
+        {
+            TEST_ASSERT_TRUE_MESSAGE(test_file_read(type, new_data, new_size, &ret), message);
+        }
+        else
+        {
+            TEST_ASSERT_FALSE_MESSAGE(test_file_read(type, new_data, new_size, &ret), message);
+            TEST_ASSERT_NOT_EQUAL_MESSAGE(ESP_OK, ret, message);
+        }
+    }
+
+    for (size_t bit = 0; bit < image_size * 8; bit++)
+    {
+        image[bit / 8] ^= 1 << (bit % 8);
+        test_file_put(TEST_FILE_PATH, image, image_size);
+        image[bit / 8] ^= 1 << (bit % 8);
+        test_file_read(type, new_data, new_size, &ret);
+        snprintf(message, sizeof(message), "bit %d flipped", bit);
+        TEST_ASSERT_NOT_EQUAL_MESSAGE(ESP_OK, ret, message);
+    }
+
+    unlink(TEST_FILE_PATH);
+    unlink(tmp_path);
+    free(image);
+}
+
+TEST_CASE("a delay file survives a cut write and rejects flipped bits", "[ir][file]")
+{
+    static const int32_t old_delays[] = {500, 1200, 300};
+    static const int32_t new_delays[] = {800, 250, 1000, 2000, 150};
+
+    test_ir_mount_storage();
+    test_file_run(IR_FILE_TYPE_DELAY, (const uint8_t *)old_delays, sizeof(old_delays),
+                  (const uint8_t *)new_delays, sizeof(new_delays));
+}
+
+TEST_CASE("an alias file survives a cut write and rejects flipped bits", "[ir][file]")
+{
+    static const char old_json[] = "{\"tv_power\":\"power\"}";
+    static const char new_json[] = "{\"tv_power\":\"power\",\"fan_up\":\"speed\",\"ac_on\":\"cool_24\"}";
+
+    test_ir_mount_storage();
+    test_file_run(IR_FILE_TYPE_ALIAS, (const uint8_t *)old_json, strlen(old_json),
+                  (const uint8_t *)new_json, strlen(new_json));
+}
+
+TEST_CASE("delay files of older firmware are read, damaged ones are rejected", "[ir][file]")
+{
+    static const char text[] = "500\n1200\n300\n";
+    static const int32_t delays[] = {800, 250, 1000};
+    int timediff_list[IR_STEP_COUNT_MAX];
+    size_t count = 0;
+
+    test_ir_mount_storage();
+    test_file_put(TEST_DELAY_PATH, (const uint8_t *)text, strlen(text));
+    TEST_ASSERT_EQUAL(ESP_OK, read_step_timediff_file(TEST_DELAY_KEY, timediff_list, &count));
+    TEST_ASSERT_EQUAL(3, count);
+    TEST_ASSERT_EQUAL(500, timediff_list[0]);
+    TEST_ASSERT_EQUAL(1200, timediff_list[1]);
+    TEST_ASSERT_EQUAL(300, timediff_list[2]);
+
+    /* A flipped bit in the magic must not make the file look like text */
+    TEST_ASSERT_EQUAL(ESP_OK, ir_file_write(TEST_DELAY_PATH, IR_FILE_TYPE_DELAY, delays, sizeof(delays)));
+    FILE *f = fopen(TEST_DELAY_PATH, "r+b");
+    TEST_ASSERT_NOT_NULL(f);
+    uint8_t first = fgetc(f);
+    rewind(f);
+    fputc(first ^ 0x01, f);
+    TEST_ASSERT_EQUAL(0, fclose(f));
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, read_step_timediff_file(TEST_DELAY_KEY, timediff_list, &count));
+
+    unlink(TEST_DELAY_PATH);
+}
@@ -0,0 +1,195 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+#include "esp_random.h"
+#include "unity.h"
+
+#include "ir_learn.h"
+#include "ir_learn_acc.h"
+#include "ir_protocol.h"
+
+#define TEST_ACC_PRESSES 5
+#define TEST_ACC_TRIALS 20
+#define TEST_ACC_JITTER_US 100
+
+/**
+ * @brief A template of the corpus, captured as one or more sub-frames.
+ */
+typedef struct
+{
+    const char *name;
+    ir_protocol_frame_t frame; /*!< Protocol frame, or protocol IR_PROTOCOL_UNKNOWN for raw */
+    uint8_t sub_count;         /*!< Copies of the frame captured per press */
+} test_acc_template_t;
+
+static const test_acc_template_t s_templates[] = {
+    {"NEC", {.protocol = IR_PROTOCOL_NEC, .bits = 32, .address = 0x04, .command = 0x08}, 1},
+    {"Samsung", {.protocol = IR_PROTOCOL_SAMSUNG, .bits = 32, .address = 0x0707, .command = 0x02}, 1},
+    {"Sony12", {.protocol = IR_PROTOCOL_SONY, .bits = 12, .address = 0x01, .command = 0x15}, 2},
+    {"RC5", {.protocol = IR_PROTOCOL_RC5, .bits = 14, .address = 0x00, .command = 0x0c}, 1},
+    {"raw", {.protocol = IR_PROTOCOL_UNKNOWN}, 2},
+};
+
+/**
+ * @brief Symbols of a template, as sent: marks on level 1.
+ */
+static size_t test_acc_build(const test_acc_template_t *tpl, rmt_symbol_word_t *symbols)
+{
+    if (tpl->frame.protocol != IR_PROTOCOL_UNKNOWN)
+    {
+        return ir_protocol_build(&tpl->frame, symbols, IR_PROTOCOL_FRAME_MAX_SYMBOLS);
+    }
+
+    /* No protocol: a 3.3 ms / 1.6 ms leader and 24 bits of uneven 430 us units, as air conditioners send */
+    size_t n = 0;
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 3300, .level1 = 0, .duration1 = 1600};
+    for (int i = 0; i < 24; i++)
+    {
+        symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 430, .level1 = 0, .duration1 = (0xa5c3e1 >> i) & 1 ? 1290 : 430};
+    }
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 430, .level1 = 0, .duration1 = 0};
+    return n;
+}
+
+static uint16_t test_acc_jitter(uint16_t duration)
+{
+    if (duration == 0)
+    {
+        return 0;
+    }
+    int value = duration + (int)(esp_random() % (2 * TEST_ACC_JITTER_US + 1)) - TEST_ACC_JITTER_US;
+    return MAX(value, 1);
+}
+
+/**
+ * @brief Capture one press of a template: jitter on every duration, levels as the receiver outputs them.
+ *
+ * @param kind 0: clean press, 1: glitch splitting a mark, 2: outlier with every duration 40% long
+ */
+static void test_acc_capture(struct ir_learn_list_head *samples, const test_acc_template_t *tpl,
+                             const rmt_symbol_word_t *symbols, size_t num_symbols, int kind)
+{
+    rmt_symbol_word_t capture[IR_PROTOCOL_FRAME_MAX_SYMBOLS + 1];
+    TEST_ASSERT_EQUAL(ESP_OK, ir_learn_add_list_node(samples));
+    struct ir_learn_list_t *last = SLIST_FIRST(samples);
+    while (SLIST_NEXT(last, next))
+    {
+        last = SLIST_NEXT(last, next);
+    }
+
+    for (int sub = 0; sub < tpl->sub_count; sub++)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < num_symbols; i++)
+        {
+            uint16_t d0 = symbols[i].duration0;
+            uint16_t d1 = symbols[i].duration1;
+            if (kind == 2)
+            {
+                d0 = d0 * 7 / 5;
+                d1 = d1 * 7 / 5;
+            }
+            if (kind == 1 && i == num_symbols / 2)
+            {
+                /* A short dropout in the middle of a mark */
+                capture[n++] = (rmt_symbol_word_t){.level0 = 0, .duration0 = test_acc_jitter(d0 / 2), .level1 = 1, .duration1 = 60};
+                d0 -= d0 / 2 + 60;
+            }
+            capture[n++] = (rmt_symbol_word_t){
+                .level0 = symbols[i].level1,
+                .duration0 = test_acc_jitter(d0),
+                .level1 = symbols[i].level0,
+                .duration1 = test_acc_jitter(d1),
+            };
+        }
+        rmt_rx_done_event_data_t data = {
+            .received_symbols = capture,
+            .num_symbols = n,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, ir_learn_add_sub_list_node(&last->cmd_sub_node, sub ? 45000 : 0, &data));
+    }
+}
+
+/**
+ * @brief Score a learned command against its template.
+ *
+ * @param[out] error_us Sum of the absolute duration errors
+ * @param[out] durations Durations compared
+ * @return true if every sub-frame decodes as the template, or has its layout for raw templates
+ */
+static bool test_acc_score(const struct ir_learn_sub_list_head *learned, const test_acc_template_t *tpl,
+                           const rmt_symbol_word_t *symbols, size_t num_symbols, uint32_t *error_us, uint32_t *durations)
+{
+    bool ok = true;
+    int subs = 0;
+    const struct ir_learn_sub_list_t *sub;
+    SLIST_FOREACH(sub, learned, next)
+    {
+        subs++;
+        if (sub->symbols.num_symbols != num_symbols)
+        {
+            ok = false;
+            continue;
+        }
+        for (size_t i = 0; i < num_symbols; i++)
+        {
+            *error_us += abs((int)sub->symbols.received_symbols[i].duration0 - (int)symbols[i].duration0);
+            *error_us += abs((int)sub->symbols.received_symbols[i].duration1 - (int)symbols[i].duration1);
+            *durations += 2;
+        }
+        ir_protocol_frame_t frame;
+        if (tpl->frame.protocol != IR_PROTOCOL_UNKNOWN &&
+            (ir_protocol_decode(sub->symbols.received_symbols, num_symbols, &frame) != ESP_OK ||
+             !ir_protocol_frame_equal(&frame, &tpl->frame)))
+        {
+            ok = false;
+        }
+    }
+    return ok && subs == tpl->sub_count;
+}
+
+TEST_CASE("median of K presses learns every template despite a glitch and an outlier", "[ir][learn]")
+{
+    for (int t = 0; t < sizeof(s_templates) / sizeof(s_templates[0]); t++)
+    {
+        const test_acc_template_t *tpl = &s_templates[t];
+        rmt_symbol_word_t symbols[IR_PROTOCOL_FRAME_MAX_SYMBOLS];
+        size_t num_symbols = test_acc_build(tpl, symbols);
+        int median_ok = 0;
+        uint32_t single_err = 0, single_n = 0, median_err = 0, median_n = 0;
+
+        for (int trial = 0; trial < TEST_ACC_TRIALS; trial++)
+        {
+            /* Press 1 is glitched and press 2 an outlier, the others are clean */
+            struct ir_learn_list_head samples = SLIST_HEAD_INITIALIZER(samples);
+            for (int k = 0; k < TEST_ACC_PRESSES; k++)
+            {
+                test_acc_capture(&samples, tpl, symbols, num_symbols, k < 3 ? k : 0);
+            }
+
+            /* Single press: a clean capture learned as is */
+            struct ir_learn_sub_list_head learned;
+            ir_learn_init_sub_list(&learned);
+            const struct ir_learn_sub_list_t *sub;
+            SLIST_FOREACH(sub, &SLIST_FIRST(&samples)->cmd_sub_node, next)
+            {
+                TEST_ASSERT_EQUAL(ESP_OK, ir_learn_add_sub_list_node(&learned, sub->timediff, &sub->symbols));
+            }
+            TEST_ASSERT_TRUE_MESSAGE(test_acc_score(&learned, tpl, symbols, num_symbols, &single_err, &single_n), tpl->name);
+            ir_learn_clean_sub_data(&learned);
+
+            TEST_ASSERT_EQUAL_MESSAGE(ESP_OK, ir_learn_acc_median(&samples, &learned, NULL), tpl->name);
+            median_ok += test_acc_score(&learned, tpl, symbols, num_symbols, &median_err, &median_n);
+            ir_learn_clean_sub_data(&learned);
+            ir_learn_clean_data(&samples);
+        }
+
+        printf("%-8s median ok %d/%d, error %" PRIu32 " us against %" PRIu32 " us for one press\n", tpl->name,
+               median_ok, TEST_ACC_TRIALS, median_err / median_n, single_err / single_n);
+        TEST_ASSERT_EQUAL_MESSAGE(TEST_ACC_TRIALS, median_ok, tpl->name);
+        /* The median of the clean presses averages the jitter out */
+        TEST_ASSERT_LESS_THAN_MESSAGE(single_err / single_n, median_err / median_n, tpl->name);
+    }
+}
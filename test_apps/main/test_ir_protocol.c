@@ -0,0 +1,93 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "ir_protocol.h"
+
+#define TEST_PULSE_DISTANCE_BITS 48
+
+static const ir_protocol_frame_t s_frames[] = {
+    {.protocol = IR_PROTOCOL_NEC, .bits = 32, .address = 0x04, .command = 0x08},
+    {.protocol = IR_PROTOCOL_NEC_EXT, .bits = 32, .address = 0x1234, .command = 0x56},
+    {.protocol = IR_PROTOCOL_SAMSUNG, .bits = 32, .address = 0x0707, .command = 0x02},
+    {.protocol = IR_PROTOCOL_SONY, .bits = 12, .address = 0x01, .command = 0x15},
+    {.protocol = IR_PROTOCOL_SONY, .bits = 20, .address = 0x1A3, .command = 0x33},
+    {.protocol = IR_PROTOCOL_RC5, .bits = 14, .address = 0x05, .command = 0x35},
+    {.protocol = IR_PROTOCOL_RC6, .bits = 16, .address = 0x04, .command = 0x0C},
+};
+
+/**
+ * @brief A synthesized frame as the receiver captures it: the last space merges into the idle level.
+ */
+static size_t test_protocol_capture(const ir_protocol_frame_t *frame, rmt_symbol_word_t *symbols)
+{
+    size_t num_symbols = ir_protocol_build(frame, symbols, IR_PROTOCOL_FRAME_MAX_SYMBOLS);
+    TEST_ASSERT_NOT_EQUAL(0, num_symbols);
+    symbols[num_symbols - 1].duration1 = 0;
+    return num_symbols;
+}
+
+/**
+ * @brief Pulse-distance frame with a NEC or Samsung leader, as sent by air-conditioner remotes.
+ */
+static size_t test_protocol_pulse_distance(uint32_t leading_mark_us, const uint8_t *bytes, size_t bits, rmt_symbol_word_t *symbols)
+{
+    size_t n = 0;
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = leading_mark_us, .level1 = 0, .duration1 = 4500};
+    for (size_t i = 0; i < bits; i++)
+    {
+        bool one = bytes[i / 8] & (1 << (i % 8));
+        symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 560, .level1 = 0, .duration1 = one ? 1690 : 560};
+    }
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 560, .level1 = 0, .duration1 = 0};
+    return n;
+}
+
+TEST_CASE("protocol frames decode to what they were built from", "[ir][protocol]")
+{
+    rmt_symbol_word_t symbols[IR_PROTOCOL_FRAME_MAX_SYMBOLS];
+
+    for (size_t i = 0; i < sizeof(s_frames) / sizeof(s_frames[0]); i++)
+    {
+        size_t num_symbols = test_protocol_capture(&s_frames[i], symbols);
+        ir_protocol_frame_t decoded;
+        TEST_ASSERT_EQUAL(ESP_OK, ir_protocol_decode(symbols, num_symbols, &decoded));
+        TEST_ASSERT_TRUE_MESSAGE(ir_protocol_frame_equal(&s_frames[i], &decoded), ir_protocol_name(s_frames[i].protocol));
+    }
+}
+
+TEST_CASE("long pulse-distance frames fall through to raw matching", "[ir][protocol]")
+{
+    /* Bytes 0-3 are a valid NEC payload: address 0x04, command 0x08 and their inverses */
+    const uint8_t bytes[TEST_PULSE_DISTANCE_BITS / 8] = {0x04, 0xFB, 0x08, 0xF7, 0x20, 0x00};
+    rmt_symbol_word_t symbols[TEST_PULSE_DISTANCE_BITS + 2];
+    ir_protocol_frame_t decoded;
+
+    const uint32_t leaders[] = {9000, 4500}; // NEC, Samsung
+    for (int i = 0; i < 2; i++)
+    {
+        size_t num_symbols = test_protocol_pulse_distance(leaders[i], bytes, TEST_PULSE_DISTANCE_BITS, symbols);
+        TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, ir_protocol_decode(symbols, num_symbols, &decoded));
+
+        /* The same leader with 32 bits is still a protocol frame */
+        num_symbols = test_protocol_pulse_distance(leaders[i], bytes, 32, symbols);
+        TEST_ASSERT_EQUAL(ESP_OK, ir_protocol_decode(symbols, num_symbols, &decoded));
+        TEST_ASSERT_EQUAL(0x08, decoded.command);
+    }
+}
+
+TEST_CASE("frames followed by more symbols are not decoded", "[ir][protocol]")
+{
+    rmt_symbol_word_t symbols[IR_PROTOCOL_FRAME_MAX_SYMBOLS + 4];
+    ir_protocol_frame_t decoded;
+
+    for (size_t i = 0; i < sizeof(s_frames) / sizeof(s_frames[0]); i++)
+    {
+        size_t num_symbols = test_protocol_capture(&s_frames[i], symbols);
+        /* The end of the frame isn't the end of the capture anymore */
+        symbols[num_symbols - 1].duration1 = 2000;
+        symbols[num_symbols++] = (rmt_symbol_word_t){.level0 = 1, .duration0 = 600, .level1 = 0, .duration1 = 0};
+        TEST_ASSERT_EQUAL_MESSAGE(ESP_ERR_NOT_FOUND, ir_protocol_decode(symbols, num_symbols, &decoded),
+                                  ir_protocol_name(s_frames[i].protocol));
+    }
+}
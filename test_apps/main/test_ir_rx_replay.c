@@ -0,0 +1,113 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+
+#include "ir_config.h"
+#include "ir_learn.h"
+#include "ir_rx.h"
+#include "ir_storage.h"
+#include "test_ir_common.h"
+
+#define TEST_REPLAY_KEY "test_replay"
+#define TEST_REPLAY_SENDS 20
+#define TEST_REPLAY_INTERVAL_MS 150
+
+/**
+ * @brief An air conditioner frame as the receiver captures it: marks on level 0, not a known protocol.
+ */
+static size_t test_replay_capture(rmt_symbol_word_t *symbols)
+{
+    size_t n = 0;
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 0, .duration0 = 3300, .level1 = 1, .duration1 = 1600};
+    for (int i = 0; i < 24; i++)
+    {
+        symbols[n++] = (rmt_symbol_word_t){.level0 = 0, .duration0 = 430, .level1 = 1, .duration1 = (0xa5c3e1 >> i) & 1 ? 1290 : 430};
+    }
+    symbols[n++] = (rmt_symbol_word_t){.level0 = 0, .duration0 = 430, .level1 = 1, .duration1 = 0};
+    return n;
+}
+
+/**
+ * @brief Frames the receiver should see per send of a loaded key.
+ */
+static uint32_t test_replay_frames(const ir_tx_key_t *tx_key)
+{
+    uint32_t frames = 0;
+    if (tx_key->is_record)
+    {
+        return tx_key->record.frames;
+    }
+    if (tx_key->is_mapped)
+    {
+        size_t pos = ir_key_read_header(tx_key->view.data, tx_key->view.size, NULL);
+        uint32_t timediff;
+        const rmt_symbol_word_t *symbols;
+        size_t num_symbols;
+        while (ir_key_next_frame(tx_key->view.data, tx_key->view.size, &pos, &timediff, &symbols, &num_symbols) == ESP_OK)
+        {
+            frames++;
+        }
+        return frames;
+    }
+    const struct ir_learn_sub_list_t *sub;
+    SLIST_FOREACH(sub, &tx_key->symbols, next)
+    {
+        frames++;
+    }
+    return frames;
+}
+
+TEST_CASE("a key sent to the receiver is captured without missed frames", "[loopback]")
+{
+    test_ir_mount_storage();
+    TEST_ASSERT_EQUAL(ESP_OK, ir_tx_init());
+    TEST_ASSERT_EQUAL(ESP_OK, ir_rx_init());
+
+    /* Two copies of the frame per press, 45 ms apart */
+    rmt_symbol_word_t symbols[32];
+    rmt_rx_done_event_data_t capture = {
+        .received_symbols = symbols,
+        .num_symbols = test_replay_capture(symbols),
+    };
+    struct ir_learn_sub_list_head learned, saved;
+    ir_learn_init_sub_list(&learned);
+    ir_learn_init_sub_list(&saved);
+    TEST_ASSERT_EQUAL(ESP_OK, ir_learn_add_sub_list_node(&learned, 0, &capture));
+    TEST_ASSERT_EQUAL(ESP_OK, ir_learn_add_sub_list_node(&learned, 45000, &capture));
+    ir_learn_save(&saved, &learned, TEST_REPLAY_KEY, NULL);
+    ir_learn_clean_sub_data(&saved);
+    ir_learn_clean_sub_data(&learned);
+
+    ir_tx_key_t tx_key;
+    TEST_ASSERT_EQUAL(ESP_OK, ir_tx_load_key(TEST_REPLAY_KEY, &tx_key));
+    uint32_t frames_per_send = test_replay_frames(&tx_key);
+    ir_tx_release_key(&tx_key);
+    TEST_ASSERT_EQUAL_UINT32(2, frames_per_send);
+
+    ir_rx_mode_t mode = ir_rx_get_mode();
+    ir_rx_stats_t before, after;
+    ir_rx_set_mode(IR_RX_MODE_MONITOR);
+    ir_rx_get_stats(&before);
+
+    rmt_tx_start();
+    for (int i = 0; i < TEST_REPLAY_SENDS; i++)
+    {
+        TEST_ASSERT_EQUAL(ESP_OK, ir_tx_load_key(TEST_REPLAY_KEY, &tx_key));
+        ir_tx_queue_key(&tx_key);
+        ir_tx_wait_done();
+        ir_tx_release_key(&tx_key);
+        vTaskDelay(pdMS_TO_TICKS(TEST_REPLAY_INTERVAL_MS));
+    }
+    rmt_tx_stop();
+
+    ir_rx_get_stats(&after);
+    ir_rx_set_mode(mode);
+    delete_ir_key_from_spiffs(TEST_REPLAY_KEY);
+
+    TEST_ASSERT_EQUAL_UINT32(frames_per_send * TEST_REPLAY_SENDS, after.monitored - before.monitored);
+    TEST_ASSERT_EQUAL_UINT32(0, after.rearm_failures - before.rearm_failures);
+    TEST_ASSERT_EQUAL_UINT32(0, after.queue_drops - before.queue_drops);
+    TEST_ASSERT_EQUAL_UINT32(0, after.overruns - before.overruns);
+}
@@ -0,0 +1,9 @@
+import pytest
+from pytest_embedded import Dut
+
+
+@pytest.mark.target('esp32')
+@pytest.mark.env('generic')
+def test_ir_learn(dut: Dut) -> None:
+    # The [loopback] cases are left out, they need the IR LED of the board in front of its receiver
+    dut.run_all_single_board_cases(group='ir')
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Pack and unpack IR step sequences (.seq files, see main/include/ir_sequence.h).
+
+  ir_seq.py pack <dir> <key>         <dir>/<key>_stepN.ir + <dir>/<key>.delay -> <dir>/<key>.seq
+  ir_seq.py unpack <file.seq> <dir>  <file.seq> -> <dir>/<key>_stepN.ir + <dir>/<key>.delay
+  ir_seq.py info <file.seq>
+"""
+import os
+import struct
+import sys
+import zlib
+
+SEQ_MAGIC = 0x51535249
+SEQ_VERSION = 1
+HEADER = struct.Struct("<IHHII")
+STEP = struct.Struct("<III")
+FILE_MAGIC = 0x46465249
+FILE_VERSION = 1
+FILE_TYPE_DELAY = 1
+FILE_HEADER = struct.Struct("<IHHII")
+
+
+def align4(n):
+    return (n + 3) & ~3
+
+
+def read_seq(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, version, step_count, file_size, _ = HEADER.unpack_from(data, 0)
+    if magic != SEQ_MAGIC or version != SEQ_VERSION:
+        sys.exit(f"{path}: not a v{SEQ_VERSION} sequence")
+    if file_size != len(data):
+        sys.exit(f"{path}: size {len(data)}, header says {file_size}")
+    steps = []
+    for i in range(step_count):
+        offset, size, delay_ms = STEP.unpack_from(data, HEADER.size + i * STEP.size)
+        steps.append((data[offset:offset + size], delay_ms))
+    return steps
+
+
+def write_seq(path, steps):
+    offset = align4(HEADER.size + len(steps) * STEP.size)
+    table = b""
+    blocks = b""
+    for block, delay_ms in steps:
+        table += STEP.pack(offset, len(block), delay_ms)
+        blocks += b"\0" * (offset - HEADER.size - len(steps) * STEP.size - len(blocks)) + block
+        offset = align4(offset + len(block))
+    body = table + blocks
+    with open(path, "wb") as f:
+        f.write(HEADER.pack(SEQ_MAGIC, SEQ_VERSION, len(steps), HEADER.size + len(body), 0) + body)
+
+
+def read_delays(path):
+    """A .delay file (see main/include/ir_file.h), or the text file of older firmware."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < 4 or struct.unpack_from("<I", data)[0] != FILE_MAGIC:
+        return [int(v) for v in data.decode().split()]
+    if len(data) < FILE_HEADER.size:
+        sys.exit(f"{path}: truncated")
+    _, version, kind, length, crc = FILE_HEADER.unpack_from(data, 0)
+    payload = data[FILE_HEADER.size:]
+    if version != FILE_VERSION or kind != FILE_TYPE_DELAY or length != len(payload) or zlib.crc32(payload) != crc:
+        sys.exit(f"{path}: corrupted")
+    return list(struct.unpack(f"<{length // 4}i", payload[:length // 4 * 4]))
+
+
+def write_delays(path, delays):
+    payload = struct.pack(f"<{len(delays)}i", *delays)
+    with open(path, "wb") as f:
+        f.write(FILE_HEADER.pack(FILE_MAGIC, FILE_VERSION, FILE_TYPE_DELAY, len(payload), zlib.crc32(payload)) + payload)
+
+
+def pack(directory, key):
+    delays = []
+    delay_path = os.path.join(directory, key + ".delay")
+    if os.path.exists(delay_path):
+        delays = read_delays(delay_path)
+    steps = []
+    while True:
+        step_path = os.path.join(directory, f"{key}_step{len(steps) + 1}.ir")
+        if not os.path.exists(step_path):
+            break
+        with open(step_path, "rb") as f:
+            steps.append((f.read(), delays[len(steps)] if len(steps) < len(delays) else 0))
+    if not steps:
+        sys.exit(f"{directory}: no {key}_step1.ir")
+    steps[-1] = (steps[-1][0], 0)
+    write_seq(os.path.join(directory, key + ".seq"), steps)
+    print(f"{key}.seq: {len(steps)} steps")
+
+
+def unpack(path, directory):
+    key = os.path.splitext(os.path.basename(path))[0]
+    steps = read_seq(path)
+    os.makedirs(directory, exist_ok=True)
+    for i, (block, _) in enumerate(steps):
+        with open(os.path.join(directory, f"{key}_step{i + 1}.ir"), "wb") as f:
+            f.write(block)
+    write_delays(os.path.join(directory, key + ".delay"), [delay_ms for _, delay_ms in steps[:-1]])
+    print(f"{key}: {len(steps)} steps unpacked to {directory}")
+
+
+def info(path):
+    for i, (block, delay_ms) in enumerate(read_seq(path)):
+        print(f"step {i + 1}: {len(block)} bytes, next after {delay_ms} ms")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 4 and sys.argv[1] == "pack":
+        pack(sys.argv[2], sys.argv[3])
+    elif len(sys.argv) == 4 and sys.argv[1] == "unpack":
+        unpack(sys.argv[2], sys.argv[3])
+    elif len(sys.argv) == 3 and sys.argv[1] == "info":
+        info(sys.argv[2])
+    else:
+        sys.exit(__doc__)
@@ -132,202 +132,213 @@ unsigned char index_html[] = {
   0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x74, 0x68, 0x65,
   0x6f, 0x20, 0x62, 0xc6, 0xb0, 0xe1, 0xbb, 0x9b, 0x63, 0x3c, 0x2f, 0x62,
   0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74,
+  0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22,
+  0x63, 0x61, 0x6e, 0x63, 0x65, 0x6c, 0x4c, 0x65, 0x61, 0x72, 0x6e, 0x28,
+  0x29, 0x22, 0x3e, 0x48, 0x75, 0xe1, 0xbb, 0xb7, 0x20, 0x68, 0xe1, 0xbb,
+  0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x3c, 0x2f, 0x62,
+  0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
   0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x68, 0x33, 0x20, 0x73, 0x74,
-  0x79, 0x6c, 0x65, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x61, 0x6c,
-  0x69, 0x67, 0x6e, 0x3a, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x3b, 0x20,
-  0x6d, 0x61, 0x72, 0x67, 0x69, 0x6e, 0x2d, 0x74, 0x6f, 0x70, 0x3a, 0x20,
-  0x34, 0x30, 0x70, 0x78, 0x3b, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63,
-  0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x6d, 0xe1, 0xba, 0xb7,
-  0x63, 0x20, 0xc4, 0x91, 0xe1, 0xbb, 0x8b, 0x6e, 0x68, 0x3c, 0x2f, 0x68,
-  0x33, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x62,
-  0x75, 0x74, 0x74, 0x6f, 0x6e, 0x2d, 0x6c, 0x69, 0x73, 0x74, 0x22, 0x3e,
-  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63,
-  0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44,
-  0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x77, 0x68, 0x69, 0x74,
-  0x65, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c,
-  0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x57, 0x68, 0x69, 0x74, 0x65, 0x3c,
-  0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75,
-  0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b,
-  0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75,
-  0x6c, 0x74, 0x28, 0x27, 0x72, 0x65, 0x73, 0x65, 0x74, 0x27, 0x29, 0x22,
-  0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e,
-  0x68, 0x20, 0x52, 0x65, 0x73, 0x65, 0x74, 0x3c, 0x2f, 0x62, 0x75, 0x74,
-  0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e,
-  0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65,
-  0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27,
-  0x74, 0x6f, 0x67, 0x67, 0x6c, 0x65, 0x27, 0x29, 0x22, 0x3e, 0x4c, 0x49,
-  0x47, 0x48, 0x54, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e,
-  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63,
-  0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44,
-  0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x75, 0x70, 0x27, 0x29,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x70, 0x20, 0x69, 0x64, 0x3d,
+  0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x50, 0x72, 0x6f, 0x67, 0x72, 0x65,
+  0x73, 0x73, 0x22, 0x20, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x3d, 0x22, 0x74,
+  0x65, 0x78, 0x74, 0x2d, 0x61, 0x6c, 0x69, 0x67, 0x6e, 0x3a, 0x63, 0x65,
+  0x6e, 0x74, 0x65, 0x72, 0x3b, 0x22, 0x3e, 0x3c, 0x2f, 0x70, 0x3e, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x68, 0x33, 0x20,
+  0x73, 0x74, 0x79, 0x6c, 0x65, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74, 0x2d,
+  0x61, 0x6c, 0x69, 0x67, 0x6e, 0x3a, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x72,
+  0x3b, 0x20, 0x6d, 0x61, 0x72, 0x67, 0x69, 0x6e, 0x2d, 0x74, 0x6f, 0x70,
+  0x3a, 0x20, 0x34, 0x30, 0x70, 0x78, 0x3b, 0x22, 0x3e, 0x48, 0xe1, 0xbb,
+  0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x6d, 0xe1,
+  0xba, 0xb7, 0x63, 0x20, 0xc4, 0x91, 0xe1, 0xbb, 0x8b, 0x6e, 0x68, 0x3c,
+  0x2f, 0x68, 0x33, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d,
+  0x22, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x2d, 0x6c, 0x69, 0x73, 0x74,
+  0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f,
+  0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72,
+  0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x77, 0x68,
+  0x69, 0x74, 0x65, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63,
+  0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x57, 0x68, 0x69, 0x74,
+  0x65, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
+  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69,
+  0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66,
+  0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x72, 0x65, 0x73, 0x65, 0x74, 0x27,
+  0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb,
+  0x87, 0x6e, 0x68, 0x20, 0x52, 0x65, 0x73, 0x65, 0x74, 0x3c, 0x2f, 0x62,
+  0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74,
+  0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22,
+  0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74,
+  0x28, 0x27, 0x74, 0x6f, 0x67, 0x67, 0x6c, 0x65, 0x27, 0x29, 0x22, 0x3e,
+  0x4c, 0x49, 0x47, 0x48, 0x54, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f,
+  0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f,
+  0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72,
+  0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x75, 0x70,
+  0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1,
+  0xbb, 0x87, 0x6e, 0x68, 0x20, 0xe2, 0x86, 0x91, 0x3c, 0x2f, 0x62, 0x75,
+  0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f,
+  0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c,
+  0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28,
+  0x27, 0x64, 0x6f, 0x77, 0x6e, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb,
+  0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0xe2, 0x86,
+  0x93, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
+  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69,
+  0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66,
+  0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x6c, 0x65, 0x66, 0x74, 0x27, 0x29,
   0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87,
-  0x6e, 0x68, 0x20, 0xe2, 0x86, 0x91, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74,
+  0x6e, 0x68, 0x20, 0xe2, 0x86, 0x90, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74,
   0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
   0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20,
   0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61,
-  0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x64,
-  0x6f, 0x77, 0x6e, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63,
-  0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0xe2, 0x86, 0x93, 0x3c,
-  0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75,
-  0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b,
-  0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75,
-  0x6c, 0x74, 0x28, 0x27, 0x6c, 0x65, 0x66, 0x74, 0x27, 0x29, 0x22, 0x3e,
-  0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68,
-  0x20, 0xe2, 0x86, 0x90, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e,
-  0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e,
-  0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e,
-  0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x72, 0x69, 0x67,
-  0x68, 0x74, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20,
-  0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0xe2, 0x86, 0x92, 0x3c, 0x2f,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74,
-  0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d,
-  0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c,
-  0x74, 0x28, 0x27, 0x6f, 0x6b, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb,
-  0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x4f, 0x4b,
+  0x72, 0x6e, 0x44, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x72,
+  0x69, 0x67, 0x68, 0x74, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d,
+  0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0xe2, 0x86, 0x92,
   0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20,
   0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62,
   0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63,
   0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65, 0x66, 0x61,
-  0x75, 0x6c, 0x74, 0x28, 0x27, 0x65, 0x78, 0x69, 0x74, 0x27, 0x29, 0x22,
-  0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e,
-  0x68, 0x20, 0x45, 0x78, 0x69, 0x74, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74,
-  0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x3c, 0x68, 0x33, 0x20, 0x73, 0x74, 0x79, 0x6c, 0x65,
-  0x3d, 0x22, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x61, 0x6c, 0x69, 0x67, 0x6e,
-  0x3a, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x3b, 0x20, 0x6d, 0x61, 0x72,
-  0x67, 0x69, 0x6e, 0x2d, 0x74, 0x6f, 0x70, 0x3a, 0x20, 0x34, 0x30, 0x70,
-  0x78, 0x3b, 0x22, 0x3e, 0xf0, 0x9f, 0x8e, 0xaf, 0x20, 0x47, 0xc3, 0xa1,
-  0x6e, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x49, 0x52, 0x3c,
-  0x2f, 0x68, 0x33, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d,
-  0x22, 0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x69, 0x72, 0x20, 0x62,
-  0x6f, 0x78, 0x2d, 0x73, 0x68, 0x61, 0x64, 0x6f, 0x77, 0x20, 0x70, 0x2d,
-  0x34, 0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x69, 0x64, 0x3d,
-  0x22, 0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x63, 0x6f, 0x6e, 0x74,
-  0x61, 0x69, 0x6e, 0x65, 0x72, 0x22, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73,
-  0x3d, 0x22, 0x73, 0x70, 0x61, 0x63, 0x65, 0x2d, 0x79, 0x2d, 0x32, 0x20,
-  0x66, 0x6c, 0x65, 0x78, 0x20, 0x66, 0x6c, 0x65, 0x78, 0x2d, 0x63, 0x6f,
-  0x6c, 0x20, 0x69, 0x74, 0x65, 0x6d, 0x73, 0x2d, 0x63, 0x65, 0x6e, 0x74,
-  0x65, 0x72, 0x22, 0x3e, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x0a, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76,
-  0x20, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74,
-  0x2d, 0x61, 0x6c, 0x69, 0x67, 0x6e, 0x3a, 0x20, 0x63, 0x65, 0x6e, 0x74,
-  0x65, 0x72, 0x3b, 0x20, 0x6d, 0x61, 0x72, 0x67, 0x69, 0x6e, 0x2d, 0x74,
-  0x6f, 0x70, 0x3a, 0x20, 0x31, 0x32, 0x70, 0x78, 0x3b, 0x22, 0x3e, 0x0a,
+  0x75, 0x6c, 0x74, 0x28, 0x27, 0x6f, 0x6b, 0x27, 0x29, 0x22, 0x3e, 0x48,
+  0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20,
+  0x4f, 0x4b, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a,
   0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20,
-  0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x61, 0x64, 0x64,
-  0x41, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x50, 0x61, 0x69, 0x72, 0x28, 0x29,
-  0x22, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x61, 0x73, 0x73,
-  0x69, 0x67, 0x6e, 0x2d, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x22, 0x3e,
-  0xe2, 0x9e, 0x95, 0x20, 0x54, 0x68, 0xc3, 0xaa, 0x6d, 0x20, 0x6c, 0xe1,
-  0xbb, 0x87, 0x6e, 0x68, 0x20, 0x67, 0xc3, 0xa1, 0x6e, 0x3c, 0x2f, 0x62,
-  0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69,
-  0x63, 0x6b, 0x3d, 0x22, 0x73, 0x75, 0x62, 0x6d, 0x69, 0x74, 0x41, 0x6c,
-  0x6c, 0x41, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x6d, 0x65, 0x6e, 0x74, 0x73,
+  0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c,
+  0x69, 0x63, 0x6b, 0x3d, 0x22, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x44, 0x65,
+  0x66, 0x61, 0x75, 0x6c, 0x74, 0x28, 0x27, 0x65, 0x78, 0x69, 0x74, 0x27,
+  0x29, 0x22, 0x3e, 0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb,
+  0x87, 0x6e, 0x68, 0x20, 0x45, 0x78, 0x69, 0x74, 0x3c, 0x2f, 0x62, 0x75,
+  0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x68, 0x33, 0x20, 0x73, 0x74, 0x79,
+  0x6c, 0x65, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x61, 0x6c, 0x69,
+  0x67, 0x6e, 0x3a, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x3b, 0x20, 0x6d,
+  0x61, 0x72, 0x67, 0x69, 0x6e, 0x2d, 0x74, 0x6f, 0x70, 0x3a, 0x20, 0x34,
+  0x30, 0x70, 0x78, 0x3b, 0x22, 0x3e, 0xf0, 0x9f, 0x8e, 0xaf, 0x20, 0x47,
+  0xc3, 0xa1, 0x6e, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x49,
+  0x52, 0x3c, 0x2f, 0x68, 0x33, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73,
+  0x73, 0x3d, 0x22, 0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x69, 0x72,
+  0x20, 0x62, 0x6f, 0x78, 0x2d, 0x73, 0x68, 0x61, 0x64, 0x6f, 0x77, 0x20,
+  0x70, 0x2d, 0x34, 0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x69,
+  0x64, 0x3d, 0x22, 0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x63, 0x6f,
+  0x6e, 0x74, 0x61, 0x69, 0x6e, 0x65, 0x72, 0x22, 0x20, 0x63, 0x6c, 0x61,
+  0x73, 0x73, 0x3d, 0x22, 0x73, 0x70, 0x61, 0x63, 0x65, 0x2d, 0x79, 0x2d,
+  0x32, 0x20, 0x66, 0x6c, 0x65, 0x78, 0x20, 0x66, 0x6c, 0x65, 0x78, 0x2d,
+  0x63, 0x6f, 0x6c, 0x20, 0x69, 0x74, 0x65, 0x6d, 0x73, 0x2d, 0x63, 0x65,
+  0x6e, 0x74, 0x65, 0x72, 0x22, 0x3e, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x0a, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64,
+  0x69, 0x76, 0x20, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x3d, 0x22, 0x74, 0x65,
+  0x78, 0x74, 0x2d, 0x61, 0x6c, 0x69, 0x67, 0x6e, 0x3a, 0x20, 0x63, 0x65,
+  0x6e, 0x74, 0x65, 0x72, 0x3b, 0x20, 0x6d, 0x61, 0x72, 0x67, 0x69, 0x6e,
+  0x2d, 0x74, 0x6f, 0x70, 0x3a, 0x20, 0x31, 0x32, 0x70, 0x78, 0x3b, 0x22,
+  0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f,
+  0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x61,
+  0x64, 0x64, 0x41, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x50, 0x61, 0x69, 0x72,
   0x28, 0x29, 0x22, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x61,
   0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e,
-  0x22, 0x20, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x3d, 0x22, 0x6d, 0x61, 0x72,
-  0x67, 0x69, 0x6e, 0x2d, 0x6c, 0x65, 0x66, 0x74, 0x3a, 0x20, 0x38, 0x70,
-  0x78, 0x3b, 0x22, 0x3e, 0xf0, 0x9f, 0x9a, 0x80, 0x20, 0x47, 0xe1, 0xbb,
-  0xad, 0x69, 0x20, 0x74, 0xe1, 0xba, 0xa5, 0x74, 0x20, 0x63, 0xe1, 0xba,
-  0xa3, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x0a, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x21, 0x2d, 0x2d, 0x20, 0x54, 0x61, 0x62, 0x3a, 0x20, 0x44,
+  0x22, 0x3e, 0xe2, 0x9e, 0x95, 0x20, 0x54, 0x68, 0xc3, 0xaa, 0x6d, 0x20,
+  0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x67, 0xc3, 0xa1, 0x6e, 0x3c,
+  0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63,
+  0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x73, 0x75, 0x62, 0x6d, 0x69, 0x74,
+  0x41, 0x6c, 0x6c, 0x41, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x6d, 0x65, 0x6e,
+  0x74, 0x73, 0x28, 0x29, 0x22, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d,
+  0x22, 0x61, 0x73, 0x73, 0x69, 0x67, 0x6e, 0x2d, 0x62, 0x75, 0x74, 0x74,
+  0x6f, 0x6e, 0x22, 0x20, 0x73, 0x74, 0x79, 0x6c, 0x65, 0x3d, 0x22, 0x6d,
+  0x61, 0x72, 0x67, 0x69, 0x6e, 0x2d, 0x6c, 0x65, 0x66, 0x74, 0x3a, 0x20,
+  0x38, 0x70, 0x78, 0x3b, 0x22, 0x3e, 0xf0, 0x9f, 0x9a, 0x80, 0x20, 0x47,
+  0xe1, 0xbb, 0xad, 0x69, 0x20, 0x74, 0xe1, 0xba, 0xa5, 0x74, 0x20, 0x63,
+  0xe1, 0xba, 0xa3, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x21, 0x2d, 0x2d, 0x20, 0x54, 0x61, 0x62, 0x3a,
+  0x20, 0x44, 0x61, 0x6e, 0x68, 0x20, 0x73, 0xc3, 0xa1, 0x63, 0x68, 0x20,
+  0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x20, 0x2d, 0x2d, 0x3e, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73,
+  0x73, 0x3d, 0x22, 0x74, 0x61, 0x62, 0x2d, 0x63, 0x6f, 0x6e, 0x74, 0x65,
+  0x6e, 0x74, 0x22, 0x20, 0x69, 0x64, 0x3d, 0x22, 0x6c, 0x69, 0x73, 0x74,
+  0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
+  0x68, 0x32, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x74, 0x65,
+  0x78, 0x74, 0x2d, 0x78, 0x6c, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x73,
+  0x65, 0x6d, 0x69, 0x62, 0x6f, 0x6c, 0x64, 0x20, 0x74, 0x65, 0x78, 0x74,
+  0x2d, 0x63, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x20, 0x6d, 0x62, 0x2d, 0x34,
+  0x20, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x67, 0x72, 0x61, 0x79, 0x2d, 0x38,
+  0x30, 0x30, 0x20, 0x64, 0x61, 0x72, 0x6b, 0x3a, 0x74, 0x65, 0x78, 0x74,
+  0x2d, 0x67, 0x72, 0x61, 0x79, 0x2d, 0x32, 0x30, 0x30, 0x22, 0x3e, 0x44,
   0x61, 0x6e, 0x68, 0x20, 0x73, 0xc3, 0xa1, 0x63, 0x68, 0x20, 0x6c, 0xe1,
-  0xbb, 0x87, 0x6e, 0x68, 0x20, 0x2d, 0x2d, 0x3e, 0x0a, 0x20, 0x20, 0x20,
+  0xbb, 0x87, 0x6e, 0x68, 0x20, 0x49, 0x52, 0x3c, 0x2f, 0x68, 0x32, 0x3e,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x75, 0x6c,
+  0x20, 0x69, 0x64, 0x3d, 0x22, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64,
+  0x4c, 0x69, 0x73, 0x74, 0x22, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d,
+  0x22, 0x73, 0x70, 0x61, 0x63, 0x65, 0x2d, 0x79, 0x2d, 0x36, 0x20, 0x70,
+  0x78, 0x2d, 0x34, 0x22, 0x3e, 0x3c, 0x2f, 0x75, 0x6c, 0x3e, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x21, 0x2d, 0x2d, 0x20, 0x54, 0x61, 0x62, 0x3a,
+  0x20, 0x46, 0x69, 0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x20, 0x55, 0x70,
+  0x64, 0x61, 0x74, 0x65, 0x20, 0x2d, 0x2d, 0x3e, 0x0a, 0x20, 0x20, 0x20,
   0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d,
   0x22, 0x74, 0x61, 0x62, 0x2d, 0x63, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74,
-  0x22, 0x20, 0x69, 0x64, 0x3d, 0x22, 0x6c, 0x69, 0x73, 0x74, 0x22, 0x3e,
-  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x68, 0x32,
-  0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x74, 0x65, 0x78, 0x74,
-  0x2d, 0x78, 0x6c, 0x20, 0x66, 0x6f, 0x6e, 0x74, 0x2d, 0x73, 0x65, 0x6d,
-  0x69, 0x62, 0x6f, 0x6c, 0x64, 0x20, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x63,
-  0x65, 0x6e, 0x74, 0x65, 0x72, 0x20, 0x6d, 0x62, 0x2d, 0x34, 0x20, 0x74,
-  0x65, 0x78, 0x74, 0x2d, 0x67, 0x72, 0x61, 0x79, 0x2d, 0x38, 0x30, 0x30,
-  0x20, 0x64, 0x61, 0x72, 0x6b, 0x3a, 0x74, 0x65, 0x78, 0x74, 0x2d, 0x67,
-  0x72, 0x61, 0x79, 0x2d, 0x32, 0x30, 0x30, 0x22, 0x3e, 0x44, 0x61, 0x6e,
-  0x68, 0x20, 0x73, 0xc3, 0xa1, 0x63, 0x68, 0x20, 0x6c, 0xe1, 0xbb, 0x87,
-  0x6e, 0x68, 0x20, 0x49, 0x52, 0x3c, 0x2f, 0x68, 0x32, 0x3e, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x75, 0x6c, 0x20, 0x69,
-  0x64, 0x3d, 0x22, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x4c, 0x69,
-  0x73, 0x74, 0x22, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x73,
-  0x70, 0x61, 0x63, 0x65, 0x2d, 0x79, 0x2d, 0x36, 0x20, 0x70, 0x78, 0x2d,
-  0x34, 0x22, 0x3e, 0x3c, 0x2f, 0x75, 0x6c, 0x3e, 0x0a, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x0a, 0x20, 0x20, 0x20,
-  0x20, 0x3c, 0x21, 0x2d, 0x2d, 0x20, 0x54, 0x61, 0x62, 0x3a, 0x20, 0x46,
-  0x69, 0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x20, 0x55, 0x70, 0x64, 0x61,
-  0x74, 0x65, 0x20, 0x2d, 0x2d, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x64, 0x69, 0x76, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x74,
-  0x61, 0x62, 0x2d, 0x63, 0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x22, 0x20,
-  0x69, 0x64, 0x3d, 0x22, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65, 0x22, 0x3e,
-  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x68, 0x32,
-  0x3e, 0x46, 0x69, 0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x20, 0x55, 0x70,
-  0x64, 0x61, 0x74, 0x65, 0x3c, 0x2f, 0x68, 0x32, 0x3e, 0x0a, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76, 0x20, 0x63,
-  0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65,
-  0x2d, 0x73, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x22, 0x3e, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x70, 0x20, 0x69, 0x64, 0x3d, 0x22, 0x66, 0x77, 0x53, 0x74, 0x61, 0x74,
-  0x75, 0x73, 0x22, 0x3e, 0x4b, 0x69, 0xe1, 0xbb, 0x83, 0x6d, 0x20, 0x74,
-  0x72, 0x61, 0x20, 0x63, 0xe1, 0xba, 0xad, 0x70, 0x20, 0x6e, 0x68, 0xe1,
-  0xba, 0xad, 0x74, 0x2e, 0x2e, 0x2e, 0x3c, 0x2f, 0x70, 0x3e, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69,
-  0x63, 0x6b, 0x3d, 0x22, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65, 0x46, 0x69,
-  0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x28, 0x29, 0x22, 0x3e, 0x43, 0xe1,
-  0xba, 0xad, 0x70, 0x20, 0x6e, 0x68, 0xe1, 0xba, 0xad, 0x74, 0x3c, 0x2f,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a, 0x0a, 0x20,
-  0x20, 0x20, 0x20, 0x3c, 0x21, 0x2d, 0x2d, 0x20, 0x42, 0x6f, 0x74, 0x74,
-  0x6f, 0x6d, 0x20, 0x54, 0x61, 0x62, 0x20, 0x42, 0x61, 0x72, 0x20, 0x2d,
-  0x2d, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76, 0x20,
-  0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x74, 0x61, 0x62, 0x2d, 0x62,
-  0x61, 0x72, 0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x22, 0x20, 0x69, 0x64, 0x3d, 0x22, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65,
+  0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
+  0x68, 0x32, 0x3e, 0x46, 0x69, 0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x20,
+  0x55, 0x70, 0x64, 0x61, 0x74, 0x65, 0x3c, 0x2f, 0x68, 0x32, 0x3e, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69, 0x76,
+  0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x75, 0x70, 0x64, 0x61,
+  0x74, 0x65, 0x2d, 0x73, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x22, 0x3e,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3c, 0x70, 0x20, 0x69, 0x64, 0x3d, 0x22, 0x66, 0x77, 0x53, 0x74,
+  0x61, 0x74, 0x75, 0x73, 0x22, 0x3e, 0x4b, 0x69, 0xe1, 0xbb, 0x83, 0x6d,
+  0x20, 0x74, 0x72, 0x61, 0x20, 0x63, 0xe1, 0xba, 0xad, 0x70, 0x20, 0x6e,
+  0x68, 0xe1, 0xba, 0xad, 0x74, 0x2e, 0x2e, 0x2e, 0x3c, 0x2f, 0x70, 0x3e,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63,
+  0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x75, 0x70, 0x64, 0x61, 0x74, 0x65,
+  0x46, 0x69, 0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x28, 0x29, 0x22, 0x3e,
+  0x43, 0xe1, 0xba, 0xad, 0x70, 0x20, 0x6e, 0x68, 0xe1, 0xba, 0xad, 0x74,
+  0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69, 0x76, 0x3e, 0x0a,
+  0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x21, 0x2d, 0x2d, 0x20, 0x42, 0x6f,
+  0x74, 0x74, 0x6f, 0x6d, 0x20, 0x54, 0x61, 0x62, 0x20, 0x42, 0x61, 0x72,
+  0x20, 0x2d, 0x2d, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x64, 0x69,
+  0x76, 0x20, 0x63, 0x6c, 0x61, 0x73, 0x73, 0x3d, 0x22, 0x74, 0x61, 0x62,
+  0x2d, 0x62, 0x61, 0x72, 0x22, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f,
+  0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x73, 0x68, 0x6f, 0x77,
+  0x54, 0x61, 0x62, 0x28, 0x27, 0x63, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c,
+  0x27, 0x29, 0x22, 0x3e, 0xc4, 0x90, 0x69, 0xe1, 0xbb, 0x81, 0x75, 0x20,
+  0x6b, 0x68, 0x69, 0xe1, 0xbb, 0x83, 0x6e, 0x3c, 0x2f, 0x62, 0x75, 0x74,
+  0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
   0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63,
   0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x73, 0x68, 0x6f, 0x77, 0x54, 0x61,
-  0x62, 0x28, 0x27, 0x63, 0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x27, 0x29,
-  0x22, 0x3e, 0xc4, 0x90, 0x69, 0xe1, 0xbb, 0x81, 0x75, 0x20, 0x6b, 0x68,
-  0x69, 0xe1, 0xbb, 0x83, 0x6e, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f,
-  0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69,
-  0x63, 0x6b, 0x3d, 0x22, 0x73, 0x68, 0x6f, 0x77, 0x54, 0x61, 0x62, 0x28,
-  0x27, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x27, 0x29, 0x22, 0x3e, 0x48, 0xe1,
-  0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68, 0x3c, 0x2f,
-  0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20,
-  0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x20,
-  0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x73, 0x68, 0x6f,
-  0x77, 0x54, 0x61, 0x62, 0x28, 0x27, 0x6c, 0x69, 0x73, 0x74, 0x27, 0x29,
-  0x22, 0x3e, 0x44, 0x61, 0x6e, 0x68, 0x20, 0x73, 0xc3, 0xa1, 0x63, 0x68,
+  0x62, 0x28, 0x27, 0x6c, 0x65, 0x61, 0x72, 0x6e, 0x27, 0x29, 0x22, 0x3e,
+  0x48, 0xe1, 0xbb, 0x8d, 0x63, 0x20, 0x6c, 0xe1, 0xbb, 0x87, 0x6e, 0x68,
   0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20,
   0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74, 0x74, 0x6f,
   0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d, 0x22, 0x73,
-  0x68, 0x6f, 0x77, 0x54, 0x61, 0x62, 0x28, 0x27, 0x75, 0x70, 0x64, 0x61,
-  0x74, 0x65, 0x27, 0x29, 0x22, 0x3e, 0x43, 0xe1, 0xba, 0xad, 0x70, 0x20,
-  0x6e, 0x68, 0xe1, 0xba, 0xad, 0x74, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74,
-  0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x2f, 0x64, 0x69,
-  0x76, 0x3e, 0x0a, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x73, 0x63, 0x72,
-  0x69, 0x70, 0x74, 0x20, 0x73, 0x72, 0x63, 0x3d, 0x22, 0x73, 0x63, 0x72,
-  0x69, 0x70, 0x74, 0x2e, 0x6a, 0x73, 0x22, 0x3e, 0x3c, 0x2f, 0x73, 0x63,
-  0x72, 0x69, 0x70, 0x74, 0x3e, 0x0a, 0x3c, 0x2f, 0x62, 0x6f, 0x64, 0x79,
-  0x3e, 0x0a, 0x0a, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e
+  0x68, 0x6f, 0x77, 0x54, 0x61, 0x62, 0x28, 0x27, 0x6c, 0x69, 0x73, 0x74,
+  0x27, 0x29, 0x22, 0x3e, 0x44, 0x61, 0x6e, 0x68, 0x20, 0x73, 0xc3, 0xa1,
+  0x63, 0x68, 0x3c, 0x2f, 0x62, 0x75, 0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x62, 0x75, 0x74,
+  0x74, 0x6f, 0x6e, 0x20, 0x6f, 0x6e, 0x63, 0x6c, 0x69, 0x63, 0x6b, 0x3d,
+  0x22, 0x73, 0x68, 0x6f, 0x77, 0x54, 0x61, 0x62, 0x28, 0x27, 0x75, 0x70,
+  0x64, 0x61, 0x74, 0x65, 0x27, 0x29, 0x22, 0x3e, 0x43, 0xe1, 0xba, 0xad,
+  0x70, 0x20, 0x6e, 0x68, 0xe1, 0xba, 0xad, 0x74, 0x3c, 0x2f, 0x62, 0x75,
+  0x74, 0x74, 0x6f, 0x6e, 0x3e, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x2f,
+  0x64, 0x69, 0x76, 0x3e, 0x0a, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x73,
+  0x63, 0x72, 0x69, 0x70, 0x74, 0x20, 0x73, 0x72, 0x63, 0x3d, 0x22, 0x73,
+  0x63, 0x72, 0x69, 0x70, 0x74, 0x2e, 0x6a, 0x73, 0x22, 0x3e, 0x3c, 0x2f,
+  0x73, 0x63, 0x72, 0x69, 0x70, 0x74, 0x3e, 0x0a, 0x3c, 0x2f, 0x62, 0x6f,
+  0x64, 0x79, 0x3e, 0x0a, 0x0a, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e
 };
-unsigned int index_html_len = 3958;
+unsigned int index_html_len = 4092;
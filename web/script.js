@@ -287,6 +287,36 @@ function submitAllAssignments() {
     .catch(err => alert("❌ Gửi thất bại: " + err));
 }
 
+// Tiến trình học lệnh, ESP32 đẩy từng sự kiện qua WebSocket
+const LEARN_STATE_TEXT = {
+    start: "Chờ nhấn nút",
+    sample: "Đã nhận",
+    done: "Học xong",
+    fail: "Học thất bại",
+    timeout: "Hết thời gian",
+    cancel: "Đã huỷ",
+};
+
+function connectLearnProgress() {
+    const ws = new WebSocket(`ws://${location.host}/ir/learn/ws`);
+    ws.onmessage = event => showLearnProgress(JSON.parse(event.data));
+    ws.onclose = () => setTimeout(connectLearnProgress, 3000);
+}
+
+function showLearnProgress(p) {
+    const el = document.getElementById("learnProgress");
+    if (!el) return;
+
+    let text = `${p.key}: ${LEARN_STATE_TEXT[p.state] || p.state} ${p.sample}/${p.samples}`;
+    if (p.state === "sample") text += `, ${p.symbols} symbol, phương sai ${p.variance} µs²`;
+    if (p.remaining_ms) text += `, còn ${Math.ceil(p.remaining_ms / 1000)} s`;
+    el.textContent = text;
+}
+
+function cancelLearn() {
+    fetch('/ir/learn/cancel');
+}
+
 // Khi trang load
 window.addEventListener("DOMContentLoaded", async () => {
     await fetchAvailableCommands();
@@ -298,4 +328,5 @@ window.addEventListener("DOMContentLoaded", async () => {
 });
 
 // Khởi động
-loadIRList();
\ No newline at end of file
+loadIRList();
+connectLearnProgress();
\ No newline at end of file